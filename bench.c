@@ -0,0 +1,532 @@
+#include "pl.h"
+#include "pl_bench.h"
+#include "pl_var.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+
+/*-----------------------------------------------------------------------------
+ |  New object churn
+ ----------------------------------------------------------------------------*/
+
+typedef struct churn_context
+{
+    int class;
+    long capacity;
+} churn_context;
+
+// Short-lived objects, collected at the safe point after each operation.
+static void bench_new_object(void *const context, const long ops)
+{
+    const pl_ns pl                   = pl_get_ns();
+    const churn_context *const churn = context;
+    for (long i = 0; i < ops; i++)
+    {
+        pl.gc.new_object(churn->class, churn->capacity);
+        pl.gc.maybe_collect();
+    }
+}
+
+static void bench_churn(void)
+{
+    static const long capacities[] = {1, 16, 1024, 65536};
+    for (int i = 0; i < 4; i++)
+    {
+        churn_context churn = {.class = PL_CLASS_DOUBLE, .capacity = capacities[i]};
+        pl_bench_get_ns().run("new_object", churn.capacity, capacities[i] > 1024 ? 1000 : 100000, bench_new_object, &churn);
+    }
+}
+
+/*-----------------------------------------------------------------------------
+ |  Garbage collection
+ ----------------------------------------------------------------------------*/
+
+static void bench_garbage_collect(void *const context, const long ops)
+{
+    (void) context;
+    const pl_ns pl = pl_get_ns();
+    for (long i = 0; i < ops; i++)
+        pl.gc.garbage_collect();
+}
+
+static void bench_minor_collect(void *const context, const long ops)
+{
+    (void) context;
+    const pl_ns pl = pl_get_ns();
+    for (long i = 0; i < ops; i++)
+        pl.gc.minor_collect();
+}
+
+// A list of `num_live` small objects kept alive during the collections.
+static void bench_collect(void)
+{
+    const pl_ns pl             = pl_get_ns();
+    const pl_bench_ns bench_ns = pl_bench_get_ns();
+    if (!bench_ns.selected("garbage_collect") && !bench_ns.selected("minor_collect"))
+        return;
+
+    for (long num_live = 1000; num_live <= 1000000; num_live *= 10)
+    {
+        pl_object live = pl.object.primitive.new(PL_CLASS_LIST, num_live);
+        pl.gc.directly_reachable(live);
+        for (long i = 0; i < num_live; i++)
+            pl.object.primitive.extend_object(live, pl.object.primitive.new(PL_CLASS_INT, 1));
+        pl.gc.garbage_collect();
+
+        bench_ns.run("garbage_collect", num_live, 1, bench_garbage_collect, NULL);
+        bench_ns.run("minor_collect", num_live, 1, bench_minor_collect, NULL);
+
+        pl.gc.directly_unreachable(live);
+        pl.gc.garbage_collect();
+    }
+}
+
+/*-----------------------------------------------------------------------------
+ |  Kernels
+ ----------------------------------------------------------------------------*/
+
+typedef struct kernel_context
+{
+    pl_object x;
+    pl_object y;
+    pl_object indices;
+    pl_object dst;
+    pl_object mask;
+    pl_object bool_dst;
+    pl_object na_last;
+    pl_object grouping;
+} kernel_context;
+
+static void bench_equal(void *const context, const long ops)
+{
+    const pl_ns pl                     = pl_get_ns();
+    const kernel_context *const kernel = context;
+    for (long i = 0; i < ops; i++)
+    {
+        pl.object.equal(kernel->x, kernel->y);
+        pl.gc.maybe_collect();
+    }
+}
+
+static void bench_equal_into(void *const context, const long ops)
+{
+    const pl_ns pl                     = pl_get_ns();
+    const kernel_context *const kernel = context;
+    for (long i = 0; i < ops; i++)
+        pl.object.equal_into(kernel->bool_dst, kernel->x, kernel->y);
+}
+
+static void bench_subset(void *const context, const long ops)
+{
+    const pl_ns pl                     = pl_get_ns();
+    const kernel_context *const kernel = context;
+    for (long i = 0; i < ops; i++)
+    {
+        pl.object.subset(kernel->x, kernel->indices);
+        pl.gc.maybe_collect();
+    }
+}
+
+static void bench_subset_mask(void *const context, const long ops)
+{
+    const pl_ns pl                     = pl_get_ns();
+    const kernel_context *const kernel = context;
+    for (long i = 0; i < ops; i++)
+    {
+        pl.object.subset(kernel->x, kernel->mask);
+        pl.gc.maybe_collect();
+    }
+}
+
+static void bench_as_double(void *const context, const long ops)
+{
+    const pl_ns pl                     = pl_get_ns();
+    const kernel_context *const kernel = context;
+    for (long i = 0; i < ops; i++)
+    {
+        pl.object.as_double(kernel->x);
+        pl.gc.maybe_collect();
+    }
+}
+
+static void bench_as_char(void *const context, const long ops)
+{
+    const pl_ns pl                     = pl_get_ns();
+    const kernel_context *const kernel = context;
+    for (long i = 0; i < ops; i++)
+    {
+        pl.object.as_char(kernel->x);
+        pl.gc.maybe_collect();
+    }
+}
+
+static void bench_sort(void *const context, const long ops)
+{
+    const pl_ns pl                     = pl_get_ns();
+    const kernel_context *const kernel = context;
+    for (long i = 0; i < ops; i++)
+    {
+        pl.object.sort(kernel->indices, kernel->na_last);
+        pl.gc.maybe_collect();
+    }
+}
+
+static void bench_order(void *const context, const long ops)
+{
+    const pl_ns pl                     = pl_get_ns();
+    const kernel_context *const kernel = context;
+    for (long i = 0; i < ops; i++)
+        pl.object.order_into(kernel->dst, kernel->indices, kernel->na_last);
+}
+
+static void bench_unique(void *const context, const long ops)
+{
+    const pl_ns pl                     = pl_get_ns();
+    const kernel_context *const kernel = context;
+    for (long i = 0; i < ops; i++)
+        pl.object.unique_into(kernel->dst, kernel->indices);
+}
+
+static void bench_match(void *const context, const long ops)
+{
+    const pl_ns pl                     = pl_get_ns();
+    const kernel_context *const kernel = context;
+    for (long i = 0; i < ops; i++)
+        pl.object.match_into(kernel->dst, kernel->x, kernel->y);
+}
+
+static void bench_group(void *const context, const long ops)
+{
+    const pl_ns pl                     = pl_get_ns();
+    const kernel_context *const kernel = context;
+    for (long i = 0; i < ops; i++)
+    {
+        pl.object.group(kernel->x);
+        pl.gc.maybe_collect();
+    }
+}
+
+static void bench_group_sum(void *const context, const long ops)
+{
+    const pl_ns pl                     = pl_get_ns();
+    const kernel_context *const kernel = context;
+    for (long i = 0; i < ops; i++)
+    {
+        pl.object.group_sum(kernel->y, kernel->grouping);
+        pl.gc.maybe_collect();
+    }
+}
+
+// Every kernel runs on operands of 10 to 10^5 ints. Operations per run shrink with the size.
+// The filter `subset(x + y, as_double(x) == as_double(y))`, with an intermediate object per operation.
+static void bench_filter_eager(void *const context, const long ops)
+{
+    const pl_ns pl                     = pl_get_ns();
+    const kernel_context *const kernel = context;
+    for (long i = 0; i < ops; i++)
+    {
+        pl_object mask = pl.object.equal(pl.object.as_double(kernel->x), pl.object.as_double(kernel->y));
+        pl.object.subset(pl.object.math.add(kernel->x, kernel->y), mask);
+        pl.gc.maybe_collect();
+    }
+}
+
+// The same filter evaluated by blocks, allocating only the mask and the result.
+static void bench_filter_lazy(void *const context, const long ops)
+{
+    const pl_ns pl                     = pl_get_ns();
+    const kernel_context *const kernel = context;
+    for (long i = 0; i < ops; i++)
+    {
+        pl_object mask = pl.object.lazy.equal(pl.object.lazy.as_double(kernel->x), pl.object.lazy.as_double(kernel->y));
+        pl.object.lazy.subset(pl.object.lazy.add(kernel->x, kernel->y), mask);
+        pl.gc.maybe_collect();
+    }
+}
+
+static void bench_kernels(void)
+{
+    const pl_ns pl             = pl_get_ns();
+    const pl_bench_ns bench_ns = pl_bench_get_ns();
+
+    for (long length = 10; length <= 1000000; length *= 100)
+    {
+        pl_object x        = pl.object.primitive.new(PL_CLASS_INT, length);
+        pl_object y        = pl.object.primitive.new(PL_CLASS_INT, length);
+        pl_object indices  = pl.object.primitive.new(PL_CLASS_INT, length);
+        pl_object dst      = pl.object.primitive.new(PL_CLASS_INT, length);
+        pl_object mask     = pl.object.primitive.new(PL_CLASS_BOOL, length);
+        pl_object bool_dst = pl.object.primitive.new(PL_CLASS_BOOL, length);
+        pl_object na_last  = pl.object.primitive.new(PL_CLASS_INT, 1);
+        pl.object.primitive.extend_int(na_last, 1);
+        for (long i = 0; i < length; i++)
+        {
+            pl.object.primitive.extend_int(x, (int) (i % 97));
+            pl.object.primitive.extend_int(y, (int) (i % 89));
+            pl.object.primitive.extend_int(indices, (int) ((i * 7919) % length));
+            pl.object.primitive.extend_bool(mask, i % 3 != 0);
+        }
+        pl_object grouping = pl.object.group(x);
+        pl.gc.multiple_directly_reachable(8, x, y, indices, dst, mask, bool_dst, na_last, grouping);
+
+        kernel_context kernel = {.x        = x,
+                                 .y        = y,
+                                 .indices  = indices,
+                                 .dst      = dst,
+                                 .mask     = mask,
+                                 .bool_dst = bool_dst,
+                                 .na_last  = na_last,
+                                 .grouping = grouping};
+        const long ops        = 1000000 / length;
+        bench_ns.run("equal", length, ops, bench_equal, &kernel);
+        bench_ns.run("equal_into", length, ops, bench_equal_into, &kernel);
+        bench_ns.run("subset", length, ops, bench_subset, &kernel);
+        bench_ns.run("subset_mask", length, ops, bench_subset_mask, &kernel);
+        bench_ns.run("as_double", length, ops, bench_as_double, &kernel);
+        bench_ns.run("as_char", length, ops, bench_as_char, &kernel);
+        bench_ns.run("sort", length, ops, bench_sort, &kernel);
+        bench_ns.run("order", length, ops, bench_order, &kernel);
+        bench_ns.run("unique", length, ops, bench_unique, &kernel);
+        bench_ns.run("match", length, ops, bench_match, &kernel);
+        bench_ns.run("group", length, ops, bench_group, &kernel);
+        bench_ns.run("group_sum", length, ops, bench_group_sum, &kernel);
+        bench_ns.run("filter_eager", length, ops, bench_filter_eager, &kernel);
+        bench_ns.run("filter_lazy", length, ops, bench_filter_lazy, &kernel);
+
+        pl.gc.multiple_directly_unreachable(8, x, y, indices, dst, mask, bool_dst, na_last, grouping);
+        pl.gc.garbage_collect();
+    }
+}
+
+/*-----------------------------------------------------------------------------
+ |  Variables
+ ----------------------------------------------------------------------------*/
+
+#define BENCH_VAR_FRAME 1
+#define BENCH_VAR_NAME_LEN 16
+
+typedef struct var_context
+{
+    long num_vars;
+    char (*names)[BENCH_VAR_NAME_LEN];
+} var_context;
+
+static void bench_var_get(void *const context, const long ops)
+{
+    const pl_var_ns var_ns       = pl_var_get_ns();
+    const var_context *const var = context;
+    for (long i = 0; i < ops; i++)
+        var_ns.get(var->names[(i * 7919) % var->num_vars], BENCH_VAR_FRAME);
+}
+
+static void bench_var_set(void *const context, const long ops)
+{
+    const pl_var_ns var_ns       = pl_var_get_ns();
+    const var_context *const var = context;
+    pl_object content            = var_ns.get(var->names[0], BENCH_VAR_FRAME);
+    for (long i = 0; i < ops; i++)
+        var_ns.set(var->names[(i * 7919) % var->num_vars], content, BENCH_VAR_FRAME);
+}
+
+static void bench_vars(void)
+{
+    const pl_ns pl             = pl_get_ns();
+    const pl_var_ns var_ns     = pl_var_get_ns();
+    const pl_bench_ns bench_ns = pl_bench_get_ns();
+    if (!bench_ns.selected("var_get") && !bench_ns.selected("var_set"))
+        return;
+
+    for (long num_vars = 10; num_vars <= 100000; num_vars *= 100)
+    {
+        var_context var = {.num_vars = num_vars, .names = malloc((size_t) num_vars * BENCH_VAR_NAME_LEN)};
+        if (var.names == NULL)
+            return;
+        pl_object content = pl.object.primitive.new(PL_CLASS_INT, 1);
+        for (long i = 0; i < num_vars; i++)
+        {
+            snprintf(var.names[i], BENCH_VAR_NAME_LEN, "v%ld", i);
+            var_ns.set(var.names[i], content, BENCH_VAR_FRAME);
+        }
+
+        bench_ns.run("var_get", num_vars, 100000, bench_var_get, &var);
+        bench_ns.run("var_set", num_vars, 100000, bench_var_set, &var);
+
+        var_ns.delete_frame(BENCH_VAR_FRAME);
+        free(var.names);
+    }
+}
+
+/*-----------------------------------------------------------------------------
+ |  Attributes
+ ----------------------------------------------------------------------------*/
+
+typedef struct attribute_context
+{
+    pl_object x;
+    pl_object names;
+    pl_object item;
+} attribute_context;
+
+static void bench_attribute_get(void *const context, const long ops)
+{
+    const pl_ns pl                           = pl_get_ns();
+    const attribute_context *const attribute = context;
+    const pl_object *const names             = attribute->names->data;
+    for (long i = 0; i < ops; i++)
+        pl.object.attribute.get(attribute->x, names[i % attribute->names->length]);
+}
+
+static void bench_attribute_set(void *const context, const long ops)
+{
+    const pl_ns pl                           = pl_get_ns();
+    const attribute_context *const attribute = context;
+    const pl_object *const names             = attribute->names->data;
+    for (long i = 0; i < ops; i++)
+        pl.object.attribute.set(attribute->x, names[i % attribute->names->length], attribute->item);
+}
+
+static void bench_attributes(void)
+{
+    const pl_ns pl             = pl_get_ns();
+    const pl_bench_ns bench_ns = pl_bench_get_ns();
+    if (!bench_ns.selected("attribute_get") && !bench_ns.selected("attribute_set"))
+        return;
+
+    for (int num_attributes = 2; num_attributes <= 32; num_attributes *= 4)
+    {
+        attribute_context attribute = {.x     = pl.object.primitive.new(PL_CLASS_INT, 1),
+                                       .names = pl.object.primitive.new(PL_CLASS_LIST, num_attributes),
+                                       .item  = pl.object.primitive.new(PL_CLASS_INT, 1)};
+        pl.gc.multiple_directly_reachable(3, attribute.x, attribute.names, attribute.item);
+        for (int i = 0; i < num_attributes; i++)
+        {
+            char name[BENCH_VAR_NAME_LEN];
+            snprintf(name, BENCH_VAR_NAME_LEN, "a%d", i);
+            pl_object symbol = pl.symbol.intern(name);
+            pl.object.primitive.extend_object(attribute.names, symbol);
+            pl.object.attribute.set(attribute.x, symbol, attribute.item);
+        }
+
+        bench_ns.run("attribute_get", num_attributes, 1000000, bench_attribute_get, &attribute);
+        bench_ns.run("attribute_set", num_attributes, 1000000, bench_attribute_set, &attribute);
+
+        pl.gc.multiple_directly_unreachable(3, attribute.x, attribute.names, attribute.item);
+        pl.gc.garbage_collect();
+    }
+}
+
+/*-----------------------------------------------------------------------------
+ |  Strings
+ ----------------------------------------------------------------------------*/
+
+typedef struct string_context
+{
+    pl_object strings;
+    pl_object key;
+} string_context;
+
+static void bench_string_equal(void *const context, const long ops)
+{
+    const pl_ns pl                     = pl_get_ns();
+    const string_context *const string = context;
+    for (long i = 0; i < ops; i++)
+    {
+        pl.object.equal(string->strings, string->key);
+        pl.gc.maybe_collect();
+    }
+}
+
+static void bench_string_unique(void *const context, const long ops)
+{
+    const pl_ns pl                     = pl_get_ns();
+    const string_context *const string = context;
+    for (long i = 0; i < ops; i++)
+    {
+        pl.object.unique(string->strings);
+        pl.gc.maybe_collect();
+    }
+}
+
+// A column of strings is traced as two objects, while a list of char objects is traced
+// as one object per string.
+static void bench_strings(void)
+{
+    const pl_ns pl             = pl_get_ns();
+    const pl_bench_ns bench_ns = pl_bench_get_ns();
+
+    for (long length = 1000; length <= 1000000; length *= 1000)
+    {
+        pl_object strings = pl.object.primitive.new(PL_CLASS_STRING, length);
+        char item[32];
+        for (long i = 0; i < length; i++)
+        {
+            snprintf(item, sizeof(item), "item-%ld", i % 997);
+            pl.object.primitive.extend_string(strings, item);
+        }
+        pl_object key = pl.object.primitive.new(PL_CLASS_STRING, 1);
+        pl.object.primitive.extend_string(key, "item-7");
+        pl.gc.multiple_directly_reachable(2, strings, key);
+        pl.gc.garbage_collect();
+
+        string_context string = {.strings = strings, .key = key};
+        const long ops        = 1000000 / length;
+        bench_ns.run("garbage_collect_strings", length, 1, bench_garbage_collect, NULL);
+        bench_ns.run("string_equal", length, ops, bench_string_equal, &string);
+        bench_ns.run("string_unique", length, ops, bench_string_unique, &string);
+        pl.gc.directly_unreachable(strings);
+
+        pl_object chars = pl.object.string.to_list(strings);
+        pl.gc.directly_reachable(chars);
+        pl.gc.garbage_collect();
+        bench_ns.run("garbage_collect_char_list", length, 1, bench_garbage_collect, NULL);
+
+        pl.gc.multiple_directly_unreachable(2, chars, key);
+        pl.gc.garbage_collect();
+    }
+}
+
+/*-----------------------------------------------------------------------------
+ |  Main
+ ----------------------------------------------------------------------------*/
+
+// Usage: pl_bench [--filter TEXT] [--json PATH]
+int main(int argc, char **argv)
+{
+    const pl_bench_ns bench_ns = pl_bench_get_ns();
+    const char *json_path      = NULL;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+            bench_ns.set_filter(argv[++i]);
+        else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+            json_path = argv[++i];
+        else
+        {
+            fprintf(stderr, "Usage: %s [--filter TEXT] [--json PATH]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    printf("%-28s %10s %15s %15s %20s %17s\n", "benchmark", "size", "median", "p99", "throughput", "allocated");
+    bench_churn();
+    bench_collect();
+    bench_kernels();
+    bench_vars();
+    bench_attributes();
+    bench_strings();
+
+    if (json_path != NULL)
+    {
+        FILE *const file = fopen(json_path, "w");
+        if (file == NULL)
+        {
+            fprintf(stderr, "Can not open file `%s`!\n", json_path);
+            return EXIT_FAILURE;
+        }
+        bench_ns.write_json(file);
+        fclose(file);
+    }
+
+    pl_get_ns().gc.kill();
+    return 0;
+}
@@ -35,8 +35,8 @@ int main()
     }
     $end_frame
 
-    // The GC needs to be triggered manually at the moment. There is no scheduler for it.
-    // This is a pretty simple stop-the-world GC so use it wisely.
+    // The GC is triggered automatically at the end of the outermost frame once enough memory has been allocated.
+    // It can also be run manually. This is a pretty simple stop-the-world GC so use it wisely.
     pl.gc.garbage_collect();
 
     // Report the memory usage.
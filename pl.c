@@ -14,6 +14,8 @@ pl_ns pl_get_ns(void)
                       .error  = pl_error_get_ns(),
                       .class = pl_class_get_ns(),
                       .gc     = pl_gc_get_ns(),
-                      .object = pl_object_get_ns()};
+                      .object = pl_object_get_ns(),
+                      .symbol = pl_symbol_get_ns(),
+                      .io     = pl_io_get_ns()};
     return ns;
 }
@@ -10,6 +10,8 @@
 #include "pl_class.h"
 #include "pl_gc.h"
 #include "pl_object.h"
+#include "pl_symbol.h"
+#include "pl_io.h"
 
 /*-----------------------------------------------------------------------------
  |  Library namespace
@@ -33,6 +35,12 @@ typedef struct pl_ns {
     /// Namespace of object.
     const pl_object_ns object;
 
+    /// Namespace of symbol.
+    const pl_symbol_ns symbol;
+
+    /// Namespace of io.
+    const pl_io_ns io;
+
 } pl_ns;
 
 /// Get the namespace of the library.
@@ -0,0 +1,164 @@
+//
+// Created by Patrick Li on 14/10/2026.
+//
+
+#include "pl_bench.h"
+#include "pl_error.h"
+#include "pl_gc.h"
+#include "stdlib.h"
+#include "string.h"
+#include "time.h"
+
+/*-----------------------------------------------------------------------------
+ |  Clock
+ ----------------------------------------------------------------------------*/
+
+// A monotonic clock is used where it exists, since the wall clock may jump.
+static double now(void)
+{
+    struct timespec time;
+#if defined(__unix__) || defined(__APPLE__)
+    clock_gettime(CLOCK_MONOTONIC, &time);
+#else
+    timespec_get(&time, TIME_UTC);
+#endif
+    return (double) time.tv_sec + (double) time.tv_nsec * 1e-9;
+}
+
+/*-----------------------------------------------------------------------------
+ |  Results
+ ----------------------------------------------------------------------------*/
+
+static pl_bench_result global_results[PL_BENCH_MAX_RESULTS] = {0};
+static int global_num_results                               = 0;
+static const char *global_filter                            = NULL;
+
+static void set_filter(const char *const filter)
+{
+    global_filter = filter;
+}
+
+static int selected(const char *const name)
+{
+    return global_filter == NULL || strstr(name, global_filter) != NULL;
+}
+
+static const pl_bench_result *results(int *const count)
+{
+    *count = global_num_results;
+    return global_results;
+}
+
+/*-----------------------------------------------------------------------------
+ |  Run
+ ----------------------------------------------------------------------------*/
+
+static int compare_double(const void *const a, const void *const b)
+{
+    const double x = *(const double *) a;
+    const double y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+static void run(const char *const name,
+                const long size,
+                const long ops,
+                void (*const body)(void *context, long ops),
+                void *const context)
+{
+    pl_error_expect(name != NULL && body != NULL,
+                    PL_ERROR_UNEXPECTED_NULL_POINTER,
+                    "Unexpected NULL pointer provided!");
+    pl_error_expect(ops > 0, PL_ERROR_INVALID_ARGUMENT, "Invalid number of operations [%ld]!", ops);
+    pl_error_expect(global_num_results < PL_BENCH_MAX_RESULTS,
+                    PL_ERROR_INVALID_ARGUMENT,
+                    "More than [%d] benchmarks!",
+                    PL_BENCH_MAX_RESULTS);
+    if (!selected(name))
+        return;
+
+    const pl_gc_ns gc_ns = pl_gc_get_ns();
+
+    // Warm up the caches, the pools and the branch predictors.
+    body(context, ops);
+
+    double times[PL_BENCH_MAX_RUNS];
+    int runs                  = 0;
+    double total              = 0.0;
+    const size_t bytes_before = gc_ns.allocated_bytes();
+    while (runs < PL_BENCH_MAX_RUNS && (runs < PL_BENCH_MIN_RUNS || total < PL_BENCH_MIN_TIME))
+    {
+        const double start = now();
+        body(context, ops);
+        const double elapsed = now() - start;
+        times[runs++]        = elapsed;
+        total += elapsed;
+    }
+    const size_t bytes = gc_ns.allocated_bytes() - bytes_before;
+
+    qsort(times, (size_t) runs, sizeof(double), compare_double);
+    const double median = runs % 2 == 1 ? times[runs / 2] : (times[runs / 2 - 1] + times[runs / 2]) / 2.0;
+    const int p99_index = (int) ((double) (runs - 1) * 0.99 + 0.5);
+
+    pl_bench_result *const result = global_results + global_num_results++;
+    *result                       = (pl_bench_result) {.name         = name,
+                                                       .size         = size,
+                                                       .ops          = ops,
+                                                       .runs         = runs,
+                                                       .median_ns    = median / (double) ops * 1e9,
+                                                       .p99_ns       = times[p99_index] / (double) ops * 1e9,
+                                                       .ops_per_sec  = median > 0.0 ? (double) ops / median : 0.0,
+                                                       .bytes_per_op = (double) bytes / ((double) ops * runs)};
+
+    printf("%-28s %10ld %12.1f ns %12.1f ns %14.0f ops/s %12.1f B/op\n",
+           result->name,
+           result->size,
+           result->median_ns,
+           result->p99_ns,
+           result->ops_per_sec,
+           result->bytes_per_op);
+    fflush(stdout);
+}
+
+/*-----------------------------------------------------------------------------
+ |  JSON
+ ----------------------------------------------------------------------------*/
+
+// Names are written as they are, so they must not contain quotes or backslashes.
+static void write_json(FILE *const stream)
+{
+    pl_error_expect(stream != NULL, PL_ERROR_UNEXPECTED_NULL_POINTER, "Unexpected NULL pointer `stream` provided!");
+
+    fprintf(stream, "{\n  \"results\": [");
+    for (int i = 0; i < global_num_results; i++)
+    {
+        const pl_bench_result *const result = global_results + i;
+        fprintf(stream,
+                "%s\n    {\"name\": \"%s\", \"size\": %ld, \"ops\": %ld, \"runs\": %d, "
+                "\"median_ns\": %.3f, \"p99_ns\": %.3f, \"ops_per_sec\": %.1f, \"bytes_per_op\": %.3f}",
+                i == 0 ? "" : ",",
+                result->name,
+                result->size,
+                result->ops,
+                result->runs,
+                result->median_ns,
+                result->p99_ns,
+                result->ops_per_sec,
+                result->bytes_per_op);
+    }
+    fprintf(stream, "\n  ]\n}\n");
+}
+
+/*-----------------------------------------------------------------------------
+ |  Get bench namespace
+ ----------------------------------------------------------------------------*/
+
+pl_bench_ns pl_bench_get_ns(void)
+{
+    static const pl_bench_ns bench_ns = {.set_filter = set_filter,
+                                         .selected   = selected,
+                                         .run        = run,
+                                         .results    = results,
+                                         .write_json = write_json};
+    return bench_ns;
+}
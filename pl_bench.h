@@ -0,0 +1,96 @@
+//
+// Created by Patrick Li on 14/10/2026.
+//
+
+#ifndef PL_PL_BENCH_H
+#define PL_PL_BENCH_H
+
+#include "stdio.h"
+
+/*-----------------------------------------------------------------------------
+ |  Limits
+ ----------------------------------------------------------------------------*/
+
+/// Maximum number of results kept by the harness.
+#define PL_BENCH_MAX_RESULTS 256
+
+/// Maximum number of timed runs of a benchmark.
+#define PL_BENCH_MAX_RUNS 200
+
+/// Minimum number of timed runs of a benchmark.
+#define PL_BENCH_MIN_RUNS 10
+
+/// A benchmark keeps running until its timed runs take this many seconds, or
+/// `PL_BENCH_MAX_RUNS` is reached.
+#define PL_BENCH_MIN_TIME 0.2
+
+/*-----------------------------------------------------------------------------
+ |  Result
+ ----------------------------------------------------------------------------*/
+
+/// Result of a benchmark.
+/// @param name (const char *). Name of the benchmark.
+/// @param size (long). Size of the problem, e.g. the length of the operands.
+/// @param ops (long). Number of operations per run.
+/// @param runs (int). Number of timed runs.
+/// @param median_ns (double). Median time per operation in nanoseconds.
+/// @param p99_ns (double). 99th percentile of the time per operation over the runs.
+/// @param ops_per_sec (double). Operations per second at the median.
+/// @param bytes_per_op (double). Bytes allocated by the heap per operation.
+typedef struct pl_bench_result
+{
+    const char *name;
+    long size;
+    long ops;
+    int runs;
+    double median_ns;
+    double p99_ns;
+    double ops_per_sec;
+    double bytes_per_op;
+} pl_bench_result;
+
+/*-----------------------------------------------------------------------------
+ |  Bench namespace
+ ----------------------------------------------------------------------------*/
+
+/// Namespace of the benchmark harness.
+typedef struct pl_bench_ns
+{
+    /// Only run the benchmarks whose names contain a filter.
+    /// @param filter (const char *). The filter, or NULL to run all the benchmarks.
+    void (*const set_filter)(const char *filter);
+
+    /// Check if a benchmark is selected by the filter.
+    /// @details Used to skip the setup of benchmarks that will not run.
+    /// @param name (const char *). Name of the benchmark.
+    /// @return 1 if selected, 0 otherwise.
+    int (*const selected)(const char *name);
+
+    /// Run a benchmark.
+    /// @details The body runs once untimed as a warmup, then it is timed for at least
+    /// `PL_BENCH_MIN_RUNS` runs and `PL_BENCH_MIN_TIME` seconds. Each run calls the
+    /// body once, which performs `ops` operations. The result is printed and kept.
+    /// @param name (const char *). Name of the benchmark. It must outlive the harness.
+    /// @param size (long). Size of the problem.
+    /// @param ops (long). Number of operations per run.
+    /// @param body (void (*)(void *context, long ops)). The body.
+    /// @param context (void *). Passed to the body.
+    void (*const run)(const char *name, long size, long ops, void (*body)(void *context, long ops), void *context);
+
+    /// Get the results kept by the harness.
+    /// @param count (int *). Receives the number of results.
+    /// @return The results.
+    const pl_bench_result *(*const results)(int *count);
+
+    /// Write the results as JSON.
+    /// @details The document is an object with a `results` array, where every result
+    /// has the fields of `pl_bench_result`.
+    /// @param stream (FILE *). The stream.
+    void (*const write_json)(FILE *stream);
+} pl_bench_ns;
+
+/// Get bench namespace.
+/// @return Namespace of bench.
+pl_bench_ns pl_bench_get_ns(void);
+
+#endif//PL_PL_BENCH_H
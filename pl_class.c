@@ -60,13 +60,7 @@ static int type(const int derived) {
                     PL_ERROR_UNDEFINED_CLASS,
                     "Undefined class [%d]!", derived);
 
-    // Recursively find the base class.
-    int current = derived;
-    while (PL_CLASS_INHERIT[current] != -1) {
-        current = PL_CLASS_INHERIT[current];
-    }
-
-    return current;
+    return PL_CLASS_TYPE[derived];
 }
 
 static pl_unittest_summary test_type(void) {
@@ -76,6 +70,19 @@ static pl_unittest_summary test_type(void) {
     pl_unittest_expect_error_is(summary, PL_ERROR_UNDEFINED_CLASS, type(-1));
 
     pl_unittest_expect_true(summary, type(PL_CLASS_CHAR) == PL_CLASS_CHAR);
+    pl_unittest_expect_true(summary, type(PL_CLASS_BOOL) == PL_CLASS_BOOL);
+    pl_unittest_expect_true(summary, type(PL_CLASS_STRING) == PL_CLASS_STRING);
+
+    // The table agrees with the roots of the hierarchy.
+    volatile int roots_agree = 1;
+    for (int i = 0; i < PL_NUM_CLASS; i++) {
+        int current = i;
+        while (PL_CLASS_INHERIT[current] != -1) {
+            current = PL_CLASS_INHERIT[current];
+        }
+        roots_agree = roots_agree && type(i) == current;
+    }
+    pl_unittest_expect_true(summary, roots_agree);
 
     return summary;
 }
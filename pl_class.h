@@ -13,7 +13,7 @@
  ----------------------------------------------------------------------------*/
 
 /// Total number of classes.
-#define PL_NUM_CLASS 6
+#define PL_NUM_CLASS 8
 
 /// Enum of classes.
 /// @details Classes should follow the format "PL_CLASS_{NAME}".
@@ -23,7 +23,9 @@ enum {
     PL_CLASS_LONG = 2,
     PL_CLASS_DOUBLE = 3,
     PL_CLASS_LIST = 4,
-    PL_CLASS_EXTERNAL = 5
+    PL_CLASS_EXTERNAL = 5,
+    PL_CLASS_BOOL = 6,
+    PL_CLASS_STRING = 7
 };
 
 /// Class names.
@@ -33,16 +35,23 @@ static const char *const PL_CLASS_NAME[PL_NUM_CLASS] = {
         [PL_CLASS_LONG]     = "LONG",
         [PL_CLASS_DOUBLE]   = "DOUBLE",
         [PL_CLASS_LIST]     = "LIST",
-        [PL_CLASS_EXTERNAL] = "EXTERNAL"};
+        [PL_CLASS_EXTERNAL] = "EXTERNAL",
+        [PL_CLASS_BOOL]     = "BOOL",
+        [PL_CLASS_STRING]   = "STRING"};
 
 /// Element size of each class.
+/// @details Booleans are packed as bits, so they have no element size. The items of a
+/// string are an offset and a length into its byte buffer, and they follow a pointer to the
+/// buffer. Use `pl_object_data_size` for the size of the data of any class.
 static const size_t PL_CLASS_ELEMENT_SIZE[PL_NUM_CLASS] = {
         [PL_CLASS_CHAR]     = sizeof(char),
         [PL_CLASS_INT]      = sizeof(int),
         [PL_CLASS_LONG]     = sizeof(long),
         [PL_CLASS_DOUBLE]   = sizeof(double),
         [PL_CLASS_LIST]     = sizeof(void *),
-        [PL_CLASS_EXTERNAL] = sizeof(void *)};
+        [PL_CLASS_EXTERNAL] = sizeof(void *),
+        [PL_CLASS_BOOL]     = 0,
+        [PL_CLASS_STRING]   = 2 * sizeof(long)};
 
 /// Parent of each class.
 static const int PL_CLASS_INHERIT[PL_NUM_CLASS] = {
@@ -51,7 +60,22 @@ static const int PL_CLASS_INHERIT[PL_NUM_CLASS] = {
         [PL_CLASS_LONG]     = -1,
         [PL_CLASS_DOUBLE]   = -1,
         [PL_CLASS_LIST]     = -1,
-        [PL_CLASS_EXTERNAL] = -1};
+        [PL_CLASS_EXTERNAL] = -1,
+        [PL_CLASS_BOOL]     = -1,
+        [PL_CLASS_STRING]   = -1};
+
+/// Underlying type of each class, which is the root of the class in PL_CLASS_INHERIT.
+/// @details Types are resolved ahead of time, so dispatching on a type is a table lookup.
+/// The tests of the class namespace check the table against PL_CLASS_INHERIT.
+static const int PL_CLASS_TYPE[PL_NUM_CLASS] = {
+        [PL_CLASS_CHAR]     = PL_CLASS_CHAR,
+        [PL_CLASS_INT]      = PL_CLASS_INT,
+        [PL_CLASS_LONG]     = PL_CLASS_LONG,
+        [PL_CLASS_DOUBLE]   = PL_CLASS_DOUBLE,
+        [PL_CLASS_LIST]     = PL_CLASS_LIST,
+        [PL_CLASS_EXTERNAL] = PL_CLASS_EXTERNAL,
+        [PL_CLASS_BOOL]     = PL_CLASS_BOOL,
+        [PL_CLASS_STRING]   = PL_CLASS_STRING};
 
 /*-----------------------------------------------------------------------------
  |  Class namespace
@@ -66,6 +90,7 @@ typedef struct pl_class_ns {
     int (*const inherit)(int derived, int base);
 
     /// Get the underlying type of a class.
+    /// @details A range-checked lookup of PL_CLASS_TYPE.
     /// @param derived (int). The derived class.
     /// @return The base class.
     int (*const type)(int derived);
@@ -8,11 +8,11 @@
 #include "stdarg.h"
 #include "stdio.h"
 #include "stdlib.h"
+#include "string.h"
 
 #ifdef PL_TEST
 
 #include "pl_unittest.h"
-#include "string.h"
 
 #endif//PL_TEST
 
@@ -20,16 +20,287 @@
  |  Exception
  ----------------------------------------------------------------------------*/
 
-/// A global buffer for storing error message.
-static char global_error_message[PL_ERROR_MAX_MESSAGE_LEN] = {0};
+/// A thread-local buffer for storing error message.
+static _Thread_local char global_error_message[PL_ERROR_MAX_MESSAGE_LEN] = {0};
+
+/// A volatile thread-local variable for storing exception frames.
+extern _Thread_local volatile pl_error_exception pl_error_exception_frames = {0};
+
+/*-----------------------------------------------------------------------------
+ |  Pending error message
+ ----------------------------------------------------------------------------*/
+
+/// Maximum number of arguments of a pending error message.
+#define ERROR_MAX_ARGUMENTS 8
+
+/// Kind of an argument of an error message.
+typedef enum error_argument_kind {
+    ERROR_ARGUMENT_SIGNED,
+    ERROR_ARGUMENT_UNSIGNED,
+    ERROR_ARGUMENT_DOUBLE,
+    ERROR_ARGUMENT_POINTER,
+    ERROR_ARGUMENT_STRING
+} error_argument_kind;
+
+/// An argument of an error message.
+/// @details Strings are copied into the buffer of the pending message, since they
+/// may be on the stack of the function that throws.
+typedef struct error_argument {
+    error_argument_kind kind;
+    union {
+        long long signed_value;
+        unsigned long long unsigned_value;
+        double double_value;
+        const void *pointer_value;
+        size_t string_offset;
+    };
+} error_argument;
+
+/// An error message that has been saved but not formatted yet.
+/// @param pending (int). Whether `global_error_message` is outdated.
+/// @param error (int). The error ID.
+/// @param function_name (const char *). Function name.
+/// @param file_name (const char *). File name.
+/// @param line (int). The line number.
+/// @param format (const char *). Format of the additional error message. It is a string literal.
+/// @param num_arguments (int). Number of arguments, including `*` widths and precisions.
+/// @param arguments (error_argument [ERROR_MAX_ARGUMENTS]). The arguments.
+/// @param strings_length (size_t). Number of bytes used in `strings`.
+/// @param strings (char [PL_ERROR_MAX_MESSAGE_LEN]). Copies of the string arguments.
+typedef struct error_pending_message {
+    int pending;
+    int error;
+    const char *function_name;
+    const char *file_name;
+    int line;
+    const char *format;
+    int num_arguments;
+    error_argument arguments[ERROR_MAX_ARGUMENTS];
+    size_t strings_length;
+    char strings[PL_ERROR_MAX_MESSAGE_LEN];
+} error_pending_message;
+
+/// A thread-local pending error message.
+static _Thread_local error_pending_message global_pending_message = {0};
+
+// Skip the flags, the width, the precision and the length modifier of a conversion
+// specification. Returns the conversion character, or '\0' if it is not supported.
+// `*` widths and precisions are counted by `stars`, and `is_long` is set for `l`,
+// `ll`, `z`, `j` and `t`.
+static char parse_conversion(const char **const cursor, int *const stars, int *const is_long) {
+    const char *c = *cursor;
+    *stars = 0;
+    *is_long = 0;
+    while (*c == '-' || *c == '+' || *c == ' ' || *c == '#' || *c == '0')
+        c++;
+    for (int precision = 0; precision < 2; precision++) {
+        if (precision == 1) {
+            if (*c != '.')
+                break;
+            c++;
+        }
+        if (*c == '*') {
+            (*stars)++;
+            c++;
+        }
+        while (*c >= '0' && *c <= '9')
+            c++;
+    }
+    while (*c == 'h')
+        c++;
+    while (*c == 'l' || *c == 'z' || *c == 'j' || *c == 't') {
+        *is_long = 1;
+        c++;
+    }
+    *cursor = c + (*c != '\0');
+    switch (*c) {
+        case 'd': case 'i': case 'c': case 'u': case 'x': case 'X': case 'o':
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G':
+        case 'p': case 's': case '%':
+            return *c;
+        default:
+            return '\0';
+    }
+}
+
+// Capture the arguments of `format`. Returns 0 if the format can't be formatted lazily.
+static int capture_arguments(error_pending_message *const message, const char *const format, va_list ap) {
+    message->num_arguments = 0;
+    message->strings_length = 0;
+
+    for (const char *c = format; *c != '\0';) {
+        if (*c++ != '%')
+            continue;
+
+        int stars = 0;
+        int is_long = 0;
+        const char conversion = parse_conversion(&c, &stars, &is_long);
+        if (conversion == '\0')
+            return 0;
+        if (conversion == '%')
+            continue;
+        if (message->num_arguments + stars + 1 > ERROR_MAX_ARGUMENTS)
+            return 0;
+
+        error_argument *argument = message->arguments + message->num_arguments;
+        for (int i = 0; i < stars; i++, argument++) {
+            argument->kind = ERROR_ARGUMENT_SIGNED;
+            argument->signed_value = va_arg(ap, int);
+        }
+        message->num_arguments += stars + 1;
+
+        switch (conversion) {
+            case 'd':
+            case 'i':
+            case 'c':
+                argument->kind = ERROR_ARGUMENT_SIGNED;
+                argument->signed_value = is_long ? va_arg(ap, long) : va_arg(ap, int);
+                break;
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o':
+                argument->kind = ERROR_ARGUMENT_UNSIGNED;
+                argument->unsigned_value = is_long ? va_arg(ap, unsigned long) : va_arg(ap, unsigned int);
+                break;
+            case 'p':
+                argument->kind = ERROR_ARGUMENT_POINTER;
+                argument->pointer_value = va_arg(ap, const void *);
+                break;
+            case 's': {
+                // Strings longer than the message are truncated, since they can't fit anyway.
+                const char *const string = va_arg(ap, const char *);
+                const size_t available = PL_ERROR_MAX_MESSAGE_LEN - message->strings_length;
+                if (string == NULL || available == 0)
+                    return 0;
+                const char *const end = memchr(string, '\0', available - 1);
+                const size_t length = end == NULL ? available - 1 : (size_t) (end - string);
+                memcpy(message->strings + message->strings_length, string, length);
+                message->strings[message->strings_length + length] = '\0';
+                argument->kind = ERROR_ARGUMENT_STRING;
+                argument->string_offset = message->strings_length;
+                message->strings_length += length + 1;
+                break;
+            }
+            default:
+                argument->kind = ERROR_ARGUMENT_DOUBLE;
+                argument->double_value = va_arg(ap, double);
+                break;
+        }
+    }
+    return 1;
+}
+
+// Format a pending message into `buffer`. Each conversion is formatted by `snprintf()`
+// with its length modifier replaced by the one of the stored argument.
+static void format_pending_message(const error_pending_message *const message, char *const buffer, const size_t size) {
+    size_t length = 0;
+    const error_argument *argument = message->arguments;
+
+    for (const char *c = message->format; *c != '\0' && length + 1 < size;) {
+        if (*c != '%') {
+            buffer[length++] = *c++;
+            continue;
+        }
+
+        const char *const start = c++;
+        int stars = 0;
+        int is_long = 0;
+        const char conversion = parse_conversion(&c, &stars, &is_long);
+        if (conversion == '%') {
+            buffer[length++] = '%';
+            continue;
+        }
+
+        // Rebuild the specification with the stored widths and precisions.
+        char spec[64] = "%";
+        size_t spec_length = 1;
+        for (const char *s = start + 1; s < c - 1 && spec_length < 32; s++) {
+            if (*s == 'h' || *s == 'l' || *s == 'z' || *s == 'j' || *s == 't')
+                continue;
+            if (*s == '*')
+                spec_length += (size_t) snprintf(spec + spec_length, 16, "%d", (int) (argument++)->signed_value);
+            else
+                spec[spec_length++] = *s;
+        }
+
+        const size_t available = size - length;
+        int written = 0;
+        switch (argument->kind) {
+            case ERROR_ARGUMENT_SIGNED:
+                if (conversion == 'c') {
+                    snprintf(spec + spec_length, 8, "c");
+                    written = snprintf(buffer + length, available, spec, (int) argument->signed_value);
+                } else {
+                    snprintf(spec + spec_length, 8, "lld");
+                    written = snprintf(buffer + length, available, spec, argument->signed_value);
+                }
+                break;
+            case ERROR_ARGUMENT_UNSIGNED:
+                snprintf(spec + spec_length, 8, "ll%c", conversion);
+                written = snprintf(buffer + length, available, spec, argument->unsigned_value);
+                break;
+            case ERROR_ARGUMENT_DOUBLE:
+                snprintf(spec + spec_length, 8, "%c", conversion);
+                written = snprintf(buffer + length, available, spec, argument->double_value);
+                break;
+            case ERROR_ARGUMENT_POINTER:
+                snprintf(spec + spec_length, 8, "p");
+                written = snprintf(buffer + length, available, spec, argument->pointer_value);
+                break;
+            case ERROR_ARGUMENT_STRING:
+                snprintf(spec + spec_length, 8, "s");
+                written = snprintf(buffer + length, available, spec, message->strings + argument->string_offset);
+                break;
+        }
+        argument++;
+
+        if (written < 0)
+            break;
+        length += (size_t) written < available ? (size_t) written : available - 1;
+    }
+    buffer[length] = '\0';
+}
+
+// Rewrite the buffer with the full error message.
+static void write_error_message(const int error,
+                                const char *const function_name,
+                                const char *const file_name,
+                                const int line,
+                                const char *const message) {
+    int len = snprintf(global_error_message,
+                       PL_ERROR_MAX_MESSAGE_LEN,
+                       "[E%03d] Error raised by <%s> at %s:%d: %s\n",
+                       error,
+                       function_name,
+                       file_name,
+                       line,
+                       message);
+
+    // Check encoding error
+    if (len < 0) {
+        puts("PL Internal Error: Encounter an encoding error! The error message buffer will be reset!");
+        global_error_message[0] = '\0';
+    }
+}
 
-/// A volatile global variable for storing exception frames.
-extern volatile pl_error_exception pl_error_exception_frames = {0};
+// Format the pending message, if any, into the buffer.
+static void flush_pending_message(void) {
+    error_pending_message *const pending = &global_pending_message;
+    if (!pending->pending)
+        return;
+
+    char message[PL_ERROR_MAX_MESSAGE_LEN] = {0};
+    format_pending_message(pending, message, PL_ERROR_MAX_MESSAGE_LEN);
+    write_error_message(pending->error, pending->function_name, pending->file_name, pending->line, message);
+    pending->pending = 0;
+}
 
 /*-----------------------------------------------------------------------------
  |  Save error message
  ----------------------------------------------------------------------------*/
 
+// Most errors are caught and discarded, so the message is only formatted when it is read.
 static void save_error_message(const int error,
                                const char *const function_name,
                                const char *const file_name,
@@ -40,10 +311,26 @@ static void save_error_message(const int error,
     if (format[0] == '\0')
         return;
 
-    // Create the customized error message.
-    char message[PL_ERROR_MAX_MESSAGE_LEN] = {0};
+    error_pending_message *const pending = &global_pending_message;
     va_list ap;
     va_start(ap, format);
+    const int captured = capture_arguments(pending, format, ap);
+    va_end(ap);
+
+    if (captured) {
+        pending->pending = 1;
+        pending->error = error;
+        pending->function_name = function_name;
+        pending->file_name = file_name;
+        pending->line = line;
+        pending->format = format;
+        return;
+    }
+
+    // Formats that can't be captured are formatted right away.
+    pending->pending = 0;
+    char message[PL_ERROR_MAX_MESSAGE_LEN] = {0};
+    va_start(ap, format);
     int message_len = vsnprintf(message, PL_ERROR_MAX_MESSAGE_LEN, format, ap);
     va_end(ap);
 
@@ -53,21 +340,21 @@ static void save_error_message(const int error,
         message[0] = '\0';
     }
 
-    // Rewrite the buffer
-    int len = snprintf(global_error_message,
-                       PL_ERROR_MAX_MESSAGE_LEN,
-                       "[E%03d] Error raised by <%s> at %s:%d: %s\n",
-                       error,
-                       function_name,
-                       file_name,
-                       line,
-                       message);
+    write_error_message(error, function_name, file_name, line, message);
+}
 
-    // Check encoding error
-    if (len < 0) {
-        puts("PL Internal Error: Encounter an encoding error! The error message buffer will be reset!");
-        global_error_message[0] = '\0';
-    }
+/*-----------------------------------------------------------------------------
+ |  Get and restore error message
+ ----------------------------------------------------------------------------*/
+
+static const char *get_error_message(void) {
+    flush_pending_message();
+    return global_error_message;
+}
+
+static void restore_error_message(const char *const message) {
+    global_pending_message.pending = 0;
+    snprintf(global_error_message, PL_ERROR_MAX_MESSAGE_LEN, "%s", message);
 }
 
 static pl_unittest_summary test_save_error_message(void) {
@@ -75,14 +362,28 @@ static pl_unittest_summary test_save_error_message(void) {
 
     pl_unittest_expect_true(summary,
                             (save_error_message(1, "a", "b", 123, "test!"),
-                                    strcmp("[E001] Error raised by <a> at b:123: test!\n", global_error_message) == 0));
+                                    strcmp("[E001] Error raised by <a> at b:123: test!\n", get_error_message()) == 0));
     pl_unittest_expect_true(summary,
                             (save_error_message(2, "aa", "bb", 1234, ""),
-                                    strcmp("[E001] Error raised by <a> at b:123: test!\n", global_error_message) == 0));
+                                    strcmp("[E001] Error raised by <a> at b:123: test!\n", get_error_message()) == 0));
     pl_unittest_expect_true(summary,
                             (save_error_message(3, "aa", "bb", 1234, "test!"),
-                                    strcmp("[E003] Error raised by <aa> at bb:1234: test!\n", global_error_message) ==
+                                    strcmp("[E003] Error raised by <aa> at bb:1234: test!\n", get_error_message()) ==
                                     0));
+
+    // The arguments are formatted when the message is read, after the strings are gone.
+    char name[16] = "abc";
+    save_error_message(4, "f", "g", 1, "[%d] [%-5s] [%03ld] [%zu] [%.*f] [%c] [%u] [%%] [%g]",
+                       -7, name, 42L, (size_t) 9, 2, 3.14159, 'x', 5u, 0.5);
+    name[0] = '\0';
+    pl_unittest_expect_true(summary,
+                            strcmp("[E004] Error raised by <f> at g:1: [-7] [abc  ] [042] [9] [3.14] [x] [5] [%] [0.5]\n",
+                                   get_error_message()) == 0);
+
+    // Formats with too many arguments are formatted right away.
+    save_error_message(5, "f", "g", 1, "%d%d%d%d%d%d%d%d%d", 1, 2, 3, 4, 5, 6, 7, 8, 9);
+    pl_unittest_expect_true(summary,
+                            strcmp("[E005] Error raised by <f> at g:1: 123456789\n", get_error_message()) == 0);
     global_error_message[0] = '\0';
 
     return summary;
@@ -95,7 +396,7 @@ static pl_unittest_summary test_save_error_message(void) {
 static void long_jump_if_catch(const int error) {
     pl_error_exception_frames.error = error;
     if (pl_error_exception_frames.frame)
-        longjmp(*pl_error_exception_frames.frame, 1);
+        pl_error_longjmp(*pl_error_exception_frames.frame, 1);
 }
 
 /*-----------------------------------------------------------------------------
@@ -103,7 +404,7 @@ static void long_jump_if_catch(const int error) {
  ----------------------------------------------------------------------------*/
 
 _Noreturn static void default_error_handler(void) {
-    puts(global_error_message);
+    puts(get_error_message());
 #ifdef VDL_EXCEPTION_DISABLE
     puts("PL Internal Message: Program abort in no exception mode!");
 #else
@@ -125,11 +426,15 @@ static void test(void) {
 pl_error_ns pl_error_get_ns(void) {
 #ifdef PL_TEST
     static const pl_error_ns error_ns = {.save_error_message    = save_error_message,
+            .get_error_message     = get_error_message,
+            .restore_error_message = restore_error_message,
             .long_jump_if_catch    = long_jump_if_catch,
             .default_error_handler = default_error_handler,
             .test                  = test};
 #else
     static const pl_error_ns error_ns = {.save_error_message    = save_error_message,
+                                         .get_error_message     = get_error_message,
+                                         .restore_error_message = restore_error_message,
                                          .long_jump_if_catch    = long_jump_if_catch,
                                          .default_error_handler = default_error_handler};
 #endif//PL_TEST
@@ -28,6 +28,9 @@
 #define PL_ERROR_INVALID_VARIABLE_NAME 11
 #define PL_ERROR_INCOMPATIBLE_LENGTH 12
 #define PL_ERROR_ATTRIBUTE_NOT_FOUND 13
+#define PL_ERROR_INVALID_ARGUMENT 14
+#define PL_ERROR_IO_FAILED 15
+#define PL_ERROR_INVALID_FORMAT 16
 
 /*-----------------------------------------------------------------------------
  |  Error message length
@@ -49,12 +52,23 @@ typedef volatile struct pl_error_exception
     volatile int error;
 } pl_error_exception;
 
-/// A volatile global variable for storing exception frames.
-extern volatile pl_error_exception pl_error_exception_frames;
+/// A volatile thread-local variable for storing exception frames.
+/// @details Each thread has its own stack of exception frames.
+extern _Thread_local volatile pl_error_exception pl_error_exception_frames;
 
 /// Get the current error ID.
 #define pl_error_get_current() ((int){pl_error_exception_frames.error})
 
+// On BSD-derived systems `setjmp()` also saves the signal mask, which costs a system call.
+// Exceptions never change the signal mask, so it is skipped by `_setjmp()`.
+#if defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
+    #define pl_error_setjmp(frame) _setjmp(frame)
+    #define pl_error_longjmp(frame, value) _longjmp(frame, value)
+#else
+    #define pl_error_setjmp(frame) setjmp(frame)
+    #define pl_error_longjmp(frame, value) longjmp(frame, value)
+#endif
+
 /*-----------------------------------------------------------------------------
  |  Try
  ----------------------------------------------------------------------------*/
@@ -79,7 +93,7 @@ extern volatile pl_error_exception pl_error_exception_frames;
             previous_frame                  = pl_error_exception_frames.frame; \
             pl_error_exception_frames.frame = (jmp_buf *) (&new_frame);        \
             pl_error_exception_frames.error = PL_ERROR_NONE;                   \
-            if (setjmp(new_frame) == 0)                                        \
+            if (pl_error_setjmp(new_frame) == 0)                               \
             {                                                                  \
                 if (1)
 #endif//PL_ERROR_DISABLE
@@ -203,7 +217,11 @@ typedef struct pl_error_ns
 {
     /// Save error message to the global buffer.
     /// @NoException
-    /// @details The buffer will be reset if an encoding error occurred.
+    /// @details The arguments are stored and the message is only formatted when it is read
+    /// by `get_error_message` or the default error handler, so errors that are caught and
+    /// discarded cost no formatting. `format` must therefore outlive the message, which holds
+    /// for string literals. String arguments are copied. The buffer will be reset if an
+    /// encoding error occurred.
     /// @param error (int). The error ID.
     /// @param function_name (const char *). Function name.
     /// @param file_name (const char *). File name.
@@ -218,6 +236,18 @@ typedef struct pl_error_ns
                                      const char *format,
                                      ...);
 
+    /// Get the error message of the current thread.
+    /// @NoException
+    /// @details A pending message is formatted first.
+    /// @return The message buffer of the current thread.
+    const char *(*const get_error_message)(void);
+
+    /// Replace the error message of the current thread.
+    /// @NoException
+    /// @details Used to carry an error raised by another thread over to this thread.
+    /// @param message (const char *). A message previously saved by `save_error_message`.
+    void (*const restore_error_message)(const char *message);
+
     /// Attempt to perform a long jump because of an exception.
     /// @NoException
     /// @details This function will not perform a long jump if the
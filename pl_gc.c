@@ -5,21 +5,231 @@
 #include "pl_gc.h"
 #include "pl_class.h"
 #include "pl_error.h"
+#include "pthread.h"
+#include "sched.h"
 #include "stdarg.h"
+#include "stdint.h"
 #include "stdio.h"
 #include "stdlib.h"
 #include "string.h"
+#include "time.h"
 
-// A global pointer to the vector table.
-// It needs to be initialized by `gc_init` before use.
-static pl_object global_directly_reachable  = NULL;
-static pl_object global_reachable           = NULL;
-static pl_object global_reachable_unordered = NULL;
-static pl_object global_table               = NULL;
+#ifdef PL_TEST
+
+#include "pl_unittest.h"
+
+#endif//PL_TEST
+
+#if defined(PL_GC_HUGE_PAGES) && defined(__linux__)
+#include "sys/mman.h"
+#endif
+
+/// An open-addressing hash set of objects.
+/// @param slots (pl_object *). Slots of the set. A slot is either empty (NULL),
+/// a tombstone, or an object.
+/// @param capacity (int). Number of slots. Always a power of two.
+/// @param length (int). Number of objects stored in the set.
+/// @param tombstones (int). Number of tombstones left by removed objects.
+typedef struct object_set
+{
+    pl_object *slots;
+    int capacity;
+    int length;
+    int tombstones;
+} object_set;
+
+/// A free block of the pool allocator.
+/// @param next (struct pool_block *). Next free block of the same size class.
+typedef struct pool_block
+{
+    struct pool_block *next;
+} pool_block;
+
+/// A slab of the pool allocator. Blocks of one size class follow the slab header.
+/// @param next (struct pool_slab *). Next slab.
+typedef struct pool_slab
+{
+    struct pool_slab *next;
+} pool_slab;
+
+/// A growable array of objects.
+/// @param items (pl_object *). The items.
+/// @param capacity (int). Capacity of the array.
+/// @param length (int). Number of items in the array.
+typedef struct object_stack
+{
+    pl_object *items;
+    int capacity;
+    int length;
+} object_stack;
+
+/// A serialized object of a handoff. The data of the object follows the record.
+/// @param class (int). Class of the object.
+/// @param attribute (int). Index of the attribute in the handoff, -1 for NULL.
+/// @param length (long). Length of the object.
+/// @param size (long). Number of bytes of the data, padded to the granule.
+typedef struct handoff_record
+{
+    int class;
+    int attribute;
+    long length;
+    long size;
+} handoff_record;
+
+/// A serialized object graph. Records follow the header, the first one is the root.
+/// @param size (size_t). Number of bytes of the handoff, including the header.
+/// @param count (int). Number of records.
+struct pl_gc_handoff_struct
+{
+    size_t size;
+    int count;
+};
+
+/// A Chase-Lev work-stealing deque of objects. The owner pushes and pops at the bottom,
+/// other workers steal from the top. All fields are accessed with atomic builtins.
+/// @param buffer (pl_object *). Circular buffer of the deque.
+/// @param mask (long). Capacity of the buffer minus one. The capacity is a power of two.
+/// @param top (long). Index of the next object to steal.
+/// @param bottom (long). Index of the next free slot.
+typedef struct mark_deque
+{
+    pl_object *buffer;
+    long mask;
+    long top;
+    long bottom;
+} mark_deque;
+
+/// A worker of the parallel marker.
+/// @param context (struct mark_context *). Shared state of the marker.
+/// @param id (int). Index of the worker. Worker 0 runs on the collecting thread.
+/// @param deque (mark_deque). Objects to be explored, can be stolen by other workers.
+/// @param overflow (object_stack). Objects that do not fit in the deque. Only used by the owner.
+/// @param visited (object_stack). Marked untracked objects while marking, dead objects while sweeping.
+/// @param traced (size_t). Number of objects marked by the worker.
+/// @param thread (pthread_t). The thread running the worker.
+typedef struct mark_worker
+{
+    struct mark_context *context;
+    int id;
+    mark_deque deque;
+    object_stack overflow;
+    object_stack visited;
+    size_t traced;
+    pthread_t thread;
+} mark_worker;
+
+/// Shared state of the parallel marker. The heap is thread-local, so workers access it through the context.
+/// @param roots (object_set *). The directly reachable objects of the collecting thread.
+/// @param remembered (object_stack *). The remembered set of the collecting thread.
+/// @param table (object_set *). The object table of the collecting thread.
+/// @param workers (mark_worker *). All the workers.
+/// @param num_workers (int). Number of workers.
+/// @param minor (int). Whether it is a minor collection.
+/// @param started (int). Set once all the workers are created.
+/// @param active (int). Number of workers that may still have work.
+/// @param failed (int). Set if any worker fails to grow a stack.
+typedef struct mark_context
+{
+    object_set *roots;
+    object_stack *remembered;
+    object_set *table;
+    struct mark_worker *workers;
+    int num_workers;
+    int minor;
+    int started;
+    int active;
+    int failed;
+} mark_context;
+
+/// A chunk of a bump arena.
+/// @param next (struct arena_chunk *). Previous chunk of the arena.
+/// @param size (size_t). Number of usable bytes after the chunk header.
+typedef struct arena_chunk
+{
+    struct arena_chunk *next;
+    size_t size;
+} arena_chunk;
+
+/// A bump arena owned by an arena frame.
+/// @param chunks (arena_chunk *). Chunks of the arena, newest first.
+/// @param cursor (char *). Next free byte of the newest chunk.
+/// @param remaining (size_t). Number of free bytes after the cursor.
+/// @param objects (object_stack). Objects allocated in the arena.
+/// @param escaped (object_stack). Objects that need to outlive the arena.
+typedef struct arena
+{
+    arena_chunk *chunks;
+    char *cursor;
+    size_t remaining;
+    object_stack objects;
+    object_stack escaped;
+} arena;
+
+// All the state of the garbage collector is thread-local, so each thread owns a separate heap.
+// Objects can only move between heaps via `export_graph` and `import_graph`.
+
+// Global sets of objects. The table holds the old generation.
+// They will be initialized by `init_set` before use.
+static _Thread_local object_set global_directly_reachable = {0};
+static _Thread_local object_set global_table              = {0};
+
+// The young generation (nursery) and the remembered set. The remembered set holds
+// old objects that may refer to young objects. Both are only compacted by collections.
+static _Thread_local object_stack global_nursery    = {0};
+static _Thread_local object_stack global_remembered = {0};
+
+// The mark stack and the list of marked objects that are not recorded by the table.
+// Both are kept between collections to avoid reallocation.
+static _Thread_local object_stack global_mark_stack = {0};
+static _Thread_local object_stack global_untracked  = {0};
+
+// Removed objects leave a tombstone in the slot so that probing can continue past it.
+static pl_object_struct set_tombstone_object = {0};
+#define SET_TOMBSTONE (&set_tombstone_object)
+
+// Initial number of slots of a set.
+#define SET_INIT_CAPACITY 16
+
+// Size classes of the pool allocator. Blocks are multiples of the granule, up to the maximum block size.
+// Larger payloads are allocated by `malloc()`.
+#define POOL_GRANULE 16
+#define POOL_MAX_BLOCK 256
+#define POOL_NUM_CLASS (POOL_MAX_BLOCK / POOL_GRANULE)
+#define POOL_SLAB_SIZE ((size_t) 64 << 10)
+
+// Free lists of each size class, and all slabs owned by the pool.
+static _Thread_local pool_block *global_pool_free[POOL_NUM_CLASS] = {0};
+static _Thread_local pool_slab *global_pool_slabs                 = NULL;
+
+// Arenas of the active arena frames. The innermost frame is at `global_arena_depth - 1`.
+#define ARENA_CHUNK_SIZE ((size_t) 64 << 10)
+static _Thread_local arena global_arenas[PL_GC_MAX_ARENA_DEPTH] = {0};
+static _Thread_local int global_arena_depth                     = 0;
+
+// Scheduler state. Bytes are counted for objects tracked by the garbage collector.
+static _Thread_local size_t global_live_bytes     = 0;
+static _Thread_local size_t global_young_bytes    = 0;
+static _Thread_local size_t global_promoted_bytes = 0;
+static _Thread_local size_t global_budget_bytes   = PL_GC_DEFAULT_THRESHOLD;
+static _Thread_local size_t global_threshold      = PL_GC_DEFAULT_THRESHOLD;
+static _Thread_local size_t global_nursery_size   = PL_GC_DEFAULT_NURSERY_SIZE;
+static _Thread_local double global_growth_factor  = PL_GC_DEFAULT_GROWTH_FACTOR;
+static _Thread_local int global_promotion_age     = PL_GC_DEFAULT_PROMOTION_AGE;
+static _Thread_local int global_auto              = 1;
+static _Thread_local int global_parallelism       = 1;
+static _Thread_local int global_frame_depth       = 0;
+
+// Statistics and the hook of this thread.
+static _Thread_local pl_gc_stats global_stats            = {0};
+static _Thread_local pl_gc_hook global_hook              = NULL;
+static _Thread_local void *global_hook_context           = NULL;
+static _Thread_local size_t global_large_allocation_size = PL_GC_DEFAULT_LARGE_ALLOCATION_SIZE;
 
 static void delete_object(pl_object x);
-static void init_table(pl_object *table_p);
-static void table_record_object(pl_object table, pl_object x);
+static void detach_object(pl_object x);
+static void init_set(object_set *set);
+static void set_record_object(object_set *set, pl_object x);
+static int stack_push(object_stack *stack, pl_object x);
 
 #define check_null_pointer(x) pl_error_expect((x) != NULL,                      \
                                               PL_ERROR_UNEXPECTED_NULL_POINTER, \
@@ -29,6 +239,554 @@ static void table_record_object(pl_object table, pl_object x);
                                                PL_ERROR_INVALID_NA, \
                                                "Unexpected missing value `" #x "` !")
 
+// Besides the items of a list, the only reference an object holds is the byte buffer of a string.
+// NULL for other types or strings without a buffer.
+#define string_bytes(x) \
+    (pl_object_type(x) == PL_CLASS_STRING ? pl_object_string_bytes((x)->data) : NULL)
+
+/*-----------------------------------------------------------------------------
+ |  Pool allocator
+ ----------------------------------------------------------------------------*/
+
+// Size class of a block of `size` bytes. `size` should be in (0, POOL_MAX_BLOCK].
+#define pool_class(size) ((int) (((size) + POOL_GRANULE - 1) / POOL_GRANULE) - 1)
+
+// Size of the blocks of a size class.
+#define pool_class_size(class) ((size_t) ((class) + 1) * POOL_GRANULE)
+
+// Allocate a block of at least `size` bytes. Returns NULL if `malloc()` fails.
+static void *pool_alloc(const size_t size)
+{
+    const int class = pool_class(size);
+
+    // Carve a new slab into free blocks if the free list is empty.
+    if (global_pool_free[class] == NULL)
+    {
+        pool_slab *slab = malloc(POOL_SLAB_SIZE);
+        if (slab == NULL)
+            return NULL;
+        slab->next        = global_pool_slabs;
+        global_pool_slabs = slab;
+
+        // Blocks start after the slab header, keeping the alignment of the granule.
+        const size_t block_size = pool_class_size(class);
+        char *const blocks      = (char *) slab + POOL_GRANULE;
+        const size_t num_blocks = (POOL_SLAB_SIZE - POOL_GRANULE) / block_size;
+        for (size_t i = num_blocks; i > 0; i--)
+        {
+            pool_block *block       = (pool_block *) (blocks + (i - 1) * block_size);
+            block->next             = global_pool_free[class];
+            global_pool_free[class] = block;
+        }
+    }
+
+    pool_block *block       = global_pool_free[class];
+    global_pool_free[class] = block->next;
+    return block;
+}
+
+// Return a block of `size` bytes to its free list.
+static void pool_free(void *const block, const size_t size)
+{
+    const int class              = pool_class(size);
+    ((pool_block *) block)->next = global_pool_free[class];
+    global_pool_free[class]      = block;
+}
+
+// Release all slabs. Every block allocated by the pool becomes invalid.
+static void pool_kill(void)
+{
+    while (global_pool_slabs != NULL)
+    {
+        pool_slab *next = global_pool_slabs->next;
+        free(global_pool_slabs);
+        global_pool_slabs = next;
+    }
+    memset(global_pool_free, 0, sizeof(global_pool_free));
+}
+
+#ifdef PL_GC_HUGE_PAGES
+
+// Check if a buffer of `size` bytes is aligned to huge pages.
+#define data_is_huge(size) ((size) >= PL_GC_HUGE_PAGE_MIN_SIZE)
+
+// Allocate a buffer aligned to huge pages, and ask the kernel to back it by huge pages.
+static void *huge_alloc(const size_t size)
+{
+    const size_t aligned_size = (size + PL_GC_HUGE_PAGE_SIZE - 1) & ~(PL_GC_HUGE_PAGE_SIZE - 1);
+    void *const data          = aligned_alloc(PL_GC_HUGE_PAGE_SIZE, aligned_size);
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (data != NULL)
+        madvise(data, aligned_size, MADV_HUGEPAGE);
+#endif
+    return data;
+}
+
+#else
+
+#define data_is_huge(size) 0
+
+#endif
+
+// Allocate a data buffer. Small buffers come from the pool, large buffers come from `malloc()`.
+// With `PL_GC_HUGE_PAGES`, buffers of multiple huge pages are aligned to huge pages.
+static void *data_alloc(const size_t size)
+{
+#ifdef PL_GC_HUGE_PAGES
+    if (data_is_huge(size))
+        return huge_alloc(size);
+#endif
+    return size <= POOL_MAX_BLOCK ? pool_alloc(size) : malloc(size);
+}
+
+// Free a data buffer allocated by `data_alloc`.
+static void data_free(void *const data, const size_t size)
+{
+    if (size <= POOL_MAX_BLOCK)
+        pool_free(data, size);
+    else
+        free(data);
+}
+
+// Check if the data of an object is stored right after its header.
+#define data_is_inline(x) ((x)->flags & PL_OBJECT_FLAG_INLINE)
+
+// Size of the block holding the header of an object.
+#define header_block_size(x) pool_class_size(((x)->flags & PL_OBJECT_BLOCK_MASK) >> PL_OBJECT_BLOCK_SHIFT)
+
+/*-----------------------------------------------------------------------------
+ |  Shared buffer
+ ----------------------------------------------------------------------------*/
+
+// A data buffer shared by several objects. Objects sharing a buffer point to `buffer` and
+// their data points into `data`. The buffer is freed when the last object releases it,
+// unless it is owned by someone else, in which case `release` is called with `context`.
+// Objects are only deleted by the thread owning the heap, so the count needs no atomics.
+typedef struct shared_buffer
+{
+    long references;
+    size_t size;
+    void *data;
+    void (*release)(void *context);
+    void *context;
+} shared_buffer;
+
+// Slices smaller than this are copied, since the copy is as cheap as a shared header.
+#define SHARED_MIN_BYTES POOL_MAX_BLOCK
+
+// Drop a reference to a shared buffer.
+static void release_buffer(shared_buffer *const buffer)
+{
+    buffer->references--;
+    if (buffer->references == 0)
+    {
+        if (buffer->release != NULL)
+            buffer->release(buffer->context);
+        else
+            data_free(buffer->data, buffer->size);
+        pool_free(buffer, sizeof(shared_buffer));
+    }
+}
+
+/*-----------------------------------------------------------------------------
+ |  Bump arena
+ ----------------------------------------------------------------------------*/
+
+// Allocate `size` bytes from an arena. Returns NULL if `malloc()` fails.
+static void *arena_alloc(arena *const a, size_t size)
+{
+    // Keep the alignment of the granule.
+    size = (size + POOL_GRANULE - 1) / POOL_GRANULE * POOL_GRANULE;
+
+    if (size > a->remaining)
+    {
+        // Large requests get a dedicated chunk.
+        const size_t chunk_size = size > ARENA_CHUNK_SIZE ? size : ARENA_CHUNK_SIZE;
+        arena_chunk *chunk      = malloc(POOL_GRANULE + chunk_size);
+        if (chunk == NULL)
+            return NULL;
+
+        chunk->next  = a->chunks;
+        chunk->size  = chunk_size;
+        a->chunks    = chunk;
+        a->cursor    = (char *) chunk + POOL_GRANULE;
+        a->remaining = chunk_size;
+    }
+
+    void *mem = a->cursor;
+    a->cursor += size;
+    a->remaining -= size;
+    return mem;
+}
+
+// Release all chunks of an arena but the newest one, which is kept for the next arena frame.
+static void arena_reset(arena *const a)
+{
+    if (a->chunks == NULL)
+        return;
+
+    arena_chunk *chunk = a->chunks->next;
+    while (chunk != NULL)
+    {
+        arena_chunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+
+    a->chunks->next = NULL;
+    a->cursor       = (char *) a->chunks + POOL_GRANULE;
+    a->remaining    = a->chunks->size;
+}
+
+/*-----------------------------------------------------------------------------
+ |  Allocation profile
+ ----------------------------------------------------------------------------*/
+
+#ifdef PL_GC_PROFILE
+
+/// An allocation site.
+/// @param file (const char *). File name.
+/// @param line (int). The line number.
+/// @param function (const char *). Function name.
+/// @param objects (size_t). Number of objects created.
+/// @param bytes (size_t). Bytes of objects created, plus the growth of resizes.
+/// @param live (size_t). Number of objects alive. It is kept by `profile_reset`.
+/// @param survived (size_t). Number of objects surviving their first collection.
+/// @param died (size_t). Number of objects deleted by their first collection.
+typedef struct profile_site
+{
+    const char *file;
+    int line;
+    const char *function;
+    size_t objects;
+    size_t bytes;
+    size_t live;
+    size_t survived;
+    size_t died;
+} profile_site;
+
+// Sites of this thread, found by an open-addressing table of their indices. Objects
+// refer to their sites by index, so sites are never moved or removed until `kill`.
+static _Thread_local profile_site *global_profile_sites = NULL;
+static _Thread_local int global_profile_num_sites       = 0;
+static _Thread_local int global_profile_capacity        = 0;
+static _Thread_local int *global_profile_slots          = NULL;
+static _Thread_local int global_profile_depth           = 0;
+static _Thread_local int global_profile_current         = -1;
+
+#define PROFILE_UNKNOWN "<unknown>"
+
+// Slot of a site in a table of `num_slots` slots.
+static int profile_slot(const int *const slots, const int num_slots, const char *const file, const int line, const char *const function)
+{
+    const uint64_t key = (uint64_t) (uintptr_t) file ^ ((uint64_t) (uintptr_t) function << 1) ^ (uint64_t) line;
+    int slot           = (int) ((key * 0x9E3779B97F4A7C15u) >> 40) & (num_slots - 1);
+    while (slots[slot] != -1)
+    {
+        const profile_site *const site = global_profile_sites + slots[slot];
+        if (site->file == file && site->line == line && site->function == function)
+            break;
+        slot = (slot + 1) & (num_slots - 1);
+    }
+    return slot;
+}
+
+// Find or add a site. Returns -1 if the tables fail to grow, in which case nothing is recorded.
+static int profile_find(const char *const file, const int line, const char *const function)
+{
+    // The table has twice as many slots as the capacity of sites, so it is never full.
+    if (global_profile_slots != NULL)
+    {
+        const int slot = profile_slot(global_profile_slots, global_profile_capacity * 2, file, line, function);
+        if (global_profile_slots[slot] != -1)
+            return global_profile_slots[slot];
+    }
+
+    if (global_profile_num_sites == global_profile_capacity)
+    {
+        const int capacity = global_profile_capacity == 0 ? 64 : global_profile_capacity * 2;
+        profile_site *sites = realloc(global_profile_sites, (size_t) capacity * sizeof(profile_site));
+        if (sites == NULL)
+            return -1;
+        global_profile_sites = sites;
+
+        int *slots = malloc((size_t) capacity * 2 * sizeof(int));
+        if (slots == NULL)
+            return -1;
+        pl_misc_for_i(capacity * 2) slots[i] = -1;
+        pl_misc_for_i(global_profile_num_sites)
+        {
+            const profile_site *const site = sites + i;
+            slots[profile_slot(slots, capacity * 2, site->file, site->line, site->function)] = (int) i;
+        }
+        free(global_profile_slots);
+        global_profile_slots    = slots;
+        global_profile_capacity = capacity;
+    }
+
+    const int index             = global_profile_num_sites++;
+    global_profile_sites[index] = (profile_site) {.file = file, .line = line, .function = function};
+    global_profile_slots[profile_slot(global_profile_slots, global_profile_capacity * 2, file, line, function)] = index;
+    return index;
+}
+
+static void profile_enter(const char *const file, const int line, const char *const function)
+{
+    // Nested expressions are attributed to the outermost one, which is the call site in user code.
+    if (global_profile_depth++ == 0)
+        global_profile_current = profile_find(file, line, function);
+}
+
+static pl_object profile_leave(pl_object x)
+{
+    if (global_profile_depth > 0)
+        global_profile_depth--;
+    return x;
+}
+
+// No expression is profiled at a safe point. This drops the sites left open by exceptions.
+static void profile_safe_point(void)
+{
+    global_profile_depth = 0;
+}
+
+static void profile_new_object(pl_object x)
+{
+    x->site = global_profile_depth > 0 ? global_profile_current : profile_find(PROFILE_UNKNOWN, 0, PROFILE_UNKNOWN);
+    if (x->site == -1)
+        return;
+    global_profile_sites[x->site].objects++;
+    global_profile_sites[x->site].live++;
+    global_profile_sites[x->site].bytes += pl_object_size(x);
+}
+
+// Growth is attributed to the site causing it, or to the site of the object outside profiled expressions.
+static void profile_grown_object(pl_object x, const size_t bytes)
+{
+    const int site = global_profile_depth > 0 ? global_profile_current : x->site;
+    if (site != -1)
+        global_profile_sites[site].bytes += bytes;
+}
+
+static void profile_deleted_object(pl_object x)
+{
+    if (x->site != -1)
+        global_profile_sites[x->site].live--;
+}
+
+// Objects in the nursery with age 0 meet their first collection.
+static void profile_first_collection(pl_object x, const int survived)
+{
+    if (x->site == -1 || pl_object_age(x) != 0)
+        return;
+    if (survived)
+        global_profile_sites[x->site].survived++;
+    else
+        global_profile_sites[x->site].died++;
+}
+
+static int profile_compare_bytes(const void *const a, const void *const b)
+{
+    const size_t x = global_profile_sites[*(const int *) a].bytes;
+    const size_t y = global_profile_sites[*(const int *) b].bytes;
+    return (x < y) - (x > y);
+}
+
+static void profile_report(FILE *const stream)
+{
+    check_null_pointer(stream);
+
+    int *const order = malloc((size_t) (global_profile_num_sites > 0 ? global_profile_num_sites : 1) * sizeof(int));
+    pl_error_expect(order != NULL, PL_ERROR_ALLOC_FAILED, "`malloc()` fails!");
+    pl_misc_for_i(global_profile_num_sites) order[i] = (int) i;
+    qsort(order, (size_t) global_profile_num_sites, sizeof(int), profile_compare_bytes);
+
+    fprintf(stream, "Allocation sites by bytes:\n");
+    fprintf(stream, "\t│ %-14s │ %-10s │ %-10s │ %-8s │ %s\n", "Bytes", "Objects", "Live", "Survival", "Site");
+    pl_misc_for_i(global_profile_num_sites)
+    {
+        const profile_site *const site = global_profile_sites + order[i];
+        const size_t first             = site->survived + site->died;
+        char survival[16]              = "-";
+        if (first > 0)
+            snprintf(survival, sizeof(survival), "%.1f%%", 100.0 * (double) site->survived / (double) first);
+        fprintf(stream,
+                "\t│ %-14zu │ %-10zu │ %-10zu │ %-8s │ %s (%s:%d)\n",
+                site->bytes,
+                site->objects,
+                site->live,
+                survival,
+                site->function,
+                site->file,
+                site->line);
+    }
+    free(order);
+}
+
+// Counters are cleared but the number of live objects. The sites are kept since live objects refer to them.
+static void profile_reset(void)
+{
+    pl_misc_for_i(global_profile_num_sites)
+    {
+        profile_site *const site = global_profile_sites + i;
+        *site                    = (profile_site) {.file     = site->file,
+                                                    .line     = site->line,
+                                                    .function = site->function,
+                                                    .live     = site->live};
+    }
+}
+
+static void profile_kill(void)
+{
+    free(global_profile_sites);
+    free(global_profile_slots);
+    global_profile_sites     = NULL;
+    global_profile_slots     = NULL;
+    global_profile_num_sites = 0;
+    global_profile_capacity  = 0;
+    global_profile_depth     = 0;
+    global_profile_current   = -1;
+}
+
+#else
+
+#define profile_safe_point() ((void) 0)
+#define profile_new_object(x) ((void) 0)
+#define profile_grown_object(x, bytes) ((void) 0)
+#define profile_deleted_object(x) ((void) 0)
+#define profile_first_collection(x, survived) ((void) 0)
+#define profile_kill() ((void) 0)
+
+#endif//PL_GC_PROFILE
+
+/*-----------------------------------------------------------------------------
+ |  Statistics
+ ----------------------------------------------------------------------------*/
+
+// Pass an event to the hook, if any.
+static void notify(const pl_gc_event *const event)
+{
+    if (global_hook != NULL)
+        global_hook(event, global_hook_context);
+}
+
+// Report an allocation of `data_size` bytes of data if it is large.
+static void notify_allocation(pl_object x, const size_t data_size)
+{
+    if (global_hook == NULL || data_size < global_large_allocation_size)
+        return;
+
+    pl_gc_event event = {.type       = PL_GC_EVENT_LARGE_ALLOCATION,
+                         .live_bytes = global_stats.live_bytes,
+                         .object     = x,
+                         .bytes      = data_size};
+    notify(&event);
+}
+
+// Count a created object.
+static void count_new_object(pl_object x)
+{
+    const size_t size = pl_object_size(x);
+    global_stats.objects_allocated++;
+    global_stats.bytes_allocated += size;
+    global_stats.live_objects++;
+    global_stats.live_bytes += size;
+    global_stats.class_objects[x->class]++;
+    global_stats.class_bytes[x->class] += size;
+    if (global_stats.live_bytes > global_stats.peak_live_bytes)
+        global_stats.peak_live_bytes = global_stats.live_bytes;
+    profile_new_object(x);
+}
+
+// Count a resize of the data of an object from `old_size` to `new_size` bytes.
+static void count_resized_object(pl_object x, const size_t old_size, const size_t new_size)
+{
+    if (new_size >= old_size)
+    {
+        global_stats.bytes_allocated += new_size - old_size;
+        global_stats.live_bytes += new_size - old_size;
+        global_stats.class_bytes[x->class] += new_size - old_size;
+        if (global_stats.live_bytes > global_stats.peak_live_bytes)
+            global_stats.peak_live_bytes = global_stats.live_bytes;
+        profile_grown_object(x, new_size - old_size);
+    }
+    else
+    {
+        global_stats.bytes_freed += old_size - new_size;
+        global_stats.live_bytes -= old_size - new_size;
+        global_stats.class_bytes[x->class] -= old_size - new_size;
+    }
+}
+
+// Count a deleted object.
+static void count_deleted_object(pl_object x)
+{
+    const size_t size = pl_object_size(x);
+    global_stats.objects_freed++;
+    global_stats.bytes_freed += size;
+    global_stats.live_objects--;
+    global_stats.live_bytes -= size;
+    global_stats.class_objects[x->class]--;
+    global_stats.class_bytes[x->class] -= size;
+    profile_deleted_object(x);
+}
+
+// Pauses are measured by a monotonic clock, so they are never negative.
+static double gc_clock(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double) time.tv_sec + (double) time.tv_nsec * 1e-9;
+}
+
+/// Counters at the beginning of a collection.
+/// @param major (int). Whether the collection is major.
+/// @param time (double). Time of the beginning.
+/// @param objects_traced (size_t). `objects_traced` of the statistics.
+/// @param objects_freed (size_t). `objects_freed` of the statistics.
+/// @param bytes_freed (size_t). `bytes_freed` of the statistics.
+typedef struct collection_start
+{
+    int major;
+    double time;
+    size_t objects_traced;
+    size_t objects_freed;
+    size_t bytes_freed;
+} collection_start;
+
+static collection_start begin_collection(const int major)
+{
+    pl_gc_event event = {.type = PL_GC_EVENT_COLLECT_BEGIN, .major = major, .live_bytes = global_stats.live_bytes};
+    notify(&event);
+
+    return (collection_start) {.major          = major,
+                               .time           = gc_clock(),
+                               .objects_traced = global_stats.objects_traced,
+                               .objects_freed  = global_stats.objects_freed,
+                               .bytes_freed    = global_stats.bytes_freed};
+}
+
+static void end_collection(const collection_start *const start)
+{
+    const double pause = gc_clock() - start->time;
+    if (start->major)
+        global_stats.major_collections++;
+    else
+        global_stats.minor_collections++;
+    global_stats.total_pause_seconds += pause;
+    if (pause > global_stats.max_pause_seconds)
+        global_stats.max_pause_seconds = pause;
+
+    pl_gc_event event = {.type           = PL_GC_EVENT_COLLECT_END,
+                         .major          = start->major,
+                         .pause_seconds  = pause,
+                         .objects_traced = global_stats.objects_traced - start->objects_traced,
+                         .objects_freed  = global_stats.objects_freed - start->objects_freed,
+                         .bytes_freed    = global_stats.bytes_freed - start->bytes_freed,
+                         .live_bytes     = global_stats.live_bytes};
+    notify(&event);
+}
+
 /*-----------------------------------------------------------------------------
  |  Object memory management
  ----------------------------------------------------------------------------*/
@@ -37,7 +795,7 @@ static void table_record_object(pl_object table, pl_object x);
  |  New object
  ----------------------------------------------------------------------------*/
 
-static pl_object new_object_without_recording(const int class, const int capacity)
+static pl_object new_object_without_recording(const int class, const long capacity)
 {
     check_missing_value(class);
     check_missing_value(capacity);
@@ -47,480 +805,2177 @@ static pl_object new_object_without_recording(const int class, const int capacit
 
     pl_error_expect(capacity > 0 && capacity <= PL_OBJECT_MAX_CAPACITY,
                     PL_ERROR_INVALID_CAPACITY,
-                    "Invalid capacity [%d]!", capacity);
+                    "Invalid capacity [%ld]!", capacity);
 
-    // Allocate memory for the object and the data.
-    void *object_mem      = NULL;
-    void *object_data_mem = NULL;
-    object_mem            = malloc(sizeof(pl_object_struct));
-    object_data_mem       = malloc(pl_object_data_size(class, capacity));
+    // Small payloads are stored inline, right after the header, in one pool block.
+    // Otherwise, the header and the data are allocated separately.
+    const size_t data_size   = pl_object_data_size(class, capacity);
+    const size_t inline_size = sizeof(pl_object_struct) + data_size;
+    const size_t block_size  = inline_size <= POOL_MAX_BLOCK ? inline_size : sizeof(pl_object_struct);
 
-    pl_error_try
+    void *object_mem = pool_alloc(block_size);
+    pl_error_expect(object_mem != NULL, PL_ERROR_ALLOC_FAILED, "`malloc()` fails!");
+
+    void *object_data_mem = (char *) object_mem + sizeof(pl_object_struct);
+    int flags             = pool_class(block_size) << PL_OBJECT_BLOCK_SHIFT;
+    if (inline_size <= POOL_MAX_BLOCK)
     {
-        pl_error_expect(object_mem != NULL, PL_ERROR_ALLOC_FAILED, "`malloc()` fails!");
-        pl_error_expect(object_data_mem != NULL, PL_ERROR_ALLOC_FAILED, "`malloc()` fails!");
+        flags |= PL_OBJECT_FLAG_INLINE;
     }
-    pl_error_catch
+    else if (global_arena_depth > 0)
+    {
+        // Data of objects allocated in an arena frame comes from the bump arena.
+        object_data_mem = arena_alloc(&global_arenas[global_arena_depth - 1], data_size);
+        if (object_data_mem == NULL)
+        {
+            pool_free(object_mem, block_size);
+            pl_error_throw(PL_ERROR_ALLOC_FAILED, "`malloc()` fails!");
+        }
+        flags |= PL_OBJECT_FLAG_ARENA_DATA;
+    }
+    else
+    {
+        object_data_mem = data_alloc(data_size);
+        if (object_data_mem == NULL)
+        {
+            pool_free(object_mem, block_size);
+            pl_error_throw(PL_ERROR_ALLOC_FAILED, "`malloc()` fails!");
+        }
+    }
+
+    pl_object object = object_mem;
+
+    // Prepare the metadata struct.
+    pl_object_struct object_struct_copy = {.class     = class,
+                                           .capacity  = capacity,
+                                           .length    = 0,
+                                           .flags     = flags,
+                                           .attribute = NULL,
+                                           .data      = object_data_mem};
+
+    // Copy it to the allocated metadata memory.
+    memcpy(object, &object_struct_copy, sizeof(pl_object_struct));
+    if (pl_class_get_ns().type(class) == PL_CLASS_STRING)
+        pl_object_string_bytes(object->data) = NULL;
+    count_new_object(object);
+    notify_allocation(object, data_size);
+
+    return object;
+}
+
+
+// Record a new object to the innermost arena or the nursery. The object is deleted if it fails to be recorded.
+static void record_new_object(pl_object object)
+{
+    // Objects created in an arena frame belong to the innermost arena and are not
+    // tracked by the garbage collector.
+    if (global_arena_depth > 0)
+    {
+        object->flags |= global_arena_depth << PL_OBJECT_ARENA_SHIFT;
+        if (!stack_push(&global_arenas[global_arena_depth - 1].objects, object))
+        {
+            delete_object(object);
+            pl_error_throw(PL_ERROR_ALLOC_FAILED, "`realloc()` fails!");
+        }
+        return;
+    }
+
+    // New objects are born in the nursery.
+    // If the object fails to be recorded, delete the object.
+    if (!stack_push(&global_nursery, object))
+    {
+        delete_object(object);
+        pl_error_throw(PL_ERROR_ALLOC_FAILED, "`realloc()` fails!");
+    }
+    object->flags |= PL_OBJECT_FLAG_TRACKED;
+
+    // Account the allocation for the scheduler.
+    const size_t size = pl_object_size(object);
+    global_live_bytes += size;
+    global_young_bytes += size;
+}
+
+static pl_object new_object(const int class, const long capacity)
+{
+    // Init the global table.
+    init_set(&global_table);
+
+    // Create a new object.
+    pl_object object = new_object_without_recording(class, capacity);
+    record_new_object(object);
+    return object;
+}
+
+/*-----------------------------------------------------------------------------
+ |  New shared object
+ ----------------------------------------------------------------------------*/
+
+// New an object whose data points into a shared buffer. The header is the only allocation.
+static pl_object new_shared_object(const int class, const long length, void *const data, shared_buffer *const buffer)
+{
+    void *object_mem = pool_alloc(sizeof(pl_object_struct));
+    pl_error_expect(object_mem != NULL, PL_ERROR_ALLOC_FAILED, "`malloc()` fails!");
+
+    pl_object object                    = object_mem;
+    pl_object_struct object_struct_copy = {.class     = class,
+                                           .capacity  = length,
+                                           .length    = length,
+                                           .flags     = pool_class(sizeof(pl_object_struct)) << PL_OBJECT_BLOCK_SHIFT,
+                                           .attribute = NULL,
+                                           .data      = data,
+                                           .buffer    = buffer};
+    memcpy(object, &object_struct_copy, sizeof(pl_object_struct));
+    buffer->references++;
+    count_new_object(object);
+
+    record_new_object(object);
+    return object;
+}
+
+/*-----------------------------------------------------------------------------
+ |  Slice object
+ ----------------------------------------------------------------------------*/
+
+static pl_object slice_object(pl_object x, const long start, const long length)
+{
+    check_null_pointer(x);
+    check_missing_value(start);
+    check_missing_value(length);
+    pl_error_expect(start >= 0 && length >= 0 && start + length <= x->length,
+                    PL_ERROR_INDEX_OUT_OF_BOUND,
+                    "Range [%ld, %ld) out of bound [0, %ld)!",
+                    start,
+                    start + length,
+                    x->length);
+
+    // Booleans are packed, so only slices starting on a block boundary are contiguous.
+    if (x->class == PL_CLASS_BOOL && start % PL_OBJECT_BOOL_BLOCK != 0)
+    {
+        pl_object object = new_object(x->class, length > 0 ? length : 1);
+        pl_misc_for_i(length) pl_object_bool_set(object->data, i, pl_object_bool_get(x->data, start + i));
+        object->length = length;
+        return object;
+    }
+
+    // The pointer to the byte buffer of a string comes first, so the items are copied.
+    // The slice shares the byte buffer, which is never written in place.
+    if (pl_object_type(x) == PL_CLASS_STRING)
+    {
+        pl_object object                     = new_object(x->class, length > 0 ? length : 1);
+        pl_object_string_bytes(object->data) = pl_object_string_bytes(x->data);
+        memcpy(pl_object_string_items(object->data),
+               pl_object_string_items(x->data) + start,
+               (size_t) length * sizeof(pl_object_string_item));
+        object->length = length;
+        return object;
+    }
+    void *const start_data = (char *) x->data + pl_object_data_size(x->class, start);
+
+    // Only data allocated by the collector can be shared. Inline data, arena data and data of
+    // local objects can't outlive their objects. Small slices are cheap to copy anyway.
+    const int sharable = x->buffer != NULL || ((x->flags & PL_OBJECT_FLAG_TRACKED) && !data_is_inline(x));
+    if (!sharable || pl_object_data_size(x->class, length) <= SHARED_MIN_BYTES)
+    {
+        pl_object object = new_object(x->class, length > 0 ? length : 1);
+        memcpy(object->data, start_data, pl_object_data_size(x->class, length));
+        object->length = length;
+        return object;
+    }
+
+    init_set(&global_table);
+
+    // The data of x becomes a shared buffer on its first slice.
+    if (x->buffer == NULL)
+    {
+        shared_buffer *buffer = pool_alloc(sizeof(shared_buffer));
+        pl_error_expect(buffer != NULL, PL_ERROR_ALLOC_FAILED, "`malloc()` fails!");
+        buffer->references = 1;
+        buffer->size       = pl_object_data_size(x->class, x->capacity);
+        buffer->data       = x->data;
+        buffer->release    = NULL;
+        buffer->context    = NULL;
+        x->buffer          = buffer;
+    }
+
+    return new_shared_object(x->class, length, start_data, x->buffer);
+}
+
+/*-----------------------------------------------------------------------------
+ |  Detach object
+ ----------------------------------------------------------------------------*/
+
+static void detach_object(pl_object x)
+{
+    check_null_pointer(x);
+
+    shared_buffer *const buffer = x->buffer;
+    if (buffer == NULL)
+        return;
+
+    // The last owner of a whole buffer takes it back, unless the buffer is owned by someone else.
+    const size_t size = pl_object_data_size(x->class, x->capacity);
+    if (buffer->references == 1 && buffer->data == x->data && buffer->size == size && buffer->release == NULL)
+    {
+        pool_free(buffer, sizeof(shared_buffer));
+        x->buffer = NULL;
+        return;
+    }
+
+    void *data_mem = data_alloc(size);
+    pl_error_expect(data_mem != NULL, PL_ERROR_ALLOC_FAILED, "`malloc()` fails!");
+    memcpy(data_mem, x->data, pl_object_data_size(x->class, x->length));
+
+    x->data   = data_mem;
+    x->buffer = NULL;
+    release_buffer(buffer);
+}
+
+/*-----------------------------------------------------------------------------
+ |  Resize object
+ ----------------------------------------------------------------------------*/
+
+static void resize_object(pl_object x, const long capacity)
+{
+    check_null_pointer(x);
+    check_missing_value(capacity);
+    pl_error_expect(capacity > 0 && capacity <= PL_OBJECT_MAX_CAPACITY,
+                    PL_ERROR_INVALID_CAPACITY,
+                    "Invalid capacity [%ld]!",
+                    capacity);
+
+    // Shared data is never resized in place.
+    detach_object(x);
+
+    const size_t old_size = pl_object_data_size(x->class, x->capacity);
+    const size_t new_size = pl_object_data_size(x->class, capacity);
+    void *data_mem        = x->data;
+
+    if (pl_object_arena_depth(x) > 0 &&
+        (!data_is_inline(x) || new_size > header_block_size(x) - sizeof(pl_object_struct)))
+    {
+        // Objects of an arena frame grow within their arena. The old buffer is released with the arena.
+        data_mem = arena_alloc(&global_arenas[pl_object_arena_depth(x) - 1], new_size);
+        pl_error_expect(data_mem != NULL, PL_ERROR_ALLOC_FAILED, "`malloc()` fails!");
+        memcpy(data_mem, x->data, old_size < new_size ? old_size : new_size);
+        x->flags = (x->flags & ~PL_OBJECT_FLAG_INLINE) | PL_OBJECT_FLAG_ARENA_DATA;
+    }
+    else if (data_is_inline(x))
+    {
+        // Inline data stays in place while it fits in the header block.
+        // Otherwise, it migrates to a separate buffer and the header block keeps its size.
+        if (new_size > header_block_size(x) - sizeof(pl_object_struct))
+        {
+            data_mem = data_alloc(new_size);
+            pl_error_expect(data_mem != NULL, PL_ERROR_ALLOC_FAILED, "`malloc()` fails!");
+            memcpy(data_mem, x->data, old_size < new_size ? old_size : new_size);
+            x->flags &= ~PL_OBJECT_FLAG_INLINE;
+        }
+    }
+    else if (old_size > POOL_MAX_BLOCK && new_size > POOL_MAX_BLOCK && !data_is_huge(old_size) && !data_is_huge(new_size))
+    {
+        // Realloc memory block for the data.
+        data_mem = realloc(x->data, new_size);
+        pl_error_expect(data_mem != NULL, PL_ERROR_ALLOC_FAILED, "`realloc()` fails!");
+    }
+    else if (old_size > POOL_MAX_BLOCK || new_size > POOL_MAX_BLOCK || pool_class(old_size) != pool_class(new_size))
+    {
+        // Move the data across size classes, or between the pool and `malloc()`.
+        // `realloc()` would not keep the alignment of huge pages.
+        data_mem = data_alloc(new_size);
+        pl_error_expect(data_mem != NULL, PL_ERROR_ALLOC_FAILED, "`malloc()` fails!");
+        memcpy(data_mem, x->data, old_size < new_size ? old_size : new_size);
+        data_free(x->data, old_size);
+    }
+
+    // Account the growth for the scheduler.
+    count_resized_object(x, old_size, new_size);
+    if (x->flags & PL_OBJECT_FLAG_TRACKED)
+    {
+        global_live_bytes = global_live_bytes + new_size - old_size;
+        if (!(x->flags & PL_OBJECT_FLAG_OLD))
+            global_young_bytes = global_young_bytes + new_size - old_size;
+        else if (new_size > old_size)
+            global_promoted_bytes += new_size - old_size;
+    }
+
+    x->data     = data_mem;
+    x->capacity = capacity;
+
+    // Some data will be lost if the requested capacity is smaller than the current length.
+    if (x->capacity < x->length)
+        x->length = x->capacity;
+
+    if (new_size > old_size)
+        notify_allocation(x, new_size);
+}
+
+/*-----------------------------------------------------------------------------
+ |  Reserve memory for object
+ ----------------------------------------------------------------------------*/
+
+static void reserve_object(pl_object x, const long capacity)
+{
+    check_null_pointer(x);
+    check_missing_value(capacity);
+    pl_error_expect(capacity > 0 && capacity <= PL_OBJECT_MAX_CAPACITY,
+                    PL_ERROR_INVALID_CAPACITY,
+                    "Invalid capacity [%ld]!",
+                    capacity);
+
+    // If there is enough memory.
+    if (x->capacity >= capacity)
+        return;
+
+    // Grow by 1.5x, so that appending stays amortized linear at any size
+    // while at most a third of the memory is left unused.
+    long final_capacity = x->capacity;
+    while (final_capacity <= capacity)
+        final_capacity += final_capacity / 2 + 1;
+    if (final_capacity > PL_OBJECT_MAX_CAPACITY)
+        final_capacity = PL_OBJECT_MAX_CAPACITY;
+
+    // Resize the object to the final capacity.
+    resize_object(x, final_capacity);
+}
+
+
+/*-----------------------------------------------------------------------------
+ |  Delete object
+ ----------------------------------------------------------------------------*/
+
+static void delete_object(pl_object x)
+{
+    check_null_pointer(x);
+    count_deleted_object(x);
+    if (x->flags & PL_OBJECT_FLAG_TRACKED)
+    {
+        global_live_bytes -= pl_object_size(x);
+        if (!(x->flags & PL_OBJECT_FLAG_OLD))
+            global_young_bytes -= pl_object_size(x);
+    }
+    if (x->buffer != NULL)
+        release_buffer(x->buffer);
+    else if (!data_is_inline(x) && !(x->flags & PL_OBJECT_FLAG_ARENA_DATA))
+        data_free(x->data, pl_object_data_size(x->class, x->capacity));
+    pool_free(x, header_block_size(x));
+}
+
+/*-----------------------------------------------------------------------------
+ |  Set operation
+ ----------------------------------------------------------------------------*/
+
+/*-----------------------------------------------------------------------------
+ |  Hash an object
+ ----------------------------------------------------------------------------*/
+
+// Fibonacci hashing of the address. The low bits are dropped since objects are aligned.
+static size_t set_hash(const object_set *const set, pl_object x)
+{
+    const uint64_t address = (uint64_t) (uintptr_t) x;
+    const uint64_t hash    = (address >> 4) * UINT64_C(0x9E3779B97F4A7C15);
+    return (size_t) (hash ^ (hash >> 32)) & ((size_t) set->capacity - 1);
+}
+
+/*-----------------------------------------------------------------------------
+ |  Rehash a set
+ ----------------------------------------------------------------------------*/
+
+// Move all objects to a new slot array. Tombstones are dropped.
+// The set stays untouched if the allocation fails.
+static void set_rehash(object_set *const set, const int capacity)
+{
+    pl_object *const slots = calloc((size_t) capacity, sizeof(pl_object));
+    pl_error_expect(slots != NULL, PL_ERROR_ALLOC_FAILED, "`calloc()` fails!");
+
+    pl_object *const old_slots = set->slots;
+    const int old_capacity     = set->capacity;
+
+    set->slots      = slots;
+    set->capacity   = capacity;
+    set->tombstones = 0;
+
+    pl_misc_for_i(old_capacity)
+    {
+        pl_object x = old_slots[i];
+        if (x == NULL || x == SET_TOMBSTONE)
+            continue;
+
+        size_t index = set_hash(set, x);
+        while (slots[index] != NULL)
+            index = (index + 1) & ((size_t) capacity - 1);
+        slots[index] = x;
+    }
+
+    free(old_slots);
+}
+
+// The smallest capacity that keeps the load factor below 3/4.
+static int set_fit_capacity(const int length)
+{
+    int capacity = SET_INIT_CAPACITY;
+    while ((long) length * 4 >= (long) capacity * 3)
+    {
+        pl_error_expect(capacity <= INT_MAX / 2,
+                        PL_ERROR_INVALID_CAPACITY,
+                        "Invalid capacity [%d]!",
+                        capacity);
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+// Make room for `count` more objects, so that recording them will not rehash the set.
+static void set_reserve(object_set *const set, const int count)
+{
+    if ((long) (set->length + set->tombstones + count) * 4 > (long) set->capacity * 3)
+        set_rehash(set, set_fit_capacity(set->length + count));
+}
+
+/*-----------------------------------------------------------------------------
+ |  Init set
+ ----------------------------------------------------------------------------*/
+
+static void init_set(object_set *const set)
+{
+    // Allocate slots for the set if it is uninitialized.
+    if (set->slots == NULL)
+    {
+        set->length     = 0;
+        set->tombstones = 0;
+        set->capacity   = 0;
+        set_rehash(set, SET_INIT_CAPACITY);
+    }
+}
+
+/*-----------------------------------------------------------------------------
+ |  Free set
+ ----------------------------------------------------------------------------*/
+
+static void free_set(object_set *const set)
+{
+    free(set->slots);
+    set->slots      = NULL;
+    set->capacity   = 0;
+    set->length     = 0;
+    set->tombstones = 0;
+}
+
+/*-----------------------------------------------------------------------------
+ |  Find object
+ ----------------------------------------------------------------------------*/
+
+// Find the slot of an object from a set, -1 for not found.
+static int set_find_object(const object_set *const set, pl_object x)
+{
+    if (x == NULL || set->slots == NULL)
+        return -1;
+
+    const size_t mask = (size_t) set->capacity - 1;
+    size_t index      = set_hash(set, x);
+
+    // Linear probing stops at the first empty slot.
+    while (set->slots[index] != NULL)
+    {
+        if (set->slots[index] == x)
+            return (int) index;
+        index = (index + 1) & mask;
+    }
+
+    return -1;
+}
+
+/*-----------------------------------------------------------------------------
+ |  Record object
+ ----------------------------------------------------------------------------*/
+
+static void set_record_object(object_set *const set, pl_object x)
+{
+    check_null_pointer(x);
+
+    // Grow the set if the load factor (counting tombstones) exceeds 3/4.
+    if ((long) (set->length + set->tombstones + 1) * 4 > (long) set->capacity * 3)
+        set_rehash(set, set_fit_capacity(set->length + 1));
+
+    const size_t mask = (size_t) set->capacity - 1;
+    size_t index      = set_hash(set, x);
+    long reuse        = -1;
+
+    while (set->slots[index] != NULL)
+    {
+        // Do nothing if the object is already recorded.
+        if (set->slots[index] == x)
+            return;
+
+        // Remember the first tombstone so it can be reused.
+        if (set->slots[index] == SET_TOMBSTONE && reuse == -1)
+            reuse = (long) index;
+
+        index = (index + 1) & mask;
+    }
+
+    if (reuse != -1)
+    {
+        index = (size_t) reuse;
+        set->tombstones--;
+    }
+
+    set->slots[index] = x;
+    set->length++;
+}
+
+/*-----------------------------------------------------------------------------
+ |  Untrack object
+ ----------------------------------------------------------------------------*/
+
+static void set_untrack_object(object_set *const set, pl_object x)
+{
+    check_null_pointer(x);
+
+    // Do nothing if the object is not in the set.
+    const int index = set_find_object(set, x);
+    if (index == -1)
+        return;
+
+    set->slots[index] = SET_TOMBSTONE;
+    set->length--;
+    set->tombstones++;
+}
+
+/*-----------------------------------------------------------------------------
+ |  Check slot
+ ----------------------------------------------------------------------------*/
+
+/// Check if a slot of a set holds an object.
+#define set_slot_used(x) ((x) != NULL && (x) != SET_TOMBSTONE)
+
+static pl_unittest_summary test_set(void)
+{
+    pl_unittest_summary summary = pl_unittest_new_summary();
+
+    static pl_object_struct objects[1000];
+    object_set set = {0};
+    init_set(&set);
+    pl_unittest_expect_true(summary, set.capacity == SET_INIT_CAPACITY && set.length == 0);
+
+    // The capacity stays a power of two with the load factor below 3/4.
+    pl_misc_for_i(1000) set_record_object(&set, &objects[i]);
+    set_record_object(&set, &objects[0]);
+    pl_unittest_expect_true(summary, set.length == 1000);
+    pl_unittest_expect_true(summary, (set.capacity & (set.capacity - 1)) == 0);
+    pl_unittest_expect_true(summary, (long) set.length * 4 < (long) set.capacity * 3);
+    volatile int all_found = 1;
+    pl_misc_for_i(1000) all_found = all_found && set_find_object(&set, &objects[i]) != -1;
+    pl_unittest_expect_true(summary, all_found);
+
+    // Removed objects leave tombstones, and probing continues past them.
+    const int capacity = set.capacity;
+    for (int i = 0; i < 1000; i += 2)
+        set_untrack_object(&set, &objects[i]);
+    set_untrack_object(&set, &objects[0]);
+    pl_unittest_expect_true(summary, set.length == 500 && set.tombstones == 500);
+    volatile int found_odd = 1, found_even = 0;
+    pl_misc_for_i(1000)
+    {
+        if (i % 2)
+            found_odd = found_odd && set_find_object(&set, &objects[i]) != -1;
+        else
+            found_even = found_even || set_find_object(&set, &objects[i]) != -1;
+    }
+    pl_unittest_expect_true(summary, found_odd && !found_even);
+
+    // Tombstones are reused by new records, and dropped by a rehash.
+    set_record_object(&set, &objects[0]);
+    pl_unittest_expect_true(summary, set.length == 501 && set.tombstones == 499);
+    set_rehash(&set, capacity);
+    pl_unittest_expect_true(summary, set.tombstones == 0 && set_find_object(&set, &objects[0]) != -1);
+    pl_unittest_expect_true(summary, set_find_object(&set, NULL) == -1);
+
+    free_set(&set);
+    pl_unittest_expect_true(summary, set.slots == NULL && set_find_object(&set, &objects[1]) == -1);
+
+    return summary;
+}
+
+/*-----------------------------------------------------------------------------
+ |  Directly reachable
+ ----------------------------------------------------------------------------*/
+
+static void directly_reachable(pl_object x)
+{
+    // Init the table.
+    init_set(&global_directly_reachable);
+
+    if (x != NULL)
+        set_record_object(&global_directly_reachable, x);
+}
+
+/*-----------------------------------------------------------------------------
+ |  Multiple directly reachable
+ ----------------------------------------------------------------------------*/
+
+static void multiple_directly_reachable(const int length, ...)
+{
+    // Init the table.
+    init_set(&global_directly_reachable);
+
+    if (length <= 0)
+        return;
+
+    va_list ap;
+    va_start(ap, length);
+    pl_misc_for_i(length)
+    {
+        pl_object x = va_arg(ap, pl_object);
+        if (x != NULL)
+            set_record_object(&global_directly_reachable, x);
+    }
+    va_end(ap);
+}
+
+/*-----------------------------------------------------------------------------
+ |  Directly unreachable
+ ----------------------------------------------------------------------------*/
+
+static void directly_unreachable(pl_object x)
+{
+    // Init the table.
+    init_set(&global_directly_reachable);
+
+    if (x != NULL)
+        set_untrack_object(&global_directly_reachable, x);
+}
+
+/*-----------------------------------------------------------------------------
+ |  Multiple directly unreachable
+ ----------------------------------------------------------------------------*/
+
+static void multiple_directly_unreachable(const int length, ...)
+{
+    // Init the table.
+    init_set(&global_directly_reachable);
+
+    if (length <= 0)
+        return;
+
+    va_list ap;
+    va_start(ap, length);
+    pl_misc_for_i(length)
+    {
+        pl_object x = va_arg(ap, pl_object);
+        if (x != NULL)
+            set_untrack_object(&global_directly_reachable, x);
+    }
+    va_end(ap);
+}
+
+/*-----------------------------------------------------------------------------
+ |  Scheduler
+ ----------------------------------------------------------------------------*/
+
+// The budget of the old generation is the threshold or the growth of the live heap allowed
+// by the growth factor, whichever is larger.
+static void update_budget(void)
+{
+    const double growth = (double) (global_live_bytes - global_young_bytes) * (global_growth_factor - 1.0);
+    global_budget_bytes = growth > (double) global_threshold ? (size_t) growth : global_threshold;
+}
+
+static void set_threshold(const size_t bytes)
+{
+    pl_error_expect(bytes > 0,
+                    PL_ERROR_INVALID_ARGUMENT,
+                    "Invalid threshold [%zu]!",
+                    bytes);
+    global_threshold = bytes;
+    update_budget();
+}
+
+static void set_growth_factor(const double factor)
+{
+    pl_error_expect(factor >= 1.0,
+                    PL_ERROR_INVALID_ARGUMENT,
+                    "Invalid growth factor [%f]!",
+                    factor);
+    global_growth_factor = factor;
+    update_budget();
+}
+
+static void set_nursery_size(const size_t bytes)
+{
+    pl_error_expect(bytes > 0,
+                    PL_ERROR_INVALID_ARGUMENT,
+                    "Invalid nursery size [%zu]!",
+                    bytes);
+    global_nursery_size = bytes;
+}
+
+static void set_promotion_age(const int age)
+{
+    pl_error_expect(age >= 1 && age <= PL_OBJECT_MAX_AGE,
+                    PL_ERROR_INVALID_ARGUMENT,
+                    "Invalid promotion age [%d]! Expecting [1, %d]!",
+                    age,
+                    PL_OBJECT_MAX_AGE);
+    global_promotion_age = age;
+}
+
+static void set_parallelism(const int n)
+{
+    pl_error_expect(n >= 1 && n <= PL_GC_MAX_PARALLELISM,
+                    PL_ERROR_INVALID_ARGUMENT,
+                    "Invalid parallelism [%d]! Expecting [1, %d]!",
+                    n,
+                    PL_GC_MAX_PARALLELISM);
+    global_parallelism = n;
+}
+
+static void enable_auto(void)
+{
+    global_auto = 1;
+}
+
+static void disable_auto(void)
+{
+    global_auto = 0;
+}
+
+/*-----------------------------------------------------------------------------
+ |  Stack operation
+ ----------------------------------------------------------------------------*/
+
+// Push an object onto a stack. Returns 0 if the stack fails to grow.
+static int stack_push(object_stack *const stack, pl_object x)
+{
+    if (stack->length == stack->capacity)
+    {
+        if (stack->capacity > INT_MAX / 2)
+            return 0;
+
+        const int capacity = stack->capacity == 0 ? 64 : stack->capacity * 2;
+        pl_object *items   = realloc(stack->items, (size_t) capacity * sizeof(pl_object));
+        if (items == NULL)
+            return 0;
+
+        stack->items    = items;
+        stack->capacity = capacity;
+    }
+
+    stack->items[stack->length] = x;
+    stack->length++;
+    return 1;
+}
+
+// Grow a stack to hold at least `capacity` objects.
+static void stack_reserve(object_stack *const stack, const int capacity)
+{
+    if (capacity <= stack->capacity)
+        return;
+
+    pl_object *items = realloc(stack->items, (size_t) capacity * sizeof(pl_object));
+    pl_error_expect(items != NULL, PL_ERROR_ALLOC_FAILED, "`realloc()` fails!");
+
+    stack->items    = items;
+    stack->capacity = capacity;
+}
+
+static void free_stack(object_stack *const stack)
+{
+    free(stack->items);
+    stack->items    = NULL;
+    stack->capacity = 0;
+    stack->length   = 0;
+}
+
+/*-----------------------------------------------------------------------------
+ |  Write barrier
+ ----------------------------------------------------------------------------*/
+
+static void remember(pl_object x)
+{
+    if (x == NULL || !(x->flags & PL_OBJECT_FLAG_OLD) || (x->flags & PL_OBJECT_FLAG_REMEMBERED))
+        return;
+
+    pl_error_expect(stack_push(&global_remembered, x), PL_ERROR_ALLOC_FAILED, "`realloc()` fails!");
+    x->flags |= PL_OBJECT_FLAG_REMEMBERED;
+}
+
+static pl_object escape(pl_object x);
+
+// Escape the arena objects stored into an object that outlives their arena.
+static void escape_item(pl_object x, pl_object item)
+{
+    if (item != NULL && pl_object_arena_depth(item) > pl_object_arena_depth(x))
+        escape(item);
+}
+
+static void write_barrier(pl_object x, pl_object item)
+{
+    check_null_pointer(x);
+
+    // Without the written item, all the references of the object are checked.
+    if (item == NULL)
+    {
+        if (pl_object_type(x) == PL_CLASS_LIST)
+        {
+            pl_object *const vectors = x->data;
+            pl_misc_for_i(x->length) escape_item(x, vectors[i]);
+        }
+        escape_item(x, string_bytes(x));
+        escape_item(x, x->attribute);
+        remember(x);
+        return;
+    }
+
+    escape_item(x, item);
+    if (!(item->flags & PL_OBJECT_FLAG_OLD))
+        remember(x);
+}
+
+// Check if an object refers to any object outside the old generation.
+static int refer_young(pl_object x)
+{
+    if (x->attribute != NULL && !(x->attribute->flags & PL_OBJECT_FLAG_OLD))
+        return 1;
+
+    pl_object bytes = string_bytes(x);
+    if (bytes != NULL && !(bytes->flags & PL_OBJECT_FLAG_OLD))
+        return 1;
+
+    if (pl_object_type(x) != PL_CLASS_LIST)
+        return 0;
+
+    pl_object *const vectors = x->data;
+    pl_misc_for_i(x->length)
+    {
+        if (vectors[i] != NULL && !(vectors[i]->flags & PL_OBJECT_FLAG_OLD))
+            return 1;
+    }
+    return 0;
+}
+
+// Drop the remembered objects that no longer refer to young objects.
+static void update_remembered(void)
+{
+    int count = 0;
+    pl_misc_for_i(global_remembered.length)
+    {
+        pl_object x = global_remembered.items[i];
+        if (refer_young(x))
+        {
+            global_remembered.items[count] = x;
+            count++;
+        }
+        else
+        {
+            x->flags &= ~PL_OBJECT_FLAG_REMEMBERED;
+        }
+    }
+    global_remembered.length = count;
+}
+
+/*-----------------------------------------------------------------------------
+ |  Arena frames
+ ----------------------------------------------------------------------------*/
+
+static void begin_arena(void)
+{
+    pl_error_expect(global_arena_depth < PL_GC_MAX_ARENA_DEPTH,
+                    PL_ERROR_INVALID_ARGUMENT,
+                    "Too many nested arena frames! Expecting at most [%d]!",
+                    PL_GC_MAX_ARENA_DEPTH);
+    global_arena_depth++;
+}
+
+// Record an object that needs to outlive its arena. Returns 0 if the list fails to grow.
+static int push_escaped(pl_object x)
+{
+    if (x == NULL || pl_object_arena_depth(x) == 0)
+        return 1;
+
+    return stack_push(&global_arenas[pl_object_arena_depth(x) - 1].escaped, x);
+}
+
+static pl_object escape(pl_object x)
+{
+    pl_error_expect(push_escaped(x), PL_ERROR_ALLOC_FAILED, "`realloc()` fails!");
+    return x;
+}
+
+// Move an object of the innermost arena to the nursery.
+// Returns 0 if the data fails to be moved out of the arena.
+static int migrate_object(pl_object x)
+{
+    if (x->flags & PL_OBJECT_FLAG_ARENA_DATA)
+    {
+        const size_t size = pl_object_data_size(x->class, x->capacity);
+        void *data_mem    = data_alloc(size);
+        if (data_mem == NULL)
+            return 0;
+        memcpy(data_mem, x->data, size);
+        x->data = data_mem;
+    }
+
+    if (!stack_push(&global_nursery, x))
+    {
+        if (x->flags & PL_OBJECT_FLAG_ARENA_DATA)
+            data_free(x->data, pl_object_data_size(x->class, x->capacity));
+        return 0;
+    }
+
+    x->flags &= ~(PL_OBJECT_ARENA_MASK | PL_OBJECT_FLAG_ARENA_DATA);
+    x->flags |= PL_OBJECT_FLAG_TRACKED;
+
+    const size_t size = pl_object_size(x);
+    global_live_bytes += size;
+    global_young_bytes += size;
+    return 1;
+}
+
+// Escape the arena objects referred by a migrated object. Returns 0 if the list fails to grow.
+static int escape_children(pl_object x)
+{
+    if (pl_object_type(x) == PL_CLASS_LIST)
+    {
+        pl_object *const vectors = x->data;
+        pl_misc_for_i(x->length)
+        {
+            if (!push_escaped(vectors[i]))
+                return 0;
+        }
+    }
+    return push_escaped(string_bytes(x)) && push_escaped(x->attribute);
+}
+
+static void end_arena(void)
+{
+    pl_error_expect(global_arena_depth > 0,
+                    PL_ERROR_INVALID_ARGUMENT,
+                    "No arena frame to end!");
+
+    arena *const a  = &global_arenas[global_arena_depth - 1];
+    const int depth = global_arena_depth;
+    global_arena_depth--;
+
+    // Rooted objects outlive the arena as well.
+    int migrated = 1;
+    pl_misc_for_i(a->objects.length)
+    {
+        pl_object x = a->objects.items[i];
+        if (set_find_object(&global_directly_reachable, x) != -1 && !stack_push(&a->escaped, x))
+            migrated = 0;
+    }
+
+    // Move the escaped objects and the arena objects reachable from them to the nursery.
+    while (migrated && a->escaped.length > 0)
+    {
+        a->escaped.length--;
+        pl_object x = a->escaped.items[a->escaped.length];
+
+        // Skip the objects already migrated.
+        if (pl_object_arena_depth(x) != depth)
+            continue;
+
+        migrated = migrate_object(x) && escape_children(x);
+    }
+    a->escaped.length = 0;
+
+    // Release everything else.
+    pl_misc_for_i(a->objects.length)
+    {
+        pl_object x = a->objects.items[i];
+        if (pl_object_arena_depth(x) == depth)
+            delete_object(x);
+    }
+    a->objects.length = 0;
+    arena_reset(a);
+
+    pl_error_expect(migrated, PL_ERROR_ALLOC_FAILED, "Failed to move escaped objects out of the arena!");
+}
+
+/*-----------------------------------------------------------------------------
+ |  Garbage collect
+ ----------------------------------------------------------------------------*/
+
+// Mark an object and push it onto the mark stack. Returns 0 if the stack fails to grow.
+// In a minor collection, the old generation is neither marked nor explored.
+static int mark_object(pl_object x, const int minor)
+{
+    // Null item and marked item should be ignored.
+    if (x == NULL || (x->flags & PL_OBJECT_FLAG_MARK))
+        return 1;
+
+    if (minor && (x->flags & PL_OBJECT_FLAG_OLD))
+        return 1;
+
+    x->flags |= PL_OBJECT_FLAG_MARK;
+    global_stats.objects_traced++;
+
+    // Objects outside the table (e.g. local objects) are not visited by the sweep,
+    // so they are remembered to have their marks cleared.
+    if (!(x->flags & PL_OBJECT_FLAG_TRACKED) && !stack_push(&global_untracked, x))
+        return 0;
+
+    return stack_push(&global_mark_stack, x);
+}
+
+// Push the children of an object onto the mark stack. Returns 0 if the mark stack fails to grow.
+static int mark_children(pl_object x, const int minor)
+{
+    // No need to explore the items of types other than list.
+    if (pl_object_type(x) == PL_CLASS_LIST)
+    {
+        // Define an array for convenience.
+        pl_object *const vectors = x->data;
+
+        // Check each item in the array.
+        pl_misc_for_i(x->length)
+        {
+            if (!mark_object(vectors[i], minor))
+                return 0;
+        }
+    }
+
+    // If the byte buffer of a string or the attribute presents, mark it.
+    return mark_object(string_bytes(x), minor) && mark_object(x->attribute, minor);
+}
+
+/*-----------------------------------------------------------------------------
+ |  Parallel mark
+ ----------------------------------------------------------------------------*/
+
+// Capacity of the deque of a worker. Objects beyond it go to the overflow stack of the worker.
+#define MARK_DEQUE_CAPACITY ((long) 1 << 14)
+
+// Push an object onto the bottom of a deque. Returns 0 if the deque is full. Only called by the owner.
+static int deque_push(mark_deque *const deque, pl_object x)
+{
+    const long bottom = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED);
+    const long top    = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+    if (bottom - top > deque->mask)
+        return 0;
+
+    __atomic_store_n(&deque->buffer[bottom & deque->mask], x, __ATOMIC_RELAXED);
+    __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+// Pop an object from the bottom of a deque. Returns NULL if the deque is empty. Only called by the owner.
+static pl_object deque_pop(mark_deque *const deque)
+{
+    const long bottom = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED) - 1;
+    __atomic_store_n(&deque->bottom, bottom, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    long top = __atomic_load_n(&deque->top, __ATOMIC_RELAXED);
+
+    if (top > bottom)
+    {
+        __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    pl_object x = __atomic_load_n(&deque->buffer[bottom & deque->mask], __ATOMIC_RELAXED);
+    if (top == bottom)
+    {
+        // The last object may be stolen at the same time.
+        if (!__atomic_compare_exchange_n(&deque->top, &top, top + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+            x = NULL;
+        __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);
+    }
+    return x;
+}
+
+// Steal an object from the top of a deque. Returns NULL if the deque is empty or the steal loses a race.
+static pl_object deque_steal(mark_deque *const deque)
+{
+    long top = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    const long bottom = __atomic_load_n(&deque->bottom, __ATOMIC_ACQUIRE);
+    if (top >= bottom)
+        return NULL;
+
+    pl_object x = __atomic_load_n(&deque->buffer[top & deque->mask], __ATOMIC_RELAXED);
+    if (!__atomic_compare_exchange_n(&deque->top, &top, top + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+        return NULL;
+    return x;
+}
+
+// Check if a deque may have objects to steal.
+static int deque_nonempty(mark_deque *const deque)
+{
+    return __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE) < __atomic_load_n(&deque->bottom, __ATOMIC_ACQUIRE);
+}
+
+// Atomically mark an object and queue it on a worker. Returns 0 if a stack fails to grow.
+static int parallel_mark_object(mark_worker *const worker, pl_object x)
+{
+    if (x == NULL)
+        return 1;
+
+    const int flags = __atomic_load_n(&x->flags, __ATOMIC_RELAXED);
+    if ((flags & PL_OBJECT_FLAG_MARK) || (worker->context->minor && (flags & PL_OBJECT_FLAG_OLD)))
+        return 1;
+
+    // Only the worker setting the bit explores the object.
+    if (__atomic_fetch_or(&x->flags, PL_OBJECT_FLAG_MARK, __ATOMIC_ACQ_REL) & PL_OBJECT_FLAG_MARK)
+        return 1;
+    worker->traced++;
+
+    if (!(flags & PL_OBJECT_FLAG_TRACKED) && !stack_push(&worker->visited, x))
+        return 0;
+
+    return deque_push(&worker->deque, x) || stack_push(&worker->overflow, x);
+}
+
+// Mark the children of an object. Returns 0 if a stack fails to grow.
+static int parallel_mark_children(mark_worker *const worker, pl_object x)
+{
+    if (pl_object_type(x) == PL_CLASS_LIST)
+    {
+        pl_object *const vectors = x->data;
+        pl_misc_for_i(x->length)
+        {
+            if (!parallel_mark_object(worker, vectors[i]))
+                return 0;
+        }
+    }
+    return parallel_mark_object(worker, string_bytes(x)) && parallel_mark_object(worker, x->attribute);
+}
+
+// Take an object to explore: from the overflow stack, the own deque, then other deques.
+static pl_object parallel_next_object(mark_worker *const worker)
+{
+    if (worker->overflow.length > 0)
+    {
+        worker->overflow.length--;
+        return worker->overflow.items[worker->overflow.length];
+    }
+
+    pl_object x = deque_pop(&worker->deque);
+    if (x != NULL)
+        return x;
+
+    mark_context *const context = worker->context;
+    for (int k = 1; k < context->num_workers; k++)
+    {
+        x = deque_steal(&context->workers[(worker->id + k) % context->num_workers].deque);
+        if (x != NULL)
+            return x;
+    }
+    return NULL;
+}
+
+// Check if any deque may have objects to steal.
+static int parallel_has_work(mark_context *const context)
+{
+    pl_misc_for_i(context->num_workers)
+    {
+        if (deque_nonempty(&context->workers[i].deque))
+            return 1;
+    }
+    return 0;
+}
+
+// Mark a slice of the roots, then explore and steal until all workers run out of work.
+static void *parallel_mark_worker(void *arg)
+{
+    mark_worker *const worker   = arg;
+    mark_context *const context = worker->context;
+
+    // Wait until the number of workers is final.
+    while (!__atomic_load_n(&context->started, __ATOMIC_ACQUIRE))
+        sched_yield();
+
+    int ok = 1;
+
+    // Each worker takes a contiguous slice of the directly reachable and the remembered set.
+    const int n          = context->num_workers;
+    const int root_start = (int) ((long) context->roots->capacity * worker->id / n);
+    const int root_end   = (int) ((long) context->roots->capacity * (worker->id + 1) / n);
+    for (int i = root_start; ok && i < root_end; i++)
+    {
+        pl_object x = context->roots->slots[i];
+        if (set_slot_used(x))
+            ok = parallel_mark_object(worker, x);
+    }
+
+    if (context->minor)
+    {
+        const int remembered_start = (int) ((long) context->remembered->length * worker->id / n);
+        const int remembered_end   = (int) ((long) context->remembered->length * (worker->id + 1) / n);
+        for (int i = remembered_start; ok && i < remembered_end; i++)
+            ok = parallel_mark_children(worker, context->remembered->items[i]);
+    }
+
+    for (;;)
+    {
+        if (!ok)
+            __atomic_store_n(&context->failed, 1, __ATOMIC_RELEASE);
+        if (__atomic_load_n(&context->failed, __ATOMIC_ACQUIRE))
+            break;
+
+        pl_object x = parallel_next_object(worker);
+        if (x != NULL)
+        {
+            ok = parallel_mark_children(worker, x);
+            continue;
+        }
+
+        // Run out of work. Marking is done once no worker is active and all deques are empty.
+        __atomic_fetch_sub(&context->active, 1, __ATOMIC_ACQ_REL);
+        int done = 0;
+        for (;;)
+        {
+            if (__atomic_load_n(&context->active, __ATOMIC_ACQUIRE) == 0 ||
+                __atomic_load_n(&context->failed, __ATOMIC_ACQUIRE))
+            {
+                done = 1;
+                break;
+            }
+            if (parallel_has_work(context))
+            {
+                __atomic_fetch_add(&context->active, 1, __ATOMIC_ACQ_REL);
+                break;
+            }
+            sched_yield();
+        }
+        if (done)
+            break;
+    }
+
+    return NULL;
+}
+
+// Free the memory of the workers.
+static void parallel_free_workers(mark_worker *const workers, const int n)
+{
+    pl_misc_for_i(n)
+    {
+        free(workers[i].deque.buffer);
+        free_stack(&workers[i].overflow);
+        free_stack(&workers[i].visited);
+    }
+    free(workers);
+}
+
+// Allocate `n` workers sharing a context. Returns NULL if the allocation fails.
+static mark_worker *parallel_new_workers(mark_context *const context, const int n, const int with_deque)
+{
+    mark_worker *workers = calloc((size_t) n, sizeof(mark_worker));
+    if (workers == NULL)
+        return NULL;
+
+    pl_misc_for_i(n)
+    {
+        workers[i].context    = context;
+        workers[i].id         = (int) i;
+        workers[i].deque.mask = MARK_DEQUE_CAPACITY - 1;
+        if (with_deque)
+        {
+            workers[i].deque.buffer = malloc((size_t) MARK_DEQUE_CAPACITY * sizeof(pl_object));
+            if (workers[i].deque.buffer == NULL)
+            {
+                parallel_free_workers(workers, n);
+                return NULL;
+            }
+        }
+    }
+    return workers;
+}
+
+// Run `routine` on all the workers. Worker 0 runs on the calling thread. If a thread fails
+// to be created, the work is split among the created ones. Returns the number of workers.
+static int parallel_run(mark_context *const context, void *(*routine)(void *))
+{
+    int n = 1;
+    while (n < context->num_workers && pthread_create(&context->workers[n].thread, NULL, routine, &context->workers[n]) == 0)
+        n++;
+
+    context->num_workers = n;
+    context->active      = n;
+    __atomic_store_n(&context->started, 1, __ATOMIC_RELEASE);
+
+    routine(&context->workers[0]);
+    for (int i = 1; i < n; i++)
+        pthread_join(context->workers[i].thread, NULL);
+    return n;
+}
+
+// Mark all objects reachable from the directly reachable with multiple threads.
+// Returns 0 if a stack fails to grow, or -1 if the workers fail to be allocated.
+static int parallel_mark(const int minor)
+{
+    mark_context context = {.roots       = &global_directly_reachable,
+                            .remembered  = &global_remembered,
+                            .table       = &global_table,
+                            .num_workers = global_parallelism,
+                            .minor       = minor};
+    context.workers      = parallel_new_workers(&context, context.num_workers, 1);
+    if (context.workers == NULL)
+        return -1;
+
+    const int n = parallel_run(&context, parallel_mark_worker);
+
+    // Objects outside the table are not visited by the sweep, so their marks are cleared now.
+    pl_misc_for_i(n)
+    {
+        const object_stack *const visited = &context.workers[i].visited;
+        pl_misc_for_j(visited->length) visited->items[j]->flags &= ~PL_OBJECT_FLAG_MARK;
+        global_stats.objects_traced += context.workers[i].traced;
+    }
+
+    const int marked = !context.failed;
+    parallel_free_workers(context.workers, global_parallelism);
+    return marked;
+}
+
+// Sweep a slice of the object table. Dead objects are tombstoned and handed to the collecting thread.
+static void *parallel_sweep_worker(void *arg)
+{
+    mark_worker *const worker   = arg;
+    mark_context *const context = worker->context;
+
+    while (!__atomic_load_n(&context->started, __ATOMIC_ACQUIRE))
+        sched_yield();
+
+    const int n     = context->num_workers;
+    const int start = (int) ((long) context->table->capacity * worker->id / n);
+    const int end   = (int) ((long) context->table->capacity * (worker->id + 1) / n);
+    for (int i = start; i < end; i++)
+    {
+        pl_object x = context->table->slots[i];
+        if (!set_slot_used(x))
+            continue;
+
+        if (x->flags & PL_OBJECT_FLAG_MARK)
+        {
+            x->flags &= ~PL_OBJECT_FLAG_MARK;
+        }
+        else if (stack_push(&worker->visited, x))
+        {
+            context->table->slots[i] = SET_TOMBSTONE;
+        }
+        else
+        {
+            // Keep the object for the next collection if it can not be handed over.
+            __atomic_store_n(&context->failed, 1, __ATOMIC_RELAXED);
+        }
+    }
+    return NULL;
+}
+
+// Sweep the object table after a full mark with multiple threads. Objects are deleted by the collecting
+// thread, since the pool is not shared. Returns 0 if the workers fail to be allocated.
+static int parallel_sweep_old(void)
+{
+    mark_context context = {.roots       = &global_directly_reachable,
+                            .remembered  = &global_remembered,
+                            .table       = &global_table,
+                            .num_workers = global_parallelism};
+    context.workers      = parallel_new_workers(&context, context.num_workers, 0);
+    if (context.workers == NULL)
+        return 0;
+
+    const int n = parallel_run(&context, parallel_sweep_worker);
+
+    pl_misc_for_i(n)
+    {
+        const object_stack *const dead = &context.workers[i].visited;
+        pl_misc_for_j(dead->length) delete_object(dead->items[j]);
+        global_table.length -= dead->length;
+        global_table.tombstones += dead->length;
+    }
+
+    parallel_free_workers(context.workers, global_parallelism);
+    return 1;
+}
+
+// Check if a collection is large enough to run in parallel.
+static int use_parallel(const int minor)
+{
+    const long objects = minor ? global_nursery.length : (long) global_table.length + global_nursery.length;
+    return global_parallelism > 1 && objects >= PL_GC_PARALLEL_MIN_OBJECTS;
+}
+
+// Mark all objects reachable from the directly reachable. Returns 0 if the mark stack fails to grow.
+// A minor collection also starts from the children of the remembered set.
+static int mark(const int minor)
+{
+    global_mark_stack.length = 0;
+    global_untracked.length  = 0;
+
+    // Large heaps are marked in parallel. Fall back to a single thread if the workers can not be allocated.
+    if (use_parallel(minor))
+    {
+        const int marked = parallel_mark(minor);
+        if (marked != -1)
+            return marked;
+    }
+
+    // Use the directly reachable as a starting point.
+    pl_misc_for_i(global_directly_reachable.capacity)
+    {
+        pl_object x = global_directly_reachable.slots[i];
+        if (set_slot_used(x) && !mark_object(x, minor))
+            return 0;
+    }
+
+    if (minor)
+    {
+        pl_misc_for_i(global_remembered.length)
+        {
+            if (!mark_children(global_remembered.items[i], minor))
+                return 0;
+        }
+    }
+
+    // Use DFS to find all reachable objects.
+    while (global_mark_stack.length > 0)
+    {
+        global_mark_stack.length--;
+        if (!mark_children(global_mark_stack.items[global_mark_stack.length], minor))
+            return 0;
+    }
+
+    return 1;
+}
+
+// Clear the marks of the objects outside the table.
+static void clear_untracked(void)
+{
+    pl_misc_for_i(global_untracked.length) global_untracked.items[i]->flags &= ~PL_OBJECT_FLAG_MARK;
+    global_untracked.length = 0;
+}
+
+// Sweep the nursery in one pass. Survivors get older and the ones reaching the
+// promotion age move to the old generation. If the marking is incomplete, only
+// the marks are cleared.
+static void sweep_nursery(const int marked)
+{
+    int count = 0;
+    pl_misc_for_i(global_nursery.length)
+    {
+        pl_object x = global_nursery.items[i];
+
+        if (!marked)
+        {
+            x->flags &= ~PL_OBJECT_FLAG_MARK;
+            global_nursery.items[count] = x;
+            count++;
+            continue;
+        }
+
+        if (!(x->flags & PL_OBJECT_FLAG_MARK))
+        {
+            profile_first_collection(x, 0);
+            delete_object(x);
+            continue;
+        }
+
+        profile_first_collection(x, 1);
+        x->flags &= ~PL_OBJECT_FLAG_MARK;
+        const int age = pl_object_age(x) + 1;
+        x->flags      = (x->flags & ~PL_OBJECT_AGE_MASK) | (age << PL_OBJECT_AGE_SHIFT);
+
+        // Keep the object in the nursery until it reaches the promotion age.
+        if (age < global_promotion_age)
+        {
+            global_nursery.items[count] = x;
+            count++;
+            continue;
+        }
+
+        // Room in the table is reserved before the collection, so this never rehashes.
+        set_record_object(&global_table, x);
+        x->flags |= PL_OBJECT_FLAG_OLD;
+        global_young_bytes -= pl_object_size(x);
+        global_promoted_bytes += pl_object_size(x);
+
+        // A promoted object may still refer to young objects. The remembered set is
+        // reserved as well, so this never fails.
+        if (refer_young(x))
+        {
+            global_remembered.items[global_remembered.length] = x;
+            global_remembered.length++;
+            x->flags |= PL_OBJECT_FLAG_REMEMBERED;
+        }
+    }
+    global_nursery.length = count;
+}
+
+// Sweep the old generation in one pass. If the marking is incomplete, only the marks are cleared.
+static void sweep_old(const int marked)
+{
+    if (marked && use_parallel(0) && parallel_sweep_old())
+        return;
+
+    pl_misc_for_i(global_table.capacity)
+    {
+        pl_object x = global_table.slots[i];
+        if (!set_slot_used(x))
+            continue;
+
+        if (!marked || (x->flags & PL_OBJECT_FLAG_MARK))
+        {
+            x->flags &= ~PL_OBJECT_FLAG_MARK;
+        }
+        else
+        {
+            // The remembered set holds no dead objects after a full mark.
+            delete_object(x);
+            global_table.slots[i] = SET_TOMBSTONE;
+            global_table.length--;
+            global_table.tombstones++;
+        }
+    }
+}
+
+static void minor_collect(void)
+{
+    // Init all the sets.
+    init_set(&global_table);
+    init_set(&global_directly_reachable);
+    const collection_start start = begin_collection(0);
+    profile_safe_point();
+
+    // Reserve room for promoting the whole nursery.
+    set_reserve(&global_table, global_nursery.length);
+    stack_reserve(&global_remembered, global_remembered.length + global_nursery.length);
+
+    // Mark the reachable young objects.
+    const int marked = mark(1);
+
+    // Sweep the nursery.
+    sweep_nursery(marked);
+    clear_untracked();
+    if (!marked)
+    {
+        end_collection(&start);
+        pl_error_throw(PL_ERROR_ALLOC_FAILED, "`realloc()` fails!");
+    }
+
+    update_remembered();
+    end_collection(&start);
+}
+
+static void garbage_collect(void)
+{
+    // Init all the sets.
+    init_set(&global_table);
+    init_set(&global_directly_reachable);
+    const collection_start start = begin_collection(1);
+    profile_safe_point();
+
+    // Reserve room for promoting the whole nursery.
+    set_reserve(&global_table, global_nursery.length);
+    stack_reserve(&global_remembered, global_remembered.length + global_nursery.length);
+
+    // Mark all the reachable objects.
+    const int marked = mark(0);
+
+    // The remembered set may refer to dead objects, so it is rebuilt from the survivors.
+    if (marked)
     {
-        free(object_mem);
-        free(object_data_mem);
-        pl_error_rethrow();
+        int count = 0;
+        pl_misc_for_i(global_remembered.length)
+        {
+            pl_object x = global_remembered.items[i];
+            if (x->flags & PL_OBJECT_FLAG_MARK)
+            {
+                global_remembered.items[count] = x;
+                count++;
+            }
+        }
+        global_remembered.length = count;
     }
 
-    pl_object object = object_mem;
+    // Sweep both generations.
+    sweep_old(marked);
+    sweep_nursery(marked);
+    clear_untracked();
+    if (!marked)
+    {
+        end_collection(&start);
+        pl_error_throw(PL_ERROR_ALLOC_FAILED, "`realloc()` fails!");
+    }
 
-    // Prepare the metadata struct.
-    pl_object_struct object_struct_copy = {.class     = class,
-                                           .capacity  = capacity,
-                                           .length    = 0,
-                                           .attribute = NULL,
-                                           .data      = object_data_mem};
+    update_remembered();
 
-    // Copy it to the allocated metadata memory.
-    memcpy(object, &object_struct_copy, sizeof(pl_object_struct));
+    // Start a new budget for the old generation.
+    update_budget();
+    global_promoted_bytes = 0;
 
-    return object;
+    // Rehash the global table to drop the tombstones and save some space.
+    if ((long) global_table.tombstones * 4 > (long) global_table.capacity)
+        set_rehash(&global_table, set_fit_capacity(global_table.length));
+    end_collection(&start);
 }
 
+// A list of two items for the tests of the collector.
+static pl_object test_pair(pl_object first, pl_object second)
+{
+    pl_object x                = new_object(PL_CLASS_LIST, 2);
+    ((pl_object *) x->data)[0] = first;
+    ((pl_object *) x->data)[1] = second;
+    x->length                  = 2;
+    write_barrier(x, NULL);
+    return x;
+}
 
-static pl_object new_object(const int class, const int capacity)
+static pl_unittest_summary test_mark(void)
 {
-    // Init the global table.
-    init_table(&global_table);
+    pl_unittest_summary summary = pl_unittest_new_summary();
+
+    garbage_collect();
+    const size_t live = global_stats.live_objects;
+
+    // A reachable cycle and an unreachable cycle.
+    pl_object leaf                = new_object(PL_CLASS_INT, 1);
+    pl_object root                = test_pair(leaf, NULL);
+    ((pl_object *) root->data)[1] = test_pair(root, leaf);
+    write_barrier(root, NULL);
+    pl_object garbage                = test_pair(NULL, new_object(PL_CLASS_DOUBLE, 1));
+    ((pl_object *) garbage->data)[0] = test_pair(garbage, NULL);
+    write_barrier(garbage, NULL);
+    directly_reachable(root);
+    pl_unittest_expect_true(summary, global_stats.live_objects == live + 6);
+
+    // Only the unreachable cycle is deleted, and the marks are cleared by the sweep.
+    garbage_collect();
+    pl_unittest_expect_true(summary, global_stats.live_objects == live + 3);
+    pl_object child = ((pl_object *) root->data)[1];
+    pl_unittest_expect_true(summary, ((pl_object *) child->data)[0] == root && ((pl_object *) child->data)[1] == leaf);
+    const int flags = root->flags | child->flags | leaf->flags;
+    pl_unittest_expect_true(summary, !(flags & PL_OBJECT_FLAG_MARK));
+    pl_unittest_expect_true(summary, global_untracked.length == 0);
+
+    // A second collection finds the same objects.
+    const size_t traced = global_stats.objects_traced;
+    garbage_collect();
+    pl_unittest_expect_true(summary, global_stats.objects_traced - traced >= 3);
+    pl_unittest_expect_true(summary, global_stats.live_objects == live + 3);
+
+    directly_unreachable(root);
+    garbage_collect();
+    pl_unittest_expect_true(summary, global_stats.live_objects == live);
+
+    return summary;
+}
 
-    // Create a new object.
-    pl_object object = new_object_without_recording(class, capacity);
+static pl_unittest_summary test_generation(void)
+{
+    pl_unittest_summary summary = pl_unittest_new_summary();
+
+    garbage_collect();
+    const size_t live = global_stats.live_objects;
+    set_promotion_age(2);
+
+    // Survivors stay in the nursery until they reach the promotion age.
+    pl_object x = test_pair(NULL, NULL);
+    directly_reachable(x);
+    minor_collect();
+    pl_unittest_expect_true(summary, !(x->flags & PL_OBJECT_FLAG_OLD) && pl_object_age(x) == 1);
+    minor_collect();
+    pl_unittest_expect_true(summary, (x->flags & PL_OBJECT_FLAG_OLD) && set_find_object(&global_table, x) != -1);
+    volatile int in_nursery = 0;
+    pl_misc_for_i(global_nursery.length) in_nursery = in_nursery || global_nursery.items[i] == x;
+    pl_unittest_expect_true(summary, !in_nursery);
+
+    // A young object stored into an old object is kept alive by the remembered set.
+    pl_object young            = new_object(PL_CLASS_INT, 1);
+    ((pl_object *) x->data)[0] = young;
+    write_barrier(x, young);
+    pl_unittest_expect_true(summary, (x->flags & PL_OBJECT_FLAG_REMEMBERED) && global_remembered.length == 1);
+    minor_collect();
+    pl_unittest_expect_true(summary, global_stats.live_objects == live + 2 && pl_object_age(young) == 1);
+    pl_unittest_expect_true(summary, x->flags & PL_OBJECT_FLAG_REMEMBERED);
+
+    // Once the young object is promoted, the old object is dropped from the remembered set.
+    minor_collect();
+    pl_unittest_expect_true(summary, (young->flags & PL_OBJECT_FLAG_OLD) && global_stats.live_objects == live + 2);
+    pl_unittest_expect_true(summary, !(x->flags & PL_OBJECT_FLAG_REMEMBERED) && global_remembered.length == 0);
+
+    // Storing an old object needs no remembering.
+    write_barrier(x, young);
+    pl_unittest_expect_true(summary, global_remembered.length == 0);
+
+    set_promotion_age(PL_GC_DEFAULT_PROMOTION_AGE);
+    directly_unreachable(x);
+    garbage_collect();
+    pl_unittest_expect_true(summary, global_stats.live_objects == live);
+
+    return summary;
+}
 
-    //  Try to record the object.
+static pl_unittest_summary test_arena(void)
+{
+    pl_unittest_summary summary = pl_unittest_new_summary();
+
+    garbage_collect();
+    const size_t live = global_stats.live_objects;
+
+    // Rooted and escaped objects, and the arena objects they refer to, outlive the arena.
+    begin_arena();
+    pl_object escaped          = escape(new_object(PL_CLASS_INT, 1));
+    ((int *) escaped->data)[0] = 42;
+    escaped->length            = 1;
+    pl_object child            = new_object(PL_CLASS_INT, 1);
+    pl_object rooted           = test_pair(child, NULL);
+    directly_reachable(rooted);
+    pl_misc_for_i(8) new_object(PL_CLASS_DOUBLE, 16);
+    pl_unittest_expect_true(summary, pl_object_arena_depth(escaped) == 1 && !(escaped->flags & PL_OBJECT_FLAG_TRACKED));
+    end_arena();
+    pl_unittest_expect_true(summary, global_arena_depth == 0 && global_stats.live_objects == live + 3);
+    const int flags = escaped->flags & child->flags & rooted->flags;
+    pl_unittest_expect_true(summary, (flags & PL_OBJECT_FLAG_TRACKED) && !(flags & PL_OBJECT_FLAG_ARENA_DATA));
+    pl_unittest_expect_true(summary, pl_object_arena_depth(child) == 0 && ((int *) escaped->data)[0] == 42);
+
+    // An inner arena object stored into an outer arena object escapes the inner arena only.
+    begin_arena();
+    pl_object outer = test_pair(NULL, NULL);
+    begin_arena();
+    pl_object inner                = new_object(PL_CLASS_INT, 1);
+    ((pl_object *) outer->data)[0] = inner;
+    write_barrier(outer, inner);
+    end_arena();
+    pl_unittest_expect_true(summary, inner->flags & PL_OBJECT_FLAG_TRACKED);
+    end_arena();
+    pl_unittest_expect_true(summary, global_stats.live_objects == live + 4);
+
+    // Objects moved to the garbage collector are collected once unreachable.
+    directly_unreachable(rooted);
+    garbage_collect();
+    pl_unittest_expect_true(summary, global_stats.live_objects == live);
+
+    // Ending an arena without one is an error.
+    volatile int caught = PL_ERROR_NONE;
     pl_error_try
     {
-        table_record_object(global_table, object);
+        end_arena();
     }
     pl_error_catch
     {
-        // If the object fails to be recorded, delete the object.
-        delete_object(object);
-        pl_error_rethrow();
+        caught = pl_error_get_current();
     }
+    pl_unittest_expect_true(summary, caught == PL_ERROR_INVALID_ARGUMENT);
 
-    return object;
+    return summary;
 }
 
 /*-----------------------------------------------------------------------------
- |  Resize object
+ |  Maybe collect
  ----------------------------------------------------------------------------*/
 
-static void resize_object(pl_object x, const int capacity)
+static void garbage_collect_if_needed(void)
 {
-    check_null_pointer(x);
-    check_missing_value(capacity);
-    pl_error_expect(capacity > 0 && capacity <= PL_OBJECT_MAX_CAPACITY,
-                    PL_ERROR_INVALID_CAPACITY,
-                    "Invalid capacity [%d]!",
-                    capacity);
+    profile_safe_point();
+    if (!global_auto)
+        return;
 
-    // Realloc memory block for the data.
-    void *data_mem = realloc(x->data, pl_object_data_size(x->class, capacity));
-    pl_error_expect(data_mem != NULL, PL_ERROR_ALLOC_FAILED, "`realloc()` fails!");
-    x->data = data_mem;
-    x->capacity = capacity;
+    if (global_young_bytes >= global_nursery_size)
+        minor_collect();
 
-    // Some data will be lost if the requested capacity is smaller than the current length.
-    if (x->capacity < x->length)
-        x->length = x->capacity;
+    if (global_promoted_bytes >= global_budget_bytes)
+        garbage_collect();
 }
 
-/*-----------------------------------------------------------------------------
- |  Reserve memory for object
- ----------------------------------------------------------------------------*/
+static void begin_frame(void)
+{
+    global_frame_depth++;
+}
 
-static void reserve_object(pl_object x, const int capacity)
+// Only the outermost frame is a safe point. An enclosing frame may still use temporaries
+// that are not directly reachable, e.g. `x = equal(...)` followed by a loop of inner frames.
+static void end_frame(void)
 {
-    check_null_pointer(x);
-    check_missing_value(capacity);
-    pl_error_expect(capacity > 0 && capacity < PL_OBJECT_MAX_CAPACITY,
-                    PL_ERROR_INVALID_CAPACITY,
-                    "Invalid capacity [%d]!",
-                    capacity);
+    if (global_frame_depth > 0)
+        global_frame_depth--;
+    if (global_frame_depth == 0 && pl_error_get_current() == PL_ERROR_NONE)
+        garbage_collect_if_needed();
+}
 
-    // If there is enough memory.
-    if (x->capacity >= capacity)
-        return;
+static pl_unittest_summary test_nested_frame(void)
+{
+    pl_unittest_summary summary = pl_unittest_new_summary();
 
-    // Switch to linear growth at some point.
-    int final_capacity  = 1;
-    const int threshold = 2 << (sizeof(int) * 4);
-    while (final_capacity <= capacity)
+    set_nursery_size(4096);
+    const long minor = global_stats.minor_collections;
+
+    // A temporary of the outer frame survives the inner frames filling the nursery.
+    begin_frame();
+    pl_object temporary = new_object(PL_CLASS_INT, 4);
+    pl_misc_for_i(16)
     {
-        if (final_capacity < threshold)
-            final_capacity *= 2;
-        else
-            final_capacity += threshold;
+        begin_frame();
+        new_object(PL_CLASS_DOUBLE, 128);
+        end_frame();
     }
-    if (final_capacity > PL_OBJECT_MAX_CAPACITY)
-        final_capacity = PL_OBJECT_MAX_CAPACITY - 1;
-
-    // Resize the object to the final capacity.
-    resize_object(x, final_capacity);
-}
+    volatile int in_nursery = 0;
+    pl_misc_for_i(global_nursery.length) in_nursery = in_nursery || global_nursery.items[i] == temporary;
+    pl_unittest_expect_true(summary, global_stats.minor_collections == minor);
+    pl_unittest_expect_true(summary, in_nursery);
+    pl_unittest_expect_true(summary, global_frame_depth == 1);
 
+    // The outermost frame is a safe point.
+    end_frame();
+    pl_unittest_expect_true(summary, global_stats.minor_collections == minor + 1);
+    pl_unittest_expect_true(summary, global_frame_depth == 0);
+    pl_unittest_expect_true(summary, global_young_bytes < global_nursery_size);
 
-/*-----------------------------------------------------------------------------
- |  Delete object
- ----------------------------------------------------------------------------*/
+    set_nursery_size(PL_GC_DEFAULT_NURSERY_SIZE);
 
-static void delete_object(pl_object x)
-{
-    check_null_pointer(x);
-    free(x->data);
-    free(x);
+    return summary;
 }
 
 /*-----------------------------------------------------------------------------
- |  Table operation
+ |  Handoff
  ----------------------------------------------------------------------------*/
 
-/*-----------------------------------------------------------------------------
- |  Init table
- ----------------------------------------------------------------------------*/
-
-static void init_table(pl_object *const table_p)
-{
-    // Allocate memory for the table if it is uninitialized.
-    if (*table_p == NULL)
-        *table_p = new_object_without_recording(PL_CLASS_LIST, 8);
-}
+// Offset of the first record of a handoff.
+#define HANDOFF_HEADER_SIZE ((sizeof(struct pl_gc_handoff_struct) + POOL_GRANULE - 1) / POOL_GRANULE * POOL_GRANULE)
 
-/*-----------------------------------------------------------------------------
- |  Find object
- ----------------------------------------------------------------------------*/
+// Size of the padded data of an object in a handoff.
+#define handoff_data_size(class, length) \
+        ((pl_object_data_size(class, length) + POOL_GRANULE - 1) / POOL_GRANULE * POOL_GRANULE)
 
-// Find an object from a table, -1 for not found.
-static int table_find_object(pl_object table, pl_object x)
+// Index of an object in a handoff given the slots of the visited set, -1 for NULL.
+static intptr_t handoff_index(const object_set *const seen, const int *const index, pl_object x)
 {
     if (x == NULL)
         return -1;
+    return index[set_find_object(seen, x)];
+}
 
-    int head    = 0;
-    int tail    = table->length - 1;
-    int current = 0;
-
-    pl_object *const data_array = table->data;
+// Append an object to the handoff order if it has not been visited.
+static void handoff_visit(object_set *const seen, object_stack *const order, pl_object x)
+{
+    if (x == NULL || set_find_object(seen, x) != -1)
+        return;
 
-    // Use binary search to find the object.
-    while (head <= tail)
-    {
-        current = head / 2 + tail / 2 + (tail % 2 && head % 2);
+    set_record_object(seen, x);
+    pl_error_expect(stack_push(order, x), PL_ERROR_ALLOC_FAILED, "`realloc()` fails!");
+}
 
-        if (data_array[current] == x)
-            return current;
+// Collect all objects reachable from `x` in breadth-first order.
+static void handoff_collect(pl_object x, object_set *const seen, object_stack *const order)
+{
+    init_set(seen);
+    handoff_visit(seen, order, x);
 
-        if (data_array[current] < x)
-            head = current + 1;
-        else
-            tail = current - 1;
+    for (int i = 0; i < order->length; i++)
+    {
+        pl_object y = order->items[i];
+        if (pl_object_type(y) == PL_CLASS_LIST)
+        {
+            pl_object *const vectors = y->data;
+            pl_misc_for_j(y->length) handoff_visit(seen, order, vectors[j]);
+        }
+        handoff_visit(seen, order, string_bytes(y));
+        handoff_visit(seen, order, y->attribute);
     }
-
-    return -1;
 }
 
-/*-----------------------------------------------------------------------------
- |  Record object
- ----------------------------------------------------------------------------*/
-
-static void table_record_object(pl_object table, pl_object x)
+static pl_gc_handoff export_graph(pl_object x)
 {
     check_null_pointer(x);
 
-    // Do nothing if the object is already recorded.
-    if (table_find_object(table, x) != -1)
-        return;
+    // Variables modified inside `pl_error_try` are volatile, so they are valid in `pl_error_catch`.
+    object_set seen              = {0};
+    object_stack order           = {0};
+    int *volatile index          = NULL;
+    pl_gc_handoff volatile bytes = NULL;
+
+    pl_error_try
+    {
+        handoff_collect(x, &seen, &order);
 
-    // Reserve enough space for the table.
-    reserve_object(table, table->length + 1);
+        // Map slots of the visited set to positions in the handoff.
+        index = malloc((size_t) seen.capacity * sizeof(int));
+        pl_error_expect(index != NULL, PL_ERROR_ALLOC_FAILED, "`malloc()` fails!");
+        pl_misc_for_i(order.length) index[set_find_object(&seen, order.items[i])] = (int) i;
 
-    // Define a data array for convenience.
-    pl_object *const data_array = table->data;
+        size_t size = HANDOFF_HEADER_SIZE;
+        pl_misc_for_i(order.length)
+        {
+            size += sizeof(handoff_record) + handoff_data_size(order.items[i]->class, order.items[i]->length);
+        }
 
-    // If the table is empty, there is no need to memmove.
-    // Otherwise, find the correct location to insert the object.
-    if (table->length == 0)
-    {
-        table->length = 1;
-        data_array[0] = x;
-    }
-    else
-    {
-        int head    = 0;
-        int tail    = table->length - 1;
-        int current = 0;
+        bytes = malloc(size);
+        pl_error_expect(bytes != NULL, PL_ERROR_ALLOC_FAILED, "`malloc()` fails!");
+        bytes->size  = size;
+        bytes->count = order.length;
 
-        while (head <= tail)
+        // Write the records. References are replaced by indices of the handoff.
+        char *cursor = (char *) bytes + HANDOFF_HEADER_SIZE;
+        pl_misc_for_i(order.length)
         {
-            current = head / 2 + tail / 2 + (tail % 2 && head % 2);
-            if (data_array[current] < x)
-                head = current + 1;
+            pl_object y                  = order.items[i];
+            handoff_record *const record = (handoff_record *) cursor;
+            record->class                = y->class;
+            record->length               = y->length;
+            record->attribute            = (int) handoff_index(&seen, index, y->attribute);
+            record->size                 = (long) handoff_data_size(y->class, y->length);
+            cursor += sizeof(handoff_record);
+
+            if (pl_object_type(y) == PL_CLASS_LIST)
+            {
+                pl_object *const vectors = y->data;
+                pl_misc_for_j(y->length)((intptr_t *) cursor)[j] = handoff_index(&seen, index, vectors[j]);
+            }
+            else if (pl_object_type(y) == PL_CLASS_STRING)
+            {
+                *(intptr_t *) cursor = handoff_index(&seen, index, string_bytes(y));
+                memcpy(pl_object_string_items(cursor),
+                       pl_object_string_items(y->data),
+                       (size_t) y->length * sizeof(pl_object_string_item));
+            }
             else
-                tail = current - 1;
+            {
+                memcpy(cursor, y->data, pl_object_data_size(y->class, y->length));
+            }
+            cursor += record->size;
         }
+    }
+    pl_error_catch
+    {
+        free_set(&seen);
+        free_stack(&order);
+        free(index);
+        free(bytes);
+        pl_error_rethrow();
+    }
+
+    free_set(&seen);
+    free_stack(&order);
+    free(index);
+    return bytes;
+}
 
-        if (head == table->length)
+// Rebuild the objects of a handoff into `objects`. Primitive data is copied, or shared
+// with the handoff through `buffer` if it is not NULL.
+static void import_records(pl_gc_handoff handoff, pl_object *const objects, shared_buffer *const buffer)
+{
+    // Create the objects first, so that references can be resolved.
+    char *cursor = (char *) handoff + HANDOFF_HEADER_SIZE;
+    pl_misc_for_i(handoff->count)
+    {
+        const handoff_record *const record = (const handoff_record *) cursor;
+        cursor += sizeof(handoff_record);
+
+        // Lists and strings hold references, so their data is never shared.
+        const int type         = pl_class_get_ns().type(record->class);
+        const size_t data_size = pl_object_data_size(record->class, record->length);
+        if (buffer != NULL && type != PL_CLASS_LIST && type != PL_CLASS_STRING && data_size > SHARED_MIN_BYTES)
         {
-            data_array[table->length] = x;
+            objects[i] = new_shared_object(record->class, record->length, cursor, buffer);
         }
         else
         {
-            memmove(data_array + head + 1,
-                    data_array + head,
-                    pl_object_data_size(PL_CLASS_LIST, table->length - head));
-            data_array[head] = x;
+            objects[i]         = new_object(record->class, record->length > 0 ? record->length : 1);
+            objects[i]->length = record->length;
+            if (type == PL_CLASS_STRING)
+                memcpy(pl_object_string_items(objects[i]->data),
+                       pl_object_string_items(cursor),
+                       (size_t) record->length * sizeof(pl_object_string_item));
+            else if (type != PL_CLASS_LIST)
+                memcpy(objects[i]->data, cursor, data_size);
         }
-
-        table->length++;
+        cursor += record->size;
     }
-}
-
-/*-----------------------------------------------------------------------------
- |  Untrack object
- ----------------------------------------------------------------------------*/
-
-static void table_untrack_object(pl_object table, pl_object x)
-{
-    check_null_pointer(x);
 
-    // Do nothing if the object is not in the table.
-    int index = table_find_object(table, x);
-    if (index == -1)
-        return;
+    // Resolve the references. All the objects are new, so no write barrier is needed.
+    cursor = (char *) handoff + HANDOFF_HEADER_SIZE;
+    pl_misc_for_i(handoff->count)
+    {
+        const handoff_record *const record = (const handoff_record *) cursor;
+        cursor += sizeof(handoff_record);
 
-    // Define a data array for convenience.
-    pl_object *const data_array = table->data;
+        if (record->attribute != -1)
+            objects[i]->attribute = objects[record->attribute];
 
-    // If it is the last item.
-    if (index == table->length - 1)
-    {
-        table->length--;
-        return;
+        if (pl_class_get_ns().type(record->class) == PL_CLASS_LIST)
+        {
+            pl_object *const vectors      = objects[i]->data;
+            const intptr_t *const indices = (const intptr_t *) cursor;
+            pl_misc_for_j(record->length) vectors[j] = indices[j] == -1 ? NULL : objects[indices[j]];
+        }
+        else if (pl_class_get_ns().type(record->class) == PL_CLASS_STRING)
+        {
+            const intptr_t bytes_index               = *(const intptr_t *) cursor;
+            pl_object_string_bytes(objects[i]->data) = bytes_index == -1 ? NULL : objects[bytes_index];
+        }
+        cursor += record->size;
     }
 
-    // Otherwise, move the data.
-    memmove(data_array + index,
-            data_array + index + 1,
-            pl_object_data_size(PL_CLASS_LIST, table->length - index - 1));
-    table->length--;
+    // Attribute names are symbols of the exporting thread.
+    const pl_object_ns object_ns = pl_object_get_ns();
+    pl_misc_for_i(handoff->count) object_ns.attribute.rebuild(objects[i]);
 }
 
-/*-----------------------------------------------------------------------------
- |  Directly reachable
- ----------------------------------------------------------------------------*/
-
-static void directly_reachable(pl_object x)
+static pl_object import_graph(pl_gc_handoff handoff)
 {
-    // Init the table.
-    init_table(&global_directly_reachable);
+    check_null_pointer(handoff);
 
-    if (x != NULL)
-        table_record_object(global_directly_reachable, x);
-}
+    pl_object *objects = malloc((size_t) handoff->count * sizeof(pl_object));
+    pl_error_expect(objects != NULL, PL_ERROR_ALLOC_FAILED, "`malloc()` fails!");
 
-/*-----------------------------------------------------------------------------
- |  Multiple directly reachable
- ----------------------------------------------------------------------------*/
+    pl_error_try
+    {
+        import_records(handoff, objects, NULL);
+    }
+    pl_error_catch
+    {
+        free(objects);
+        pl_error_rethrow();
+    }
 
-static void multiple_directly_reachable(const int length, ...)
+    pl_object root = objects[0];
+    free(objects);
+    free(handoff);
+    return root;
+}
+
+static pl_object import_shared_graph(pl_gc_handoff handoff, void (*const release)(void *context), void *const context)
 {
-    // Init the table.
-    init_table(&global_directly_reachable);
+    check_null_pointer(handoff);
+    check_null_pointer(release);
 
-    if (length <= 0)
-        return;
+    pl_object *objects = malloc((size_t) handoff->count * sizeof(pl_object));
+    pl_error_expect(objects != NULL, PL_ERROR_ALLOC_FAILED, "`malloc()` fails!");
 
-    va_list ap;
-    va_start(ap, length);
-    pl_misc_for_i(length)
+    shared_buffer *const buffer = pool_alloc(sizeof(shared_buffer));
+    if (buffer == NULL)
     {
-        pl_object x = va_arg(ap, pl_object);
-        if (x != NULL)
-            table_record_object(global_directly_reachable, x);
+        free(objects);
+        pl_error_throw(PL_ERROR_ALLOC_FAILED, "`malloc()` fails!");
     }
-    va_end(ap);
-}
 
-/*-----------------------------------------------------------------------------
- |  Directly unreachable
- ----------------------------------------------------------------------------*/
+    // The import holds a reference until the objects are created, so the handoff is
+    // released by whichever comes last, the import or the objects sharing its data.
+    buffer->references = 1;
+    buffer->size       = handoff->size;
+    buffer->data       = handoff;
+    buffer->release    = release;
+    buffer->context    = context;
 
-static void directly_unreachable(pl_object x)
-{
-    // Init the table.
-    init_table(&global_directly_reachable);
+    pl_error_try
+    {
+        import_records(handoff, objects, buffer);
+    }
+    pl_error_catch
+    {
+        free(objects);
+        release_buffer(buffer);
+        pl_error_rethrow();
+    }
 
-    if (x != NULL)
-        table_untrack_object(global_directly_reachable, x);
+    pl_object root = objects[0];
+    free(objects);
+    release_buffer(buffer);
+    return root;
 }
 
-/*-----------------------------------------------------------------------------
- |  Multiple directly unreachable
- ----------------------------------------------------------------------------*/
+// Throw if a handoff read from outside does not hold well-formed records.
+#define check_handoff(condition) pl_error_expect(condition, PL_ERROR_INVALID_FORMAT, "Malformed handoff!")
 
-static void multiple_directly_unreachable(const int length, ...)
+// Every item of a string record must lie inside the byte buffer, followed by the null terminator.
+// Empty strings and missing values need no byte buffer.
+static void check_string_record(const void *const bytes,
+                                const size_t *const offsets,
+                                const int count,
+                                const handoff_record *const record)
 {
-    // Init the table.
-    init_table(&global_directly_reachable);
+    const intptr_t bytes_index = *(const intptr_t *) (record + 1);
+    check_handoff(bytes_index >= -1 && bytes_index < count);
 
-    if (length <= 0)
-        return;
+    const handoff_record *buffer = NULL;
+    if (bytes_index != -1)
+    {
+        buffer = (const handoff_record *) ((const char *) bytes + offsets[bytes_index]);
+        check_handoff(pl_class_get_ns().type(buffer->class) == PL_CLASS_CHAR);
+    }
 
-    va_list ap;
-    va_start(ap, length);
-    pl_misc_for_i(length)
+    const pl_object_string_item *const items = pl_object_string_items(record + 1);
+    pl_misc_for_i(record->length)
     {
-        pl_object x = va_arg(ap, pl_object);
-        if (x != NULL)
-            table_untrack_object(global_directly_reachable, x);
+        if (items[i].length == PL_LONG_NA || items[i].length == 0)
+            continue;
+        check_handoff(buffer != NULL && items[i].length > 0 && items[i].offset >= 0);
+        check_handoff(items[i].offset < buffer->length && items[i].length < buffer->length - items[i].offset);
+
+        const char *const data = (const char *) (buffer + 1);
+        check_handoff(data[items[i].offset + items[i].length] == '\0');
     }
-    va_end(ap);
 }
 
-/*-----------------------------------------------------------------------------
- |  Garbage collect
- ----------------------------------------------------------------------------*/
-
-static void update_reachable(void)
+static pl_gc_handoff open_handoff(void *const bytes, const size_t size)
 {
-    // Init the reachable and directly reachable.
-    init_table(&global_reachable);
-    init_table(&global_reachable_unordered);
-    init_table(&global_directly_reachable);
-
-    // Reset global reachable
-    global_reachable->length = 0;
-
-    // Do nothing if the global directly reachable has no objects.
-    if (global_directly_reachable->length == 0)
-        return;
-
-    // Resize global reachable and global reachable unordered.
-    resize_object(global_reachable, global_directly_reachable->length);
-    resize_object(global_reachable_unordered, global_directly_reachable->length);
-
-    // Copy all the directly reachable to unordered reachable as a starting point.
-    memcpy(global_reachable_unordered->data,
-           global_directly_reachable->data,
-           pl_object_data_size(PL_CLASS_LIST, global_directly_reachable->length));
-    global_reachable_unordered->length = global_directly_reachable->length;
-
-    // Also make a copy to reachable.
-    memcpy(global_reachable->data,
-           global_directly_reachable->data,
-           pl_object_data_size(PL_CLASS_LIST, global_directly_reachable->length));
-    global_reachable->length = global_directly_reachable->length;
+    check_null_pointer(bytes);
+    check_handoff(size >= HANDOFF_HEADER_SIZE && ((uintptr_t) bytes) % sizeof(long) == 0);
 
-    // Use BFS to find all reachable objects.
+    const pl_gc_handoff handoff = bytes;
+    check_handoff(handoff->size == size && handoff->count > 0);
+    check_handoff((size_t) handoff->count <= (size - HANDOFF_HEADER_SIZE) / sizeof(handoff_record));
 
-    // Define the head and the tail.
-    int head_index = 0;
-    int tail_index = global_directly_reachable->length - 1;
+    // Offsets of the records, so that references can be checked against the referred records.
+    size_t *volatile offsets = malloc((size_t) handoff->count * sizeof(size_t));
+    pl_error_expect(offsets != NULL, PL_ERROR_ALLOC_FAILED, "`malloc()` fails!");
 
-    // Define a data array for convenience. This pointer needs to be updated if the object is reallocated.
-    pl_object *reachable_unordered_array = global_reachable_unordered->data;
-
-    const pl_class_ns class_ns = pl_class_get_ns();
-    while (head_index <= tail_index)
+    pl_error_try
     {
-        // Get the head item.
-        pl_object head_item = reachable_unordered_array[head_index];
-
-        // No need to explore types other than list.
-        if (class_ns.type(head_item->class) == PL_CLASS_LIST)
+        const pl_class_ns class_ns = pl_class_get_ns();
+        size_t offset              = HANDOFF_HEADER_SIZE;
+        pl_misc_for_i(handoff->count)
         {
-            // Define an array for convenience.
-            pl_object *const vectors = head_item->data;
-
-            // Check each item in the array.
-            pl_misc_for_i(head_item->length)
-            {
-                // Null item should be ignored.
-                if (vectors[i] != NULL)
-                {
-                    // Try to record it by the reachable table
-                    int before_length = global_reachable->length;
-                    table_record_object(global_reachable, vectors[i]);
-
-                    // If success (no repeated item), append it to the end of the reachable unordered.
-                    if (global_reachable->length > before_length)
-                    {
-                        // Reserve enough space for the reachable unordered.
-                        reserve_object(global_reachable_unordered, global_reachable_unordered->length + 1);
-
-                        // Update the data array since the object is reallocated.
-                        reachable_unordered_array = global_reachable_unordered->data;
-
-                        // Store the object at the end of the array.
-                        reachable_unordered_array[global_reachable_unordered->length] = vectors[i];
-                        global_reachable_unordered->length++;
-                    }
-                }
-            }
+            check_handoff(size - offset >= sizeof(handoff_record));
+            const handoff_record *const record = (const handoff_record *) ((const char *) bytes + offset);
+            check_handoff(record->class >= 0 && record->class < PL_NUM_CLASS);
+            check_handoff(class_ns.type(record->class) != PL_CLASS_EXTERNAL);
+            check_handoff(record->length >= 0 && record->length <= PL_OBJECT_MAX_CAPACITY);
+            check_handoff(record->size == (long) handoff_data_size(record->class, record->length));
+            check_handoff(record->attribute >= -1 && record->attribute < handoff->count);
+
+            offsets[i] = offset;
+            offset += sizeof(handoff_record);
+            check_handoff(size - offset >= (size_t) record->size);
+            offset += (size_t) record->size;
         }
+        check_handoff(offset == size);
 
-        // If the attribute presents, record it.
-        if (head_item->attribute != NULL)
+        pl_misc_for_i(handoff->count)
         {
-            // Try to record it by the reachable table.
-            int before_length = global_reachable->length;
-            table_record_object(global_reachable, head_item->attribute);
-
-            // If success (no repeated item), append it to the end of the reachable unordered.
-            if (global_reachable->length > before_length)
+            const handoff_record *const record = (const handoff_record *) ((const char *) bytes + offsets[i]);
+            if (record->attribute != -1)
             {
-                // Reserve enough space for the reachable unordered.
-                reserve_object(global_reachable_unordered, global_reachable_unordered->length + 1);
-
-                // Update the data array since the object is reallocated.
-                reachable_unordered_array = global_reachable_unordered->data;
-
-                // Store the object at the end of the array.
-                reachable_unordered_array[global_reachable_unordered->length] = head_item->attribute;
-                global_reachable_unordered->length++;
+                const handoff_record *const attribute = (const handoff_record *) ((const char *) bytes + offsets[record->attribute]);
+                check_handoff(class_ns.type(attribute->class) == PL_CLASS_LIST);
+            }
+            if (class_ns.type(record->class) == PL_CLASS_LIST)
+            {
+                const intptr_t *const indices = (const intptr_t *) (record + 1);
+                pl_misc_for_j(record->length) check_handoff(indices[j] >= -1 && indices[j] < handoff->count);
             }
+            if (class_ns.type(record->class) == PL_CLASS_STRING)
+                check_string_record(bytes, offsets, handoff->count, record);
         }
-
-        // Update the tail index and the head index
-        tail_index = global_reachable_unordered->length - 1;
-        head_index++;
     }
-}
-
-
-#include <malloc/malloc.h>
-
-static void garbage_collect(void)
-{
-    // Init all the tables.
-    init_table(&global_table);
-    init_table(&global_directly_reachable);
-    init_table(&global_reachable);
-
-    // Update the reachable table.
-    update_reachable();
-
-    // Delete all the objects not presented in the reachable.
-    pl_object *const vectors = global_table->data;
-    pl_misc_for_i(global_table->length)
+    pl_error_catch
     {
-        if (table_find_object(global_reachable, vectors[i]) == -1)
-            delete_object(vectors[i]);
+        free(offsets);
+        pl_error_rethrow();
     }
+    free(offsets);
+    return handoff;
+}
 
-    // Copy all the objects from the reachable to the global table.
-    memcpy(global_table->data,
-           global_reachable->data,
-           (size_t) global_reachable->length * sizeof(pl_object));
-    global_table->length = global_reachable->length;
+static size_t handoff_size(pl_gc_handoff handoff)
+{
+    check_null_pointer(handoff);
+    return handoff->size;
+}
 
-    // Resize the global table to save some space.
-    resize_object(global_table, global_table->length == 0 ? 1 : global_table->length);
+static void discard_handoff(pl_gc_handoff handoff)
+{
+    free(handoff);
 }
 
 /*-----------------------------------------------------------------------------
@@ -530,41 +2985,51 @@ static void garbage_collect(void)
 static void report(void)
 {
     // Init the global table
-    init_table(&global_table);
-
-    // Define a data array for convenience.
-    pl_object *const data_array = global_table->data;
+    init_set(&global_table);
 
     // Calculate the size of all the objects.
     size_t total_size = 0;
-    pl_misc_for_i(global_table->length)
+    pl_misc_for_i(global_table.capacity)
     {
-        total_size += pl_object_size(data_array[i]);
+        pl_object x = global_table.slots[i];
+        if (set_slot_used(x))
+            total_size += pl_object_size(x);
     }
+    pl_misc_for_i(global_nursery.length) total_size += pl_object_size(global_nursery.items[i]);
 
     // Print the report.
-    printf("Object table summary:\n[Capacity = %d, Length = %d, Heap Memory usage = %zu bytes]\n",
-           global_table->capacity,
-           global_table->length,
+    printf("Object table summary:\n[Capacity = %d, Length = %d, Nursery = %d, Heap Memory usage = %zu bytes]\n",
+           global_table.capacity,
+           global_table.length + global_nursery.length,
+           global_nursery.length,
            total_size);
 
-    printf("\t│ Object     │ %-16s │ %-8s │ %-10s │ %-12s │ %s │ %s │\n",
+    printf("\t│ Object     │ %-16s │ %-5s │ %-8s │ %-10s │ %-12s │ %s │ %s │\n",
            "Address",
+           "Space",
            "Class",
            "Length",
            "Element size",
            "Base size",
            "Total size");
-    pl_misc_for_i(global_table->length)
-    {
-        printf("\t│ %-10d │ <%p> │ %-8s │ %-10d │ %-1lu Bytes      │ %lu Bytes  │ %lu Bytes   │\n",
-               i,
-               (const void *) data_array[i],
-               PL_CLASS_NAME[data_array[i]->class],
-               data_array[i]->length,
-               PL_CLASS_ELEMENT_SIZE[data_array[i]->class],
+
+    int count = 0;
+    pl_misc_for_i(global_table.capacity + global_nursery.length)
+    {
+        pl_object x = i < global_table.capacity ? global_table.slots[i] : global_nursery.items[i - global_table.capacity];
+        if (!set_slot_used(x))
+            continue;
+
+        printf("\t│ %-10d │ <%p> │ %-5s │ %-8s │ %-10ld │ %-1lu Bytes      │ %lu Bytes  │ %lu Bytes   │\n",
+               count,
+               (const void *) x,
+               (x->flags & PL_OBJECT_FLAG_OLD) ? "old" : "young",
+               PL_CLASS_NAME[x->class],
+               x->length,
+               PL_CLASS_ELEMENT_SIZE[x->class],
                sizeof(pl_object_struct),
-               pl_object_size(data_array[i]));
+               pl_object_size(x));
+        count++;
     }
     puts("");
 }
@@ -575,21 +3040,64 @@ static void report(void)
 
 static void kill(void)
 {
-    pl_object *const vectors = global_table->data;
-    pl_misc_for_i(global_table->length)
+    pl_misc_for_i(global_table.capacity)
+    {
+        pl_object x = global_table.slots[i];
+        if (set_slot_used(x))
+            delete_object(x);
+    }
+    pl_misc_for_i(global_nursery.length) delete_object(global_nursery.items[i]);
+
+    // Objects of the arenas are released with the pool.
+    pl_misc_for_i(PL_GC_MAX_ARENA_DEPTH)
     {
-        delete_object(vectors[i]);
+        arena_reset(&global_arenas[i]);
+        free(global_arenas[i].chunks);
+        free_stack(&global_arenas[i].objects);
+        free_stack(&global_arenas[i].escaped);
+        global_arenas[i] = (arena) {0};
     }
+    global_arena_depth = 0;
+    global_frame_depth = 0;
+
+    free_set(&global_directly_reachable);
+    free_set(&global_table);
+    free_stack(&global_nursery);
+    free_stack(&global_remembered);
+    free_stack(&global_mark_stack);
+    free_stack(&global_untracked);
+    pool_kill();
+
+    global_live_bytes     = 0;
+    global_young_bytes    = 0;
+    global_promoted_bytes = 0;
+    update_budget();
+    profile_kill();
+}
+
+/*-----------------------------------------------------------------------------
+ |  Statistics and hook
+ ----------------------------------------------------------------------------*/
+
+static size_t allocated_bytes(void)
+{
+    return global_stats.bytes_allocated;
+}
+
+static pl_gc_stats stats(void)
+{
+    return global_stats;
+}
 
-    delete_object(global_directly_reachable);
-    delete_object(global_reachable);
-    delete_object(global_reachable_unordered);
-    delete_object(global_table);
+static void set_hook(const pl_gc_hook hook, void *const context)
+{
+    global_hook         = hook;
+    global_hook_context = context;
+}
 
-    global_directly_reachable  = NULL;
-    global_reachable           = NULL;
-    global_reachable_unordered = NULL;
-    global_table               = NULL;
+static void set_large_allocation_size(const size_t bytes)
+{
+    global_large_allocation_size = bytes;
 }
 
 /*-----------------------------------------------------------------------------
@@ -598,25 +3106,71 @@ static void kill(void)
 
 static int check_status(void)
 {
-    return global_table != NULL;
+    return global_table.slots != NULL;
 }
 
 /*-----------------------------------------------------------------------------
  |  Get garbage collector namespace
  ----------------------------------------------------------------------------*/
 
+static void test(void)
+{
+    printf("In file: %s\n", __FILE__);
+    pl_unittest_print_summary(test_set());
+    pl_unittest_print_summary(test_mark());
+    pl_unittest_print_summary(test_generation());
+    pl_unittest_print_summary(test_arena());
+    pl_unittest_print_summary(test_nested_frame());
+}
+
 pl_gc_ns pl_gc_get_ns(void)
 {
     static const pl_gc_ns gc_ns = {.new_object                    = new_object,
                                    .resize_object                 = resize_object,
                                    .reserve_object                = reserve_object,
+                                   .slice_object                  = slice_object,
+                                   .detach_object                 = detach_object,
                                    .directly_reachable            = directly_reachable,
                                    .multiple_directly_reachable   = multiple_directly_reachable,
                                    .directly_unreachable          = directly_unreachable,
                                    .multiple_directly_unreachable = multiple_directly_unreachable,
                                    .garbage_collect               = garbage_collect,
+                                   .minor_collect                 = minor_collect,
+                                   .maybe_collect                 = garbage_collect_if_needed,
+                                   .begin_frame                   = begin_frame,
+                                   .end_frame                     = end_frame,
+                                   .write_barrier                 = write_barrier,
+                                   .begin_arena                   = begin_arena,
+                                   .end_arena                     = end_arena,
+                                   .escape                        = escape,
+                                   .set_threshold                 = set_threshold,
+                                   .set_growth_factor             = set_growth_factor,
+                                   .set_nursery_size              = set_nursery_size,
+                                   .set_promotion_age             = set_promotion_age,
+                                   .set_parallelism               = set_parallelism,
+                                   .enable_auto                   = enable_auto,
+                                   .disable_auto                  = disable_auto,
+                                   .export_graph                  = export_graph,
+                                   .import_graph                  = import_graph,
+                                   .import_shared_graph           = import_shared_graph,
+                                   .open_handoff                  = open_handoff,
+                                   .handoff_size                  = handoff_size,
+                                   .discard_handoff               = discard_handoff,
                                    .report                        = report,
+                                   .allocated_bytes               = allocated_bytes,
+                                   .stats                         = stats,
+                                   .set_hook                      = set_hook,
+                                   .set_large_allocation_size     = set_large_allocation_size,
                                    .kill                          = kill,
+#ifdef PL_GC_PROFILE
+                                   .profile_enter                 = profile_enter,
+                                   .profile_leave                 = profile_leave,
+                                   .profile_report                = profile_report,
+                                   .profile_reset                 = profile_reset,
+#endif//PL_GC_PROFILE
+#ifdef PL_TEST
+                                   .test                          = test,
+#endif//PL_TEST
                                    .check_status                  = check_status};
     return gc_ns;
 }
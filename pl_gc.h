@@ -6,6 +6,55 @@
 #define PL_PL_GC_H
 
 #include "pl_object.h"
+#include "stddef.h"
+
+/*-----------------------------------------------------------------------------
+ |  Scheduler defaults
+ ----------------------------------------------------------------------------*/
+
+/// Default number of bytes promoted to the old generation between two automatic major collections.
+#define PL_GC_DEFAULT_THRESHOLD ((size_t) 4 << 20)
+
+/// Default growth factor of the old generation between two automatic major collections.
+#define PL_GC_DEFAULT_GROWTH_FACTOR 2.0
+
+/// Default number of bytes allocated in the nursery between two automatic minor collections.
+#define PL_GC_DEFAULT_NURSERY_SIZE ((size_t) 1 << 20)
+
+/// Default number of minor collections an object survives before promotion.
+#define PL_GC_DEFAULT_PROMOTION_AGE 2
+
+/// Maximum number of threads used by a collection.
+#define PL_GC_MAX_PARALLELISM 64
+
+/// Minimum number of objects to be collected by multiple threads.
+#define PL_GC_PARALLEL_MIN_OBJECTS 65536
+
+/// Maximum number of nested arena frames.
+#define PL_GC_MAX_ARENA_DEPTH 64
+
+/// Size of a huge page. Used when compiled with `PL_GC_HUGE_PAGES`.
+#define PL_GC_HUGE_PAGE_SIZE ((size_t) 2 << 20)
+
+/// Minimum size of a data buffer aligned to huge pages. Used when compiled with `PL_GC_HUGE_PAGES`.
+#define PL_GC_HUGE_PAGE_MIN_SIZE ((size_t) 64 << 20)
+
+/// Default minimum data size of an allocation reported to the hook as large.
+#define PL_GC_DEFAULT_LARGE_ALLOCATION_SIZE ((size_t) 1 << 20)
+
+/*-----------------------------------------------------------------------------
+ |  Allocation profile
+ ----------------------------------------------------------------------------*/
+
+/// Attribute the objects created by an expression to the call site.
+/// @details Only effective with PL_GC_PROFILE. Nested expressions are attributed to the
+/// outermost one. Objects created outside profiled expressions are attributed to `<unknown>`.
+/// @param expr An expression of type `pl_object`.
+#ifdef PL_GC_PROFILE
+#define pl_gc_profile(expr) pl_gc_get_ns().profile_leave((pl_gc_get_ns().profile_enter(__FILE__, __LINE__, __func__), (expr)))
+#else
+#define pl_gc_profile(expr) (expr)
+#endif
 
 /*-----------------------------------------------------------------------------
  |  Shortcuts for garbage collection management
@@ -13,12 +62,17 @@
 
 #ifdef PL_GC_SHORTCUTS
 
+/// Attribute the objects created by an expression to the call site. See `pl_gc_profile`.
+/// @param expr An expression of type `pl_object`.
+#define $profile(expr) pl_gc_profile(expr)
+
 /// Begin a frame. Objects will be marked directly unreachable at the end of the frame.
 /// @param ... Objects need to be used inside the frame.
-#define $begin_frame(...)                                                                           \
+#define $begin_frame(...)                                                                               \
         for (pl_object __VA_ARGS__,                                                                     \
              *pl_misc_with_i_name(__LINE__),                                                            \
-             **pl_misc_with_ip_name(__LINE__) = &pl_misc_with_i_name(__LINE__);                         \
+             **pl_misc_with_ip_name(__LINE__) = (pl_gc_get_ns().begin_frame(),                          \
+                                                 &pl_misc_with_i_name(__LINE__));                       \
              pl_misc_with_ip_name(__LINE__);                                                            \
              pl_misc_with_ip_name(__LINE__) = 0,                                                        \
              pl_gc_get_ns().multiple_directly_unreachable(pl_misc_count_arg(__VA_ARGS__), __VA_ARGS__)) \
@@ -27,16 +81,42 @@
             pl_error_try
 
 /// End a frame. Objects will be marked directly unreachable at the end of the frame.
-#define $end_frame                                   \
+/// @details An automatic collection may run at the end of the outermost frame, so objects
+/// that are not reachable from a directly reachable object should not be used afterwards.
+/// Nested frames never collect, since the enclosing frames may hold temporaries that are not rooted.
+#define $end_frame                                       \
         pl_error_catch                                   \
         {                                                \
         }                                                \
         }                                                \
         do {                                             \
+            pl_gc_get_ns().end_frame();                  \
             if (pl_error_get_current() != PL_ERROR_NONE) \
                 pl_error_rethrow();                      \
         } while (0);
 
+/// Begin an arena frame. Objects will be marked directly unreachable at the end of the frame.
+/// @details Objects created inside the frame are allocated from a bump arena and are
+/// not tracked by the garbage collector. At the end of the frame, the arena is released
+/// at once, except for the objects that are still directly reachable (e.g. `$set` to a
+/// variable of an outer frame), the objects passed to `escape()`, the objects stored into an
+/// object outliving the arena, and the arena objects they refer to. Those are moved to the
+/// garbage collector. An arena frame is ended by `$end_frame`.
+/// @param ... Objects need to be used inside the frame.
+#define $begin_arena_frame(...)                                                                         \
+        for (pl_object __VA_ARGS__,                                                                     \
+             *pl_misc_with_i_name(__LINE__),                                                            \
+             **pl_misc_with_ip_name(__LINE__) = (pl_gc_get_ns().begin_arena(),                          \
+                                                 pl_gc_get_ns().begin_frame(),                          \
+                                                 &pl_misc_with_i_name(__LINE__));                       \
+             pl_misc_with_ip_name(__LINE__);                                                            \
+             pl_misc_with_ip_name(__LINE__) = 0,                                                        \
+             pl_gc_get_ns().end_arena(),                                                                \
+             pl_gc_get_ns().multiple_directly_unreachable(pl_misc_count_arg(__VA_ARGS__), __VA_ARGS__)) \
+        {                                                                                               \
+            pl_misc_init_variables(NULL, __VA_ARGS__);                                                  \
+            pl_error_try
+
 /// Set value for object. The previous content will be marked directly unreachable, and the updated content will be marked directly reachable.
 /// @param x Object.
 /// @param content Content.
@@ -44,39 +124,170 @@
         do {                                            \
             if (x != NULL)                              \
                 pl_gc_get_ns().directly_unreachable(x); \
-            x = content;                                \
+            x = pl_gc_profile(content);                 \
             pl_gc_get_ns().directly_reachable(x);       \
         } while (0)
 #endif
 
 
+/*-----------------------------------------------------------------------------
+ |  Write barrier
+ ----------------------------------------------------------------------------*/
+
+/// Record a write of an object reference into an object.
+/// @details Must be called whenever `item` is stored into the list data or the
+/// attribute of `x`, so that minor collections can find young objects referred
+/// by old objects, and arena objects stored into longer-lived objects escape their
+/// arena. Pass NULL as `item` after writing multiple references.
+/// @param x (pl_object). The object being written.
+/// @param item (pl_object). The object being stored.
+#define pl_gc_write_barrier(x, item)                                                                  \
+        do {                                                                                              \
+            pl_object pl_gc_barrier_x_    = (x);                                                          \
+            pl_object pl_gc_barrier_item_ = (item);                                                       \
+            if (pl_gc_barrier_item_ == NULL ||                                                            \
+                pl_object_arena_depth(pl_gc_barrier_item_) > pl_object_arena_depth(pl_gc_barrier_x_) ||   \
+                ((pl_gc_barrier_x_->flags & PL_OBJECT_FLAG_OLD) &&                                        \
+                 !(pl_gc_barrier_x_->flags & PL_OBJECT_FLAG_REMEMBERED) &&                                \
+                 !(pl_gc_barrier_item_->flags & PL_OBJECT_FLAG_OLD)))                                     \
+                pl_gc_get_ns().write_barrier(pl_gc_barrier_x_, pl_gc_barrier_item_);                      \
+        } while (0)
+
+/*-----------------------------------------------------------------------------
+ |  Handoff
+ ----------------------------------------------------------------------------*/
+
+/// A serialized object graph that can be moved between threads.
+/// @details It is a single `malloc()` block that does not refer to any heap.
+typedef struct pl_gc_handoff_struct *pl_gc_handoff;
+
+/*-----------------------------------------------------------------------------
+ |  Statistics
+ ----------------------------------------------------------------------------*/
+
+/// Statistics of the heap of the current thread.
+/// @details Counters are cumulative since the thread started, and are not reset by `kill`.
+/// Bytes are the sizes reported by `pl_object_size`, so data shared by slices is counted
+/// for every slice. Objects of arena frames are counted as well.
+/// @param objects_allocated (size_t). Number of objects created.
+/// @param bytes_allocated (size_t). Bytes of objects created, plus the growth of resizes.
+/// @param objects_freed (size_t). Number of objects deleted.
+/// @param bytes_freed (size_t). Bytes of objects deleted, plus the shrinkage of resizes.
+/// @param live_objects (size_t). Number of objects not deleted yet.
+/// @param live_bytes (size_t). Bytes of objects not deleted yet.
+/// @param peak_live_bytes (size_t). Maximum of `live_bytes`.
+/// @param minor_collections (long). Number of minor collections.
+/// @param major_collections (long). Number of major collections.
+/// @param total_pause_seconds (double). Time spent in collections.
+/// @param max_pause_seconds (double). Time of the longest collection.
+/// @param objects_traced (size_t). Number of objects marked by all the collections.
+/// @param class_objects (size_t [PL_NUM_CLASS]). Number of live objects of each class.
+/// @param class_bytes (size_t [PL_NUM_CLASS]). Bytes of live objects of each class. Classes are named by `PL_CLASS_NAME`.
+typedef struct pl_gc_stats
+{
+    size_t objects_allocated;
+    size_t bytes_allocated;
+    size_t objects_freed;
+    size_t bytes_freed;
+    size_t live_objects;
+    size_t live_bytes;
+    size_t peak_live_bytes;
+    long minor_collections;
+    long major_collections;
+    double total_pause_seconds;
+    double max_pause_seconds;
+    size_t objects_traced;
+    size_t class_objects[PL_NUM_CLASS];
+    size_t class_bytes[PL_NUM_CLASS];
+} pl_gc_stats;
+
+/*-----------------------------------------------------------------------------
+ |  Events
+ ----------------------------------------------------------------------------*/
+
+/// A collection begins.
+#define PL_GC_EVENT_COLLECT_BEGIN 0
+
+/// A collection ends.
+#define PL_GC_EVENT_COLLECT_END 1
+
+/// An object is created or grown to at least the large allocation size.
+#define PL_GC_EVENT_LARGE_ALLOCATION 2
+
+/// An event passed to the hook.
+/// @param type (int). One of `PL_GC_EVENT_*`.
+/// @param major (int). Whether the collection is major. Collection events only.
+/// @param pause_seconds (double). Duration of the collection. `PL_GC_EVENT_COLLECT_END` only.
+/// @param objects_traced (size_t). Objects marked by the collection. `PL_GC_EVENT_COLLECT_END` only.
+/// @param objects_freed (size_t). Objects deleted by the collection. `PL_GC_EVENT_COLLECT_END` only.
+/// @param bytes_freed (size_t). Bytes deleted by the collection. `PL_GC_EVENT_COLLECT_END` only.
+/// @param live_bytes (size_t). Live bytes of the heap at the event.
+/// @param object (pl_object). The object allocated. `PL_GC_EVENT_LARGE_ALLOCATION` only.
+/// @param bytes (size_t). Data bytes allocated. `PL_GC_EVENT_LARGE_ALLOCATION` only.
+typedef struct pl_gc_event
+{
+    int type;
+    int major;
+    double pause_seconds;
+    size_t objects_traced;
+    size_t objects_freed;
+    size_t bytes_freed;
+    size_t live_bytes;
+    pl_object object;
+    size_t bytes;
+} pl_gc_event;
+
+/// A hook receiving events of the heap of the current thread.
+/// @param event (const pl_gc_event *). The event. Only valid during the call.
+/// @param context (void *). The context given to `set_hook`.
+typedef void (*pl_gc_hook)(const pl_gc_event *event, void *context);
+
 /*-----------------------------------------------------------------------------
  |  Garbage collector namespace
  ----------------------------------------------------------------------------*/
 
 /// Garbage collector namespace.
+/// @details The heap, the directly reachable objects and the scheduler are
+/// thread-local. Each thread has its own heap and needs to `kill` it before exit.
+/// Objects must not be shared between threads; use `export_graph` and
+/// `import_graph` to hand an object graph over to another thread.
 typedef struct pl_gc_ns {
     /// New an object.
     /// @param class (int). Class of the object.
-    /// @param capacity (int). Capacity of the object.
+    /// @param capacity (long). Capacity of the object.
     /// @return A new object.
-    pl_object (*const new_object)(int class, int capacity);
+    pl_object (*const new_object)(int class, long capacity);
 
     /// Resize the object.
     /// @details Data may be lost if the original length of the object is
     /// greater than the original capacity.
     /// @param x (pl_object). The object.
-    /// @param capacity (int). New capacity.
+    /// @param capacity (long). New capacity.
     /// @return A resized object.
-    void (*const resize_object)(pl_object x, int capacity);
+    void (*const resize_object)(pl_object x, long capacity);
 
     /// Reserve memory for an object.
     /// @details The function may reserve more memory than the requested
     /// amount for efficiency.
     /// @param x (pl_object). The object.
-    /// @param capacity (int). New capacity.
+    /// @param capacity (long). New capacity.
     /// @return A new object.
-    void (*const reserve_object)(pl_object x, int capacity);
+    void (*const reserve_object)(pl_object x, long capacity);
+
+    /// New an object holding a range of items of another object.
+    /// @details Large ranges share the data of x instead of copying it. The data is
+    /// copied when either object is written through the object namespace, or when
+    /// `detach_object` is called. The attribute will be dropped.
+    /// @param x (pl_object). The object.
+    /// @param start (long). The start index.
+    /// @param length (long). Number of items.
+    /// @return A new object.
+    pl_object (*const slice_object)(pl_object x, long start, long length);
+
+    /// Make sure an object owns its data before it is written.
+    /// @details Nothing is done if the data is not shared.
+    /// @param x (pl_object). The object.
+    void (*const detach_object)(pl_object x);
 
     /// Declare a directly reachable object.
     /// @param x (pl_object). The object.
@@ -96,22 +307,199 @@ typedef struct pl_gc_ns {
     /// @param ... Objects need to be untracked.
     void (*const multiple_directly_unreachable)(int length, ...);
 
-    /// Run the garbage collector.
-    /// @details Garbage collector may fail to shrink the container but successfully delete
-    /// unreachable objects with error code PL_ERROR_ALLOC_FAIL.\n\n
-    /// This happens when `realloc()` fails to allocate space for a new container.\n\n
-    /// In this case, the garbage collector still keeps all the reachable objects correctly.\n\n
+    /// Run the garbage collector on both generations (major collection).
+    /// @details Reachable objects are marked from the directly reachable objects,
+    /// then the object table and the nursery are swept in one pass.\n\n
+    /// Garbage collector may fail with error code PL_ERROR_ALLOC_FAIL.\n\n
+    /// This happens when `realloc()` fails to grow the mark stack, in which case no
+    /// objects are deleted, or when the object table fails to shrink after the sweep.\n\n
+    /// In both cases, the garbage collector still keeps all the reachable objects correctly.\n\n
     void (*const garbage_collect)(void);
 
-    /// Report the global table.
+    /// Run the garbage collector on the nursery only (minor collection).
+    /// @details Young objects are marked from the directly reachable objects and
+    /// the remembered old objects. Old objects are not visited. Survivors are
+    /// promoted to the old generation after reaching the promotion age.\n\n
+    /// Fails with error code PL_ERROR_ALLOC_FAIL in the same cases as `garbage_collect`.
+    void (*const minor_collect)(void);
+
+    /// Run the garbage collector if the allocation budget is used up.
+    /// @details This is a safe point for automatic collection. It is called at
+    /// the end of the outermost frame. A minor collection runs once the nursery size is
+    /// allocated, and a major collection runs once the bytes promoted since the last
+    /// major collection reach the budget. The budget is the larger of the threshold
+    /// and the old generation after the last major collection times (growth factor - 1).
+    /// Bytes are counted by `new_object` and `resize_object`.
+    void (*const maybe_collect)(void);
+
+    /// Enter a frame. Usually called through `$begin_frame` and `$begin_arena_frame`.
+    void (*const begin_frame)(void);
+
+    /// Leave a frame. Usually called through `$end_frame`.
+    /// @details Calls `maybe_collect` when the outermost frame is left without a pending error.
+    /// Inner frames do not collect, because temporaries of the enclosing frames, e.g. the
+    /// result of an expression not yet `$set` to a variable, are not directly reachable.
+    void (*const end_frame)(void);
+
+    /// Record a write of an object reference into an object.
+    /// @details Usually called through `pl_gc_write_barrier`. Old objects are added to the
+    /// remembered set, and arena objects stored into longer-lived objects are escaped.
+    /// @param x (pl_object). The object being written.
+    /// @param item (pl_object). The object being stored, or NULL to check all the references of `x`.
+    void (*const write_barrier)(pl_object x, pl_object item);
+
+    /// Begin an arena. Usually called through `$begin_arena_frame`.
+    void (*const begin_arena)(void);
+
+    /// End the innermost arena. Usually called through `$end_frame`.
+    /// @details Escaped and directly reachable objects of the arena, and the arena objects
+    /// reachable from them, are moved to the garbage collector. The rest are released.\n\n
+    /// Fails with error code PL_ERROR_ALLOC_FAIL if the objects fail to be moved, in which
+    /// case the arena is still released.
+    void (*const end_arena)(void);
+
+    /// Let an object outlive its arena frame.
+    /// @details Objects owned by the garbage collector are returned as is.
+    /// @param x (pl_object). The object.
+    /// @return The object.
+    pl_object (*const escape)(pl_object x);
+
+    /// Set the minimum number of bytes promoted between two automatic major collections.
+    /// @param bytes (size_t). The threshold.
+    void (*const set_threshold)(size_t bytes);
+
+    /// Set the growth factor of the old generation between two automatic major collections.
+    /// @details A larger factor trades memory for fewer collections.
+    /// @param factor (double). A factor no less than 1.
+    void (*const set_growth_factor)(double factor);
+
+    /// Set the number of bytes allocated in the nursery between two automatic minor collections.
+    /// @param bytes (size_t). The nursery size.
+    void (*const set_nursery_size)(size_t bytes);
+
+    /// Set the number of minor collections an object survives before promotion.
+    /// @param age (int). An age in [1, PL_OBJECT_MAX_AGE].
+    void (*const set_promotion_age)(int age);
+
+    /// Set the number of threads used to mark and sweep.
+    /// @details Collections of at least PL_GC_PARALLEL_MIN_OBJECTS objects are split among
+    /// worker threads that balance the work by stealing. The default is 1 (no worker threads).
+    /// Objects are still deleted by the thread running the collection.
+    /// @param n (int). Number of threads in [1, PL_GC_MAX_PARALLELISM], including the calling thread.
+    void (*const set_parallelism)(int n);
+
+    /// Enable automatic collection at safe points.
+    void (*const enable_auto)(void);
+
+    /// Disable automatic collection at safe points.
+    /// @details `garbage_collect` can still be called manually.
+    void (*const disable_auto)(void);
+
+    /// Serialize all the objects reachable from an object.
+    /// @details The objects stay in the heap of the current thread. External
+    /// pointers are copied as is. The handoff can be passed to another thread.
+    /// @param x (pl_object). The root object.
+    /// @return A handoff owned by the caller.
+    pl_gc_handoff (*const export_graph)(pl_object x);
+
+    /// Rebuild an object graph in the heap of the current thread.
+    /// @details The handoff is released on success, and still owned by the caller on failure.
+    /// The root object is not directly reachable.
+    /// @param handoff (pl_gc_handoff). A handoff created by `export_graph`.
+    /// @return The root object.
+    pl_object (*const import_graph)(pl_gc_handoff handoff);
+
+    /// Rebuild an object graph whose primitive objects share the data of a handoff.
+    /// @details Primitive objects larger than a few hundred bytes point into the handoff
+    /// like slices, and are copied when written. Lists are always rebuilt. The handoff is
+    /// not freed; `release(context)` is called once no object shares its data, which may
+    /// be before this function returns, and is also called on failure. The root object
+    /// is not directly reachable.
+    /// @param handoff (pl_gc_handoff). A handoff that stays valid until released.
+    /// @param release (void (*)(void *)). Called to release the handoff.
+    /// @param context (void *). The context passed to `release`.
+    /// @return The root object.
+    pl_object (*const import_shared_graph)(pl_gc_handoff handoff, void (*release)(void *context), void *context);
+
+    /// Check that a block of memory from outside holds a well-formed handoff.
+    /// @details Throws PL_ERROR_INVALID_FORMAT if the records or references are out of
+    /// bound, or if there are external pointers, which are meaningless outside the process.
+    /// @param bytes (void *). The block, aligned to `long`.
+    /// @param size (size_t). Number of bytes of the block.
+    /// @return The handoff stored in the block.
+    pl_gc_handoff (*const open_handoff)(void *bytes, size_t size);
+
+    /// Get the number of bytes of a handoff.
+    /// @param handoff (pl_gc_handoff). The handoff.
+    /// @return Number of bytes, including the header.
+    size_t (*const handoff_size)(pl_gc_handoff handoff);
+
+    /// Release a handoff that will not be imported.
+    /// @param handoff (pl_gc_handoff). The handoff.
+    void (*const discard_handoff)(pl_gc_handoff handoff);
+
+    /// Report the global table and the nursery.
     void (*const report)(void);
 
+    /// Get the number of bytes allocated by the current thread.
+    /// @details Same as `bytes_allocated` of `stats`. The counter only increases, so the
+    /// difference between two calls is the memory allocated in between.
+    /// @return Number of bytes.
+    size_t (*const allocated_bytes)(void);
+
+    /// Get the statistics of the heap of the current thread.
+    /// @details The counters are maintained on every allocation, so this is cheap.
+    /// @return The statistics.
+    pl_gc_stats (*const stats)(void);
+
+    /// Set the hook of the heap of the current thread.
+    /// @details The hook is called at the beginning and the end of every collection, and
+    /// after large allocations. It must not create objects, run the garbage collector
+    /// or throw.
+    /// @param hook (pl_gc_hook). The hook, or NULL to remove it.
+    /// @param context (void *). Passed to the hook.
+    void (*const set_hook)(pl_gc_hook hook, void *context);
+
+    /// Set the minimum data size of an allocation reported to the hook as large.
+    /// @details The default is PL_GC_DEFAULT_LARGE_ALLOCATION_SIZE.
+    /// @param bytes (size_t). Number of bytes.
+    void (*const set_large_allocation_size)(size_t bytes);
+
+#ifdef PL_GC_PROFILE
+    /// Enter a profiled expression. Used by `pl_gc_profile`.
+    /// @param file (const char *). File name, which must outlive the profile.
+    /// @param line (int). The line number.
+    /// @param function (const char *). Function name, which must outlive the profile.
+    void (*const profile_enter)(const char *file, int line, const char *function);
+
+    /// Leave a profiled expression. Used by `pl_gc_profile`.
+    /// @param x (pl_object). Value of the expression.
+    /// @return The same object.
+    pl_object (*const profile_leave)(pl_object x);
+
+    /// Report the allocation sites of the current thread, by bytes allocated in descending order.
+    /// @details For each site, the report shows the bytes and the objects allocated, the
+    /// objects still alive, and the percentage of objects surviving their first collection.
+    /// @param stream (FILE *). The stream.
+    void (*const profile_report)(FILE *stream);
+
+    /// Reset the counters of the allocation sites of the current thread.
+    void (*const profile_reset)(void);
+#endif//PL_GC_PROFILE
+
     /// Kill the garbage collector and release all memory.
     void (*const kill)(void);
 
     /// Check the status of the garbage collector.
     /// @return 0 for stopped, 1 for working.
     int (*const check_status)(void);
+
+#ifdef PL_TEST
+
+    void (*const test)(void);
+
+#endif//PL_TEST
+
 } pl_gc_ns;
 
 /// Get garbage collector namespace.
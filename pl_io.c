@@ -0,0 +1,351 @@
+//
+// Created by Patrick Li on 14/10/2026.
+//
+
+#include "pl_io.h"
+#include "pl_error.h"
+#include "pl_gc.h"
+#include "stdint.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include "fcntl.h"
+#include "sys/mman.h"
+#include "sys/stat.h"
+#include "unistd.h"
+#define PL_IO_HAS_MMAP
+#endif
+
+#ifdef PL_TEST
+
+#include "pl_unittest.h"
+
+#endif//PL_TEST
+
+/*-----------------------------------------------------------------------------
+ |  File header
+ ----------------------------------------------------------------------------*/
+
+/// The header of a file.
+/// @param magic (char [8]). Always `IO_MAGIC`.
+/// @param version (uint32_t). Version of the file format.
+/// @param byte_order (uint32_t). `IO_BYTE_ORDER` as written by the saving machine.
+/// @param long_size (uint32_t). Size of `long` on the saving machine.
+/// @param pointer_size (uint32_t). Size of pointers on the saving machine.
+/// @param handoff_size (uint64_t). Number of bytes of the handoff following the header.
+typedef struct io_header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t long_size;
+    uint32_t pointer_size;
+    uint64_t handoff_size;
+    char reserved[PL_IO_HEADER_SIZE - 32];
+} io_header;
+
+#define IO_MAGIC "PLOBJ\0\0\0"
+#define IO_BYTE_ORDER 0x01020304u
+
+#define check_null_pointer(x) pl_error_expect((x) != NULL,                      \
+                                              PL_ERROR_UNEXPECTED_NULL_POINTER, \
+                                              "Unexpected NULL pointer `" #x "` provided!")
+
+// Check the header of a file of `file_size` bytes.
+static void check_header(const io_header *const header, const size_t file_size, const char *const path)
+{
+    pl_error_expect(memcmp(header->magic, IO_MAGIC, sizeof(header->magic)) == 0,
+                    PL_ERROR_INVALID_FORMAT,
+                    "File `%s` is not a pl object file!",
+                    path);
+    pl_error_expect(header->version == PL_IO_FORMAT_VERSION,
+                    PL_ERROR_INVALID_FORMAT,
+                    "File `%s` has format version [%u] instead of [%d]!",
+                    path,
+                    header->version,
+                    PL_IO_FORMAT_VERSION);
+    pl_error_expect(header->byte_order == IO_BYTE_ORDER &&
+                        header->long_size == sizeof(long) &&
+                        header->pointer_size == sizeof(void *),
+                    PL_ERROR_INVALID_FORMAT,
+                    "File `%s` is saved by a machine of another byte order or word size!",
+                    path);
+    pl_error_expect(header->handoff_size == file_size - PL_IO_HEADER_SIZE,
+                    PL_ERROR_INVALID_FORMAT,
+                    "File `%s` is truncated!",
+                    path);
+}
+
+/*-----------------------------------------------------------------------------
+ |  Save
+ ----------------------------------------------------------------------------*/
+
+static void save(const char *const path, pl_object x)
+{
+    check_null_pointer(path);
+    check_null_pointer(x);
+
+    const pl_gc_ns gc_ns  = pl_gc_get_ns();
+    pl_gc_handoff handoff = gc_ns.export_graph(x);
+
+    // Variables modified inside `pl_error_try` are volatile, so they are valid in `pl_error_catch`.
+    FILE *volatile file = NULL;
+    pl_error_try
+    {
+        // External pointers are rejected by the same check as loading.
+        const size_t size = gc_ns.handoff_size(handoff);
+        gc_ns.open_handoff(handoff, size);
+
+        io_header header = {.version      = PL_IO_FORMAT_VERSION,
+                            .byte_order   = IO_BYTE_ORDER,
+                            .long_size    = sizeof(long),
+                            .pointer_size = sizeof(void *),
+                            .handoff_size = size};
+        memcpy(header.magic, IO_MAGIC, sizeof(header.magic));
+
+        file = fopen(path, "wb");
+        pl_error_expect(file != NULL, PL_ERROR_IO_FAILED, "Can not open file `%s` for writing!", path);
+        pl_error_expect(fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(handoff, size, 1, file) == 1,
+                        PL_ERROR_IO_FAILED,
+                        "Can not write file `%s`!",
+                        path);
+
+        FILE *const closing = file;
+        file                = NULL;
+        pl_error_expect(fclose(closing) == 0, PL_ERROR_IO_FAILED, "Can not write file `%s`!", path);
+    }
+    pl_error_catch
+    {
+        if (file != NULL)
+            fclose(file);
+        gc_ns.discard_handoff(handoff);
+        pl_error_rethrow();
+    }
+    gc_ns.discard_handoff(handoff);
+}
+
+/*-----------------------------------------------------------------------------
+ |  Load
+ ----------------------------------------------------------------------------*/
+
+static pl_object load(const char *const path)
+{
+    check_null_pointer(path);
+
+    FILE *volatile file = fopen(path, "rb");
+    pl_error_expect(file != NULL, PL_ERROR_IO_FAILED, "Can not open file `%s`!", path);
+
+    void *volatile bytes    = NULL;
+    pl_object volatile root = NULL;
+    pl_error_try
+    {
+        pl_error_expect(fseek(file, 0, SEEK_END) == 0, PL_ERROR_IO_FAILED, "Can not read file `%s`!", path);
+        const long file_size = ftell(file);
+        pl_error_expect(file_size >= PL_IO_HEADER_SIZE && fseek(file, 0, SEEK_SET) == 0,
+                        PL_ERROR_INVALID_FORMAT,
+                        "File `%s` is not a pl object file!",
+                        path);
+
+        io_header header;
+        pl_error_expect(fread(&header, sizeof(header), 1, file) == 1, PL_ERROR_IO_FAILED, "Can not read file `%s`!", path);
+        check_header(&header, (size_t) file_size, path);
+
+        const size_t size = (size_t) header.handoff_size;
+        bytes             = malloc(size > 0 ? size : 1);
+        pl_error_expect(bytes != NULL, PL_ERROR_ALLOC_FAILED, "`malloc()` fails!");
+        pl_error_expect(fread(bytes, size, 1, file) == 1, PL_ERROR_IO_FAILED, "Can not read file `%s`!", path);
+
+        FILE *const closing = file;
+        file                = NULL;
+        fclose(closing);
+
+        // The handoff is freed by a successful import.
+        const pl_gc_ns gc_ns = pl_gc_get_ns();
+        root                 = gc_ns.import_graph(gc_ns.open_handoff(bytes, size));
+    }
+    pl_error_catch
+    {
+        if (file != NULL)
+            fclose(file);
+        free(bytes);
+        pl_error_rethrow();
+    }
+    return root;
+}
+
+/*-----------------------------------------------------------------------------
+ |  Map
+ ----------------------------------------------------------------------------*/
+
+#ifdef PL_IO_HAS_MMAP
+
+/// A private mapping of a file.
+/// @param data (void *). Start of the mapping.
+/// @param size (size_t). Number of bytes of the mapping.
+typedef struct io_mapping
+{
+    void *data;
+    size_t size;
+} io_mapping;
+
+// Unmap a file once no object points into it.
+static void release_mapping(void *const context)
+{
+    io_mapping *const mapping = context;
+    munmap(mapping->data, mapping->size);
+    free(mapping);
+}
+
+static pl_object map(const char *const path)
+{
+    check_null_pointer(path);
+
+    const int fd = open(path, O_RDONLY);
+    pl_error_expect(fd != -1, PL_ERROR_IO_FAILED, "Can not open file `%s`!", path);
+
+    struct stat status;
+    if (fstat(fd, &status) != 0)
+    {
+        close(fd);
+        pl_error_throw(PL_ERROR_IO_FAILED, "Can not read file `%s`!", path);
+    }
+    if (status.st_size < PL_IO_HEADER_SIZE)
+    {
+        close(fd);
+        pl_error_throw(PL_ERROR_INVALID_FORMAT, "File `%s` is not a pl object file!", path);
+    }
+
+    // Pages are copied on write, so a stray write never reaches the file.
+    const size_t file_size = (size_t) status.st_size;
+    void *const data       = mmap(NULL, file_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    pl_error_expect(data != MAP_FAILED, PL_ERROR_IO_FAILED, "Can not map file `%s`!", path);
+
+    io_mapping *const mapping = malloc(sizeof(io_mapping));
+    if (mapping == NULL)
+    {
+        munmap(data, file_size);
+        pl_error_throw(PL_ERROR_ALLOC_FAILED, "`malloc()` fails!");
+    }
+    mapping->data = data;
+    mapping->size = file_size;
+
+    const pl_gc_ns gc_ns           = pl_gc_get_ns();
+    pl_gc_handoff volatile handoff = NULL;
+    pl_error_try
+    {
+        check_header(data, file_size, path);
+        handoff = gc_ns.open_handoff((char *) data + PL_IO_HEADER_SIZE, file_size - PL_IO_HEADER_SIZE);
+    }
+    pl_error_catch
+    {
+        release_mapping(mapping);
+        pl_error_rethrow();
+    }
+
+    // The mapping is released by the import if it fails.
+    return gc_ns.import_shared_graph(handoff, release_mapping, mapping);
+}
+
+#else
+
+static pl_object map(const char *const path)
+{
+    return load(path);
+}
+
+#endif//PL_IO_HAS_MMAP
+
+/*-----------------------------------------------------------------------------
+ |  Test
+ ----------------------------------------------------------------------------*/
+
+#ifdef PL_TEST
+
+#define IO_TEST_PATH "pl_io_test.plobj"
+
+// Check a loaded list of an int vector, a double vector and the int vector again.
+static int test_graph_is(pl_object root, const int *const ints, const double *const doubles)
+{
+    if (root->class != PL_CLASS_LIST || root->length != 3)
+        return 0;
+    const pl_object *const items = root->data;
+    return items[0] == items[2] && items[0]->class == PL_CLASS_INT && items[0]->length == 256 &&
+           memcmp(items[0]->data, ints, 256 * sizeof(int)) == 0 && items[1]->class == PL_CLASS_DOUBLE &&
+           items[1]->length == 2 && memcmp(items[1]->data, doubles, 2 * sizeof(double)) == 0;
+}
+
+// Overwrite `size` bytes of the test file at `offset`.
+static void test_patch_file(const long offset, const void *const bytes, const size_t size)
+{
+    FILE *const file = fopen(IO_TEST_PATH, "r+b");
+    pl_error_expect(file != NULL, PL_ERROR_IO_FAILED, "Can not open file `%s`!", IO_TEST_PATH);
+    fseek(file, offset, SEEK_SET);
+    fwrite(bytes, size, 1, file);
+    fclose(file);
+}
+
+static pl_unittest_summary test_round_trip(void)
+{
+    pl_unittest_summary summary = pl_unittest_new_summary();
+
+    // The int vector is large enough to point into the mapping, and is shared by the list.
+    const pl_object_ns object_ns = pl_object_get_ns();
+    int ints[256];
+    pl_misc_for_i(256) ints[i] = (int) i * 7 - 300;
+    const double doubles[] = {1.5, -0.25};
+    pl_object x    = object_ns.primitive.new_from_array(PL_CLASS_INT, 256, ints);
+    pl_object y    = object_ns.primitive.new_from_array(PL_CLASS_DOUBLE, 2, doubles);
+    pl_object root = object_ns.primitive.new_from_array(PL_CLASS_LIST, 3, (pl_object[]) {x, y, x});
+
+    save(IO_TEST_PATH, root);
+    pl_unittest_expect_true(summary, test_graph_is(load(IO_TEST_PATH), ints, doubles));
+    pl_unittest_expect_true(summary, test_graph_is(map(IO_TEST_PATH), ints, doubles));
+
+    // A corrupted version, a corrupted magic and a truncated file are rejected.
+    const uint32_t version = PL_IO_FORMAT_VERSION + 1;
+    test_patch_file((long) offsetof(io_header, version), &version, sizeof(version));
+    pl_unittest_expect_error_is(summary, PL_ERROR_INVALID_FORMAT, load(IO_TEST_PATH));
+    pl_unittest_expect_error_is(summary, PL_ERROR_INVALID_FORMAT, map(IO_TEST_PATH));
+
+    save(IO_TEST_PATH, root);
+    test_patch_file(0, "XX", 2);
+    pl_unittest_expect_error_is(summary, PL_ERROR_INVALID_FORMAT, load(IO_TEST_PATH));
+    pl_unittest_expect_error_is(summary, PL_ERROR_INVALID_FORMAT, map(IO_TEST_PATH));
+
+    FILE *const file = fopen(IO_TEST_PATH, "wb");
+    pl_error_expect(file != NULL, PL_ERROR_IO_FAILED, "Can not open file `%s` for writing!", IO_TEST_PATH);
+    fwrite(IO_MAGIC, sizeof(IO_MAGIC), 1, file);
+    fclose(file);
+    pl_unittest_expect_error_is(summary, PL_ERROR_INVALID_FORMAT, load(IO_TEST_PATH));
+    pl_unittest_expect_error_is(summary, PL_ERROR_INVALID_FORMAT, map(IO_TEST_PATH));
+
+    remove(IO_TEST_PATH);
+
+    return summary;
+}
+
+static void test(void)
+{
+    printf("In file: %s\n", __FILE__);
+    pl_unittest_print_summary(test_round_trip());
+}
+
+#endif//PL_TEST
+
+/*-----------------------------------------------------------------------------
+ |  Get io namespace
+ ----------------------------------------------------------------------------*/
+
+pl_io_ns pl_io_get_ns(void)
+{
+    static const pl_io_ns io_ns = {.save = save,
+                                   .load = load,
+#ifdef PL_TEST
+                                   .test = test,
+#endif//PL_TEST
+                                   .map  = map};
+    return io_ns;
+}
@@ -0,0 +1,66 @@
+//
+// Created by Patrick Li on 14/10/2026.
+//
+
+#ifndef PL_PL_IO_H
+#define PL_PL_IO_H
+
+#include "pl_object.h"
+
+/*-----------------------------------------------------------------------------
+ |  File format
+ ----------------------------------------------------------------------------*/
+
+/// Version of the file format. Files of other versions are rejected.
+#define PL_IO_FORMAT_VERSION 1
+
+/// Number of bytes of the file header. The handoff of the object graph follows it.
+#define PL_IO_HEADER_SIZE 64
+
+/*-----------------------------------------------------------------------------
+ |  IO namespace
+ ----------------------------------------------------------------------------*/
+
+/// Namespace of io.
+/// @details An object graph is saved as a header followed by its handoff (see `export_graph`),
+/// so classes, lengths, attributes and shared substructure are all kept. The data is stored
+/// in the byte order and word size of the machine, and files from machines that differ are
+/// rejected. External pointers can't be saved.
+typedef struct pl_io_ns
+{
+    /// Save an object graph to a file.
+    /// @details The file is overwritten.
+    /// @param path (const char *). Path of the file.
+    /// @param x (pl_object). The root object.
+    void (*const save)(const char *path, pl_object x);
+
+    /// Load an object graph from a file.
+    /// @details The file is read into memory and can be removed afterwards.
+    /// The root object is not directly reachable.
+    /// @param path (const char *). Path of the file.
+    /// @return The root object.
+    pl_object (*const load)(const char *path);
+
+    /// Map an object graph from a file without reading it.
+    /// @details Primitive objects larger than a few hundred bytes point into a private
+    /// mapping of the file, and are copied when written. The mapping is released once
+    /// no object points into it. Lists and small objects are loaded as by `load`.
+    /// Falls back to `load` on platforms without `mmap()`. The root object is not
+    /// directly reachable.
+    /// @param path (const char *). Path of the file.
+    /// @return The root object.
+    pl_object (*const map)(const char *path);
+
+#ifdef PL_TEST
+
+    void (*const test)(void);
+
+#endif//PL_TEST
+
+} pl_io_ns;
+
+/// Get io namespace.
+/// @return Namespace of io.
+pl_io_ns pl_io_get_ns(void);
+
+#endif//PL_PL_IO_H
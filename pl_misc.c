@@ -3,6 +3,8 @@
 //
 
 #include "pl_misc.h"
+#include "pl_error.h"
+#include "pthread.h"
 #include "stdarg.h"
 
 #ifdef PL_TEST
@@ -141,6 +143,298 @@ static pl_unittest_summary test_compare_pointer(void) {
     return summary;
 }
 
+/*-----------------------------------------------------------------------------
+ |  Parallel for
+ ----------------------------------------------------------------------------*/
+
+/// A fork of the thread pool. It lives on the stack of the forking thread.
+/// @param body (void (*)(void *, int, long, long)). The loop body.
+/// @param context (void *). The context passed to the body.
+/// @param length (long). Number of items.
+/// @param num_chunks (int). Number of chunks.
+/// @param next_chunk (int). The next chunk to be claimed.
+/// @param pending (int). Number of pool threads that have not finished the fork.
+/// @param error (int). The first error raised by a chunk.
+/// @param message (char [PL_ERROR_MAX_MESSAGE_LEN]). The message of the first error.
+typedef struct parallel_fork {
+    void (*body)(void *context, int chunk, long start, long end);
+    void *context;
+    long length;
+    int num_chunks;
+    int next_chunk;
+    int pending;
+    int error;
+    char message[PL_ERROR_MAX_MESSAGE_LEN];
+} parallel_fork;
+
+/// The thread pool is shared by all threads. Only one fork runs at a time.
+/// @param fork_lock (pthread_mutex_t). Held by the forking thread.
+/// @param lock (pthread_mutex_t). Guards the fields below.
+/// @param wake (pthread_cond_t). Signaled when a fork starts or the pool stops.
+/// @param done (pthread_cond_t). Signaled when the last pool thread finishes a fork.
+/// @param threads (pthread_t [PL_MISC_MAX_THREADS]). The pool threads.
+/// @param num_threads (int). Number of pool threads, excluding the forking thread.
+/// @param generation (long). Incremented by every fork.
+/// @param current (parallel_fork *). The running fork.
+/// @param stop (int). Set to stop the pool threads.
+static struct {
+    pthread_mutex_t fork_lock;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    pthread_t threads[PL_MISC_MAX_THREADS];
+    int num_threads;
+    long generation;
+    parallel_fork *current;
+    int stop;
+} global_pool = {.fork_lock = PTHREAD_MUTEX_INITIALIZER,
+                 .lock      = PTHREAD_MUTEX_INITIALIZER,
+                 .wake      = PTHREAD_COND_INITIALIZER,
+                 .done      = PTHREAD_COND_INITIALIZER};
+
+/// Number of threads used by a fork, including the forking thread.
+static int global_num_threads = 1;
+
+/// Minimum number of items of a chunk.
+static int global_grain_size = PL_MISC_DEFAULT_GRAIN_SIZE;
+
+/// Set while the thread runs a chunk. Nested loops run on the calling thread.
+static _Thread_local int global_in_parallel = 0;
+
+// Bounds of a chunk. Chunks are of nearly equal sizes.
+#define parallel_chunk_start(length, num_chunks, chunk) ((length) * (chunk) / (num_chunks))
+
+// Claim and run chunks until none is left. Errors are caught, so that
+// every thread finishes the fork before the error is rethrown.
+static void parallel_run_chunks(parallel_fork *const fork) {
+    global_in_parallel = 1;
+    for (;;) {
+        const int chunk = __atomic_fetch_add(&fork->next_chunk, 1, __ATOMIC_RELAXED);
+        if (chunk >= fork->num_chunks || __atomic_load_n(&fork->error, __ATOMIC_RELAXED) != PL_ERROR_NONE)
+            break;
+
+        pl_error_try {
+            fork->body(fork->context,
+                       chunk,
+                       parallel_chunk_start(fork->length, fork->num_chunks, chunk),
+                       parallel_chunk_start(fork->length, fork->num_chunks, chunk + 1));
+        } pl_error_catch {
+            int expected = PL_ERROR_NONE;
+            if (__atomic_compare_exchange_n(&fork->error, &expected, pl_error_get_current(), 0,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                snprintf(fork->message, PL_ERROR_MAX_MESSAGE_LEN, "%s", pl_error_get_ns().get_error_message());
+        }
+    }
+    global_in_parallel = 0;
+}
+
+static void *parallel_pool_thread(void *const arg) {
+    // The thread waits for the fork after the one running when it was created.
+    long generation = (long) arg;
+
+    pthread_mutex_lock(&global_pool.lock);
+    for (;;) {
+        while (!global_pool.stop && global_pool.generation == generation)
+            pthread_cond_wait(&global_pool.wake, &global_pool.lock);
+        if (global_pool.stop)
+            break;
+
+        generation = global_pool.generation;
+        parallel_fork *const fork = global_pool.current;
+        pthread_mutex_unlock(&global_pool.lock);
+
+        parallel_run_chunks(fork);
+
+        pthread_mutex_lock(&global_pool.lock);
+        if (--fork->pending == 0)
+            pthread_cond_signal(&global_pool.done);
+    }
+    pthread_mutex_unlock(&global_pool.lock);
+    return NULL;
+}
+
+// Stop and join all the pool threads. The fork lock must be held.
+static void parallel_stop_pool(void) {
+    pthread_mutex_lock(&global_pool.lock);
+    global_pool.stop = 1;
+    pthread_cond_broadcast(&global_pool.wake);
+    pthread_mutex_unlock(&global_pool.lock);
+
+    pl_misc_for_i(global_pool.num_threads) pthread_join(global_pool.threads[i], NULL);
+
+    pthread_mutex_lock(&global_pool.lock);
+    global_pool.stop        = 0;
+    global_pool.num_threads = 0;
+    pthread_mutex_unlock(&global_pool.lock);
+}
+
+// Start pool threads until there are `n`. If a thread fails to be created, the pool runs with fewer.
+// The fork lock must be held.
+static void parallel_start_pool(const int n) {
+    pthread_mutex_lock(&global_pool.lock);
+    const long generation = global_pool.generation;
+    pthread_mutex_unlock(&global_pool.lock);
+
+    // New threads wait for the next fork.
+    while (global_pool.num_threads < n) {
+        pthread_t *const thread = &global_pool.threads[global_pool.num_threads];
+        if (pthread_create(thread, NULL, parallel_pool_thread, (void *) (long) generation) != 0)
+            break;
+        global_pool.num_threads++;
+    }
+}
+
+static void set_num_threads(const int n) {
+    pl_error_expect(n >= 1 && n <= PL_MISC_MAX_THREADS,
+                    PL_ERROR_INVALID_ARGUMENT,
+                    "Number of threads [%d] is not in [1, %d]!",
+                    n,
+                    PL_MISC_MAX_THREADS);
+
+    pthread_mutex_lock(&global_pool.fork_lock);
+    if (n - 1 < global_pool.num_threads)
+        parallel_stop_pool();
+    __atomic_store_n(&global_num_threads, n, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&global_pool.fork_lock);
+}
+
+static int get_num_threads(void) {
+    return __atomic_load_n(&global_num_threads, __ATOMIC_RELAXED);
+}
+
+static void set_grain_size(const int n) {
+    pl_error_expect(n >= 1,
+                    PL_ERROR_INVALID_ARGUMENT,
+                    "Grain size [%d] is not positive!",
+                    n);
+    __atomic_store_n(&global_grain_size, n, __ATOMIC_RELAXED);
+}
+
+static int parallel_chunks(const long length) {
+    const int grain_size = __atomic_load_n(&global_grain_size, __ATOMIC_RELAXED);
+    const int num_threads = __atomic_load_n(&global_num_threads, __ATOMIC_RELAXED);
+    const long by_grain = length / grain_size;
+    if (by_grain <= 1 || num_threads == 1)
+        return 1;
+
+    // A few chunks per thread balance uneven chunks.
+    const int by_threads = num_threads * 4;
+    return by_grain < by_threads ? (int) by_grain : by_threads;
+}
+
+static void parallel_for_chunks(const long length, const int num_chunks,
+                                void (*const body)(void *context, int chunk, long start, long end),
+                                void *const context) {
+    if (length <= 0)
+        return;
+
+    pl_error_expect(num_chunks >= 1 && num_chunks <= PL_MISC_MAX_THREADS * 4,
+                    PL_ERROR_INVALID_ARGUMENT,
+                    "Number of chunks [%d] is not in [1, %d]!",
+                    num_chunks,
+                    PL_MISC_MAX_THREADS * 4);
+
+    // Small loops, nested loops, and loops racing with another fork run on the calling thread.
+    if (num_chunks == 1 || global_in_parallel || pthread_mutex_trylock(&global_pool.fork_lock) != 0) {
+        for (int i = 0; i < num_chunks; i++) {
+            body(context,
+                 i,
+                 parallel_chunk_start(length, num_chunks, i),
+                 parallel_chunk_start(length, num_chunks, i + 1));
+        }
+        return;
+    }
+
+    parallel_start_pool(get_num_threads() - 1);
+
+    parallel_fork fork = {.body       = body,
+                          .context    = context,
+                          .length     = length,
+                          .num_chunks = num_chunks};
+
+    pthread_mutex_lock(&global_pool.lock);
+    fork.pending        = global_pool.num_threads;
+    global_pool.current = &fork;
+    global_pool.generation++;
+    pthread_cond_broadcast(&global_pool.wake);
+    pthread_mutex_unlock(&global_pool.lock);
+
+    parallel_run_chunks(&fork);
+
+    pthread_mutex_lock(&global_pool.lock);
+    while (fork.pending > 0)
+        pthread_cond_wait(&global_pool.done, &global_pool.lock);
+    global_pool.current = NULL;
+    pthread_mutex_unlock(&global_pool.lock);
+    pthread_mutex_unlock(&global_pool.fork_lock);
+
+    // Rethrow the first error on the calling thread.
+    if (fork.error != PL_ERROR_NONE) {
+        pl_error_get_ns().restore_error_message(fork.message);
+        pl_error_throw(fork.error, "");
+    }
+}
+
+static void parallel_for(const long length, void (*const body)(void *context, int chunk, long start, long end),
+                         void *const context) {
+    parallel_for_chunks(length, parallel_chunks(length), body, context);
+}
+
+static void test_parallel_square(void *const context, const int chunk, const long start, const long end) {
+    (void) chunk;
+    long *const x = context;
+    pl_misc_for_i(start, end) x[i] = i * i;
+}
+
+static void test_parallel_fail(void *const context, const int chunk, const long start, const long end) {
+    (void) context;
+    (void) start;
+    (void) end;
+    pl_error_expect(chunk != 3, PL_ERROR_INVALID_ARGUMENT, "Chunk [%d] fails!", chunk);
+}
+
+static pl_unittest_summary test_parallel_for(void) {
+    pl_unittest_summary summary = pl_unittest_new_summary();
+
+    const long length = 1000;
+    long x[1000] = {0};
+    set_num_threads(4);
+    set_grain_size(16);
+    parallel_for(length, test_parallel_square, x);
+    int all_squared = 1;
+    pl_misc_for_i(length) all_squared = all_squared && x[i] == i * i;
+    pl_unittest_expect_true(summary, all_squared);
+    pl_unittest_expect_true(summary, parallel_chunks(length) == 16);
+    pl_unittest_expect_true(summary, parallel_chunks(20) == 1);
+
+    volatile int caught = PL_ERROR_NONE;
+    pl_error_try {
+        parallel_for(length, test_parallel_fail, NULL);
+    } pl_error_catch {
+        caught = pl_error_get_current();
+    }
+    pl_unittest_expect_true(summary, caught == PL_ERROR_INVALID_ARGUMENT);
+
+    // Chunks fixed by the caller.
+    pl_misc_for_i(length) x[i] = 0;
+    parallel_for_chunks(length, 5, test_parallel_square, x);
+    all_squared = 1;
+    pl_misc_for_i(length) all_squared = all_squared && x[i] == i * i;
+    pl_unittest_expect_true(summary, all_squared);
+    caught = PL_ERROR_NONE;
+    pl_error_try {
+        parallel_for_chunks(length, 0, test_parallel_square, x);
+    } pl_error_catch {
+        caught = pl_error_get_current();
+    }
+    pl_unittest_expect_true(summary, caught == PL_ERROR_INVALID_ARGUMENT);
+
+    set_num_threads(1);
+    set_grain_size(PL_MISC_DEFAULT_GRAIN_SIZE);
+    pl_unittest_expect_true(summary, parallel_chunks(length * 1000) == 1);
+
+    return summary;
+}
 
 /*-----------------------------------------------------------------------------
  |  Get misc namespace
@@ -153,21 +447,35 @@ static void test(void) {
     pl_unittest_print_summary(test_compare_long());
     pl_unittest_print_summary(test_compare_double());
     pl_unittest_print_summary(test_compare_pointer());
+    pl_unittest_print_summary(test_parallel_for());
 }
 
 pl_misc_ns pl_misc_get_ns(void) {
 #ifdef PL_TEST
-    static const pl_misc_ns misc_ns = {.compare_char    = compare_char,
-            .compare_int     = compare_int,
-            .compare_long    = compare_long,
-            .compare_double  = compare_double,
-            .compare_pointer = compare_pointer,
-            .test            = test};
+    static const pl_misc_ns misc_ns = {.compare_char        = compare_char,
+            .compare_int         = compare_int,
+            .compare_long        = compare_long,
+            .compare_double      = compare_double,
+            .compare_pointer     = compare_pointer,
+            .set_num_threads     = set_num_threads,
+            .get_num_threads     = get_num_threads,
+            .set_grain_size      = set_grain_size,
+            .parallel_chunks     = parallel_chunks,
+            .parallel_for        = parallel_for,
+            .parallel_for_chunks = parallel_for_chunks,
+            .test                = test};
 #else
-    static const pl_misc_ns misc_ns = {.compare_char    = compare_char,
-                                       .compare_int     = compare_int,
-                                       .compare_double  = compare_double,
-                                       .compare_address = compare_address};
+    static const pl_misc_ns misc_ns = {.compare_char        = compare_char,
+                                       .compare_int         = compare_int,
+                                       .compare_long        = compare_long,
+                                       .compare_double      = compare_double,
+                                       .compare_pointer     = compare_pointer,
+                                       .set_num_threads     = set_num_threads,
+                                       .get_num_threads     = get_num_threads,
+                                       .set_grain_size      = set_grain_size,
+                                       .parallel_chunks     = parallel_chunks,
+                                       .parallel_for        = parallel_for,
+                                       .parallel_for_chunks = parallel_for_chunks};
 #endif//PL_TEST
 
     return misc_ns;
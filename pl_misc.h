@@ -43,35 +43,35 @@
 #define pl_misc_for_i_name(line) pl_misc_paste_arg(_i, line)
 #define pl_misc_for_j_name(line) pl_misc_paste_arg(_j, line)
 
-/// A variadic macro similar to `range()` in python. The counter i is an int.
+/// A variadic macro similar to `range()` in python. The counter i is a long.
 /// @arg1 start (int). The start.
 /// @arg2 start (int), end (int). The start and the end.
 /// @arg3 start (int), end (int), step (int). The start, the end and the step size.
 #define pl_misc_for_i(...) pl_misc_arg4(__VA_ARGS__, pl_misc_for_i_3, pl_misc_for_i_2, pl_misc_for_i_1)(__VA_ARGS__)
-#define pl_misc_for_i_1(end)                      \
-    const int pl_misc_for_i_name(__LINE__) = end; \
-    for (int i = 0; i < pl_misc_for_i_name(__LINE__); i++)
-#define pl_misc_for_i_2(start, end)               \
-    const int pl_misc_for_i_name(__LINE__) = end; \
-    for (int i = start; i < pl_misc_for_i_name(__LINE__); i++)
-#define pl_misc_for_i_3(start, end, step)         \
-    const int pl_misc_for_i_name(__LINE__) = end; \
-    for (int i = start; i < pl_misc_for_i_name(__LINE__); i += (step))
-
-/// A variadic macro similar to `range()` in python. The counter j is an int.
+#define pl_misc_for_i_1(end)                       \
+    const long pl_misc_for_i_name(__LINE__) = end; \
+    for (long i = 0; i < pl_misc_for_i_name(__LINE__); i++)
+#define pl_misc_for_i_2(start, end)                \
+    const long pl_misc_for_i_name(__LINE__) = end; \
+    for (long i = start; i < pl_misc_for_i_name(__LINE__); i++)
+#define pl_misc_for_i_3(start, end, step)          \
+    const long pl_misc_for_i_name(__LINE__) = end; \
+    for (long i = start; i < pl_misc_for_i_name(__LINE__); i += (step))
+
+/// A variadic macro similar to `range()` in python. The counter j is a long.
 /// @arg1 start (int). The start.
 /// @arg2 start (int), end (int). The start and the end.
 /// @arg3 start (int), end (int), step (int). The start, the end and the step size.
 #define pl_misc_for_j(...) pl_misc_arg4(__VA_ARGS__, pl_misc_for_j_3, pl_misc_for_j_2, pl_misc_for_j_1)(__VA_ARGS__)
-#define pl_misc_for_j_1(end)                      \
-    const int pl_misc_for_j_name(__LINE__) = end; \
-    for (int j = 0; j < pl_misc_for_j_name(__LINE__); j++)
-#define pl_misc_for_j_2(start, end)               \
-    const int pl_misc_for_j_name(__LINE__) = end; \
-    for (int j = start; j < pl_misc_for_j_name(__LINE__); j++)
-#define pl_misc_for_j_3(start, end, step)         \
-    const int pl_misc_for_j_name(__LINE__) = end; \
-    for (int j = start; j < pl_misc_for_i_name(__LINE__); j += (step))
+#define pl_misc_for_j_1(end)                       \
+    const long pl_misc_for_j_name(__LINE__) = end; \
+    for (long j = 0; j < pl_misc_for_j_name(__LINE__); j++)
+#define pl_misc_for_j_2(start, end)                \
+    const long pl_misc_for_j_name(__LINE__) = end; \
+    for (long j = start; j < pl_misc_for_j_name(__LINE__); j++)
+#define pl_misc_for_j_3(start, end, step)          \
+    const long pl_misc_for_j_name(__LINE__) = end; \
+    for (long j = start; j < pl_misc_for_j_name(__LINE__); j += (step))
 
 /*-----------------------------------------------------------------------------
  |  Paste argument
@@ -204,6 +204,16 @@
         var1 = var2 = var3 = var4 = var5 = var6 = var7 = var8 = var9 = var10 = var11 = var12 = var13 = var14 = var15 = var16 = var17 = var18 = var19 = var20 = constant;       \
     } while (0)
 
+/*-----------------------------------------------------------------------------
+ |  Parallel
+ ----------------------------------------------------------------------------*/
+
+/// Maximum number of threads of parallel loops, including the calling thread.
+#define PL_MISC_MAX_THREADS 64
+
+/// Default minimum number of items of a chunk of a parallel loop.
+#define PL_MISC_DEFAULT_GRAIN_SIZE 65536
+
 /*-----------------------------------------------------------------------------
  |  Misc namespace
  ----------------------------------------------------------------------------*/
@@ -244,6 +254,53 @@ typedef struct pl_misc_ns {
     /// @return 1 if a > b, -1 if a \< b and 0 if a == b.
     int (*const compare_pointer)(const void *a, const void *b);
 
+    /*-----------------------------------------------------------------------------
+     |  Parallel
+     ----------------------------------------------------------------------------*/
+
+    /// Set the number of threads used by parallel loops.
+    /// @details The default is 1 (no pool threads). Pool threads are shared by
+    /// all threads and started by the first parallel loop that needs them.
+    /// @param n (int). Number of threads in [1, PL_MISC_MAX_THREADS], including the calling thread.
+    void (*const set_num_threads)(int n);
+
+    /// Get the number of threads used by parallel loops.
+    /// @return Number of threads, including the calling thread.
+    int (*const get_num_threads)(void);
+
+    /// Set the minimum number of items of a chunk of a parallel loop.
+    /// @details Loops shorter than two grains run on the calling thread.
+    /// The default is PL_MISC_DEFAULT_GRAIN_SIZE.
+    /// @param n (int). A positive grain size.
+    void (*const set_grain_size)(int n);
+
+    /// Get the number of chunks a parallel loop over `length` items is split into.
+    /// @details Chunks are of nearly equal sizes and are passed to the body in
+    /// ascending order of items. This can be used to size per-chunk buffers.
+    /// @param length (long). Number of items.
+    /// @return Number of chunks.
+    int (*const parallel_chunks)(long length);
+
+    /// Run a loop body over chunks of [0, length) with the thread pool.
+    /// @details The body is called once per chunk with the chunk index and the
+    /// item range [start, end). It must not allocate objects, since the heap is
+    /// thread-local. If the body throws, the first error is rethrown on the calling
+    /// thread after all the chunks are finished. Nested loops run on the calling thread.
+    /// @param length (long). Number of items.
+    /// @param body (void (*)(void *, int, long, long)). The loop body.
+    /// @param context (void *). The context passed to the body.
+    void (*const parallel_for)(long length, void (*body)(void *context, int chunk, long start, long end), void *context);
+
+    /// Run a loop body over a given number of chunks of [0, length) with the thread pool.
+    /// @details Same as `parallel_for`, but the chunks are fixed by the caller, so that
+    /// several loops sharing per-chunk buffers agree on them even if the number of threads
+    /// or the grain size changes in between.
+    /// @param length (long). Number of items.
+    /// @param num_chunks (int). Number of chunks in [1, 4 * PL_MISC_MAX_THREADS], usually from `parallel_chunks`.
+    /// @param body (void (*)(void *, int, long, long)). The loop body.
+    /// @param context (void *). The context passed to the body.
+    void (*const parallel_for_chunks)(long length, int num_chunks, void (*body)(void *context, int chunk, long start, long end), void *context);
+
 #ifdef PL_TEST
 
     void (*const test)(void);
@@ -5,13 +5,31 @@
 #include "pl_object.h"
 #include "pl_class.h"
 #include "pl_gc.h"
+#include "pl_symbol.h"
+#include "pthread.h"
 #include "stdarg.h"
+#include "stdint.h"
 #include "stdio.h"
+#include "stdlib.h"
 #include "string.h"
 
+#ifdef PL_TEST
+
+#include "pl_unittest.h"
+
+#endif//PL_TEST
+
+#if defined(__x86_64__) || defined(__i386__)
+#include "immintrin.h"
+#elif defined(__aarch64__)
+#include "arm_neon.h"
+#endif
+
 static pl_object copy(pl_object x);
+static void convert_into(pl_object dst, pl_object x, int type, int target);
 
-static int pl_object_print_num_decimals = 2;
+static _Thread_local int pl_object_print_num_decimals = 2;
+static _Thread_local int pl_object_print_max_items = 0;
 
 /*-----------------------------------------------------------------------------
  |  Checks
@@ -23,7 +41,7 @@ static int pl_object_print_num_decimals = 2;
 
 #define check_object_type(object, this_type)                              \
     do {                                                                  \
-        const int object_type = pl_class_get_ns().type((object)->class);  \
+        const int object_type = pl_object_type(object);                   \
         pl_error_expect(object_type == (this_type),                       \
                         PL_ERROR_INVALID_CLASS,                           \
                         "Object `" #object "` [%s] is not of type [%s]!", \
@@ -31,11 +49,19 @@ static int pl_object_print_num_decimals = 2;
                         PL_CLASS_NAME[this_type]);                        \
     } while (0)
 
+#define check_index_type(object)                                                     \
+    do {                                                                             \
+        const int object_type = pl_object_type(object);                              \
+        pl_error_expect(object_type == PL_CLASS_INT || object_type == PL_CLASS_LONG, \
+                        PL_ERROR_INVALID_CLASS,                                      \
+                        "Object `" #object "` [%s] is not of type [int] or [long]!", \
+                        PL_CLASS_NAME[object_type]);                                 \
+    } while (0)
+
 #define check_same_type(x, y)                                                                    \
     do {                                                                                         \
-        const pl_class_ns class_ns = pl_class_get_ns();                                          \
-        const int x_type           = class_ns.type((x)->class);                                  \
-        const int y_type           = class_ns.type((y)->class);                                  \
+        const int x_type = pl_object_type(x);                                                    \
+        const int y_type = pl_object_type(y);                                                    \
         pl_error_expect(x_type == y_type,                                                        \
                         PL_ERROR_INVALID_CLASS,                                                  \
                         "Object `" #x "` [%s] is not of the same type as object `" #y "` [%s]!", \
@@ -43,33 +69,280 @@ static int pl_object_print_num_decimals = 2;
                         PL_CLASS_NAME[y_type]);                                                  \
     } while (0)
 
-#define check_object_length(object, len) pl_error_expect((object)->length == (len),                               \
-                                                         PL_ERROR_INVALID_LENGTH,                                 \
-                                                         "Object `" #object "` has length [%d] instead of [%d]!", \
-                                                         (object)->length,                                        \
-                                                         len)
+#define check_object_length(object, len) pl_error_expect((object)->length == (len),                                 \
+                                                         PL_ERROR_INVALID_LENGTH,                                   \
+                                                         "Object `" #object "` has length [%ld] instead of [%ld]!", \
+                                                         (object)->length,                                          \
+                                                         (long) (len))
 
-#define check_index_out_of_bound(object, index) pl_error_expect(((index) >= 0) && ((index) <= (object)->length - 1),                       \
-                                                                PL_ERROR_INDEX_OUT_OF_BOUND,                                               \
-                                                                "Index [%d] out of bound [0, %d) while accessing elements of!" #object "", \
-                                                                index,                                                                     \
+#define check_index_out_of_bound(object, index) pl_error_expect(((index) >= 0) && ((index) <= (object)->length - 1),                         \
+                                                                PL_ERROR_INDEX_OUT_OF_BOUND,                                                 \
+                                                                "Index [%ld] out of bound [0, %ld) while accessing elements of!" #object "", \
+                                                                (long) (index),                                                              \
                                                                 (object)->length)
 
 #define check_missing_value(x) pl_error_expect(!pl_is_na(x),        \
                                                PL_ERROR_INVALID_NA, \
                                                "Unexpected missing value `" #x "` !")
 
-#define check_incompatible_length(target, provided) pl_error_expect(((target) == (provided)) || ((provided) == 1),                             \
-                                                                    PL_ERROR_INCOMPATIBLE_LENGTH,                                              \
-                                                                    "Incompatible length [%d] provided! Expecting length [1] or length [%d]!", \
-                                                                    target,                                                                    \
-                                                                    provided)
+// Shared data is copied before it is written.
+#define prepare_write(x)                     \
+    do {                                     \
+        if ((x)->buffer != NULL)             \
+            pl_gc_get_ns().detach_object(x); \
+    } while (0)
+
+static pl_object primitive_new(int class, long capacity);
+static void primitive_reserve(pl_object x, long capacity);
+
+// Prepare the destination of a producer for `length` items of class `class`.
+// A new object is created if `dst` is NULL. Otherwise, `dst` is reused and only grows
+// when its capacity is insufficient. The destination can't be one of the operands.
+static pl_object prepare_destination(pl_object dst, const int class, const long length, pl_object x, pl_object y) {
+    if (dst == NULL) {
+        pl_object object = primitive_new(class, length == 0 ? 1 : length);
+        object->length = length;
+        return object;
+    }
+
+    check_object_type(dst, pl_class_get_ns().type(class));
+    pl_error_expect(dst != x && dst != y,
+                    PL_ERROR_INVALID_ARGUMENT,
+                    "The destination can't be an operand!");
+    if (dst->capacity < length)
+        primitive_reserve(dst, length);
+    prepare_write(dst);
+    dst->length = length;
+    return dst;
+}
+
+// A reused list or string destination may be old, so the references written into it are recorded.
+#define finish_destination(dst, object)                                   \
+    do {                                                                  \
+        if ((dst) != NULL && (pl_object_type(object) == PL_CLASS_LIST ||  \
+                              pl_object_type(object) == PL_CLASS_STRING)) \
+            pl_gc_write_barrier(object, NULL);                            \
+    } while (0)
+
+// Operands of a kernel split into chunks by `parallel_for`. Chunks of large objects
+// run on the thread pool, so the chunk bodies neither allocate nor touch the heap.
+// Operands of length 1 are recycled.
+typedef struct parallel_operands {
+    const void *x;
+    long x_length;
+    const void *y;
+    long y_length;
+    void *result;
+    long *offsets;
+    void (*convert)(const void *, void *, long);
+    int x_class;
+    int result_class;
+} parallel_operands;
+
+// Offset an operand to the start of a chunk, unless it is recycled.
+#define parallel_offset(array, type, array_length, start) ((const type *) (array) + ((array_length) == 1 ? 0 : (start)))
+
+// Classes holding one C item per element, as X(prefix, class, name, type, na). A kernel template is
+// instantiated for every class by passing a generator as X, and its dispatch table indexed by the
+// underlying type is filled by passing `kernel_entry`. Booleans are packed into blocks, and the items
+// of strings are stored from C strings, so their kernels are written out where they differ.
+#define pl_object_plain_types(X, prefix)                     \
+    X(prefix, PL_CLASS_CHAR, char, char, PL_CHAR_NA)         \
+    X(prefix, PL_CLASS_INT, int, int, PL_INT_NA)             \
+    X(prefix, PL_CLASS_LONG, long, long, PL_LONG_NA)         \
+    X(prefix, PL_CLASS_DOUBLE, double, double, PL_DOUBLE_NA) \
+    X(prefix, PL_CLASS_LIST, list, pl_object, PL_LIST_NA)    \
+    X(prefix, PL_CLASS_EXTERNAL, external, void *, PL_EXTERNAL_NA)
+
+// Plain classes and strings, whose items are moved as offsets and lengths into their byte buffers.
+#define pl_object_item_types(X, prefix) \
+    pl_object_plain_types(X, prefix)    \
+    X(prefix, PL_CLASS_STRING, string, pl_object_string_item, string_na_item)
+
+// The entry of the kernel `prefix##_##name` in a dispatch table.
+#define kernel_entry(prefix, class, name, type, na) [class] = prefix##_##name,
+
+// Flags of the items excluded by `indices`. The flags live in a thread-local buffer reused
+// by the next call, so the callers have nothing to release if anything throws in between.
+static _Thread_local char *global_exclusion_flags = NULL;
+static _Thread_local size_t global_exclusion_capacity = 0;
+
+#define EXCLUSION_FLAGS_KEEP_CAPACITY ((size_t) 1 << 20)
+
+static char *exclusion_flags(pl_object x, const long length, const int *const indices) {
+    check_null_pointer(indices);
+
+    // Check index out of bound.
+    pl_misc_for_i(length) {
+        if (!pl_is_na(indices[i]))
+            check_index_out_of_bound(x, indices[i]);
+    }
+
+    const size_t size = (size_t) x->length + 1;
+    if (size > global_exclusion_capacity) {
+        char *const flags = realloc(global_exclusion_flags, size);
+        pl_error_expect(flags != NULL, PL_ERROR_ALLOC_FAILED, "`realloc()` fails!");
+        global_exclusion_flags = flags;
+        global_exclusion_capacity = size;
+    }
+    char *const flags = global_exclusion_flags;
+    memset(flags, 0, size);
+    pl_misc_for_i(length) if (!pl_is_na(indices[i])) flags[indices[i]] = 1;
+    return flags;
+}
+
+// Done with the flags. Large buffers are returned to the system.
+static void release_exclusion_flags(void) {
+    if (global_exclusion_capacity > EXCLUSION_FLAGS_KEEP_CAPACITY) {
+        free(global_exclusion_flags);
+        global_exclusion_flags = NULL;
+        global_exclusion_capacity = 0;
+    }
+}
+
+#define check_incompatible_length(target, provided) pl_error_expect(((target) == (provided)) || ((provided) == 1),                               \
+                                                                    PL_ERROR_INCOMPATIBLE_LENGTH,                                                \
+                                                                    "Incompatible length [%ld] provided! Expecting length [1] or length [%ld]!", \
+                                                                    (long) (target),                                                             \
+                                                                    (long) (provided))
+
+/*-----------------------------------------------------------------------------
+ |  Boolean blocks
+ ----------------------------------------------------------------------------*/
+
+// Number of blocks holding `length` Booleans.
+#define bool_num_blocks(length) (((length) + PL_OBJECT_BOOL_BLOCK - 1) / PL_OBJECT_BOOL_BLOCK)
+
+// Bits of a block holding items of an object of length `length`. Bits past the length are
+// unspecified, so they are masked before they are counted or compared.
+#define bool_block_mask(length, block)                                          \
+    ((length) - (long) (block) * PL_OBJECT_BOOL_BLOCK >= PL_OBJECT_BOOL_BLOCK \
+         ? ~(uint64_t) 0                                                        \
+         : ((uint64_t) 1 << ((length) % PL_OBJECT_BOOL_BLOCK)) - 1)
+
+// Move `length` items of class `class` from `src_start` of `src` to `dst_start` of `dst`.
+// The ranges may overlap. Booleans are moved block by block when both ranges start on a block
+// boundary, otherwise item by item. The items of strings are moved without their byte buffers.
+static void move_items(const int class, void *const dst, const long dst_start, const void *const src,
+                       const long src_start, const long length) {
+    if (class == PL_CLASS_STRING) {
+        memmove(pl_object_string_items(dst) + dst_start,
+                pl_object_string_items(src) + src_start,
+                (size_t) length * sizeof(pl_object_string_item));
+        return;
+    }
+
+    if (class != PL_CLASS_BOOL) {
+        memmove((char *) dst + pl_object_data_size(class, dst_start),
+                (const char *) src + pl_object_data_size(class, src_start),
+                pl_object_data_size(class, length));
+        return;
+    }
+
+    if (dst_start % PL_OBJECT_BOOL_BLOCK == 0 && src_start % PL_OBJECT_BOOL_BLOCK == 0) {
+        const long blocked = length / PL_OBJECT_BOOL_BLOCK * PL_OBJECT_BOOL_BLOCK;
+        memmove((char *) dst + pl_object_bool_data_size(dst_start),
+                (const char *) src + pl_object_bool_data_size(src_start),
+                pl_object_bool_data_size(blocked));
+        for (long i = blocked; i < length; i++)
+            pl_object_bool_set(dst, dst_start + i, pl_object_bool_get(src, src_start + i));
+    } else if (dst == src && dst_start > src_start) {
+        for (long i = length - 1; i >= 0; i--)
+            pl_object_bool_set(dst, dst_start + i, pl_object_bool_get(src, src_start + i));
+    } else {
+        pl_misc_for_i(length) pl_object_bool_set(dst, dst_start + i, pl_object_bool_get(src, src_start + i));
+    }
+}
+
+/*-----------------------------------------------------------------------------
+ |  String items
+ ----------------------------------------------------------------------------*/
+
+// The item of a missing string.
+#define string_na_item ((pl_object_string_item) {.offset = 0, .length = PL_LONG_NA})
+
+// Items of an object. The items of a string follow the pointer to its byte buffer.
+#define object_items(x) \
+    (pl_object_type(x) == PL_CLASS_STRING ? (void *) pl_object_string_items((x)->data) : (x)->data)
+
+// Strings built from the items of `x` share its byte buffer. Producers record it by `finish_destination`.
+#define share_bytes(object, x) (pl_object_string_bytes((object)->data) = pl_object_string_bytes((x)->data))
+
+// Append `length` bytes and a null terminator to the byte buffer of a string, which is created
+// if it does not exist. Returns the offset of the bytes. The bytes may live in the buffer itself.
+static long string_append_bytes(pl_object x, const char *bytes, const long length) {
+    pl_object buffer = pl_object_string_bytes(x->data);
+    if (buffer == NULL) {
+        buffer = primitive_new(PL_CLASS_CHAR, length + 1);
+        pl_object_string_bytes(x->data) = buffer;
+        pl_gc_write_barrier(x, buffer);
+    }
+
+    const long offset = buffer->length;
+    pl_error_expect(length < PL_OBJECT_MAX_CAPACITY - offset,
+                    PL_ERROR_INVALID_CAPACITY,
+                    "Invalid capacity [%ld]!",
+                    offset + length + 1);
+
+    // The buffer may move when it grows or when its shared data is copied.
+    const uintptr_t position = (uintptr_t) bytes - (uintptr_t) buffer->data;
+    const int is_inside = (uintptr_t) bytes >= (uintptr_t) buffer->data && position < (uintptr_t) offset;
+    primitive_reserve(buffer, offset + length + 1);
+    prepare_write(buffer);
+    if (is_inside)
+        bytes = (const char *) buffer->data + position;
+
+    char *const data_array = buffer->data;
+    memcpy(data_array + offset, bytes, (size_t) length);
+    data_array[offset + length] = '\0';
+    buffer->length = offset + length + 1;
+    return offset;
+}
+
+// Store a null-terminated string, or NULL for NA, in the byte buffer of a string.
+static pl_object_string_item string_store(pl_object x, const char *const item) {
+    if (item == NULL)
+        return string_na_item;
+    const long length = (long) strlen(item);
+    if (length == 0)
+        return (pl_object_string_item) {.offset = 0, .length = 0};
+    return (pl_object_string_item) {.offset = string_append_bytes(x, item, length), .length = length};
+}
+
+// Items of `y` written into `x` must refer to the byte buffer of `x`. Returns `y` if they do, sharing
+// the buffer of `y` if `x` has none. Otherwise, returns a new string holding the items of `y` whose
+// bytes are appended to the buffer of `x`.
+static pl_object string_adopt(pl_object x, pl_object y) {
+    pl_object bytes = pl_object_string_bytes(y->data);
+    if (bytes == NULL || bytes == pl_object_string_bytes(x->data))
+        return y;
+    if (pl_object_string_bytes(x->data) == NULL) {
+        prepare_write(x);
+        pl_object_string_bytes(x->data) = bytes;
+        pl_gc_write_barrier(x, bytes);
+        return y;
+    }
+
+    pl_object object = primitive_new(PL_CLASS_STRING, y->length == 0 ? 1 : y->length);
+    object->length = y->length;
+    share_bytes(object, x);
+    const pl_object_string_item *const src_array = pl_object_string_items(y->data);
+    pl_object_string_item *const data_array = pl_object_string_items(object->data);
+    pl_misc_for_i(y->length) {
+        data_array[i] = src_array[i];
+        if (!pl_is_na(src_array[i].length) && src_array[i].length > 0)
+            data_array[i].offset = string_append_bytes(object,
+                                                       (const char *) bytes->data + src_array[i].offset,
+                                                       src_array[i].length);
+    }
+    return object;
+}
 
 /*-----------------------------------------------------------------------------
  |  Primitive new
  ----------------------------------------------------------------------------*/
 
-static pl_object primitive_new(const int class, const int capacity) {
+static pl_object primitive_new(const int class, const long capacity) {
     return pl_gc_get_ns().new_object(class, capacity);
 }
 
@@ -78,18 +351,24 @@ static pl_object primitive_new(const int class, const int capacity) {
  ----------------------------------------------------------------------------*/
 
 // If `length` is zero, an empty object will be returned. The `array` will not be used.
-static pl_object primitive_new_from_array(const int class, const int length, const void *const array) {
+static pl_object primitive_new_from_array(const int class, const long length, const void *const array) {
     if (length == 0)
         return primitive_new(class, 1);
     pl_error_expect(length > 0,
                     PL_ERROR_INVALID_LENGTH,
-                    "Invalid length [%d]!",
+                    "Invalid length [%ld]!",
                     length);
     check_null_pointer(array);
 
     pl_object object = primitive_new(class, length);
     object->length = length;
 
+    if (pl_class_get_ns().type(class) == PL_CLASS_STRING) {
+        const char *const *const src_array = array;
+        pl_misc_for_i(length) pl_object_string_items(object->data)[i] = string_store(object, src_array[i]);
+        return object;
+    }
+
     memmove(object->data,
             array,
             pl_object_data_size(class, length));
@@ -101,12 +380,12 @@ static pl_object primitive_new_from_array(const int class, const int length, con
  ----------------------------------------------------------------------------*/
 
 // If `length` is zero, an empty object will be returned.
-static pl_object primitive_new_from_variadic(const int class, const int length, ...) {
+static pl_object primitive_new_from_variadic(const int class, const long length, ...) {
     if (length == 0)
         return primitive_new(class, 1);
     pl_error_expect(length > 0,
                     PL_ERROR_INVALID_LENGTH,
-                    "Invalid length [%d]!",
+                    "Invalid length [%ld]!",
                     length);
 
     pl_object object = primitive_new(class, length);
@@ -148,6 +427,14 @@ static pl_object primitive_new_from_variadic(const int class, const int length,
             pl_misc_for_i(length) data_array[i] = va_arg(ap, void *);
             break;
         }
+        case PL_CLASS_BOOL: {
+            pl_misc_for_i(length) pl_object_bool_set(object->data, i, va_arg(ap, int));
+            break;
+        }
+        case PL_CLASS_STRING: {
+            pl_misc_for_i(length) pl_object_string_items(object->data)[i] = string_store(object, va_arg(ap, const char *));
+            break;
+        }
         default:
             break;
     }
@@ -164,6 +451,11 @@ static pl_object primitive_new_from_variadic(const int class, const int length,
 static void primitive_to_array(pl_object x, void *const array) {
     check_null_pointer(x);
     check_null_pointer(array);
+    if (pl_object_type(x) == PL_CLASS_STRING) {
+        const char **const data_array = array;
+        pl_misc_for_i(x->length) data_array[i] = pl_object_string_get(x->data, i);
+        return;
+    }
     memmove(array,
             x->data,
             pl_object_data_size(x->class, x->length));
@@ -173,7 +465,7 @@ static void primitive_to_array(pl_object x, void *const array) {
  |  Primitive reserve
  ----------------------------------------------------------------------------*/
 
-static void primitive_reserve(pl_object x, const int capacity) {
+static void primitive_reserve(pl_object x, const long capacity) {
     pl_gc_get_ns().reserve_object(x, capacity);
 }
 
@@ -182,7 +474,7 @@ static void primitive_reserve(pl_object x, const int capacity) {
  ----------------------------------------------------------------------------*/
 
 // Data may be lost due to the shrink.
-static void primitive_shrink(pl_object x, const int capacity) {
+static void primitive_shrink(pl_object x, const long capacity) {
     check_null_pointer(x);
     check_missing_value(capacity);
 
@@ -196,16 +488,17 @@ static void primitive_shrink(pl_object x, const int capacity) {
  |  Primitive set
  ----------------------------------------------------------------------------*/
 
-#define primitive_set_type_template(this_type, this_class)                                    \
-    static void primitive_set_##this_type(pl_object x, const int index, const this_type item) \
-    {                                                                                         \
-        check_null_pointer(x);                                                                \
-        if (pl_is_na(index))                                                                  \
-            return;                                                                           \
-        check_index_out_of_bound(x, index);                                                   \
-        check_object_type(x, this_class);                                                     \
-                                                                                              \
-        ((this_type *) x->data)[index] = item;                                                \
+#define primitive_set_type_template(this_type, this_class)                                     \
+    static void primitive_set_##this_type(pl_object x, const long index, const this_type item) \
+    {                                                                                          \
+        check_null_pointer(x);                                                                 \
+        if (pl_is_na(index))                                                                   \
+            return;                                                                            \
+        check_index_out_of_bound(x, index);                                                    \
+        check_object_type(x, this_class);                                                      \
+        prepare_write(x);                                                                      \
+                                                                                               \
+        ((this_type *) x->data)[index] = item;                                                 \
     }
 
 
@@ -217,99 +510,140 @@ primitive_set_type_template(long, PL_CLASS_LONG);
 
 primitive_set_type_template(double, PL_CLASS_DOUBLE);
 
-static void primitive_set_object(pl_object x, const int index, pl_object item) {
+static void primitive_set_object(pl_object x, const long index, pl_object item) {
     check_null_pointer(x);
     if (pl_is_na(index))
         return;
     check_index_out_of_bound(x, index);
     check_object_type(x, PL_CLASS_LIST);
+    prepare_write(x);
 
     ((pl_object *) x->data)[index] = item;
+    pl_gc_write_barrier(x, item);
 }
 
-static void primitive_set_external(pl_object x, const int index, void *item) {
+static void primitive_set_external(pl_object x, const long index, void *item) {
     check_null_pointer(x);
     if (pl_is_na(index))
         return;
     check_index_out_of_bound(x, index);
     check_object_type(x, PL_CLASS_EXTERNAL);
+    prepare_write(x);
 
     ((void **) x->data)[index] = item;
 }
 
+static void primitive_set_bool(pl_object x, const long index, const int item) {
+    check_null_pointer(x);
+    if (pl_is_na(index))
+        return;
+    check_index_out_of_bound(x, index);
+    check_object_type(x, PL_CLASS_BOOL);
+    prepare_write(x);
+
+    pl_object_bool_set(x->data, index, item);
+}
+
+static void primitive_set_string(pl_object x, const long index, const char *item) {
+    check_null_pointer(x);
+    if (pl_is_na(index))
+        return;
+    check_index_out_of_bound(x, index);
+    check_object_type(x, PL_CLASS_STRING);
+    prepare_write(x);
+
+    pl_object_string_items(x->data)[index] = string_store(x, item);
+}
+
 /*-----------------------------------------------------------------------------
  |  Primitive set by indices
  ----------------------------------------------------------------------------*/
 
-// If an index of `indices` is NA, the corresponding value will not be set.
-// If `length` is zero, no items will be set and `array` will not be used.
-static void primitive_set_by_indices(pl_object x, const int length, const int *const indices, const void *const array) {
-    check_null_pointer(x);
+// Write the items of `array` to the positions `indices` of x. NA indices are skipped.
+#define pl_object_index_set_kernel(name, index_type, type)                                                       \
+    static void name(pl_object x, const long length, const index_type *const indices, const void *const array) { \
+        type *const data_array = x->data;                                                                        \
+        type const *const src_array = array;                                                                     \
+        for (long i = 0; i < length; i++)                                                                        \
+            if (!pl_is_na(indices[i]))                                                                           \
+                data_array[indices[i]] = src_array[i];                                                           \
+    }
 
-    check_missing_value(length);
-    if (length == 0)
-        return;
-    pl_error_expect(length > 0,
-                    PL_ERROR_INVALID_LENGTH,
-                    "Invalid length [%d]!",
-                    length);
+#define pl_object_index_set_bool_kernel(name, index_type)                                                        \
+    static void name(pl_object x, const long length, const index_type *const indices, const void *const array) { \
+        for (long i = 0; i < length; i++)                                                                        \
+            if (!pl_is_na(indices[i]))                                                                           \
+                pl_object_bool_set(x->data, indices[i], pl_object_bool_get(array, i));                           \
+    }
 
-    check_null_pointer(indices);
-    pl_misc_for_i(length) {
-        if (!pl_is_na(indices[i]))
-            check_index_out_of_bound(x, indices[i]);
+// Items of strings are stored from C strings.
+#define pl_object_index_set_string_kernel(name, index_type)                                                      \
+    static void name(pl_object x, const long length, const index_type *const indices, const void *const array) { \
+        const char *const *const src_array = array;                                                              \
+        for (long i = 0; i < length; i++)                                                                        \
+            if (!pl_is_na(indices[i]))                                                                           \
+                pl_object_string_items(x->data)[indices[i]] = string_store(x, src_array[i]);                     \
     }
 
-    check_null_pointer(array);
+#define index_set_kernel(prefix, class, name, type, na) pl_object_index_set_kernel(prefix##_##name, int, type)
+#define index_set_by_long_kernel(prefix, class, name, type, na) pl_object_index_set_kernel(prefix##_##name, long, type)
 
-    const int type = pl_class_get_ns().type(x->class);
-    switch (type) {
-        case PL_CLASS_CHAR: {
-            char *const data_array = x->data;
-            const char *const src_array = array;
-            pl_misc_for_i(length) if (!pl_is_na(indices[i])) data_array[indices[i]] = src_array[i];
-            break;
-        }
-        case PL_CLASS_INT: {
-            int *const data_array = x->data;
-            const int *const src_array = array;
-            pl_misc_for_i(length) if (!pl_is_na(indices[i])) data_array[indices[i]] = src_array[i];
-            break;
-        }
-        case PL_CLASS_LONG: {
-            long *const data_array = x->data;
-            const long *const src_array = array;
-            pl_misc_for_i(length) if (!pl_is_na(indices[i])) data_array[indices[i]] = src_array[i];
-            break;
-        }
-        case PL_CLASS_DOUBLE: {
-            double *const data_array = x->data;
-            const double *const src_array = array;
-            pl_misc_for_i(length) if (!pl_is_na(indices[i])) data_array[indices[i]] = src_array[i];
-            break;
-        }
-        case PL_CLASS_LIST: {
-            pl_object *const data_array = x->data;
-            const pl_object *const src_array = array;
-            pl_misc_for_i(length) if (!pl_is_na(indices[i])) data_array[indices[i]] = src_array[i];
-            break;
-        }
-        case PL_CLASS_EXTERNAL: {
-            void **const data_array = x->data;
-            void *const *const src_array = array;
-            pl_misc_for_i(length) if (!pl_is_na(indices[i])) data_array[indices[i]] = src_array[i];
-            break;
-        }
-        default:
-            break;
+pl_object_plain_types(index_set_kernel, index_set)
+pl_object_plain_types(index_set_by_long_kernel, index_set_by_long)
+pl_object_index_set_bool_kernel(index_set_bool, int)
+pl_object_index_set_bool_kernel(index_set_by_long_bool, long)
+pl_object_index_set_string_kernel(index_set_string, int)
+pl_object_index_set_string_kernel(index_set_by_long_string, long)
+
+// Set kernels indexed by the underlying type, for int and long indices.
+static void (*const index_set_kernels[PL_NUM_CLASS])(pl_object, long, const int *, const void *) = {
+        pl_object_plain_types(kernel_entry, index_set)
+        [PL_CLASS_BOOL]   = index_set_bool,
+        [PL_CLASS_STRING] = index_set_string};
+
+static void (*const index_set_by_long_kernels[PL_NUM_CLASS])(pl_object, long, const long *, const void *) = {
+        pl_object_plain_types(kernel_entry, index_set_by_long)
+        [PL_CLASS_BOOL]   = index_set_by_long_bool,
+        [PL_CLASS_STRING] = index_set_by_long_string};
+
+// If an index of `indices` is NA, the corresponding value will not be set.
+// If `length` is zero, no items will be set and `array` will not be used.
+#define primitive_set_by_indices_template(name, index_type, kernels)                                             \
+    static void name(pl_object x, const long length, const index_type *const indices, const void *const array) { \
+        check_null_pointer(x);                                                                                   \
+                                                                                                                 \
+        check_missing_value(length);                                                                             \
+        if (length == 0)                                                                                         \
+            return;                                                                                              \
+        pl_error_expect(length > 0,                                                                              \
+                        PL_ERROR_INVALID_LENGTH,                                                                 \
+                        "Invalid length [%ld]!",                                                                 \
+                        length);                                                                                 \
+                                                                                                                 \
+        check_null_pointer(indices);                                                                             \
+        for (long i = 0; i < length; i++) {                                                                      \
+            if (!pl_is_na(indices[i]))                                                                           \
+                check_index_out_of_bound(x, indices[i]);                                                         \
+        }                                                                                                        \
+                                                                                                                 \
+        check_null_pointer(array);                                                                               \
+        prepare_write(x);                                                                                        \
+                                                                                                                 \
+        const int type = pl_object_type(x);                                                                      \
+        if (type == PL_CLASS_LIST)                                                                               \
+            pl_gc_write_barrier(x, NULL);                                                                        \
+        kernels[type](x, length, indices, array);                                                                \
     }
-}
+
+primitive_set_by_indices_template(primitive_set_by_indices, int, index_set_kernels)
+
+primitive_set_by_indices_template(set_by_long_indices, long, index_set_by_long_kernels)
 
 /*-----------------------------------------------------------------------------
  |  Primitive set range
  ----------------------------------------------------------------------------*/
 
-static void primitive_set_range(pl_object x, const int start, const int end, const void *const array) {
+static void primitive_set_range(pl_object x, const long start, const long end, const void *const array) {
     check_null_pointer(x);
     check_index_out_of_bound(x, start);
     check_index_out_of_bound(x, end);
@@ -317,113 +651,91 @@ static void primitive_set_range(pl_object x, const int start, const int end, con
 
     if (start > end)
         return;
+    prepare_write(x);
 
-    memmove((char *) x->data + pl_object_data_size(x->class, start),
-            array,
-            pl_object_data_size(x->class, end - start + 1));
+    if (pl_object_type(x) == PL_CLASS_STRING) {
+        const char *const *const src_array = array;
+        pl_misc_for_i(start, end + 1) pl_object_string_items(x->data)[i] = string_store(x, src_array[i - start]);
+        return;
+    }
+    move_items(x->class, x->data, start, array, 0, end - start + 1);
+    if (pl_object_type(x) == PL_CLASS_LIST)
+        pl_gc_write_barrier(x, NULL);
 }
 
 /*-----------------------------------------------------------------------------
  |  Primitive set by Booleans
  ----------------------------------------------------------------------------*/
 
+// Write the items of `array` in order to the TRUEs of `bool_array`.
+#define pl_object_bool_set_kernel(name, type)                                             \
+    static void name(pl_object x, const int *const bool_array, const void *const array) { \
+        type *const data_array = x->data;                                                 \
+        type const *const src_array = array;                                              \
+        long count = 0;                                                                   \
+        for (long i = 0; i < x->length; i++)                                              \
+            if (bool_array[i] == 1)                                                       \
+                data_array[i] = src_array[count++];                                       \
+    }
+
+#define bool_set_kernel(prefix, class, name, type, na) pl_object_bool_set_kernel(prefix##_##name, type)
+
+pl_object_plain_types(bool_set_kernel, bool_set)
+
+static void bool_set_bool(pl_object x, const int *const bool_array, const void *const array) {
+    long count = 0;
+    pl_misc_for_i(x->length) {
+        if (bool_array[i] == 1)
+            pl_object_bool_set(x->data, i, pl_object_bool_get(array, count++));
+    }
+}
+
+// Items of strings are stored from C strings.
+static void bool_set_string(pl_object x, const int *const bool_array, const void *const array) {
+    const char *const *const src_array = array;
+    long count = 0;
+    pl_misc_for_i(x->length) {
+        if (bool_array[i] == 1)
+            pl_object_string_items(x->data)[i] = string_store(x, src_array[count++]);
+    }
+}
+
+// Set kernels indexed by the underlying type.
+static void (*const bool_set_kernels[PL_NUM_CLASS])(pl_object, const int *, const void *) = {
+        pl_object_plain_types(kernel_entry, bool_set)
+        [PL_CLASS_BOOL]   = bool_set_bool,
+        [PL_CLASS_STRING] = bool_set_string};
+
 static void primitive_set_by_bool(pl_object x, const int *const bool_array, const void *const array) {
     check_null_pointer(x);
     check_null_pointer(bool_array);
     check_null_pointer(array);
 
     pl_misc_for_i(x->length) check_missing_value(bool_array[i]);
+    prepare_write(x);
 
-    const int type = pl_class_get_ns().type(x->class);
+    const int type = pl_object_type(x);
+    if (type == PL_CLASS_LIST)
+        pl_gc_write_barrier(x, NULL);
 
-    int count = 0;
-    switch (type) {
-        case PL_CLASS_CHAR: {
-            char *const data_array = x->data;
-            const char *const src_array = array;
-            pl_misc_for_i(x->length) {
-                if (bool_array[i] == 1) {
-                    data_array[i] = src_array[count];
-                    count++;
-                }
-            }
-            break;
-        }
-        case PL_CLASS_INT: {
-            int *const data_array = x->data;
-            const int *const src_array = array;
-            pl_misc_for_i(x->length) {
-                if (bool_array[i] == 1) {
-                    data_array[i] = src_array[count];
-                    count++;
-                }
-            }
-            break;
-        }
-        case PL_CLASS_LONG: {
-            long *const data_array = x->data;
-            const long *const src_array = array;
-            pl_misc_for_i(x->length) {
-                if (bool_array[i] == 1) {
-                    data_array[i] = src_array[count];
-                    count++;
-                }
-            }
-            break;
-        }
-        case PL_CLASS_DOUBLE: {
-            double *const data_array = x->data;
-            const double *const src_array = array;
-            pl_misc_for_i(x->length) {
-                if (bool_array[i] == 1) {
-                    data_array[i] = src_array[count];
-                    count++;
-                }
-            }
-            break;
-        }
-        case PL_CLASS_LIST: {
-            pl_object *const data_array = x->data;
-            const pl_object *const src_array = array;
-            pl_misc_for_i(x->length) {
-                if (bool_array[i] == 1) {
-                    data_array[i] = src_array[count];
-                    count++;
-                }
-            }
-            break;
-        }
-        case PL_CLASS_EXTERNAL: {
-            void **const data_array = x->data;
-            void *const *const src_array = array;
-            pl_misc_for_i(x->length) {
-                if (bool_array[i] == 1) {
-                    data_array[i] = src_array[count];
-                    count++;
-                }
-            }
-            break;
-        }
-        default:
-            break;
-    }
+    bool_set_kernels[type](x, bool_array, array);
 }
 
 /*-----------------------------------------------------------------------------
  |  Primitive extract
  ----------------------------------------------------------------------------*/
 
-#define primitive_extract_type_template(this_type, this_class, this_na)          \
-    static this_type primitive_extract_##this_type(pl_object x, const int index) \
-    {                                                                            \
-        check_null_pointer(x);                                                   \
-        check_object_type(x, this_class);                                        \
-                                                                                 \
-        if (pl_is_na(index))                                                     \
-            return this_na;                                                      \
-        check_index_out_of_bound(x, index);                                      \
-                                                                                 \
-        return ((this_type *) x->data)[index];                                   \
+#define primitive_extract_type_template(this_type, this_class, this_na)           \
+    static this_type primitive_extract_##this_type(pl_object x, const long index) \
+    {                                                                             \
+        check_null_pointer(x);                                                    \
+        check_object_type(x, this_class);                                         \
+                                                                                  \
+        if (pl_is_na(index))                                                      \
+            return this_na;                                                       \
+        check_index_out_of_bound(x, index);                                       \
+                                                                                  \
+        return ((this_type *) x->data)[index];                                    \
     }
 
 
@@ -435,7 +747,7 @@ primitive_extract_type_template(long, PL_CLASS_LONG, PL_LONG_NA);
 
 primitive_extract_type_template(double, PL_CLASS_DOUBLE, PL_DOUBLE_NA);
 
-static pl_object primitive_extract_object(pl_object x, const int index) {
+static pl_object primitive_extract_object(pl_object x, const long index) {
     check_null_pointer(x);
     check_object_type(x, PL_CLASS_LIST);
 
@@ -446,7 +758,7 @@ static pl_object primitive_extract_object(pl_object x, const int index) {
     return ((pl_object *) x->data)[index];
 }
 
-static void *primitive_extract_external(pl_object x, const int index) {
+static void *primitive_extract_external(pl_object x, const long index) {
     check_null_pointer(x);
     check_object_type(x, PL_CLASS_EXTERNAL);
 
@@ -457,6 +769,28 @@ static void *primitive_extract_external(pl_object x, const int index) {
     return ((void **) x->data)[index];
 }
 
+static int primitive_extract_bool(pl_object x, const long index) {
+    check_null_pointer(x);
+    check_object_type(x, PL_CLASS_BOOL);
+
+    if (pl_is_na(index))
+        return PL_BOOL_NA;
+    check_index_out_of_bound(x, index);
+
+    return pl_object_bool_get(x->data, index);
+}
+
+static const char *primitive_extract_string(pl_object x, const long index) {
+    check_null_pointer(x);
+    check_object_type(x, PL_CLASS_STRING);
+
+    if (pl_is_na(index))
+        return NULL;
+    check_index_out_of_bound(x, index);
+
+    return pl_object_string_get(x->data, index);
+}
+
 /*-----------------------------------------------------------------------------
  |  Primitive extend
  ----------------------------------------------------------------------------*/
@@ -468,6 +802,7 @@ static void *primitive_extract_external(pl_object x, const int index) {
         check_object_type(x, this_class);                                       \
                                                                                 \
         primitive_reserve(x, x->length + 1);                                    \
+        prepare_write(x);                                                       \
         ((this_type *) x->data)[x->length] = item;                              \
         x->length += 1;                                                         \
     }
@@ -485,8 +820,10 @@ static void primitive_extend_object(pl_object x, pl_object item) {
     check_object_type(x, PL_CLASS_LIST);
 
     primitive_reserve(x, x->length + 1);
+    prepare_write(x);
     ((pl_object *) x->data)[x->length] = item;
     x->length += 1;
+    pl_gc_write_barrier(x, item);
 }
 
 static void primitive_extend_external(pl_object x, void *item) {
@@ -494,233 +831,477 @@ static void primitive_extend_external(pl_object x, void *item) {
     check_object_type(x, PL_CLASS_EXTERNAL);
 
     primitive_reserve(x, x->length + 1);
+    prepare_write(x);
     ((void **) x->data)[x->length] = item;
     x->length += 1;
 }
 
+static void primitive_extend_bool(pl_object x, const int item) {
+    check_null_pointer(x);
+    check_object_type(x, PL_CLASS_BOOL);
+
+    primitive_reserve(x, x->length + 1);
+    prepare_write(x);
+    pl_object_bool_set(x->data, x->length, item);
+    x->length += 1;
+}
+
+static void primitive_extend_string(pl_object x, const char *item) {
+    check_null_pointer(x);
+    check_object_type(x, PL_CLASS_STRING);
+
+    primitive_reserve(x, x->length + 1);
+    prepare_write(x);
+    pl_object_string_items(x->data)[x->length] = string_store(x, item);
+    x->length += 1;
+}
+
 /*-----------------------------------------------------------------------------
  |  Primitive subset
  ----------------------------------------------------------------------------*/
 
+// Gather the items at `y` of `x` into `result`. NA indices give NAs.
+#define pl_object_gather_chunk(name, index_type, type, na)                                     \
+    static void name(void *const context, const int chunk, const long start, const long end) { \
+        (void) chunk;                                                                          \
+        const parallel_operands *const operands = context;                                     \
+        type const *restrict const src_array = operands->x;                                    \
+        const index_type *restrict const indices = operands->y;                                \
+        type *restrict const dst_array = operands->result;                                     \
+        for (long i = start; i < end; i++)                                                     \
+            dst_array[i] = pl_is_na(indices[i]) ? (na) : src_array[indices[i]];                \
+    }
+
+// Gather chunks of every class for int and long indices.
+#define gather_chunk(prefix, class, name, type, na) pl_object_gather_chunk(prefix##_##name, int, type, na)
+#define gather_by_long_chunk(prefix, class, name, type, na) pl_object_gather_chunk(prefix##_##name, long, type, na)
+
+pl_object_item_types(gather_chunk, subset_gather)
+pl_object_item_types(gather_by_long_chunk, subset_gather_by_long)
+
+// Gather Booleans. Neighbouring items share a block, so Booleans are gathered by one chunk.
+#define pl_object_bool_gather_chunk(name, index_type)                                          \
+    static void name(void *const context, const int chunk, const long start, const long end) { \
+        (void) chunk;                                                                          \
+        const parallel_operands *const operands = context;                                     \
+        const index_type *const indices = operands->y;                                         \
+        for (long i = start; i < end; i++) {                                                   \
+            int item = PL_BOOL_NA;                                                             \
+            if (!pl_is_na(indices[i]))                                                         \
+                item = pl_object_bool_get(operands->x, indices[i]);                            \
+            pl_object_bool_set(operands->result, i, item);                                     \
+        }                                                                                      \
+    }
+
+pl_object_bool_gather_chunk(subset_gather_bool, int)
+pl_object_bool_gather_chunk(subset_gather_by_long_bool, long)
+
+// Gather chunks indexed by the underlying type, for int and long indices.
+static void (*const subset_gather_chunks[PL_NUM_CLASS])(void *, int, long, long) = {
+        pl_object_item_types(kernel_entry, subset_gather)
+        [PL_CLASS_BOOL] = subset_gather_bool};
+
+static void (*const subset_gather_by_long_chunks[PL_NUM_CLASS])(void *, int, long, long) = {
+        pl_object_item_types(kernel_entry, subset_gather_by_long)
+        [PL_CLASS_BOOL] = subset_gather_by_long_bool};
+
 // The attribute will be dropped. If an index of `indices` is NA,
 // the corresponding item will be NA. If `length` is zero, an empty object will be returned.
-static pl_object primitive_subset(pl_object x, const int length, const int *const indices) {
+// The result is written into `dst`, or into a new object if `dst` is NULL.
+#define primitive_subset_to_template(name, index_type, gather_chunks)                                       \
+    static pl_object name(pl_object dst, pl_object x, const long length, const index_type *const indices) { \
+        check_null_pointer(x);                                                                              \
+                                                                                                            \
+        check_missing_value(length);                                                                        \
+        if (length == 0)                                                                                    \
+            return prepare_destination(dst, x->class, 0, x, NULL);                                          \
+        pl_error_expect(length > 0,                                                                         \
+                        PL_ERROR_INVALID_LENGTH,                                                            \
+                        "Invalid length [%ld]!",                                                            \
+                        length);                                                                            \
+                                                                                                            \
+        check_null_pointer(indices);                                                                        \
+                                                                                                            \
+        /* Check index out of bound. */                                                                     \
+        for (long i = 0; i < length; i++) {                                                                 \
+            if (!pl_is_na(indices[i]))                                                                      \
+                check_index_out_of_bound(x, indices[i]);                                                    \
+        }                                                                                                   \
+                                                                                                            \
+        /* A run of consecutive indices is a slice. Large slices share the data of x. */                    \
+        int is_range = !pl_is_na(indices[0]);                                                               \
+        for (long i = 1; i < length; i++) is_range = is_range && indices[i] == indices[0] + i;              \
+        if (is_range && dst == NULL)                                                                        \
+            return pl_gc_get_ns().slice_object(x, indices[0], length);                                      \
+                                                                                                            \
+        /* Get the underlying type. */                                                                      \
+        const int type = pl_object_type(x);                                                                 \
+                                                                                                            \
+        pl_object object = prepare_destination(dst, x->class, length, x, NULL);                             \
+        if (type == PL_CLASS_STRING)                                                                        \
+            share_bytes(object, x);                                                                         \
+        if (is_range) {                                                                                     \
+            move_items(x->class, object->data, 0, x->data, indices[0], length);                             \
+            finish_destination(dst, object);                                                                \
+            return object;                                                                                  \
+        }                                                                                                   \
+                                                                                                            \
+        parallel_operands operands = {.x = object_items(x), .y = indices, .result = object_items(object)};  \
+        if (type == PL_CLASS_BOOL)                                                                          \
+            gather_chunks[type](&operands, 0, 0, length);                                                   \
+        else                                                                                                \
+            pl_misc_get_ns().parallel_for(length, gather_chunks[type], &operands);                          \
+                                                                                                            \
+        finish_destination(dst, object);                                                                    \
+        return object;                                                                                      \
+    }
+
+primitive_subset_to_template(primitive_subset_to, int, subset_gather_chunks)
+
+primitive_subset_to_template(subset_by_long_indices_to, long, subset_gather_by_long_chunks)
+
+static pl_object primitive_subset(pl_object x, const long length, const int *const indices) {
+    return primitive_subset_to(NULL, x, length, indices);
+}
+
+static void primitive_subset_into(pl_object dst, pl_object x, const long length, const int *const indices) {
+    check_null_pointer(dst);
+    primitive_subset_to(dst, x, length, indices);
+}
+
+/*-----------------------------------------------------------------------------
+ |  Primitive subset exclude
+ ----------------------------------------------------------------------------*/
+
+// The attribute will be dropped. NAs in `indices` will be ignored.
+// Duplicate indices will be ignored. If `length` is zero, a shallow
+// copy of the object will be returned.
+static pl_object primitive_subset_exclude_to(pl_object dst, pl_object x, const long length, const int *const indices) {
     check_null_pointer(x);
 
     check_missing_value(length);
-    if (length == 0)
-        return primitive_new(x->class, 1);
+    if (length == 0) {
+        if (dst == NULL)
+            return copy(x);
+        pl_object object = prepare_destination(dst, x->class, x->length, x, NULL);
+        memcpy(object->data, x->data, pl_object_data_size(x->class, x->length));
+        if (pl_object_type(x) == PL_CLASS_STRING)
+            share_bytes(object, x);
+        finish_destination(dst, object);
+        return object;
+    }
     pl_error_expect(length > 0,
                     PL_ERROR_INVALID_LENGTH,
-                    "Invalid length [%d]!",
+                    "Invalid length [%ld]!",
                     length);
 
-    check_null_pointer(indices);
+    char *const excluded = exclusion_flags(x, length, indices);
 
-    // Check index out of bound.
-    pl_misc_for_i(length) {
-        if (!pl_is_na(indices[i]))
-            check_index_out_of_bound(x, indices[i]);
+    long count = 0;
+    pl_misc_for_i(x->length) count += !excluded[i];
+
+    // Nothing below throws except the allocation of the destination.
+    pl_object object = prepare_destination(dst, x->class, count, x, NULL);
+    if (pl_object_type(x) == PL_CLASS_STRING)
+        share_bytes(object, x);
+
+    // Copy runs of kept items at once.
+    count = 0;
+    long i = 0;
+    while (i < x->length) {
+        if (excluded[i]) {
+            i++;
+            continue;
+        }
+        long run_end = i;
+        while (run_end < x->length && !excluded[run_end])
+            run_end++;
+        move_items(x->class, object->data, count, x->data, i, run_end - i);
+        count += run_end - i;
+        i = run_end;
     }
 
-    // Request a new object.
-    pl_object object = primitive_new(x->class, length);
-    object->length = length;
+    release_exclusion_flags();
+    finish_destination(dst, object);
+    return object;
+}
 
-    // Get the underlying type.
-    const int type = pl_class_get_ns().type(x->class);
+static pl_object primitive_subset_exclude(pl_object x, const long length, const int *const indices) {
+    return primitive_subset_exclude_to(NULL, x, length, indices);
+}
 
-    switch (type) {
-        case PL_CLASS_CHAR: {
-            char *const src_array = x->data;
-            char *const dst_array = object->data;
-            pl_misc_for_i(length) dst_array[i] = pl_is_na(indices[i]) ? PL_CHAR_NA : src_array[indices[i]];
-            break;
-        }
-        case PL_CLASS_INT: {
-            int *const src_array = x->data;
-            int *const dst_array = object->data;
-            pl_misc_for_i(length) dst_array[i] = pl_is_na(indices[i]) ? PL_INT_NA : src_array[indices[i]];
-            break;
-        }
-        case PL_CLASS_LONG: {
-            long *const src_array = x->data;
-            long *const dst_array = object->data;
-            pl_misc_for_i(length) dst_array[i] = pl_is_na(indices[i]) ? PL_LONG_NA : src_array[indices[i]];
-            break;
-        }
-        case PL_CLASS_DOUBLE: {
-            double *const src_array = x->data;
-            double *const dst_array = object->data;
-            pl_misc_for_i(length) dst_array[i] = pl_is_na(indices[i]) ? PL_DOUBLE_NA : src_array[indices[i]];
-            break;
-        }
-        case PL_CLASS_LIST: {
-            pl_object *const src_array = x->data;
-            pl_object *const dst_array = object->data;
-            pl_misc_for_i(length) dst_array[i] = pl_is_na(indices[i]) ? PL_LIST_NA : src_array[indices[i]];
-            break;
-        }
-        case PL_CLASS_EXTERNAL: {
-            void **const src_array = x->data;
-            void **const dst_array = object->data;
-            pl_misc_for_i(length) dst_array[i] = pl_is_na(indices[i]) ? PL_EXTERNAL_NA : src_array[indices[i]];
-            break;
-        }
-        default:
-            break;
-    }
-
-    return object;
+static void primitive_subset_exclude_into(pl_object dst, pl_object x, const long length, const int *const indices) {
+    check_null_pointer(dst);
+    primitive_subset_exclude_to(dst, x, length, indices);
 }
 
 /*-----------------------------------------------------------------------------
- |  Primitive subset exclude
+ |  Primitive subset by Booleans
  ----------------------------------------------------------------------------*/
 
-// The attribute will be dropped. NAs in `indices` will be ignored.
-// Duplicate indices will be ignored. If `length` is zero, a shallow
-// copy of the object will be returned.
-static pl_object primitive_subset_exclude(pl_object x, const int length, const int *const indices) {
-    check_null_pointer(x);
+// The result is written into `dst`, or into a new object if `dst` is NULL.
+// Count the selected items of a chunk. Booleans can't be NA.
+static void subset_by_bool_count_chunk(void *const context, const int chunk, const long start, const long end) {
+    const parallel_operands *const operands = context;
+    const int *const bool_array = operands->y;
+    long count = 0;
+    pl_misc_for_i(start, end) {
+        check_missing_value(bool_array[i]);
+        count += bool_array[i] == 1;
+    }
+    operands->offsets[chunk] = count;
+}
 
-    check_missing_value(length);
-    if (length == 0)
-        return copy(x);
-    pl_error_expect(length > 0,
-                    PL_ERROR_INVALID_LENGTH,
-                    "Invalid length [%d]!",
-                    length);
+// Scatter the selected items of a chunk from the offset of the chunk.
+#define pl_object_scatter_chunk(name, type)                                                    \
+    static void name(void *const context, const int chunk, const long start, const long end) { \
+        const parallel_operands *const operands = context;                                     \
+        type const *restrict const src_array = operands->x;                                    \
+        const int *restrict const bool_array = operands->y;                                    \
+        type *restrict const dst_array = (type *) operands->result + operands->offsets[chunk]; \
+        long count = 0;                                                                        \
+        for (long i = start; i < end; i++) {                                                   \
+            if (bool_array[i] == 1)                                                            \
+                dst_array[count++] = src_array[i];                                             \
+        }                                                                                      \
+    }
 
-    check_null_pointer(indices);
+#define scatter_chunk(prefix, class, name, type, na) pl_object_scatter_chunk(prefix##_##name, type)
 
-    // Check index out of bound.
-    pl_misc_for_i(length) {
-        if (!pl_is_na(indices[i]))
-            check_index_out_of_bound(x, indices[i]);
+pl_object_item_types(scatter_chunk, subset_by_bool_scatter)
+
+// Booleans are scattered by one chunk, since neighbouring items share a block.
+static void subset_by_bool_scatter_bool(void *const context, const int chunk, const long start, const long end) {
+    const parallel_operands *const operands = context;
+    const int *const bool_array = operands->y;
+    long count = operands->offsets[chunk];
+    for (long i = start; i < end; i++) {
+        if (bool_array[i] == 1)
+            pl_object_bool_set(operands->result, count++, pl_object_bool_get(operands->x, i));
     }
+}
 
-    pl_object index_flags = primitive_new(PL_CLASS_INT, x->length);
-    int *const index_array = index_flags->data;
-    pl_misc_for_i(x->length) index_array[i] = 1;
-    index_flags->length = x->length;
+// Scatter chunks indexed by the underlying type.
+static void (*const subset_by_bool_scatter_chunks[PL_NUM_CLASS])(void *, int, long, long) = {
+        pl_object_item_types(kernel_entry, subset_by_bool_scatter)
+        [PL_CLASS_BOOL] = subset_by_bool_scatter_bool};
 
-    pl_misc_for_i(length) if (!pl_is_na(indices[i])) index_array[indices[i]] = 0;
+static pl_object primitive_subset_by_bool_to(pl_object dst, pl_object x, const int *const bool_array) {
 
-    int count = 0;
-    pl_misc_for_i(x->length) {
-        if (index_array[i] == 1) {
-            index_array[count] = i;
-            count++;
-        }
-    }
+    check_null_pointer(x);
+    check_null_pointer(bool_array);
+
+    // Get the underlying type.
+    const int type = pl_object_type(x);
+
+    // Count the selected items of each chunk, then scatter each chunk from the prefix sum of the counts.
+    // Both loops share the chunks, so they are fixed once.
+    const pl_misc_ns misc_ns = pl_misc_get_ns();
+    const int num_chunks = x->length == 0 ? 0 : misc_ns.parallel_chunks(x->length);
+    long offsets[PL_MISC_MAX_THREADS * 4 + 1] = {0};
+    parallel_operands operands = {.x = object_items(x), .y = bool_array, .offsets = offsets + 1};
+    misc_ns.parallel_for_chunks(x->length, num_chunks, subset_by_bool_count_chunk, &operands);
+    pl_misc_for_i(num_chunks) offsets[i + 1] += offsets[i];
+
+    pl_object object = prepare_destination(dst, x->class, offsets[num_chunks], x, NULL);
+    if (type == PL_CLASS_STRING)
+        share_bytes(object, x);
+    operands.result = object_items(object);
+    operands.offsets = offsets;
+    if (type == PL_CLASS_BOOL)
+        subset_by_bool_scatter_bool(&operands, 0, 0, x->length);
+    else
+        misc_ns.parallel_for_chunks(x->length, num_chunks, subset_by_bool_scatter_chunks[type], &operands);
+
+    finish_destination(dst, object);
+    return object;
+}
+
+static pl_object primitive_subset_by_bool(pl_object x, const int *const bool_array) {
+    return primitive_subset_by_bool_to(NULL, x, bool_array);
+}
 
-    return primitive_subset(x, count, index_array);
+static void primitive_subset_by_bool_into(pl_object dst, pl_object x, const int *const bool_array) {
+    check_null_pointer(dst);
+    primitive_subset_by_bool_to(dst, x, bool_array);
 }
 
 /*-----------------------------------------------------------------------------
- |  Primitive subset by Booleans
+ |  Subset by mask
  ----------------------------------------------------------------------------*/
 
-static pl_object primitive_subset_by_bool(pl_object x, const int *const bool_array) {
+// Count the TRUEs of a chunk of blocks of a mask. A chunk holding an NA counts -1.
+static void mask_count_chunk(void *const context, const int chunk, const long start, const long end) {
+    const parallel_operands *const operands = context;
+    const uint64_t *const block_array = operands->y;
+    long count = 0;
+    uint64_t na = 0;
+    for (long block = start; block < end; block++) {
+        const uint64_t bits = bool_block_mask(operands->x_length, block);
+        count += __builtin_popcountll(block_array[2 * block] & bits);
+        na |= block_array[2 * block + 1] & bits;
+    }
+    operands->offsets[chunk] = na == 0 ? count : -1;
+}
 
-    check_null_pointer(x);
-    check_null_pointer(bool_array);
+// Compress the items of a chunk of blocks selected by a mask, from the offset of the chunk.
+// Full blocks are copied at once, and the TRUEs of other blocks are visited by their bit positions.
+#define pl_object_mask_scatter_chunk(name, type)                                                              \
+    static void name(void *const context, const int chunk, const long start, const long end) {                \
+        const parallel_operands *const operands = context;                                                    \
+        const uint64_t *const block_array = operands->y;                                                      \
+        type *restrict const dst_array = (type *) operands->result + operands->offsets[chunk];                \
+        long count = 0;                                                                                       \
+        for (long block = start; block < end; block++) {                                                      \
+            type const *restrict const src_array = (type const *) operands->x + block * PL_OBJECT_BOOL_BLOCK; \
+            uint64_t bits = block_array[2 * block] & bool_block_mask(operands->x_length, block);              \
+            if (bits == ~(uint64_t) 0) {                                                                      \
+                for (int i = 0; i < PL_OBJECT_BOOL_BLOCK; i++)                                                \
+                    dst_array[count + i] = src_array[i];                                                      \
+                count += PL_OBJECT_BOOL_BLOCK;                                                                \
+                continue;                                                                                     \
+            }                                                                                                 \
+            for (; bits != 0; bits &= bits - 1)                                                               \
+                dst_array[count++] = src_array[__builtin_ctzll(bits)];                                        \
+        }                                                                                                     \
+    }
 
-    // Check Nas.
-    pl_misc_for_i(x->length) check_missing_value(bool_array[i]);
+#define mask_scatter_chunk(prefix, class, name, type, na) pl_object_mask_scatter_chunk(prefix##_##name, type)
 
-    // Get the underlying type.
-    const int type = pl_class_get_ns().type(x->class);
+pl_object_item_types(mask_scatter_chunk, mask_scatter)
 
-    int count = 0;
-    pl_misc_for_i(x->length) {
-        if (bool_array[i] == 1)
-            count += 1;
+// Booleans are compressed by one chunk, since neighbouring items share a block.
+static void mask_scatter_bool(void *const context, const int chunk, const long start, const long end) {
+    const parallel_operands *const operands = context;
+    const uint64_t *const block_array = operands->y;
+    long count = operands->offsets[chunk];
+    for (long block = start; block < end; block++) {
+        uint64_t bits = block_array[2 * block] & bool_block_mask(operands->x_length, block);
+        for (; bits != 0; bits &= bits - 1) {
+            const long index = block * PL_OBJECT_BOOL_BLOCK + __builtin_ctzll(bits);
+            pl_object_bool_set(operands->result, count++, pl_object_bool_get(operands->x, index));
+        }
     }
-    pl_object object = primitive_new(x->class, count);
-    object->length = count;
+}
 
-    count = 0;
-    switch (type) {
-        case PL_CLASS_CHAR: {
-            char *const src_array = x->data;
-            char *const dst_array = object->data;
-            pl_misc_for_i(x->length) {
-                if (bool_array[i] == 1) {
-                    dst_array[count] = src_array[i];
-                    count++;
-                }
-            }
-            break;
-        }
-        case PL_CLASS_INT: {
-            int *const src_array = x->data;
-            int *const dst_array = object->data;
-            pl_misc_for_i(x->length) {
-                if (bool_array[i] == 1) {
-                    dst_array[count] = src_array[i];
-                    count++;
-                }
-            }
-            break;
-        }
-        case PL_CLASS_LONG: {
-            long *const src_array = x->data;
-            long *const dst_array = object->data;
-            pl_misc_for_i(x->length) {
-                if (bool_array[i] == 1) {
-                    dst_array[count] = src_array[i];
-                    count++;
-                }
-            }
-            break;
-        }
-        case PL_CLASS_DOUBLE: {
-            double *const src_array = x->data;
-            double *const dst_array = object->data;
-            pl_misc_for_i(x->length) {
-                if (bool_array[i] == 1) {
-                    dst_array[count] = src_array[i];
-                    count++;
-                }
-            }
-            break;
-        }
-        case PL_CLASS_LIST: {
-            pl_object *const src_array = x->data;
-            pl_object *const dst_array = object->data;
-            pl_misc_for_i(x->length) {
-                if (bool_array[i] == 1) {
-                    dst_array[count] = src_array[i];
-                    count++;
-                }
-            }
-            break;
-        }
-        case PL_CLASS_EXTERNAL: {
-            void **const src_array = x->data;
-            void **const dst_array = object->data;
-            pl_misc_for_i(x->length) {
-                if (bool_array[i] == 1) {
-                    dst_array[count] = src_array[i];
-                    count++;
-                }
-            }
-            break;
-        }
-        default:
-            break;
+// Compress chunks indexed by the underlying type.
+static void (*const mask_scatter_chunks[PL_NUM_CLASS])(void *, int, long, long) = {
+        pl_object_item_types(kernel_entry, mask_scatter)
+        [PL_CLASS_BOOL] = mask_scatter_bool};
+
+// Count the TRUEs of a mask of the same length as x over `num_chunks` chunks of its blocks.
+// The mask can't contain NA.
+static long mask_count(pl_object x, pl_object mask, const int num_chunks, long *const offsets) {
+    check_object_type(mask, PL_CLASS_BOOL);
+    check_object_length(mask, x->length);
+
+    // Count the TRUEs of each chunk, then prefix sum the counts.
+    const long num_blocks = bool_num_blocks(x->length);
+    parallel_operands operands = {.x_length = x->length, .y = mask->data, .offsets = offsets + 1};
+    pl_misc_get_ns().parallel_for_chunks(num_blocks, num_chunks, mask_count_chunk, &operands);
+    pl_misc_for_i(num_chunks) {
+        pl_error_expect(offsets[i + 1] >= 0,
+                        PL_ERROR_INVALID_NA,
+                        "Unexpected missing value in mask `mask`!");
+        offsets[i + 1] += offsets[i];
     }
+    return offsets[num_chunks];
+}
+
+// The attribute will be dropped. The result is written into `dst`, or into a new object
+// if `dst` is NULL.
+static pl_object subset_by_mask_to(pl_object dst, pl_object x, pl_object mask) {
+    // The count and the compression share the chunks, so they are fixed once.
+    const pl_misc_ns misc_ns = pl_misc_get_ns();
+    const long num_blocks = bool_num_blocks(x->length);
+    const int num_chunks = num_blocks == 0 ? 0 : misc_ns.parallel_chunks(num_blocks);
+    long offsets[PL_MISC_MAX_THREADS * 4 + 1] = {0};
+    const long count = mask_count(x, mask, num_chunks, offsets);
+    pl_object object = prepare_destination(dst, x->class, count, x, mask);
+
+    // Get the underlying type.
+    const int type = pl_object_type(x);
+    if (type == PL_CLASS_STRING)
+        share_bytes(object, x);
+
+    parallel_operands operands = {.x        = object_items(x),
+                                  .x_length = x->length,
+                                  .y        = mask->data,
+                                  .result   = object_items(object),
+                                  .offsets  = offsets};
+    if (type == PL_CLASS_BOOL)
+        mask_scatter_bool(&operands, 0, 0, num_blocks);
+    else
+        misc_ns.parallel_for_chunks(num_blocks, num_chunks, mask_scatter_chunks[type], &operands);
 
+    finish_destination(dst, object);
     return object;
 }
 
+/*-----------------------------------------------------------------------------
+ |  Set by mask
+ ----------------------------------------------------------------------------*/
+
+// Write the items of `src` to the positions of the TRUEs of a mask. The item of `src` advances
+// by `step` for every TRUE, so a step of zero recycles the first item.
+#define pl_object_mask_set_kernel(name, type)                                                       \
+    static void name(void *const data, const uint64_t *const block_array, const long length,        \
+                     const void *const src, const long step) {                                      \
+        type *const data_array = data;                                                              \
+        type const *const src_array = src;                                                          \
+        long item = 0;                                                                              \
+        for (long block = 0; block < bool_num_blocks(length); block++) {                            \
+            uint64_t bits = block_array[2 * block] & bool_block_mask(length, block);                \
+            for (; bits != 0; bits &= bits - 1, item += step)                                       \
+                data_array[block * PL_OBJECT_BOOL_BLOCK + __builtin_ctzll(bits)] = src_array[item]; \
+        }                                                                                           \
+    }
+
+#define mask_set_kernel(prefix, class, name, type, na) pl_object_mask_set_kernel(prefix##_##name, type)
+
+pl_object_item_types(mask_set_kernel, mask_set)
+
+static void mask_set_bool(void *const data, const uint64_t *const block_array, const long length,
+                          const void *const src, const long step) {
+    long item = 0;
+    for (long block = 0; block < bool_num_blocks(length); block++) {
+        uint64_t bits = block_array[2 * block] & bool_block_mask(length, block);
+        for (; bits != 0; bits &= bits - 1, item += step)
+            pl_object_bool_set(data, block * PL_OBJECT_BOOL_BLOCK + __builtin_ctzll(bits), pl_object_bool_get(src, item));
+    }
+}
+
+// Set kernels indexed by the underlying type.
+static void (*const mask_set_kernels[PL_NUM_CLASS])(void *, const uint64_t *, long, const void *, long) = {
+        pl_object_item_types(kernel_entry, mask_set)
+        [PL_CLASS_BOOL] = mask_set_bool};
+
+// Items are either one per TRUE of the mask, or a single recycled item.
+static void set_by_mask(pl_object x, pl_object mask, pl_object items) {
+    long offsets[PL_MISC_MAX_THREADS * 4 + 1] = {0};
+    const long count = mask_count(x, mask, pl_misc_get_ns().parallel_chunks(bool_num_blocks(x->length)), offsets);
+    check_incompatible_length(count, items->length);
+    if (count == 0)
+        return;
+    pl_error_expect(x != items,
+                    PL_ERROR_INVALID_ARGUMENT,
+                    "Object `items` can't be the object being set!");
+    prepare_write(x);
+
+    const int type = pl_object_type(x);
+    if (type == PL_CLASS_LIST)
+        pl_gc_write_barrier(x, NULL);
+    if (type == PL_CLASS_STRING)
+        items = string_adopt(x, items);
+
+    mask_set_kernels[type](object_items(x), mask->data, x->length, object_items(items), items->length == count ? 1 : 0);
+}
+
 /*-----------------------------------------------------------------------------
  |  Primitive remove
  ----------------------------------------------------------------------------*/
 
-static void primitive_remove(pl_object x, const int start, const int end) {
+static void primitive_remove(pl_object x, const long start, const long end) {
     check_null_pointer(x);
     check_missing_value(start);
     check_missing_value(end);
@@ -731,10 +1312,9 @@ static void primitive_remove(pl_object x, const int start, const int end) {
         x->length = start;
         return;
     }
+    prepare_write(x);
 
-    memmove((char *) x->data + pl_object_data_size(x->class, start),
-            (char *) x->data + pl_object_data_size(x->class, end + 1),
-            pl_object_data_size(x->class, x->length - end - 1));
+    move_items(x->class, x->data, start, x->data, end + 1, x->length - end - 1);
     x->length = x->length - (end - start + 1);
 }
 
@@ -743,12 +1323,62 @@ static void primitive_remove(pl_object x, const int start, const int end) {
  ----------------------------------------------------------------------------*/
 
 // NAs in `indices` will be ignored. Duplicate indices will be ignored.
-static void primitive_remove_by_indices(pl_object x, const int length, const int *const indices) {
-    pl_object new_x = primitive_subset_exclude(x, length, indices);
-    memmove(x->data,
-            new_x->data,
-            pl_object_data_size(x->class, new_x->length));
-    x->length = new_x->length;
+static void primitive_remove_by_indices(pl_object x, const long length, const int *const indices) {
+    check_null_pointer(x);
+
+    check_missing_value(length);
+    if (length == 0)
+        return;
+    pl_error_expect(length > 0,
+                    PL_ERROR_INVALID_LENGTH,
+                    "Invalid length [%ld]!",
+                    length);
+
+    char *const removed_array = exclusion_flags(x, length, indices);
+
+    // Compact the kept items in place. Runs of kept items are moved at once.
+    prepare_write(x);
+    long count = 0;
+    long i = 0;
+    while (i < x->length) {
+        if (removed_array[i]) {
+            i++;
+            continue;
+        }
+        long run_end = i;
+        while (run_end < x->length && !removed_array[run_end])
+            run_end++;
+        if (count != i)
+            move_items(x->class, x->data, count, x->data, i, run_end - i);
+        count += run_end - i;
+        i = run_end;
+    }
+    x->length = count;
+    release_exclusion_flags();
+}
+
+/*-----------------------------------------------------------------------------
+ |  Scalar index
+ ----------------------------------------------------------------------------*/
+
+// Read a length one object of type PL_CLASS_INT or PL_CLASS_LONG. NA gives PL_LONG_NA.
+static long scalar_index(pl_object x) {
+    check_null_pointer(x);
+    check_index_type(x);
+    check_object_length(x, 1);
+
+    if (pl_object_type(x) == PL_CLASS_LONG)
+        return ((long *) x->data)[0];
+    const int value = ((int *) x->data)[0];
+    return pl_is_na(value) ? PL_LONG_NA : value;
+}
+
+// Read an item of an object of type PL_CLASS_INT or PL_CLASS_LONG. NA gives PL_LONG_NA.
+static long index_at(pl_object x, const long i) {
+    if (pl_object_type(x) == PL_CLASS_LONG)
+        return ((long *) x->data)[i];
+    const int value = ((int *) x->data)[i];
+    return pl_is_na(value) ? PL_LONG_NA : value;
 }
 
 /*-----------------------------------------------------------------------------
@@ -760,11 +1390,9 @@ static pl_object new(pl_object class, pl_object capacity) {
     check_null_pointer(capacity);
     check_object_type(class, PL_CLASS_INT);
     check_object_length(class, 1);
-    check_object_type(capacity, PL_CLASS_INT);
-    check_object_length(capacity, 1);
 
     pl_object object = primitive_new(((int *) class->data)[0],
-                                     ((int *) capacity->data)[0]);
+                                     scalar_index(capacity));
 
     return object;
 }
@@ -775,11 +1403,7 @@ static pl_object new(pl_object class, pl_object capacity) {
 
 static void reserve(pl_object x, pl_object capacity) {
     check_null_pointer(x);
-    check_null_pointer(capacity);
-    check_object_type(capacity, PL_CLASS_INT);
-    check_object_length(capacity, 1);
-
-    primitive_reserve(x, ((int *) capacity->data)[0]);
+    primitive_reserve(x, scalar_index(capacity));
 }
 
 
@@ -787,102 +1411,107 @@ static void reserve(pl_object x, pl_object capacity) {
  |  Set
  ----------------------------------------------------------------------------*/
 
+// Items of strings are written without copying their bytes when they share a byte buffer.
+// Items are either one per index, or a single recycled item.
+static void set_string_by_indices(pl_object x, pl_object indices, pl_object items) {
+    check_incompatible_length(indices->length, items->length);
+    pl_misc_for_i(indices->length) {
+        const long index = index_at(indices, i);
+        if (!pl_is_na(index))
+            check_index_out_of_bound(x, index);
+    }
+    if (indices->length == 0)
+        return;
+    prepare_write(x);
+
+    items = string_adopt(x, items);
+    const pl_object_string_item *const src_array = pl_object_string_items(items->data);
+    pl_object_string_item *const data_array = pl_object_string_items(x->data);
+    pl_misc_for_i(indices->length) {
+        const long index = index_at(indices, i);
+        if (!pl_is_na(index))
+            data_array[index] = src_array[items->length == 1 ? 0 : i];
+    }
+}
+
 static void set(pl_object x, pl_object indices, pl_object items) {
     check_null_pointer(x);
     check_null_pointer(indices);
     check_null_pointer(items);
-    check_object_type(indices, PL_CLASS_INT);
     check_same_type(x, items);
 
-    primitive_set_by_indices(x, indices->length, indices->data, items->data);
+    const int index_type = pl_object_type(indices);
+    if (index_type == PL_CLASS_BOOL) {
+        set_by_mask(x, indices, items);
+        return;
+    }
+
+    check_index_type(indices);
+    if (pl_object_type(x) == PL_CLASS_STRING)
+        set_string_by_indices(x, indices, items);
+    else if (index_type == PL_CLASS_LONG)
+        set_by_long_indices(x, indices->length, indices->data, items->data);
+    else
+        primitive_set_by_indices(x, indices->length, indices->data, items->data);
 }
 
 /*-----------------------------------------------------------------------------
  |  Set range
  ----------------------------------------------------------------------------*/
 
+// Write the first item of `src` to `length` items of x from `start`.
+#define pl_object_fill_kernel(name, type)                                                            \
+    static void name(void *const data, const long start, const long length, const void *const src) { \
+        type *const data_array = (type *) data + start;                                              \
+        type const item = *(type const *) src;                                                       \
+        for (long i = 0; i < length; i++)                                                            \
+            data_array[i] = item;                                                                    \
+    }
+
+#define fill_kernel(prefix, class, name, type, na) pl_object_fill_kernel(prefix##_##name, type)
+
+pl_object_plain_types(fill_kernel, fill)
+
+static void fill_bool(void *const data, const long start, const long length, const void *const src) {
+    const int item = pl_object_bool_get(src, 0);
+    pl_misc_for_i(start, start + length) pl_object_bool_set(data, i, item);
+}
+
+// Fill kernels indexed by the underlying type. Strings are filled by adopting the item.
+static void (*const fill_kernels[PL_NUM_CLASS])(void *, long, long, const void *) = {
+        pl_object_plain_types(kernel_entry, fill)
+        [PL_CLASS_BOOL] = fill_bool};
+
 static void set_range(pl_object x, pl_object start, pl_object end, pl_object items) {
     check_null_pointer(x);
     check_null_pointer(items);
-    check_null_pointer(start);
-    check_null_pointer(end);
-    check_object_type(start, PL_CLASS_INT);
-    check_object_length(start, 1);
-    check_object_type(end, PL_CLASS_INT);
-    check_object_length(end, 1);
     check_same_type(x, items);
 
-    const int start_int = ((int *) start->data)[0];
-    const int end_int = ((int *) end->data)[0];
-    check_missing_value(start_int);
-    check_missing_value(end_int);
-    check_index_out_of_bound(x, start_int);
-    check_index_out_of_bound(x, end_int);
+    const long start_index = scalar_index(start);
+    const long end_index = scalar_index(end);
+    check_missing_value(start_index);
+    check_missing_value(end_index);
+    check_index_out_of_bound(x, start_index);
+    check_index_out_of_bound(x, end_index);
 
-    const int required_length = end_int - start_int + 1;
+    const long required_length = end_index - start_index + 1;
     if (required_length <= 0)
         return;
 
     check_incompatible_length(required_length, items->length);
-    if (items->length == required_length) {
-        primitive_set_range(x, start_int, end_int, items->data);
+    if (pl_object_type(x) == PL_CLASS_STRING) {
+        prepare_write(x);
+        items = string_adopt(x, items);
+        const pl_object_string_item *const src_array = pl_object_string_items(items->data);
+        pl_object_string_item *const data_array = pl_object_string_items(x->data);
+        pl_misc_for_i(required_length) data_array[start_index + i] = src_array[items->length == 1 ? 0 : i];
+    } else if (items->length == required_length) {
+        primitive_set_range(x, start_index, end_index, items->data);
     } else if (items->length == 1) {
-        pl_object new_y = primitive_new(x->class, required_length);
-        new_y->length = required_length;
-        switch (x->class) {
-            case PL_CLASS_CHAR: {
-                char *const new_y_array = new_y->data;
-                const char item = ((char *) items->data)[0];
-                pl_misc_for_i(required_length) {
-                    new_y_array[i] = item;
-                }
-                break;
-            }
-            case PL_CLASS_INT: {
-                int *const new_y_array = new_y->data;
-                const int item = ((int *) items->data)[0];
-                pl_misc_for_i(required_length) {
-                    new_y_array[i] = item;
-                }
-                break;
-            }
-            case PL_CLASS_LONG: {
-                long *const new_y_array = new_y->data;
-                const long item = ((long *) items->data)[0];
-                pl_misc_for_i(required_length) {
-                    new_y_array[i] = item;
-                }
-                break;
-            }
-            case PL_CLASS_DOUBLE: {
-                double *const new_y_array = new_y->data;
-                const double item = ((double *) items->data)[0];
-                pl_misc_for_i(required_length) {
-                    new_y_array[i] = item;
-                }
-                break;
-            }
-            case PL_CLASS_LIST: {
-                pl_object *const new_y_array = new_y->data;
-                pl_object item = ((pl_object *) items->data)[0];
-                pl_misc_for_i(required_length) {
-                    new_y_array[i] = item;
-                }
-                break;
-            }
-            case PL_CLASS_EXTERNAL: {
-                void **const new_y_array = new_y->data;
-                void *item = ((void **) items->data)[0];
-                pl_misc_for_i(required_length) {
-                    new_y_array[i] = item;
-                }
-                break;
-            }
-            default:
-                break;
-        }
-
-        primitive_set_range(x, start_int, end_int, new_y->data);
+        prepare_write(x);
+        fill_kernels[pl_object_type(x)](x->data, start_index, required_length, items->data);
+        if (pl_object_type(x) == PL_CLASS_LIST)
+            pl_gc_write_barrier(x, NULL);
     }
 }
 
@@ -896,8 +1525,10 @@ static void append(pl_object x, pl_object item) {
     check_object_type(x, PL_CLASS_LIST);
 
     primitive_reserve(x, x->length + 1);
+    prepare_write(x);
     ((pl_object *) x->data)[x->length] = item;
     x->length += 1;
+    pl_gc_write_barrier(x, item);
 }
 
 /*-----------------------------------------------------------------------------
@@ -908,18 +1539,15 @@ static void append(pl_object x, pl_object item) {
 // Otherwise, the function will act the same as `subset` and drop the attribute.
 static pl_object extract(pl_object x, pl_object index) {
     check_null_pointer(x);
-    check_null_pointer(index);
-    check_object_type(index, PL_CLASS_INT);
-    check_object_length(index, 1);
 
-    const int int_index = ((int *) index->data)[0];
-    check_missing_value(int_index);
-    check_index_out_of_bound(x, int_index);
+    const long long_index = scalar_index(index);
+    check_missing_value(long_index);
+    check_index_out_of_bound(x, long_index);
 
-    if (pl_class_get_ns().type(x->class) == PL_CLASS_LIST)
-        return ((pl_object *) x->data)[int_index];
+    if (pl_object_type(x) == PL_CLASS_LIST)
+        return ((pl_object *) x->data)[long_index];
     else
-        return primitive_subset(x, 1, (int[1]) {int_index});
+        return subset_by_long_indices_to(NULL, x, 1, (long[1]) {long_index});
 }
 
 /*-----------------------------------------------------------------------------
@@ -935,16 +1563,19 @@ static void extend(pl_object x, pl_object y) {
         return;
 
     long result_length = x->length + y->length;
-    pl_error_expect(result_length > 0 && result_length < PL_OBJECT_MAX_CAPACITY,
+    pl_error_expect(result_length > 0 && result_length <= PL_OBJECT_MAX_CAPACITY,
                     PL_ERROR_INVALID_CAPACITY,
                     "Invalid capacity [%ld]!",
                     result_length);
 
-    primitive_reserve(x, (int) result_length);
-    memmove((char *) x->data + pl_object_data_size(x->class, x->length),
-            y->data,
-            pl_object_data_size(y->class, y->length));
+    primitive_reserve(x, result_length);
+    prepare_write(x);
+    if (pl_object_type(x) == PL_CLASS_STRING)
+        y = string_adopt(x, y);
+    move_items(x->class, x->data, x->length, y->data, 0, y->length);
     x->length = x->length + y->length;
+    if (pl_object_type(x) == PL_CLASS_LIST)
+        pl_gc_write_barrier(x, NULL);
 }
 
 /*-----------------------------------------------------------------------------
@@ -954,11 +1585,38 @@ static void extend(pl_object x, pl_object y) {
 static pl_object subset(pl_object x, pl_object indices) {
     check_null_pointer(x);
     check_null_pointer(indices);
-    check_object_type(indices, PL_CLASS_INT);
 
+    const int index_type = pl_object_type(indices);
+    if (index_type == PL_CLASS_BOOL)
+        return subset_by_mask_to(NULL, x, indices);
+
+    check_index_type(indices);
+    if (index_type == PL_CLASS_LONG)
+        return subset_by_long_indices_to(NULL, x, indices->length, indices->data);
     return primitive_subset(x, indices->length, indices->data);
 }
 
+static void subset_into(pl_object dst, pl_object x, pl_object indices) {
+    check_null_pointer(dst);
+    check_null_pointer(x);
+    check_null_pointer(indices);
+    pl_error_expect(dst != indices,
+                    PL_ERROR_INVALID_ARGUMENT,
+                    "The destination can't be an operand!");
+
+    const int index_type = pl_object_type(indices);
+    if (index_type == PL_CLASS_BOOL) {
+        subset_by_mask_to(dst, x, indices);
+        return;
+    }
+
+    check_index_type(indices);
+    if (index_type == PL_CLASS_LONG)
+        subset_by_long_indices_to(dst, x, indices->length, indices->data);
+    else
+        primitive_subset_to(dst, x, indices->length, indices->data);
+}
+
 /*-----------------------------------------------------------------------------
  |  Subset exclude
  ----------------------------------------------------------------------------*/
@@ -971,26 +1629,277 @@ static pl_object subset_exclude(pl_object x, pl_object indices) {
     return primitive_subset_exclude(x, indices->length, indices->data);
 }
 
+static void subset_exclude_into(pl_object dst, pl_object x, pl_object indices) {
+    check_null_pointer(dst);
+    check_null_pointer(x);
+    check_null_pointer(indices);
+    check_object_type(indices, PL_CLASS_INT);
+    pl_error_expect(dst != indices,
+                    PL_ERROR_INVALID_ARGUMENT,
+                    "The destination can't be an operand!");
+
+    primitive_subset_exclude_to(dst, x, indices->length, indices->data);
+}
+
 /*-----------------------------------------------------------------------------
  |  Copy
  ----------------------------------------------------------------------------*/
 
+// Large objects share their data with the copy until either one is written.
 static pl_object copy(pl_object x) {
     check_null_pointer(x);
+    return pl_gc_get_ns().slice_object(x, 0, x->length);
+}
 
-    pl_object object = primitive_new(x->class, x->length);
-    object->length = x->length;
-    memcpy(object->data,
-           x->data,
-           pl_object_data_size(x->class, x->length));
-    return object;
+/*-----------------------------------------------------------------------------
+ |  Comparison kernels
+ ----------------------------------------------------------------------------*/
+
+// Element-wise equality of two arrays into Boolean blocks. `y_length` is either `length` or 1.
+// The bits of a block are combined without branches, so the loops can be unrolled.
+// A broadcast NA makes every result NA.
+#define pl_object_equal_kernel(name, type)                                                                           \
+    static void name(const type *const x, const type *const y, const long y_length, uint64_t *restrict const result, \
+                     const long length) {                                                                            \
+        for (long block = 0; block < bool_num_blocks(length); block++) {                                             \
+            const long offset = block * PL_OBJECT_BOOL_BLOCK;                                                        \
+            const int count = length - offset < PL_OBJECT_BOOL_BLOCK ? (int) (length - offset)                       \
+                                                                     : PL_OBJECT_BOOL_BLOCK;                         \
+            uint64_t value = 0;                                                                                      \
+            uint64_t na = 0;                                                                                         \
+            for (int i = 0; i < count; i++) {                                                                        \
+                const type a = x[offset + i];                                                                        \
+                const type b = y_length == 1 ? y[0] : y[offset + i];                                                 \
+                value |= (uint64_t) (a == b) << i;                                                                   \
+                na |= (uint64_t) ((pl_is_na(a)) | (pl_is_na(b))) << i;                                               \
+            }                                                                                                        \
+            result[2 * block] = value & ~na;                                                                         \
+            result[2 * block + 1] = na;                                                                              \
+        }                                                                                                            \
+    }
+
+#define equal_kernel(prefix, class, name, type, na) pl_object_equal_kernel(prefix##_##name, type)
+
+pl_object_plain_types(equal_kernel, equal)
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// The portable kernels are compiled for the baseline instruction set (SSE2 on x86-64).
+// AVX2 kernels are selected at runtime. They compare full blocks and take the bits of
+// the comparisons with `movemask`.
+
+__attribute__((target("avx2"))) static void equal_int_avx2(const int *const x, const int *const y, const long y_length,
+                                                           uint64_t *const result, const long length) {
+    const __m256i na = _mm256_set1_epi32(PL_INT_NA);
+    const __m256i item = _mm256_set1_epi32(y[0]);
+    const long num_blocks = length / PL_OBJECT_BOOL_BLOCK;
+    for (long block = 0; block < num_blocks; block++) {
+        uint64_t value = 0;
+        uint64_t is_na = 0;
+        for (int i = 0; i < PL_OBJECT_BOOL_BLOCK; i += 8) {
+            const long offset = block * PL_OBJECT_BOOL_BLOCK + i;
+            const __m256i x_item = _mm256_loadu_si256((const __m256i *) (x + offset));
+            const __m256i y_item = y_length == 1 ? item : _mm256_loadu_si256((const __m256i *) (y + offset));
+            const __m256i is_equal = _mm256_cmpeq_epi32(x_item, y_item);
+            const __m256i item_na = _mm256_or_si256(_mm256_cmpeq_epi32(x_item, na), _mm256_cmpeq_epi32(y_item, na));
+            value |= (uint64_t) (unsigned) _mm256_movemask_ps(_mm256_castsi256_ps(is_equal)) << i;
+            is_na |= (uint64_t) (unsigned) _mm256_movemask_ps(_mm256_castsi256_ps(item_na)) << i;
+        }
+        result[2 * block] = value & ~is_na;
+        result[2 * block + 1] = is_na;
+    }
+    const long done = num_blocks * PL_OBJECT_BOOL_BLOCK;
+    equal_int(x + done, y_length == 1 ? y : y + done, y_length, result + 2 * num_blocks, length - done);
+}
+
+__attribute__((target("avx2"))) static void equal_double_avx2(const double *const x, const double *const y,
+                                                              const long y_length, uint64_t *const result,
+                                                              const long length) {
+    const __m256d item = _mm256_set1_pd(y[0]);
+    const long num_blocks = length / PL_OBJECT_BOOL_BLOCK;
+    for (long block = 0; block < num_blocks; block++) {
+        uint64_t value = 0;
+        uint64_t is_na = 0;
+        for (int i = 0; i < PL_OBJECT_BOOL_BLOCK; i += 4) {
+            const long offset = block * PL_OBJECT_BOOL_BLOCK + i;
+            const __m256d x_item = _mm256_loadu_pd(x + offset);
+            const __m256d y_item = y_length == 1 ? item : _mm256_loadu_pd(y + offset);
+            value |= (uint64_t) (unsigned) _mm256_movemask_pd(_mm256_cmp_pd(x_item, y_item, _CMP_EQ_OQ)) << i;
+            is_na |= (uint64_t) (unsigned) _mm256_movemask_pd(_mm256_cmp_pd(x_item, y_item, _CMP_UNORD_Q)) << i;
+        }
+        result[2 * block] = value & ~is_na;
+        result[2 * block + 1] = is_na;
+    }
+    const long done = num_blocks * PL_OBJECT_BOOL_BLOCK;
+    equal_double(x + done, y_length == 1 ? y : y + done, y_length, result + 2 * num_blocks, length - done);
+}
+
+#define equal_int_best (__builtin_cpu_supports("avx2") ? equal_int_avx2 : equal_int)
+#define equal_double_best (__builtin_cpu_supports("avx2") ? equal_double_avx2 : equal_double)
+
+#elif defined(__aarch64__)
+
+// NEON is always available on AArch64. The bits of the comparisons are taken by masking
+// every lane with its own bit and adding the lanes.
+
+static void equal_int_neon(const int *const x, const int *const y, const long y_length, uint64_t *const result,
+                           const long length) {
+    static const uint32_t lane_bits[4] = {1, 2, 4, 8};
+    const uint32x4_t bits = vld1q_u32(lane_bits);
+    const int32x4_t na = vdupq_n_s32(PL_INT_NA);
+    const int32x4_t item = vdupq_n_s32(y[0]);
+    const long num_blocks = length / PL_OBJECT_BOOL_BLOCK;
+    for (long block = 0; block < num_blocks; block++) {
+        uint64_t value = 0;
+        uint64_t is_na = 0;
+        for (int i = 0; i < PL_OBJECT_BOOL_BLOCK; i += 4) {
+            const long offset = block * PL_OBJECT_BOOL_BLOCK + i;
+            const int32x4_t x_item = vld1q_s32(x + offset);
+            const int32x4_t y_item = y_length == 1 ? item : vld1q_s32(y + offset);
+            const uint32x4_t item_na = vorrq_u32(vceqq_s32(x_item, na), vceqq_s32(y_item, na));
+            value |= (uint64_t) vaddvq_u32(vandq_u32(vceqq_s32(x_item, y_item), bits)) << i;
+            is_na |= (uint64_t) vaddvq_u32(vandq_u32(item_na, bits)) << i;
+        }
+        result[2 * block] = value & ~is_na;
+        result[2 * block + 1] = is_na;
+    }
+    const long done = num_blocks * PL_OBJECT_BOOL_BLOCK;
+    equal_int(x + done, y_length == 1 ? y : y + done, y_length, result + 2 * num_blocks, length - done);
+}
+
+static void equal_double_neon(const double *const x, const double *const y, const long y_length,
+                              uint64_t *const result, const long length) {
+    static const uint64_t lane_bits[2] = {1, 2};
+    const uint64x2_t bits = vld1q_u64(lane_bits);
+    const float64x2_t item = vdupq_n_f64(y[0]);
+    const long num_blocks = length / PL_OBJECT_BOOL_BLOCK;
+    for (long block = 0; block < num_blocks; block++) {
+        uint64_t value = 0;
+        uint64_t is_ordered = 0;
+        for (int i = 0; i < PL_OBJECT_BOOL_BLOCK; i += 2) {
+            const long offset = block * PL_OBJECT_BOOL_BLOCK + i;
+            const float64x2_t x_item = vld1q_f64(x + offset);
+            const float64x2_t y_item = y_length == 1 ? item : vld1q_f64(y + offset);
+            const uint64x2_t ordered = vandq_u64(vceqq_f64(x_item, x_item), vceqq_f64(y_item, y_item));
+            value |= vaddvq_u64(vandq_u64(vceqq_f64(x_item, y_item), bits)) << i;
+            is_ordered |= vaddvq_u64(vandq_u64(ordered, bits)) << i;
+        }
+        result[2 * block] = value & is_ordered;
+        result[2 * block + 1] = ~is_ordered;
+    }
+    const long done = num_blocks * PL_OBJECT_BOOL_BLOCK;
+    equal_double(x + done, y_length == 1 ? y : y + done, y_length, result + 2 * num_blocks, length - done);
+}
+
+#define equal_int_best equal_int_neon
+#define equal_double_best equal_double_neon
+
+#else
+
+#define equal_int_best equal_int
+#define equal_double_best equal_double
+
+#endif
+
+// Run an equality kernel on a chunk of blocks.
+#define pl_object_equal_chunk(name, kernel, type)                                                      \
+    static void name(void *const context, const int chunk, const long start, const long end) {         \
+        (void) chunk;                                                                                  \
+        const parallel_operands *const operands = context;                                             \
+        const long first = start * PL_OBJECT_BOOL_BLOCK;                                               \
+        const long last = end * PL_OBJECT_BOOL_BLOCK < operands->x_length ? end * PL_OBJECT_BOOL_BLOCK \
+                                                                          : operands->x_length;        \
+        kernel((const type *) operands->x + first,                                                     \
+               parallel_offset(operands->y, type, operands->y_length, first),                          \
+               operands->y_length,                                                                     \
+               (uint64_t *) operands->result + 2 * start,                                              \
+               last - first);                                                                          \
+    }
+
+pl_object_equal_chunk(equal_char_chunk, equal_char, char)
+pl_object_equal_chunk(equal_int_chunk, equal_int_best, int)
+pl_object_equal_chunk(equal_long_chunk, equal_long, long)
+pl_object_equal_chunk(equal_double_chunk, equal_double_best, double)
+pl_object_equal_chunk(equal_list_chunk, equal_list, pl_object)
+pl_object_equal_chunk(equal_external_chunk, equal_external, void *)
+
+// Booleans are compared a block at a time. A recycled Boolean is spread over a whole block.
+static void equal_bool_chunk(void *const context, const int chunk, const long start, const long end) {
+    (void) chunk;
+    const parallel_operands *const operands = context;
+    const uint64_t *const x = operands->x;
+    const uint64_t *const y = operands->y;
+    uint64_t *const result = operands->result;
+
+    const int item = operands->y_length == 1 ? pl_object_bool_get(y, 0) : 0;
+    const uint64_t item_value = item == 1 ? ~(uint64_t) 0 : 0;
+    const uint64_t item_na = pl_is_na(item) ? ~(uint64_t) 0 : 0;
+    for (long block = start; block < end; block++) {
+        const uint64_t y_value = operands->y_length == 1 ? item_value : y[2 * block];
+        const uint64_t na = x[2 * block + 1] | (operands->y_length == 1 ? item_na : y[2 * block + 1]);
+        result[2 * block] = ~(x[2 * block] ^ y_value) & ~na;
+        result[2 * block + 1] = na;
+    }
+}
+
+// Check if two strings, neither of which is NA, hold the same bytes. The same bytes
+// of a shared byte buffer are not read.
+static int string_bytes_equal(const void *const x_data, const pl_object_string_item a,
+                              const void *const y_data, const pl_object_string_item b) {
+    if (a.length != b.length)
+        return 0;
+    if (a.length == 0)
+        return 1;
+    const pl_object x_bytes = pl_object_string_bytes(x_data);
+    const pl_object y_bytes = pl_object_string_bytes(y_data);
+    if (x_bytes == y_bytes && a.offset == b.offset)
+        return 1;
+    return memcmp((const char *) x_bytes->data + a.offset, (const char *) y_bytes->data + b.offset, (size_t) a.length) == 0;
+}
+
+// Strings are compared item by item, since their bytes have different lengths.
+static void equal_string_chunk(void *const context, const int chunk, const long start, const long end) {
+    (void) chunk;
+    const parallel_operands *const operands = context;
+    const pl_object_string_item *const x = pl_object_string_items(operands->x);
+    const pl_object_string_item *const y = pl_object_string_items(operands->y);
+    uint64_t *const result = operands->result;
+    for (long block = start; block < end; block++) {
+        const long offset = block * PL_OBJECT_BOOL_BLOCK;
+        const int count = operands->x_length - offset < PL_OBJECT_BOOL_BLOCK ? (int) (operands->x_length - offset)
+                                                                             : PL_OBJECT_BOOL_BLOCK;
+        uint64_t value = 0;
+        uint64_t na = 0;
+        for (int k = 0; k < count; k++) {
+            const pl_object_string_item a = x[offset + k];
+            const pl_object_string_item b = y[operands->y_length == 1 ? 0 : offset + k];
+            if (pl_is_na(a.length) || pl_is_na(b.length))
+                na |= (uint64_t) 1 << k;
+            else
+                value |= (uint64_t) string_bytes_equal(operands->x, a, operands->y, b) << k;
+        }
+        result[2 * block] = value;
+        result[2 * block + 1] = na;
+    }
 }
 
+// Equality chunks indexed by the underlying type.
+static void (*const equal_chunks[PL_NUM_CLASS])(void *, int, long, long) = {
+        [PL_CLASS_CHAR]     = equal_char_chunk,
+        [PL_CLASS_INT]      = equal_int_chunk,
+        [PL_CLASS_LONG]     = equal_long_chunk,
+        [PL_CLASS_DOUBLE]   = equal_double_chunk,
+        [PL_CLASS_LIST]     = equal_list_chunk,
+        [PL_CLASS_EXTERNAL] = equal_external_chunk,
+        [PL_CLASS_BOOL]     = equal_bool_chunk,
+        [PL_CLASS_STRING]   = equal_string_chunk};
+
 /*-----------------------------------------------------------------------------
  |  Equal
  ----------------------------------------------------------------------------*/
 
-static pl_object equal(pl_object x, pl_object y) {
+// The result is written into `dst`, or into a new object if `dst` is NULL.
+static pl_object equal_to(pl_object dst, pl_object x, pl_object y) {
     check_null_pointer(x);
     check_null_pointer(y);
     check_same_type(x, y);
@@ -999,565 +1908,2584 @@ static pl_object equal(pl_object x, pl_object y) {
     if (x->length < y->length) {
         pl_object tmp = x;
         x = y;
-        y = x;
+        y = tmp;
     }
 
     check_incompatible_length(x->length, y->length);
 
-    // New an object for storing the result.
-    pl_object object = primitive_new(PL_CLASS_INT, x->length == 0 ? 1 : x->length);
-    object->length = x->length;
-    int *const object_data_array = object->data;
+    pl_object object = prepare_destination(dst, PL_CLASS_BOOL, x->length, x, y);
 
     // Get the underlying type.
-    const int type = pl_class_get_ns().type(y->class);
+    const int type = pl_object_type(y);
 
-    switch (type) {
-        case PL_CLASS_CHAR: {
-            char *const y_data_array = y->data;
-            char *const x_data_array = x->data;
-            pl_misc_for_i(x->length) {
-                if (y->length > 1) {
-                    object_data_array[i] =
-                            pl_is_na(x_data_array[i]) || pl_is_na(y_data_array[i]) ? PL_INT_NA : x_data_array[i] ==
-                                                                                                 y_data_array[i];
+    parallel_operands operands = {.x        = x->data,
+                                  .x_length = x->length,
+                                  .y        = y->data,
+                                  .y_length = y->length,
+                                  .result   = object->data};
+    pl_misc_get_ns().parallel_for(bool_num_blocks(x->length), equal_chunks[type], &operands);
+
+    return object;
+}
+
+static pl_object equal(pl_object x, pl_object y) {
+    return equal_to(NULL, x, y);
+}
+
+static void equal_into(pl_object dst, pl_object x, pl_object y) {
+    check_null_pointer(dst);
+    equal_to(dst, x, y);
+}
+
+/*-----------------------------------------------------------------------------
+ |  Hash kernels
+ ----------------------------------------------------------------------------*/
+
+// An open-addressing hash index from 64-bit keys to the first item having them.
+// A key and its item share a slot, so a probe touches one cache line. Empty slots hold
+// the item -1. The slots are an object, so they are released by the garbage collector.
+typedef struct hash_slot {
+    unsigned long key;
+    long item;
+} hash_slot;
+
+typedef struct hash_index {
+    hash_slot *slots;
+    unsigned long mask;
+} hash_index;
+
+static hash_index hash_index_new(const long length) {
+    // Keep the load factor below 1/2.
+    long capacity = 16;
+    while (capacity < length * 2)
+        capacity *= 2;
+
+    pl_object slots = primitive_new(PL_CLASS_CHAR, capacity * (long) sizeof(hash_slot));
+    memset(slots->data, 0xFF, (size_t) capacity * sizeof(hash_slot));
+
+    const hash_index index = {.slots = slots->data, .mask = (unsigned long) capacity - 1};
+    return index;
+}
+
+static unsigned long hash_index_slot(const hash_index *const index, const unsigned long key) {
+    unsigned long hash = key * 0x9E3779B97F4A7C15UL;
+    return (hash ^ (hash >> 32)) & index->mask;
+}
+
+// Insert a key with its item unless the key is present.
+// Returns -1 if the key is inserted, otherwise the item of the key.
+static long hash_index_insert(const hash_index *const index, const unsigned long key, const long item) {
+    unsigned long slot = hash_index_slot(index, key);
+    while (index->slots[slot].item != -1) {
+        if (index->slots[slot].key == key)
+            return index->slots[slot].item;
+        slot = (slot + 1) & index->mask;
+    }
+    index->slots[slot].key = key;
+    index->slots[slot].item = item;
+    return -1;
+}
+
+// Returns the item of a key, or -1 if the key is absent.
+static long hash_index_find(const hash_index *const index, const unsigned long key) {
+    unsigned long slot = hash_index_slot(index, key);
+    while (index->slots[slot].item != -1) {
+        if (index->slots[slot].key == key)
+            return index->slots[slot].item;
+        slot = (slot + 1) & index->mask;
+    }
+    return -1;
+}
+
+// Key of a double. All NAs share a key, and so do 0.0 and -0.0.
+static unsigned long hash_double_key(const double x) {
+    if (x != x)
+        return 0x7FF8000000000000UL;
+    if (x == 0.0)
+        return 0;
+    unsigned long key;
+    memcpy(&key, &x, sizeof(key));
+    return key;
+}
+
+#define hash_int_key(x) ((unsigned long) (unsigned int) (x))
+#define hash_long_key(x) ((unsigned long) (x))
+#define hash_pointer_key(x) ((unsigned long) (uintptr_t) (x))
+
+// Match the items of x against the items of y. Each result is the position of the first
+// equal item in y, or -1 if there is none. With `is_in`, the results are 1 or 0 instead.
+// Distinct items of x are written to `result` in order of first appearance, and their number is returned.
+// Grouping writes the group of each item to `ids` and the position of the first item of each group
+// to `first`, numbering the groups in order of first appearance, and returns the number of groups.
+#define pl_object_hash_kernels(name, type, key_of)                                                            \
+    static void name##_match(const void *const x_data, const long x_length, const void *const y_data,        \
+                             const long y_length, int *const result, const int is_in) {                      \
+        type const *const x_array = x_data;                                                                   \
+        type const *const y_array = y_data;                                                                   \
+        const hash_index index = hash_index_new(y_length);                                                    \
+        for (long j = 0; j < y_length; j++)                                                                   \
+            hash_index_insert(&index, key_of(y_array[j]), is_in ? 0 : j);                                     \
+        for (long i = 0; i < x_length; i++) {                                                                 \
+            const long item = hash_index_find(&index, key_of(x_array[i]));                                    \
+            result[i] = is_in ? item != -1 : (int) item;                                                      \
+        }                                                                                                     \
+    }                                                                                                         \
+                                                                                                              \
+    static long name##_unique(const void *const x_data, const long length, void *const result_data) {        \
+        type const *const x_array = x_data;                                                                   \
+        type *const result = result_data;                                                                     \
+        const hash_index index = hash_index_new(length);                                                      \
+        long num_unique = 0;                                                                                  \
+        for (long i = 0; i < length; i++) {                                                                   \
+            if (hash_index_insert(&index, key_of(x_array[i]), 0) == -1)                                       \
+                result[num_unique++] = x_array[i];                                                            \
+        }                                                                                                     \
+        return num_unique;                                                                                    \
+    }                                                                                                         \
+                                                                                                              \
+    static long name##_group(const void *const x_data, const long length, int *const ids, int *const first) { \
+        type const *const x_array = x_data;                                                                   \
+        const hash_index index = hash_index_new(length);                                                      \
+        long num_groups = 0;                                                                                  \
+        for (long i = 0; i < length; i++) {                                                                   \
+            const long id = hash_index_insert(&index, key_of(x_array[i]), num_groups);                        \
+            if (id == -1) {                                                                                   \
+                first[num_groups] = (int) i;                                                                  \
+                ids[i] = (int) num_groups++;                                                                  \
+            } else {                                                                                          \
+                ids[i] = (int) id;                                                                            \
+            }                                                                                                 \
+        }                                                                                                     \
+        return num_groups;                                                                                    \
+    }
+
+pl_object_hash_kernels(hash_int, int, hash_int_key)
+pl_object_hash_kernels(hash_long, long, hash_long_key)
+pl_object_hash_kernels(hash_double, double, hash_double_key)
+pl_object_hash_kernels(hash_list, pl_object, hash_pointer_key)
+pl_object_hash_kernels(hash_external, void *, hash_pointer_key)
+
+// A lookup table covers every char.
+static void hash_char_match(const void *const x_data, const long x_length, const void *const y_data,
+                            const long y_length, int *const result, const int is_in) {
+    const unsigned char *const x_array = x_data;
+    const unsigned char *const y_array = y_data;
+    int table[256];
+    memset(table, 0xFF, sizeof(table));
+    for (long j = y_length - 1; j >= 0; j--)
+        table[y_array[j]] = is_in ? 0 : (int) j;
+    pl_misc_for_i(x_length) result[i] = is_in ? table[x_array[i]] != -1 : table[x_array[i]];
+}
+
+static long hash_char_unique(const void *const x_data, const long length, void *const result_data) {
+    const unsigned char *const x_array = x_data;
+    unsigned char *const result = result_data;
+    char seen[256] = {0};
+    long num_unique = 0;
+    pl_misc_for_i(length) {
+        if (!seen[x_array[i]]) {
+            seen[x_array[i]] = 1;
+            result[num_unique++] = x_array[i];
+        }
+    }
+    return num_unique;
+}
+
+static long hash_char_group(const void *const x_data, const long length, int *const ids, int *const first) {
+    const unsigned char *const x_array = x_data;
+    int table[256];
+    memset(table, 0xFF, sizeof(table));
+    long num_groups = 0;
+    pl_misc_for_i(length) {
+        if (table[x_array[i]] == -1) {
+            first[num_groups] = (int) i;
+            table[x_array[i]] = (int) num_groups++;
+        }
+        ids[i] = table[x_array[i]];
+    }
+    return num_groups;
+}
+
+// Key of a string. All NAs share a key. The bytes are mixed eight at a time.
+static unsigned long hash_string_key(const void *const data, const long i) {
+    const pl_object_string_item item = pl_object_string_items(data)[i];
+    if (pl_is_na(item.length))
+        return ~0UL;
+
+    const char *const bytes = pl_object_string_get(data, i);
+    unsigned long key = (unsigned long) item.length;
+    for (long k = 0; k < item.length; k += 8) {
+        unsigned long word = 0;
+        memcpy(&word, bytes + k, item.length - k < 8 ? (size_t) (item.length - k) : 8);
+        key = (key ^ word) * 0xFF51AFD7ED558CCDUL;
+        key ^= key >> 32;
+    }
+    return key;
+}
+
+// Keys of strings may collide, so the items having a key are compared. NAs equal each other.
+static int hash_string_equal(const void *const x_data, const long i, const void *const y_data, const long j) {
+    const pl_object_string_item a = pl_object_string_items(x_data)[i];
+    const pl_object_string_item b = pl_object_string_items(y_data)[j];
+    if (pl_is_na(a.length) || pl_is_na(b.length))
+        return pl_is_na(a.length) && pl_is_na(b.length);
+    return string_bytes_equal(x_data, a, y_data, b);
+}
+
+// Returns the first item of `y_data` in the index equal to item `i` of `x_data`, or -1 if there is none.
+static long hash_string_find(const hash_index *const index, const void *const y_data, const void *const x_data,
+                             const long i, const unsigned long key) {
+    unsigned long slot = hash_index_slot(index, key);
+    while (index->slots[slot].item != -1) {
+        if (index->slots[slot].key == key && hash_string_equal(x_data, i, y_data, index->slots[slot].item))
+            return index->slots[slot].item;
+        slot = (slot + 1) & index->mask;
+    }
+    return -1;
+}
+
+// Insert item `i` of `x_data` unless an equal item is present.
+// Returns -1 if the item is inserted, otherwise the equal item.
+static long hash_string_insert(const hash_index *const index, const void *const x_data, const long i) {
+    const unsigned long key = hash_string_key(x_data, i);
+    unsigned long slot = hash_index_slot(index, key);
+    while (index->slots[slot].item != -1) {
+        if (index->slots[slot].key == key && hash_string_equal(x_data, i, x_data, index->slots[slot].item))
+            return index->slots[slot].item;
+        slot = (slot + 1) & index->mask;
+    }
+    index->slots[slot].key = key;
+    index->slots[slot].item = i;
+    return -1;
+}
+
+static void hash_string_match(const void *const x_data, const long x_length, const void *const y_data,
+                              const long y_length, int *const result, const int is_in) {
+    const hash_index index = hash_index_new(y_length);
+    for (long j = 0; j < y_length; j++)
+        hash_string_insert(&index, y_data, j);
+    for (long i = 0; i < x_length; i++) {
+        const long item = hash_string_find(&index, y_data, x_data, i, hash_string_key(x_data, i));
+        result[i] = is_in ? item != -1 : (int) item;
+    }
+}
+
+// Distinct items share the byte buffer of x.
+static long hash_string_unique(const void *const x_data, const long length, void *const result_data) {
+    const pl_object_string_item *const x_array = pl_object_string_items(x_data);
+    pl_object_string_item *const result = pl_object_string_items(result_data);
+    pl_object_string_bytes(result_data) = pl_object_string_bytes(x_data);
+    const hash_index index = hash_index_new(length);
+    long num_unique = 0;
+    for (long i = 0; i < length; i++) {
+        if (hash_string_insert(&index, x_data, i) == -1)
+            result[num_unique++] = x_array[i];
+    }
+    return num_unique;
+}
+
+// The index holds the first item of each group, whose group is already known.
+static long hash_string_group(const void *const x_data, const long length, int *const ids, int *const first) {
+    const hash_index index = hash_index_new(length);
+    long num_groups = 0;
+    for (long i = 0; i < length; i++) {
+        const long item = hash_string_insert(&index, x_data, i);
+        if (item == -1) {
+            first[num_groups] = (int) i;
+            ids[i] = (int) num_groups++;
+        } else {
+            ids[i] = ids[item];
+        }
+    }
+    return num_groups;
+}
+
+// Hash kernels indexed by the underlying type.
+static void (*const match_kernels[PL_NUM_CLASS])(const void *, long, const void *, long, int *, int) = {
+        [PL_CLASS_CHAR]     = hash_char_match,
+        [PL_CLASS_INT]      = hash_int_match,
+        [PL_CLASS_LONG]     = hash_long_match,
+        [PL_CLASS_DOUBLE]   = hash_double_match,
+        [PL_CLASS_LIST]     = hash_list_match,
+        [PL_CLASS_EXTERNAL] = hash_external_match,
+        [PL_CLASS_STRING]   = hash_string_match};
+
+static long (*const unique_kernels[PL_NUM_CLASS])(const void *, long, void *) = {
+        [PL_CLASS_CHAR]     = hash_char_unique,
+        [PL_CLASS_INT]      = hash_int_unique,
+        [PL_CLASS_LONG]     = hash_long_unique,
+        [PL_CLASS_DOUBLE]   = hash_double_unique,
+        [PL_CLASS_LIST]     = hash_list_unique,
+        [PL_CLASS_EXTERNAL] = hash_external_unique,
+        [PL_CLASS_STRING]   = hash_string_unique};
+
+static long (*const group_kernels[PL_NUM_CLASS])(const void *, long, int *, int *) = {
+        [PL_CLASS_CHAR]     = hash_char_group,
+        [PL_CLASS_INT]      = hash_int_group,
+        [PL_CLASS_LONG]     = hash_long_group,
+        [PL_CLASS_DOUBLE]   = hash_double_group,
+        [PL_CLASS_LIST]     = hash_list_group,
+        [PL_CLASS_EXTERNAL] = hash_external_group,
+        [PL_CLASS_STRING]   = hash_string_group};
+
+#define check_hashable(x, type) pl_error_expect(match_kernels[type] != NULL,             \
+                                                PL_ERROR_INVALID_CLASS,                  \
+                                                "Object `" #x "` [%s] can't be hashed!", \
+                                                PL_CLASS_NAME[type])
+
+/*-----------------------------------------------------------------------------
+ |  In
+ ----------------------------------------------------------------------------*/
+
+// The result is written into `dst`, or into a new object if `dst` is NULL.
+static pl_object in_to(pl_object dst, pl_object x, pl_object y) {
+    check_null_pointer(x);
+    check_null_pointer(y);
+    check_same_type(x, y);
+
+    // Get the underlying type.
+    const int type = pl_object_type(y);
+    check_hashable(y, type);
+
+    pl_object object = prepare_destination(dst, PL_CLASS_BOOL, x->length, x, y);
+
+    // The results are found as ints, then packed.
+    pl_object found = primitive_new(PL_CLASS_INT, x->length == 0 ? 1 : x->length);
+    found->length = x->length;
+    match_kernels[type](x->data, x->length, y->data, y->length, found->data, 1);
+    convert_into(object, found, PL_CLASS_INT, PL_CLASS_BOOL);
+    return object;
+}
+
+static pl_object in(pl_object x, pl_object y) {
+    return in_to(NULL, x, y);
+}
+
+static void in_into(pl_object dst, pl_object x, pl_object y) {
+    check_null_pointer(dst);
+    in_to(dst, x, y);
+}
+
+/*-----------------------------------------------------------------------------
+ |  Match
+ ----------------------------------------------------------------------------*/
+
+// The result is written into `dst`, or into a new object if `dst` is NULL.
+static pl_object match_to(pl_object dst, pl_object x, pl_object table) {
+    check_null_pointer(x);
+    check_null_pointer(table);
+    check_same_type(x, table);
+    pl_error_expect(table->length <= INT_MAX,
+                    PL_ERROR_INVALID_LENGTH,
+                    "Object `table` has length [%ld] which can't be indexed by [int]!",
+                    table->length);
+
+    // Get the underlying type.
+    const int type = pl_object_type(table);
+    check_hashable(table, type);
+
+    pl_object object = prepare_destination(dst, PL_CLASS_INT, x->length, x, table);
+    int *const object_data_array = object->data;
+
+    match_kernels[type](x->data, x->length, table->data, table->length, object_data_array, 0);
+    pl_misc_for_i(x->length) {
+        if (object_data_array[i] == -1)
+            object_data_array[i] = PL_INT_NA;
+    }
+    return object;
+}
+
+static pl_object match(pl_object x, pl_object table) {
+    return match_to(NULL, x, table);
+}
+
+static void match_into(pl_object dst, pl_object x, pl_object table) {
+    check_null_pointer(dst);
+    match_to(dst, x, table);
+}
+
+/*-----------------------------------------------------------------------------
+ |  Unique
+ ----------------------------------------------------------------------------*/
+
+// The result is written into `dst`, or into a new object if `dst` is NULL.
+static pl_object unique_to(pl_object dst, pl_object x) {
+    check_null_pointer(x);
+
+    // Get the underlying type.
+    const int type = pl_object_type(x);
+    check_hashable(x, type);
+
+    pl_object object = prepare_destination(dst, x->class, x->length, x, NULL);
+
+    object->length = unique_kernels[type](x->data, x->length, object->data);
+    finish_destination(dst, object);
+    return object;
+}
+
+static pl_object unique(pl_object x) {
+    return unique_to(NULL, x);
+}
+
+static void unique_into(pl_object dst, pl_object x) {
+    check_null_pointer(dst);
+    unique_to(dst, x);
+}
+
+/*-----------------------------------------------------------------------------
+ |  Sort kernels
+ ----------------------------------------------------------------------------*/
+
+// Runs of keys shorter than this are sorted by insertion.
+#define SORT_INSERTION_LENGTH 32
+
+// Sort unsigned keys by LSD radix sort on bytes, moving `indices` along if it is not NULL.
+// The buffers hold `length` items. A pass is skipped if every key has the same byte, so
+// narrow ranges of values take few passes. The sort is stable, and the result is left in
+// `keys` and `indices`.
+#define pl_object_radix_sort(name, key_type)                                                                 \
+    static void name(key_type *const keys, key_type *const keys_buffer, int *const indices,                 \
+                     int *const indices_buffer, const long length) {                                        \
+        if (length <= SORT_INSERTION_LENGTH) {                                                               \
+            for (long i = 1; i < length; i++) {                                                              \
+                const key_type key = keys[i];                                                                \
+                const int index = indices != NULL ? indices[i] : 0;                                          \
+                long j = i;                                                                                  \
+                for (; j > 0 && keys[j - 1] > key; j--) {                                                    \
+                    keys[j] = keys[j - 1];                                                                   \
+                    if (indices != NULL)                                                                     \
+                        indices[j] = indices[j - 1];                                                         \
+                }                                                                                            \
+                keys[j] = key;                                                                               \
+                if (indices != NULL)                                                                         \
+                    indices[j] = index;                                                                      \
+            }                                                                                                \
+            return;                                                                                          \
+        }                                                                                                    \
+                                                                                                             \
+        /* Histograms of every pass are counted in one read. */                                              \
+        long counts[sizeof(key_type)][256];                                                                  \
+        memset(counts, 0, sizeof(counts));                                                                   \
+        for (long i = 0; i < length; i++) {                                                                  \
+            for (int pass = 0; pass < (int) sizeof(key_type); pass++)                                        \
+                counts[pass][(keys[i] >> (8 * pass)) & 0xFF]++;                                              \
+        }                                                                                                    \
+                                                                                                             \
+        key_type *src = keys, *dst = keys_buffer;                                                            \
+        int *src_indices = indices, *dst_indices = indices_buffer;                                           \
+        for (int pass = 0; pass < (int) sizeof(key_type); pass++) {                                          \
+            long *const offsets = counts[pass];                                                              \
+            if (offsets[(src[0] >> (8 * pass)) & 0xFF] == length)                                            \
+                continue;                                                                                    \
+            long offset = 0;                                                                                 \
+            for (int byte = 0; byte < 256; byte++) {                                                         \
+                const long count = offsets[byte];                                                            \
+                offsets[byte] = offset;                                                                      \
+                offset += count;                                                                             \
+            }                                                                                                \
+            for (long i = 0; i < length; i++) {                                                              \
+                const long position = offsets[(src[i] >> (8 * pass)) & 0xFF]++;                              \
+                dst[position] = src[i];                                                                      \
+                if (indices != NULL)                                                                         \
+                    dst_indices[position] = src_indices[i];                                                  \
+            }                                                                                                \
+            key_type *const keys_swap = src;                                                                 \
+            src = dst;                                                                                       \
+            dst = keys_swap;                                                                                 \
+            int *const indices_swap = src_indices;                                                           \
+            src_indices = dst_indices;                                                                       \
+            dst_indices = indices_swap;                                                                      \
+        }                                                                                                    \
+                                                                                                             \
+        if (src != keys) {                                                                                   \
+            memcpy(keys, src, (size_t) length * sizeof(key_type));                                           \
+            if (indices != NULL)                                                                             \
+                memcpy(indices, src_indices, (size_t) length * sizeof(int));                                 \
+        }                                                                                                    \
+    }
+
+pl_object_radix_sort(radix_sort_char, unsigned char)
+pl_object_radix_sort(radix_sort_int, unsigned int)
+pl_object_radix_sort(radix_sort_long, unsigned long)
+
+// Keys ordered as unsigned integers in the same order as the items.
+// Negative doubles have all their bits flipped, and the others only the sign bit.
+// Chars flip the sign bit only where `char` is signed.
+#define SORT_CHAR_SIGN (CHAR_MIN < 0 ? 0x80 : 0)
+#define sort_char_key(x) ((unsigned char) ((unsigned char) (x) ^ SORT_CHAR_SIGN))
+#define sort_char_item(key) ((char) ((key) ^ SORT_CHAR_SIGN))
+#define sort_int_key(x) ((unsigned int) (x) ^ 0x80000000U)
+#define sort_int_item(key) ((int) ((key) ^ 0x80000000U))
+#define sort_long_key(x) ((unsigned long) (x) ^ 0x8000000000000000UL)
+#define sort_long_item(key) ((long) ((key) ^ 0x8000000000000000UL))
+
+static unsigned long sort_double_key(const double x) {
+    unsigned long key;
+    memcpy(&key, &x, sizeof(key));
+    return key >> 63 ? ~key : key | 0x8000000000000000UL;
+}
+
+static double sort_double_item(unsigned long key) {
+    key = key >> 63 ? key & ~0x8000000000000000UL : ~key;
+    double x;
+    memcpy(&x, &key, sizeof(x));
+    return x;
+}
+
+// Sort the items of x into `result`, or order them by writing their positions into `result`.
+// NAs are removed before sorting the keys, then placed last if `na_last` is 1, first if it is 0,
+// and dropped if it is NA. The number of results is returned. Keys and positions are sorted in
+// a `malloc()` scratch, so sorting leaves no garbage for the collector. Positions come first in
+// the scratch of `order`, since their size keeps the keys aligned.
+#define pl_object_sort_kernels(name, type, key_type, to_key, to_item, radix_sort, na)           \
+    static long name##_sort(const void *const x_data, const long length, const int na_last,     \
+                            void *const result_data) {                                          \
+        const type *const x_array = x_data;                                                     \
+        type *const result = result_data;                                                       \
+        key_type *const keys = malloc((size_t) (2 * length) * sizeof(key_type));                \
+        pl_error_expect(keys != NULL, PL_ERROR_ALLOC_FAILED, "`malloc()` fails!");              \
+                                                                                                \
+        long num_keys = 0;                                                                      \
+        for (long i = 0; i < length; i++) {                                                     \
+            if (!pl_is_na(x_array[i]))                                                          \
+                keys[num_keys++] = to_key(x_array[i]);                                          \
+        }                                                                                       \
+        radix_sort(keys, keys + length, NULL, NULL, num_keys);                                  \
+                                                                                                \
+        const long num_na = pl_is_na(na_last) ? 0 : length - num_keys;                          \
+        type *const items = result + (na_last == 0 ? num_na : 0);                               \
+        type *const nas = result + (na_last == 0 ? 0 : num_keys);                               \
+        for (long i = 0; i < num_keys; i++)                                                     \
+            items[i] = to_item(keys[i]);                                                        \
+        for (long i = 0; i < num_na; i++)                                                       \
+            nas[i] = (na);                                                                      \
+        free(keys);                                                                             \
+        return num_keys + num_na;                                                               \
+    }                                                                                           \
+                                                                                                \
+    static long name##_order(const void *const x_data, const long length, const int na_last,    \
+                             void *const result_data) {                                         \
+        const type *const x_array = x_data;                                                     \
+        int *const result = result_data;                                                        \
+        int *const indices = malloc((size_t) (2 * length) * (sizeof(key_type) + sizeof(int)));  \
+        pl_error_expect(indices != NULL, PL_ERROR_ALLOC_FAILED, "`malloc()` fails!");           \
+        key_type *const keys = (key_type *) (indices + 2 * length);                             \
+                                                                                                \
+        long num_keys = 0;                                                                      \
+        for (long i = 0; i < length; i++) {                                                     \
+            if (!pl_is_na(x_array[i])) {                                                        \
+                keys[num_keys] = to_key(x_array[i]);                                            \
+                indices[num_keys++] = (int) i;                                                  \
+            }                                                                                   \
+        }                                                                                       \
+        radix_sort(keys, keys + length, indices, indices + length, num_keys);                   \
+                                                                                                \
+        const long num_na = pl_is_na(na_last) ? 0 : length - num_keys;                          \
+        int *const nas = result + (na_last == 0 ? 0 : num_keys);                                \
+        memcpy(result + (na_last == 0 ? num_na : 0), indices, (size_t) num_keys * sizeof(int)); \
+        for (long i = 0, j = 0; j < num_na; i++) {                                              \
+            if (pl_is_na(x_array[i]))                                                           \
+                nas[j++] = (int) i;                                                             \
+        }                                                                                       \
+        free(indices);                                                                          \
+        return num_keys + num_na;                                                               \
+    }
+
+pl_object_sort_kernels(sort_char, char, unsigned char, sort_char_key, sort_char_item, radix_sort_char, PL_CHAR_NA)
+pl_object_sort_kernels(sort_int, int, unsigned int, sort_int_key, sort_int_item, radix_sort_int, PL_INT_NA)
+pl_object_sort_kernels(sort_long, long, unsigned long, sort_long_key, sort_long_item, radix_sort_long, PL_LONG_NA)
+pl_object_sort_kernels(sort_double, double, unsigned long, sort_double_key, sort_double_item, radix_sort_long, PL_DOUBLE_NA)
+
+// Sort kernels indexed by the underlying type. Pointers have no order.
+static long (*const sort_kernels[PL_NUM_CLASS])(const void *, long, int, void *) = {
+        [PL_CLASS_CHAR]   = sort_char_sort,
+        [PL_CLASS_INT]    = sort_int_sort,
+        [PL_CLASS_LONG]   = sort_long_sort,
+        [PL_CLASS_DOUBLE] = sort_double_sort};
+
+static long (*const order_kernels[PL_NUM_CLASS])(const void *, long, int, void *) = {
+        [PL_CLASS_CHAR]   = sort_char_order,
+        [PL_CLASS_INT]    = sort_int_order,
+        [PL_CLASS_LONG]   = sort_long_order,
+        [PL_CLASS_DOUBLE] = sort_double_order};
+
+// Read the placement of NAs: 1 for last, 0 for first, NA to drop them.
+static int scalar_na_last(pl_object na_last) {
+    check_null_pointer(na_last);
+    check_object_type(na_last, PL_CLASS_INT);
+    check_object_length(na_last, 1);
+
+    const int value = ((int *) na_last->data)[0];
+    pl_error_expect(value == 0 || value == 1 || pl_is_na(value),
+                    PL_ERROR_INVALID_ARGUMENT,
+                    "Invalid placement of NAs [%d]! Expecting 0, 1 or NA!",
+                    value);
+    return value;
+}
+
+#define check_sortable(x, type) pl_error_expect(sort_kernels[type] != NULL,             \
+                                                PL_ERROR_INVALID_CLASS,                 \
+                                                "Object `" #x "` [%s] can't be sorted!", \
+                                                PL_CLASS_NAME[type])
+
+/*-----------------------------------------------------------------------------
+ |  Sort
+ ----------------------------------------------------------------------------*/
+
+// The result is written into `dst`, or into a new object if `dst` is NULL.
+static pl_object sort_to(pl_object dst, pl_object x, pl_object na_last) {
+    check_null_pointer(x);
+    const int na_position = scalar_na_last(na_last);
+
+    // Get the underlying type.
+    const int type = pl_object_type(x);
+    check_sortable(x, type);
+
+    pl_object object = prepare_destination(dst, x->class, x->length, x, NULL);
+    if (x->length > 0)
+        object->length = sort_kernels[type](x->data, x->length, na_position, object->data);
+    return object;
+}
+
+static pl_object sort(pl_object x, pl_object na_last) {
+    return sort_to(NULL, x, na_last);
+}
+
+static void sort_into(pl_object dst, pl_object x, pl_object na_last) {
+    check_null_pointer(dst);
+    sort_to(dst, x, na_last);
+}
+
+/*-----------------------------------------------------------------------------
+ |  Order
+ ----------------------------------------------------------------------------*/
+
+// The result is written into `dst`, or into a new object if `dst` is NULL.
+static pl_object order_to(pl_object dst, pl_object x, pl_object na_last) {
+    check_null_pointer(x);
+    const int na_position = scalar_na_last(na_last);
+
+    // Get the underlying type.
+    const int type = pl_object_type(x);
+    check_sortable(x, type);
+    pl_error_expect(x->length <= INT_MAX,
+                    PL_ERROR_INVALID_LENGTH,
+                    "Object `x` has length [%ld] which can't be indexed by [int]!",
+                    x->length);
+
+    pl_object object = prepare_destination(dst, PL_CLASS_INT, x->length, x, NULL);
+    if (x->length > 0)
+        object->length = order_kernels[type](x->data, x->length, na_position, object->data);
+    return object;
+}
+
+static pl_object order(pl_object x, pl_object na_last) {
+    return order_to(NULL, x, na_last);
+}
+
+static void order_into(pl_object dst, pl_object x, pl_object na_last) {
+    check_null_pointer(dst);
+    order_to(dst, x, na_last);
+}
+
+static pl_unittest_summary test_sort(void) {
+    pl_unittest_summary summary = pl_unittest_new_summary();
+
+    pl_object na_first = primitive_new_from_array(PL_CLASS_INT, 1, (int[]) {0});
+    pl_object na_last = primitive_new_from_array(PL_CLASS_INT, 1, (int[]) {1});
+    pl_object na_drop = primitive_new_from_array(PL_CLASS_INT, 1, (int[]) {PL_INT_NA});
+
+    // Negative chars sort before letters, as they compare with `<`. Zero is the NA of chars.
+    const char chars[] = {'c', -5, 'a', PL_CHAR_NA, 'b', CHAR_MIN, CHAR_MAX};
+    pl_object x = primitive_new_from_array(PL_CLASS_CHAR, 7, chars);
+    pl_object sorted = sort(x, na_last);
+    const char chars_sorted[] = {CHAR_MIN, -5, 'a', 'b', 'c', CHAR_MAX, PL_CHAR_NA};
+    pl_unittest_expect_true(summary, sorted->length == 7 && memcmp(sorted->data, chars_sorted, 7) == 0);
+    volatile int chars_ordered = 1;
+    char all_chars[255];
+    pl_misc_for_i(255) all_chars[i] = (char) (i + 1);
+    sorted = sort(primitive_new_from_array(PL_CLASS_CHAR, 255, all_chars), na_drop);
+    pl_misc_for_i(1, sorted->length) chars_ordered = chars_ordered && ((char *) sorted->data)[i - 1] < ((char *) sorted->data)[i];
+    pl_unittest_expect_true(summary, chars_ordered && sorted->length == 255);
+
+    // Signed values, with NAs placed last, first or dropped.
+    const int ints[] = {3, PL_INT_NA, -7, INT_MIN, 0, -1};
+    x = primitive_new_from_array(PL_CLASS_INT, 6, ints);
+    const int ints_last[] = {INT_MIN, -7, -1, 0, 3, PL_INT_NA};
+    const int ints_first[] = {PL_INT_NA, INT_MIN, -7, -1, 0, 3};
+    sorted = sort(x, na_last);
+    pl_unittest_expect_true(summary, memcmp(sorted->data, ints_last, sizeof(ints_last)) == 0);
+    sorted = sort(x, na_first);
+    pl_unittest_expect_true(summary, memcmp(sorted->data, ints_first, sizeof(ints_first)) == 0);
+    sorted = sort(x, na_drop);
+    pl_unittest_expect_true(summary, sorted->length == 5 && memcmp(sorted->data, ints_last, 5 * sizeof(int)) == 0);
+
+    const long longs[] = {LONG_MIN, 4, PL_LONG_NA, -(4L << 40), 4L << 40};
+    sorted = sort(primitive_new_from_array(PL_CLASS_LONG, 5, longs), na_first);
+    const long longs_sorted[] = {PL_LONG_NA, LONG_MIN, -(4L << 40), 4, 4L << 40};
+    pl_unittest_expect_true(summary, memcmp(sorted->data, longs_sorted, sizeof(longs_sorted)) == 0);
+
+    const double doubles[] = {1.5, PL_DOUBLE_NA, -2.5, -(double) INFINITY, (double) INFINITY, -0.25};
+    sorted = sort(primitive_new_from_array(PL_CLASS_DOUBLE, 6, doubles), na_last);
+    const double *const sorted_doubles = sorted->data;
+    pl_unittest_expect_true(summary, sorted_doubles[0] == -(double) INFINITY && sorted_doubles[1] == -2.5 &&
+                                             sorted_doubles[2] == -0.25 && sorted_doubles[3] == 1.5 &&
+                                             sorted_doubles[4] == (double) INFINITY && isnan(sorted_doubles[5]));
+
+    // Orders are stable, and the positions of NAs keep their order.
+    const int ties[] = {2, 1, PL_INT_NA, 2, 1, PL_INT_NA};
+    pl_object positions = order(primitive_new_from_array(PL_CLASS_INT, 6, ties), na_first);
+    const int ties_order[] = {2, 5, 1, 4, 0, 3};
+    pl_unittest_expect_true(summary, memcmp(positions->data, ties_order, sizeof(ties_order)) == 0);
+    positions = order(primitive_new_from_array(PL_CLASS_CHAR, 7, chars), na_drop);
+    const int chars_order[] = {5, 1, 2, 4, 0, 6};
+    pl_unittest_expect_true(summary, positions->length == 6 && memcmp(positions->data, chars_order, sizeof(chars_order)) == 0);
+
+    pl_unittest_expect_error_is(summary, PL_ERROR_INVALID_CLASS, sort(primitive_new(PL_CLASS_LIST, 1), na_last));
+    pl_unittest_expect_error_is(summary, PL_ERROR_INVALID_ARGUMENT,
+                                sort(x, primitive_new_from_array(PL_CLASS_INT, 1, (int[]) {2})));
+
+    return summary;
+}
+
+static pl_unittest_summary test_subset(void) {
+    pl_unittest_summary summary = pl_unittest_new_summary();
+
+    // Small grains split the loops into several chunks, which must agree on their offsets.
+    const pl_misc_ns misc_ns = pl_misc_get_ns();
+    misc_ns.set_num_threads(4);
+    misc_ns.set_grain_size(16);
+    const long length = 1000;
+    pl_unittest_expect_true(summary, misc_ns.parallel_chunks(length) > 1);
+
+    int items[1000], selected[1000];
+    pl_object mask = primitive_new(PL_CLASS_BOOL, length);
+    mask->length = length;
+    pl_misc_for_i(length) {
+        items[i] = (int) i - 500;
+        selected[i] = i % 3 == 0 || (i > 600 && i < 700);
+        pl_object_bool_set(mask->data, i, selected[i]);
+    }
+    pl_object x = primitive_new_from_array(PL_CLASS_INT, length, items);
+
+    int expected[1000];
+    long num_selected = 0;
+    pl_misc_for_i(length) {
+        if (selected[i])
+            expected[num_selected++] = items[i];
+    }
+    pl_object by_bool = primitive_subset_by_bool(x, selected);
+    pl_unittest_expect_true(summary, by_bool->length == num_selected &&
+                                             memcmp(by_bool->data, expected, (size_t) num_selected * sizeof(int)) == 0);
+    pl_object by_mask = subset_by_mask_to(NULL, x, mask);
+    pl_unittest_expect_true(summary, by_mask->length == num_selected &&
+                                             memcmp(by_mask->data, expected, (size_t) num_selected * sizeof(int)) == 0);
+
+    misc_ns.set_num_threads(1);
+    misc_ns.set_grain_size(PL_MISC_DEFAULT_GRAIN_SIZE);
+    return summary;
+}
+
+/*-----------------------------------------------------------------------------
+ |  Set decimals
+ ----------------------------------------------------------------------------*/
+
+static void print_set_decimals(pl_object x) {
+    check_null_pointer(x);
+    check_object_type(x, PL_CLASS_INT);
+    check_object_length(x, 1);
+
+    const int num_decimals = ((int *) x->data)[0];
+    if (num_decimals >= 0 || num_decimals == PL_OBJECT_PRINT_SHORTEST) {
+        pl_object_print_num_decimals = num_decimals;
+    }
+}
+
+/*-----------------------------------------------------------------------------
+ |  Set max items
+ ----------------------------------------------------------------------------*/
+
+static void print_set_max_items(pl_object x) {
+    check_null_pointer(x);
+    check_object_type(x, PL_CLASS_INT);
+    check_object_length(x, 1);
+
+    const int max_items = ((int *) x->data)[0];
+    if (max_items >= 0) {
+        pl_object_print_max_items = max_items;
+    }
+}
+
+/*-----------------------------------------------------------------------------
+ |  Text buffer
+ ----------------------------------------------------------------------------*/
+
+// Formatted text is accumulated in a thread-local buffer, which is reused by later calls
+// unless it has grown beyond `TEXT_BUFFER_KEEP_CAPACITY` bytes. The buffer is freed when
+// its thread exits, through the destructor of a thread-specific key.
+typedef struct text_buffer {
+    char *data;
+    size_t length;
+    size_t capacity;
+} text_buffer;
+
+#define TEXT_BUFFER_KEEP_CAPACITY ((size_t) 1 << 20)
+
+static _Thread_local text_buffer global_text_buffer = {0};
+static pthread_key_t text_buffer_key;
+static pthread_once_t text_buffer_key_once = PTHREAD_ONCE_INIT;
+
+static void text_free(void *const context) {
+    text_buffer *const buffer = context;
+    free(buffer->data);
+    *buffer = (text_buffer) {0};
+}
+
+static void text_init_key(void) {
+    pthread_key_create(&text_buffer_key, text_free);
+}
+
+// Make room for `size` more bytes.
+static void text_reserve(text_buffer *const buffer, const size_t size) {
+    if (buffer->length + size <= buffer->capacity)
+        return;
+
+    // Register the buffer for thread exit before its first allocation.
+    if (buffer->data == NULL) {
+        pthread_once(&text_buffer_key_once, text_init_key);
+        pthread_setspecific(text_buffer_key, buffer);
+    }
+
+    size_t capacity = buffer->capacity == 0 ? 256 : buffer->capacity;
+    while (capacity < buffer->length + size)
+        capacity += capacity / 2;
+    char *const data = realloc(buffer->data, capacity);
+    pl_error_expect(data != NULL, PL_ERROR_ALLOC_FAILED, "`realloc()` fails!");
+    buffer->data = data;
+    buffer->capacity = capacity;
+}
+
+// Release the buffer if it is too large to be kept for later calls.
+static void text_release(text_buffer *const buffer) {
+    buffer->length = 0;
+    if (buffer->capacity > TEXT_BUFFER_KEEP_CAPACITY) {
+        free(buffer->data);
+        buffer->data = NULL;
+        buffer->capacity = 0;
+    }
+}
+
+static void text_append(text_buffer *const buffer, const char *const text, const size_t size) {
+    text_reserve(buffer, size);
+    memcpy(buffer->data + buffer->length, text, size);
+    buffer->length += size;
+}
+
+#define text_append_literal(buffer, text) text_append(buffer, text, sizeof(text) - 1)
+
+// Two digits per entry, so that integers are formatted two digits at a time.
+static const char text_digit_pairs[201] = "00010203040506070809"
+                                          "10111213141516171819"
+                                          "20212223242526272829"
+                                          "30313233343536373839"
+                                          "40414243444546474849"
+                                          "50515253545556575859"
+                                          "60616263646566676869"
+                                          "70717273747576777879"
+                                          "80818283848586878889"
+                                          "90919293949596979899";
+
+// Write the digits of `value` backward from `end`. Returns the first digit.
+static char *text_write_digits(char *end, unsigned long value) {
+    while (value >= 100) {
+        const unsigned long pair = (value % 100) * 2;
+        value /= 100;
+        *--end = text_digit_pairs[pair + 1];
+        *--end = text_digit_pairs[pair];
+    }
+    if (value >= 10) {
+        *--end = text_digit_pairs[value * 2 + 1];
+        *--end = text_digit_pairs[value * 2];
+    } else {
+        *--end = (char) ('0' + value);
+    }
+    return end;
+}
+
+static void text_append_long(text_buffer *const buffer, const long value) {
+    char digits[24];
+    char *const end = digits + sizeof(digits);
+    const unsigned long magnitude = value < 0 ? 0UL - (unsigned long) value : (unsigned long) value;
+    char *start = text_write_digits(end, magnitude);
+    if (value < 0)
+        *--start = '-';
+    text_append(buffer, start, (size_t) (end - start));
+}
+
+// Exact powers of ten.
+static const double text_powers_of_ten[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9,
+                                            1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17};
+
+// Scaled values below this bound are accurate to 2^-13, so rounding them can only go wrong
+// when they are within 2^-12 of halfway between two integers.
+#define TEXT_MAX_SCALED ((double) (1L << 40))
+
+// Round `|value| * 10^decimals` to an integer the same way `printf()` does.
+// Returns 0 if the fast path can't guarantee it.
+static int text_scale_double(const double value, const int decimals, unsigned long *const scaled) {
+    const double x = fabs(value) * text_powers_of_ten[decimals];
+    if (!(x < TEXT_MAX_SCALED))
+        return 0;
+    const double rounded = nearbyint(x);
+    if (fabs(fabs(x - rounded) - 0.5) < 1.0 / 4096)
+        return 0;
+    *scaled = (unsigned long) rounded;
+    return 1;
+}
+
+// Write the digits of `scaled` with `decimals` digits after the decimal point.
+static void text_append_scaled(text_buffer *const buffer, const int negative, unsigned long scaled, const int decimals) {
+    char digits[48];
+    char *const end = digits + sizeof(digits);
+    char *start = end;
+    if (decimals > 0) {
+        const unsigned long divisor = (unsigned long) text_powers_of_ten[decimals];
+        char *const fraction = text_write_digits(end, scaled % divisor);
+        start = end - decimals;
+        memset(start, '0', (size_t) (fraction - start));
+        *--start = '.';
+        scaled /= divisor;
+    }
+    start = text_write_digits(start, scaled);
+    if (negative)
+        *--start = '-';
+    text_append(buffer, start, (size_t) (end - start));
+}
+
+// Format with `snprintf()`, for the values the fast paths don't cover.
+static void text_append_double_slow(text_buffer *const buffer, const double value, const int decimals) {
+    char digits[64];
+    if (decimals == PL_OBJECT_PRINT_SHORTEST) {
+        // The fewest significant digits that round-trip. 17 digits always do.
+        int size = 0;
+        for (int precision = 1; precision <= 17; precision++) {
+            size = snprintf(digits, sizeof(digits), "%.*g", precision, value);
+            if (strtod(digits, NULL) == value)
+                break;
+        }
+        text_append(buffer, digits, (size_t) size);
+        return;
+    }
+
+    const int size = snprintf(NULL, 0, "%.*f", decimals, value);
+    text_reserve(buffer, (size_t) size + 1);
+    snprintf(buffer->data + buffer->length, (size_t) size + 1, "%.*f", decimals, value);
+    buffer->length += (size_t) size;
+}
+
+// Doubles are printed with a fixed number of decimals, or with the fewest decimals
+// that parse back to the same value when the number of decimals is `PL_OBJECT_PRINT_SHORTEST`.
+static void text_append_double(text_buffer *const buffer, const double value, const int decimals) {
+    unsigned long scaled = 0;
+    if (isinf(value)) {
+        if (value > 0)
+            text_append_literal(buffer, "inf");
+        else
+            text_append_literal(buffer, "-inf");
+        return;
+    }
+
+    if (decimals == PL_OBJECT_PRINT_SHORTEST) {
+        // The division of two exact integers is correctly rounded, so it tells whether
+        // the decimal digits parse back to the same value.
+        for (int i = 0; i <= 17; i++) {
+            const double x = fabs(value) * text_powers_of_ten[i];
+            if (!(x < TEXT_MAX_SCALED))
+                break;
+            const double rounded = nearbyint(x);
+            if (rounded / text_powers_of_ten[i] == fabs(value)) {
+                text_append_scaled(buffer, signbit(value) != 0, (unsigned long) rounded, i);
+                return;
+            }
+        }
+    } else if (decimals <= 17 && text_scale_double(value, decimals, &scaled)) {
+        text_append_scaled(buffer, signbit(value) != 0, scaled, decimals);
+        return;
+    }
+
+    text_append_double_slow(buffer, value, decimals);
+}
+
+/*-----------------------------------------------------------------------------
+ |  Format
+ ----------------------------------------------------------------------------*/
+
+// Format the items in [start, end), each followed by ", ".
+static void format_items(text_buffer *const buffer, pl_object x, const long start, const long end) {
+    switch (pl_object_type(x)) {
+        case PL_CLASS_CHAR: {
+            const char *const data_array = x->data;
+            text_reserve(buffer, (size_t) (end - start) * 5);
+            for (long i = start; i < end; i++) {
+                char *const item = buffer->data + buffer->length;
+                if (pl_is_na(data_array[i])) {
+                    memcpy(item, "NA, ", 4);
+                    buffer->length += 4;
                 } else {
-                    object_data_array[i] =
-                            pl_is_na(x_data_array[i]) || pl_is_na(y_data_array[i]) ? PL_INT_NA : x_data_array[i] ==
-                                                                                                 y_data_array[0];
+                    memcpy(item, "'?', ", 5);
+                    item[1] = data_array[i];
+                    buffer->length += 5;
+                }
+            }
+            break;
+        }
+        case PL_CLASS_INT: {
+            const int *const data_array = x->data;
+            for (long i = start; i < end; i++) {
+                if (pl_is_na(data_array[i]))
+                    text_append_literal(buffer, "NA, ");
+                else {
+                    text_append_long(buffer, data_array[i]);
+                    text_append_literal(buffer, ", ");
+                }
+            }
+            break;
+        }
+        case PL_CLASS_LONG: {
+            const long *const data_array = x->data;
+            for (long i = start; i < end; i++) {
+                if (pl_is_na(data_array[i]))
+                    text_append_literal(buffer, "NA, ");
+                else {
+                    text_append_long(buffer, data_array[i]);
+                    text_append_literal(buffer, "L, ");
+                }
+            }
+            break;
+        }
+        case PL_CLASS_DOUBLE: {
+            const double *const data_array = x->data;
+            const int decimals = pl_object_print_num_decimals;
+            for (long i = start; i < end; i++) {
+                if (pl_is_na(data_array[i]))
+                    text_append_literal(buffer, "NA, ");
+                else {
+                    text_append_double(buffer, data_array[i], decimals);
+                    text_append_literal(buffer, ", ");
                 }
             }
             break;
         }
+        case PL_CLASS_LIST: {
+            // Class names are measured once.
+            char names[PL_NUM_CLASS][64];
+            size_t name_sizes[PL_NUM_CLASS];
+            pl_misc_for_i(PL_NUM_CLASS) {
+                const int size = snprintf(names[i], sizeof(names[i]), "<%s>, ", PL_CLASS_NAME[i]);
+                name_sizes[i] = size < (int) sizeof(names[i]) ? (size_t) size : sizeof(names[i]) - 1;
+            }
+
+            const pl_object *const data_array = x->data;
+            for (long i = start; i < end; i++) {
+                if (pl_is_na(data_array[i]))
+                    text_append_literal(buffer, "NA, ");
+                else
+                    text_append(buffer, names[data_array[i]->class], name_sizes[data_array[i]->class]);
+            }
+            break;
+        }
+        case PL_CLASS_EXTERNAL: {
+            void *const *const data_array = x->data;
+            for (long i = start; i < end; i++) {
+                if (pl_is_na(data_array[i]))
+                    text_append_literal(buffer, "NA, ");
+                else
+                    text_append_literal(buffer, "<EXTERNAL>, ");
+            }
+            break;
+        }
+        case PL_CLASS_BOOL: {
+            for (long i = start; i < end; i++) {
+                const int item = pl_object_bool_get(x->data, i);
+                if (pl_is_na(item))
+                    text_append_literal(buffer, "NA, ");
+                else if (item)
+                    text_append_literal(buffer, "TRUE, ");
+                else
+                    text_append_literal(buffer, "FALSE, ");
+            }
+            break;
+        }
+        case PL_CLASS_STRING: {
+            const pl_object_string_item *const data_array = pl_object_string_items(x->data);
+            for (long i = start; i < end; i++) {
+                if (pl_is_na(data_array[i].length))
+                    text_append_literal(buffer, "NA, ");
+                else {
+                    text_append_literal(buffer, "\"");
+                    text_append(buffer, pl_object_string_get(x->data, i), (size_t) data_array[i].length);
+                    text_append_literal(buffer, "\", ");
+                }
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+// Format an object into a buffer. With a maximum number of items, only
+// the head and the tail of a longer object are formatted.
+static void format_text(text_buffer *const buffer, pl_object x) {
+    check_null_pointer(x);
+
+    buffer->length = 0;
+    text_append_literal(buffer, "[");
+    if (x->length == 0) {
+        text_append_literal(buffer, "]");
+        return;
+    }
+
+    const long max_items = pl_object_print_max_items;
+    if (max_items > 0 && x->length > max_items) {
+        format_items(buffer, x, 0, (max_items + 1) / 2);
+        text_append_literal(buffer, "..., ");
+        format_items(buffer, x, x->length - max_items / 2, x->length);
+    } else {
+        format_items(buffer, x, 0, x->length);
+    }
+
+    // Replace the last separator.
+    buffer->length -= 2;
+    text_append_literal(buffer, "]");
+}
+
+static pl_object format_to(pl_object dst, pl_object x) {
+    // If anything throws, the buffer is kept by the thread and reset by the next call.
+    text_buffer *const buffer = &global_text_buffer;
+    format_text(buffer, x);
+
+    // The text is followed by a null terminator, which is not counted in the length.
+    pl_object object = prepare_destination(dst, PL_CLASS_CHAR, (long) buffer->length + 1, x, NULL);
+    memcpy(object->data, buffer->data, buffer->length);
+    ((char *) object->data)[buffer->length] = '\0';
+    object->length = (long) buffer->length;
+    text_release(buffer);
+    return object;
+}
+
+static pl_object format(pl_object x) {
+    return format_to(NULL, x);
+}
+
+static void format_into(pl_object dst, pl_object x) {
+    check_null_pointer(dst);
+    format_to(dst, x);
+}
+
+/*-----------------------------------------------------------------------------
+ |  Print
+ ----------------------------------------------------------------------------*/
+
+// The text is written by a single `fwrite()`.
+static void print_to(FILE *const stream, pl_object x) {
+    check_null_pointer(stream);
+
+    // If anything throws, the buffer is kept by the thread and reset by the next call.
+    text_buffer *const buffer = &global_text_buffer;
+    format_text(buffer, x);
+    text_append_literal(buffer, "\n");
+    fwrite(buffer->data, 1, buffer->length, stream);
+    text_release(buffer);
+}
+
+static void print(pl_object x) {
+    print_to(stdout, x);
+}
+
+/*-----------------------------------------------------------------------------
+ |  Conversion kernels
+ ----------------------------------------------------------------------------*/
+
+// Convert an array item by item, where `a` is the source item.
+// Range checks are combined without short-circuiting and NAs are selected
+// instead of branched to, so the loops can be vectorized.
+#define pl_object_convert_kernel(name, src_type, dst_type, expression)          \
+    static void name(const void *const x, void *const dst, const long length) { \
+        const src_type *restrict const data_array = x;                          \
+        dst_type *restrict const dst_array = dst;                               \
+        for (long i = 0; i < length; i++) {                                      \
+            const src_type a = data_array[i];                                   \
+            dst_array[i] = (expression);                                        \
+        }                                                                       \
+    }
+
+// Narrowing integer conversions. Out of range items are NA.
+#define convert_narrow(dst_type, dst_na, min, max) \
+    ((pl_is_na(a)) | (a < (min)) | (a > (max)) ? (dst_na) : (dst_type) a)
+
+// Widening integer conversions.
+#define convert_widen(dst_type, dst_na) ((pl_is_na(a)) ? (dst_na) : (dst_type) a)
+
+// Conversions from double. NaNs fail both comparisons, so they are NA.
+// The upper bound of long is exclusive as LONG_MAX is rounded up to 2^63 as a double.
+#define convert_from_double(dst_type, dst_na, min, max) \
+    ((a >= (double) (min)) & (a <= (double) (max)) ? (dst_type) a : (dst_na))
+
+pl_object_convert_kernel(convert_int_to_char, int, char, convert_narrow(char, PL_CHAR_NA, CHAR_MIN, CHAR_MAX))
+pl_object_convert_kernel(convert_long_to_char, long, char, convert_narrow(char, PL_CHAR_NA, CHAR_MIN, CHAR_MAX))
+pl_object_convert_kernel(convert_double_to_char, double, char, convert_from_double(char, PL_CHAR_NA, CHAR_MIN, CHAR_MAX))
+pl_object_convert_kernel(convert_char_to_int, char, int, convert_widen(int, PL_INT_NA))
+pl_object_convert_kernel(convert_long_to_int, long, int, convert_narrow(int, PL_INT_NA, INT_MIN, INT_MAX))
+pl_object_convert_kernel(convert_double_to_int, double, int, convert_from_double(int, PL_INT_NA, INT_MIN, INT_MAX))
+pl_object_convert_kernel(convert_char_to_long, char, long, convert_widen(long, PL_LONG_NA))
+pl_object_convert_kernel(convert_int_to_long, int, long, convert_widen(long, PL_LONG_NA))
+pl_object_convert_kernel(convert_double_to_long, double, long,
+                         (a >= (double) LONG_MIN) & (a < (double) LONG_MAX) ? (long) a : PL_LONG_NA)
+pl_object_convert_kernel(convert_char_to_double, char, double, convert_widen(double, PL_DOUBLE_NA))
+pl_object_convert_kernel(convert_int_to_double, int, double, convert_widen(double, PL_DOUBLE_NA))
+pl_object_convert_kernel(convert_long_to_double, long, double, convert_widen(double, PL_DOUBLE_NA))
+
+// Pack an array into Boolean blocks. Non-zero items are TRUE.
+#define pl_object_pack_kernel(name, src_type)                                                  \
+    static void name(const void *const x, void *const dst, const long length) {                \
+        const src_type *restrict const data_array = x;                                         \
+        uint64_t *restrict const block_array = dst;                                            \
+        for (long block = 0; block < bool_num_blocks(length); block++) {                       \
+            const long offset = block * PL_OBJECT_BOOL_BLOCK;                                  \
+            const int count = length - offset < PL_OBJECT_BOOL_BLOCK ? (int) (length - offset) \
+                                                                     : PL_OBJECT_BOOL_BLOCK;   \
+            uint64_t value = 0;                                                                \
+            uint64_t na = 0;                                                                   \
+            for (int i = 0; i < count; i++) {                                                  \
+                const src_type a = data_array[offset + i];                                     \
+                value |= (uint64_t) (a != 0) << i;                                             \
+                na |= (uint64_t) (pl_is_na(a)) << i;                                           \
+            }                                                                                  \
+            block_array[2 * block] = value & ~na;                                              \
+            block_array[2 * block + 1] = na;                                                   \
+        }                                                                                      \
+    }
+
+// Unpack Boolean blocks into an array of 0, 1 and NA.
+#define pl_object_unpack_kernel(name, dst_type, dst_na)                                           \
+    static void name(const void *const x, void *const dst, const long length) {                   \
+        const uint64_t *restrict const block_array = x;                                           \
+        dst_type *restrict const dst_array = dst;                                                 \
+        for (long i = 0; i < length; i++) {                                                       \
+            const long block = i / PL_OBJECT_BOOL_BLOCK;                                          \
+            const int bit = (int) (i % PL_OBJECT_BOOL_BLOCK);                                     \
+            const int value = (int) ((block_array[2 * block] >> bit) & 1);                        \
+            dst_array[i] = (block_array[2 * block + 1] >> bit) & 1 ? (dst_na) : (dst_type) value; \
+        }                                                                                         \
+    }
+
+pl_object_pack_kernel(convert_int_to_bool, int)
+pl_object_pack_kernel(convert_long_to_bool, long)
+pl_object_pack_kernel(convert_double_to_bool, double)
+pl_object_unpack_kernel(convert_bool_to_int, int, PL_INT_NA)
+pl_object_unpack_kernel(convert_bool_to_long, long, PL_LONG_NA)
+pl_object_unpack_kernel(convert_bool_to_double, double, PL_DOUBLE_NA)
+
+// Kernels indexed by [source type][target type]. Identity conversions are copied with `memcpy`.
+static void (*const convert_kernels[PL_NUM_CLASS][PL_NUM_CLASS])(const void *, void *, long) = {
+        [PL_CLASS_CHAR]   = {[PL_CLASS_INT]    = convert_char_to_int,
+                             [PL_CLASS_LONG]   = convert_char_to_long,
+                             [PL_CLASS_DOUBLE] = convert_char_to_double},
+        [PL_CLASS_INT]    = {[PL_CLASS_CHAR]   = convert_int_to_char,
+                             [PL_CLASS_LONG]   = convert_int_to_long,
+                             [PL_CLASS_DOUBLE] = convert_int_to_double,
+                             [PL_CLASS_BOOL]   = convert_int_to_bool},
+        [PL_CLASS_LONG]   = {[PL_CLASS_CHAR]   = convert_long_to_char,
+                             [PL_CLASS_INT]    = convert_long_to_int,
+                             [PL_CLASS_DOUBLE] = convert_long_to_double,
+                             [PL_CLASS_BOOL]   = convert_long_to_bool},
+        [PL_CLASS_DOUBLE] = {[PL_CLASS_CHAR]   = convert_double_to_char,
+                             [PL_CLASS_INT]    = convert_double_to_int,
+                             [PL_CLASS_LONG]   = convert_double_to_long,
+                             [PL_CLASS_BOOL]   = convert_double_to_bool},
+        [PL_CLASS_BOOL]   = {[PL_CLASS_INT]    = convert_bool_to_int,
+                             [PL_CLASS_LONG]   = convert_bool_to_long,
+                             [PL_CLASS_DOUBLE] = convert_bool_to_double}};
+
+// Conversions from or to Booleans run on chunks of blocks.
+#define convert_by_blocks(operands) ((operands)->x_class == PL_CLASS_BOOL || (operands)->result_class == PL_CLASS_BOOL)
+
+// Run a conversion kernel on a chunk.
+static void convert_chunk(void *const context, const int chunk, const long start, const long end) {
+    (void) chunk;
+    const parallel_operands *const operands = context;
+    long first = start;
+    long last = end;
+    if (convert_by_blocks(operands)) {
+        first = start * PL_OBJECT_BOOL_BLOCK;
+        last = end * PL_OBJECT_BOOL_BLOCK < operands->x_length ? end * PL_OBJECT_BOOL_BLOCK : operands->x_length;
+    }
+    operands->convert((const char *) operands->x + pl_object_data_size(operands->x_class, first),
+                      (char *) operands->result + pl_object_data_size(operands->result_class, first),
+                      last - first);
+}
+
+// Check if an object can be converted. Returns its underlying type.
+static int convert_source_type(pl_object x, const int target) {
+    check_null_pointer(x);
+    const int type = pl_object_type(x);
+    pl_error_expect(type == target || convert_kernels[type][target] != NULL,
+                    PL_ERROR_INVALID_CLASS,
+                    "Can not convert a [%s] object to a [%s] object!",
+                    PL_CLASS_NAME[x->class],
+                    PL_CLASS_NAME[target]);
+    return type;
+}
+
+// Convert x into dst, which is of the target type and has enough capacity.
+static void convert_into(pl_object dst, pl_object x, const int type, const int target) {
+    if (dst != x) {
+        prepare_write(dst);
+        if (type == target)
+            memcpy(dst->data, x->data, pl_object_data_size(target, x->length));
+        else
+        {
+            parallel_operands operands = {.x            = x->data,
+                                          .x_length     = x->length,
+                                          .result       = dst->data,
+                                          .convert      = convert_kernels[type][target],
+                                          .x_class      = type,
+                                          .result_class = target};
+            const long length = convert_by_blocks(&operands) ? bool_num_blocks(x->length) : x->length;
+            pl_misc_get_ns().parallel_for(length, convert_chunk, &operands);
+        }
+    }
+    dst->length = x->length;
+}
+
+static pl_object convert(pl_object x, const int target) {
+    const int type = convert_source_type(x, target);
+    pl_object object = primitive_new(target, x->length == 0 ? 1 : x->length);
+    convert_into(object, x, type, target);
+    return object;
+}
+
+static void convert_to(pl_object dst, pl_object x, const int target) {
+    const int type = convert_source_type(x, target);
+    check_null_pointer(dst);
+    check_object_type(dst, target);
+
+    if (dst->capacity < x->length)
+        primitive_reserve(dst, x->length);
+    convert_into(dst, x, type, target);
+}
+
+/*-----------------------------------------------------------------------------
+ |  As char
+ ----------------------------------------------------------------------------*/
+
+static pl_object as_char(pl_object x) {
+    return convert(x, PL_CLASS_CHAR);
+}
+
+static void as_char_into(pl_object dst, pl_object x) {
+    convert_to(dst, x, PL_CLASS_CHAR);
+}
+
+/*-----------------------------------------------------------------------------
+ |  As int
+ ----------------------------------------------------------------------------*/
+
+static pl_object as_int(pl_object x) {
+    return convert(x, PL_CLASS_INT);
+}
+
+static void as_int_into(pl_object dst, pl_object x) {
+    convert_to(dst, x, PL_CLASS_INT);
+}
+
+/*-----------------------------------------------------------------------------
+ |  As long
+ ----------------------------------------------------------------------------*/
+
+static pl_object as_long(pl_object x) {
+    return convert(x, PL_CLASS_LONG);
+}
+
+static void as_long_into(pl_object dst, pl_object x) {
+    convert_to(dst, x, PL_CLASS_LONG);
+}
+
+/*-----------------------------------------------------------------------------
+ |  As double
+ ----------------------------------------------------------------------------*/
+
+static pl_object as_double(pl_object x) {
+    return convert(x, PL_CLASS_DOUBLE);
+}
+
+static void as_double_into(pl_object dst, pl_object x) {
+    convert_to(dst, x, PL_CLASS_DOUBLE);
+}
+
+/*-----------------------------------------------------------------------------
+ |  As bool
+ ----------------------------------------------------------------------------*/
+
+static pl_object as_bool(pl_object x) {
+    return convert(x, PL_CLASS_BOOL);
+}
+
+static void as_bool_into(pl_object dst, pl_object x) {
+    convert_to(dst, x, PL_CLASS_BOOL);
+}
+
+/*-----------------------------------------------------------------------------
+ |  Math
+ ----------------------------------------------------------------------------*/
+
+#define check_numeric_type(object, object_type) pl_error_expect((object_type) == PL_CLASS_INT ||                       \
+                                                                (object_type) == PL_CLASS_LONG ||                      \
+                                                                (object_type) == PL_CLASS_DOUBLE,                      \
+                                                                PL_ERROR_INVALID_CLASS,                                \
+                                                                "Object `" #object "` [%s] is not of a numeric type!", \
+                                                                PL_CLASS_NAME[object_type])
+
+// Results of int arithmetic are computed in long. Out of range results are NA.
+static inline int math_int_result(const long wide, const int a, const int b) {
+    const int invalid = (a == PL_INT_NA) | (b == PL_INT_NA) | (wide >= PL_INT_NA) | (wide < INT_MIN);
+    return invalid ? PL_INT_NA : (int) wide;
+}
+
+// Results of long arithmetic are checked for overflow. Overflowed results are NA.
+static inline long math_long_result(const int overflow, const long wide, const long a, const long b) {
+    const int invalid = overflow | (a == PL_LONG_NA) | (b == PL_LONG_NA) | (wide == PL_LONG_NA);
+    return invalid ? PL_LONG_NA : wide;
+}
+
+static inline long math_long_add(const long a, const long b) {
+    long result;
+    const int overflow = __builtin_add_overflow(a, b, &result);
+    return math_long_result(overflow, result, a, b);
+}
+
+static inline long math_long_subtract(const long a, const long b) {
+    long result;
+    const int overflow = __builtin_sub_overflow(a, b, &result);
+    return math_long_result(overflow, result, a, b);
+}
+
+static inline long math_long_multiply(const long a, const long b) {
+    long result;
+    const int overflow = __builtin_mul_overflow(a, b, &result);
+    return math_long_result(overflow, result, a, b);
+}
+
+// Division always produces doubles. NAs of the operands are NAs of the result.
+#define math_divide_item(a, b) ((pl_is_na(a)) | (pl_is_na(b)) ? PL_DOUBLE_NA : (double) (a) / (double) (b))
+
+// Element-wise arithmetic of two arrays, where `a` and `b` are items of x and y.
+// Either x or y may be of length 1. The recycled item is hoisted out of the loop,
+// and the loops are free of branches so they can be vectorized. `name##_chunk` runs the kernel on a chunk.
+#define pl_object_math_kernel(name, type, result_type, expression)                                       \
+    static void name(const type *const x, const long x_length, const type *const y, const long y_length, \
+                     result_type *restrict const result, const long length) {                            \
+        if (x_length == 1 && length > 1) {                                                               \
+            const type a = x[0];                                                                         \
+            for (long i = 0; i < length; i++) {                                                           \
+                const type b = y[i];                                                                     \
+                result[i] = (expression);                                                                \
+            }                                                                                            \
+        } else if (y_length == 1) {                                                                      \
+            const type b = y[0];                                                                         \
+            for (long i = 0; i < length; i++) {                                                           \
+                const type a = x[i];                                                                     \
+                result[i] = (expression);                                                                \
+            }                                                                                            \
+        } else {                                                                                         \
+            for (long i = 0; i < length; i++) {                                                           \
+                const type a = x[i];                                                                     \
+                const type b = y[i];                                                                     \
+                result[i] = (expression);                                                                \
+            }                                                                                            \
+        }                                                                                                \
+    }                                                                                                    \
+                                                                                                         \
+    static void name##_chunk(void *const context, const int chunk, const long start, const long end) {   \
+        (void) chunk;                                                                                    \
+        const parallel_operands *const operands = context;                                               \
+        name(parallel_offset(operands->x, type, operands->x_length, start),                              \
+             operands->x_length == 1 ? 1 : end - start,                                                  \
+             parallel_offset(operands->y, type, operands->y_length, start),                              \
+             operands->y_length == 1 ? 1 : end - start,                                                  \
+             (result_type *) operands->result + start,                                                   \
+             end - start);                                                                               \
+    }
+
+pl_object_math_kernel(math_add_int, int, int, math_int_result((long) a + b, a, b))
+pl_object_math_kernel(math_add_long, long, long, math_long_add(a, b))
+pl_object_math_kernel(math_add_double, double, double, a + b)
+pl_object_math_kernel(math_subtract_int, int, int, math_int_result((long) a - b, a, b))
+pl_object_math_kernel(math_subtract_long, long, long, math_long_subtract(a, b))
+pl_object_math_kernel(math_subtract_double, double, double, a - b)
+pl_object_math_kernel(math_multiply_int, int, int, math_int_result((long) a * b, a, b))
+pl_object_math_kernel(math_multiply_long, long, long, math_long_multiply(a, b))
+pl_object_math_kernel(math_multiply_double, double, double, a * b)
+pl_object_math_kernel(math_divide_int, int, double, math_divide_item(a, b))
+pl_object_math_kernel(math_divide_long, long, double, math_divide_item(a, b))
+pl_object_math_kernel(math_divide_double, double, double, a / b)
+
+// Operators of element-wise arithmetic.
+enum {
+    MATH_ADD,
+    MATH_SUBTRACT,
+    MATH_MULTIPLY,
+    MATH_DIVIDE
+};
+
+// Arithmetic chunks indexed by [operator][operand type].
+static void (*const math_chunks[MATH_DIVIDE + 1][PL_CLASS_DOUBLE + 1])(void *, int, long, long) = {
+        [MATH_ADD]      = {[PL_CLASS_INT]    = math_add_int_chunk,
+                           [PL_CLASS_LONG]   = math_add_long_chunk,
+                           [PL_CLASS_DOUBLE] = math_add_double_chunk},
+        [MATH_SUBTRACT] = {[PL_CLASS_INT]    = math_subtract_int_chunk,
+                           [PL_CLASS_LONG]   = math_subtract_long_chunk,
+                           [PL_CLASS_DOUBLE] = math_subtract_double_chunk},
+        [MATH_MULTIPLY] = {[PL_CLASS_INT]    = math_multiply_int_chunk,
+                           [PL_CLASS_LONG]   = math_multiply_long_chunk,
+                           [PL_CLASS_DOUBLE] = math_multiply_double_chunk},
+        [MATH_DIVIDE]   = {[PL_CLASS_INT]    = math_divide_int_chunk,
+                           [PL_CLASS_LONG]   = math_divide_long_chunk,
+                           [PL_CLASS_DOUBLE] = math_divide_double_chunk}};
+
+// Convert an object to a numeric type. The object is returned as is if it is already of the type.
+static pl_object math_as_type(pl_object x, const int type) {
+    return pl_object_type(x) == type ? x : convert(x, type);
+}
+
+static pl_object math_arithmetic(pl_object x, pl_object y, const int operator) {
+    check_null_pointer(x);
+    check_null_pointer(y);
+
+    // Operands are promoted to the wider type. INT < LONG < DOUBLE.
+    const int x_type = pl_object_type(x);
+    const int y_type = pl_object_type(y);
+    check_numeric_type(x, x_type);
+    check_numeric_type(y, y_type);
+
+    const int type = x_type == PL_CLASS_DOUBLE || y_type == PL_CLASS_DOUBLE ? PL_CLASS_DOUBLE :
+                     x_type == PL_CLASS_LONG || y_type == PL_CLASS_LONG ? PL_CLASS_LONG :
+                     PL_CLASS_INT;
+    x = math_as_type(x, type);
+    y = math_as_type(y, type);
+
+    // The shorter object is recycled.
+    const long length = x->length > y->length ? x->length : y->length;
+    check_incompatible_length(length, x->length < y->length ? x->length : y->length);
+
+    const int result_type = operator == MATH_DIVIDE ? PL_CLASS_DOUBLE : type;
+    pl_object object = primitive_new(result_type, length == 0 ? 1 : length);
+    object->length = length;
+
+    parallel_operands operands = {.x        = x->data,
+                                  .x_length = x->length,
+                                  .y        = y->data,
+                                  .y_length = y->length,
+                                  .result   = object->data};
+    pl_misc_get_ns().parallel_for(length, math_chunks[operator][type], &operands);
+
+    return object;
+}
+
+static pl_object math_add(pl_object x, pl_object y) {
+    return math_arithmetic(x, y, MATH_ADD);
+}
+
+static pl_object math_subtract(pl_object x, pl_object y) {
+    return math_arithmetic(x, y, MATH_SUBTRACT);
+}
+
+static pl_object math_multiply(pl_object x, pl_object y) {
+    return math_arithmetic(x, y, MATH_MULTIPLY);
+}
+
+static pl_object math_divide(pl_object x, pl_object y) {
+    return math_arithmetic(x, y, MATH_DIVIDE);
+}
+
+// Number of items summed by the accumulators before the halves are summed pairwise.
+#define MATH_PAIRWISE_BLOCK 128
+
+// Pairwise summation with eight accumulators. The error grows with the log of the length.
+static double math_pairwise_sum(const double *const x, const long length) {
+    if (length <= MATH_PAIRWISE_BLOCK) {
+        double accumulator[8] = {0.0};
+        int i = 0;
+        for (; i + 8 <= length; i += 8) {
+            pl_misc_for_j(8) accumulator[j] += x[i + j];
+        }
+        double result = ((accumulator[0] + accumulator[1]) + (accumulator[2] + accumulator[3])) +
+                        ((accumulator[4] + accumulator[5]) + (accumulator[6] + accumulator[7]));
+        for (; i < length; i++)
+            result += x[i];
+        return result;
+    }
+
+    // Split at a multiple of 8 to keep the accumulators aligned.
+    const long half = (length / 2) & ~7;
+    return math_pairwise_sum(x, half) + math_pairwise_sum(x + half, length - half);
+}
+
+// Sum of ints in long. Sets `na` if any item is NA.
+static long math_int_sum(const int *const x, const long length, int *const na) {
+    long result = 0;
+    int has_na = 0;
+    pl_misc_for_i(length) {
+        has_na |= x[i] == PL_INT_NA;
+        result += x[i];
+    }
+    *na = has_na;
+    return result;
+}
+
+// Sum of longs. Sets `na` if any item is NA or the sum overflows.
+static long math_long_sum(const long *const x, const long length, int *const na) {
+    long result = 0;
+    int invalid = 0;
+    pl_misc_for_i(length) {
+        invalid |= __builtin_add_overflow(result, x[i], &result) | (x[i] == PL_LONG_NA);
+    }
+    *na = invalid | (result == PL_LONG_NA);
+    return result;
+}
+
+static pl_object math_sum(pl_object x) {
+    check_null_pointer(x);
+    const int type = pl_object_type(x);
+    check_numeric_type(x, type);
+
+    int na = 0;
+    switch (type) {
         case PL_CLASS_INT: {
-            int *const y_data_array = y->data;
-            int *const x_data_array = x->data;
-            pl_misc_for_i(x->length) {
-                if (y->length > 1) {
-                    object_data_array[i] =
-                            pl_is_na(x_data_array[i]) || pl_is_na(y_data_array[i]) ? PL_INT_NA : x_data_array[i] ==
-                                                                                                 y_data_array[i];
-                } else {
-                    object_data_array[i] =
-                            pl_is_na(x_data_array[i]) || pl_is_na(y_data_array[i]) ? PL_INT_NA : x_data_array[i] ==
-                                                                                                 y_data_array[0];
-                }
-            }
-            break;
+            // Sums of ints can't overflow a long.
+            long result = math_int_sum(x->data, x->length, &na);
+            result = na ? PL_LONG_NA : result;
+            return primitive_new_from_array(PL_CLASS_LONG, 1, &result);
         }
         case PL_CLASS_LONG: {
-            long *const y_data_array = y->data;
-            long *const x_data_array = x->data;
-            pl_misc_for_i(x->length) {
-                if (y->length > 1) {
-                    object_data_array[i] =
-                            pl_is_na(x_data_array[i]) || pl_is_na(y_data_array[i]) ? PL_INT_NA : x_data_array[i] ==
-                                                                                                 y_data_array[i];
-                } else {
-                    object_data_array[i] =
-                            pl_is_na(x_data_array[i]) || pl_is_na(y_data_array[i]) ? PL_INT_NA : x_data_array[i] ==
-                                                                                                 y_data_array[0];
-                }
-            }
-            break;
+            long result = math_long_sum(x->data, x->length, &na);
+            result = na ? PL_LONG_NA : result;
+            return primitive_new_from_array(PL_CLASS_LONG, 1, &result);
         }
-        case PL_CLASS_DOUBLE: {
-            double *const y_data_array = y->data;
-            double *const x_data_array = x->data;
-            pl_misc_for_i(x->length) {
-                if (y->length > 1) {
-                    object_data_array[i] =
-                            pl_is_na(x_data_array[i]) || pl_is_na(y_data_array[i]) ? PL_INT_NA : x_data_array[i] ==
-                                                                                                 y_data_array[i];
-                } else {
-                    object_data_array[i] =
-                            pl_is_na(x_data_array[i]) || pl_is_na(y_data_array[i]) ? PL_INT_NA : x_data_array[i] ==
-                                                                                                 y_data_array[0];
-                }
-            }
-            break;
+        default: {
+            // NAs propagate through the sum.
+            double result = math_pairwise_sum(x->data, x->length);
+            return primitive_new_from_array(PL_CLASS_DOUBLE, 1, &result);
         }
-        case PL_CLASS_LIST: {
-            pl_object *const y_data_array = y->data;
-            pl_object *const x_data_array = x->data;
-            pl_misc_for_i(x->length) {
-                if (y->length > 1) {
-                    object_data_array[i] =
-                            pl_is_na(x_data_array[i]) || pl_is_na(y_data_array[i]) ? PL_INT_NA : x_data_array[i] ==
-                                                                                                 y_data_array[i];
-                } else {
-                    object_data_array[i] =
-                            pl_is_na(x_data_array[i]) || pl_is_na(y_data_array[i]) ? PL_INT_NA : x_data_array[i] ==
-                                                                                                 y_data_array[0];
-                }
+    }
+}
+
+static pl_object math_mean(pl_object x) {
+    check_null_pointer(x);
+    const int type = pl_object_type(x);
+    check_numeric_type(x, type);
+
+    double result = PL_DOUBLE_NA;
+    if (x->length > 0) {
+        int na = 0;
+        switch (type) {
+            case PL_CLASS_INT: {
+                const long sum = math_int_sum(x->data, x->length, &na);
+                result = na ? PL_DOUBLE_NA : (double) sum / (double) x->length;
+                break;
             }
-            break;
-        }
-        case PL_CLASS_EXTERNAL: {
-            void **const y_data_array = y->data;
-            void **const x_data_array = x->data;
-            pl_misc_for_i(x->length) {
-                if (y->length > 1) {
-                    object_data_array[i] =
-                            pl_is_na(x_data_array[i]) || pl_is_na(y_data_array[i]) ? PL_INT_NA : x_data_array[i] ==
-                                                                                                 y_data_array[i];
-                } else {
-                    object_data_array[i] =
-                            pl_is_na(x_data_array[i]) || pl_is_na(y_data_array[i]) ? PL_INT_NA : x_data_array[i] ==
-                                                                                                 y_data_array[0];
-                }
+            case PL_CLASS_LONG: {
+                // Longs may overflow, so they are summed as doubles.
+                pl_object converted = as_double(x);
+                result = math_pairwise_sum(converted->data, x->length) / (double) x->length;
+                break;
             }
-            break;
+            default:
+                result = math_pairwise_sum(x->data, x->length) / (double) x->length;
+                break;
         }
     }
 
-    return object;
+    return primitive_new_from_array(PL_CLASS_DOUBLE, 1, &result);
 }
 
-/*-----------------------------------------------------------------------------
- |  In
- ----------------------------------------------------------------------------*/
+// Minimum or maximum of an array. Four accumulators break the dependency chain.
+#define pl_object_extreme_kernel(name, type, better)                                 \
+    static type name(const type *const x, const long length, int *const na) {        \
+        type accumulator[4] = {x[0], x[0], x[0], x[0]};                              \
+        int has_na = 0;                                                              \
+        int i = 0;                                                                   \
+        for (; i + 4 <= length; i += 4) {                                            \
+            pl_misc_for_j(4) {                                                       \
+                const type item = x[i + j];                                          \
+                has_na |= pl_is_na(item);                                            \
+                accumulator[j] = item better accumulator[j] ? item : accumulator[j]; \
+            }                                                                        \
+        }                                                                            \
+        for (; i < length; i++) {                                                    \
+            has_na |= pl_is_na(x[i]);                                                \
+            accumulator[0] = x[i] better accumulator[0] ? x[i] : accumulator[0];     \
+        }                                                                            \
+        pl_misc_for_j(1, 4) {                                                        \
+            accumulator[0] = accumulator[j] better accumulator[0] ?                  \
+                             accumulator[j] : accumulator[0];                        \
+        }                                                                            \
+        *na = has_na;                                                                \
+        return accumulator[0];                                                       \
+    }
 
-static pl_object in(pl_object x, pl_object y) {
+pl_object_extreme_kernel(math_min_int, int, <)
+pl_object_extreme_kernel(math_min_long, long, <)
+pl_object_extreme_kernel(math_min_double, double, <)
+pl_object_extreme_kernel(math_max_int, int, >)
+pl_object_extreme_kernel(math_max_long, long, >)
+pl_object_extreme_kernel(math_max_double, double, >)
+
+static pl_object math_extreme(pl_object x, const int is_max) {
     check_null_pointer(x);
-    check_null_pointer(y);
-    check_same_type(x, y);
+    const int type = pl_object_type(x);
+    check_numeric_type(x, type);
+    pl_error_expect(x->length > 0,
+                    PL_ERROR_INVALID_LENGTH,
+                    "Can not find the extreme of an empty object!");
 
-    // New an object for storing the result.
-    pl_object object = primitive_new(PL_CLASS_INT, x->length == 0 ? 1 : x->length);
-    object->length = x->length;
-    int *const object_data_array = object->data;
+    int na = 0;
+    switch (type) {
+        case PL_CLASS_INT: {
+            int result = is_max ? math_max_int(x->data, x->length, &na) : math_min_int(x->data, x->length, &na);
+            result = na ? PL_INT_NA : result;
+            return primitive_new_from_array(PL_CLASS_INT, 1, &result);
+        }
+        case PL_CLASS_LONG: {
+            long result = is_max ? math_max_long(x->data, x->length, &na) : math_min_long(x->data, x->length, &na);
+            result = na ? PL_LONG_NA : result;
+            return primitive_new_from_array(PL_CLASS_LONG, 1, &result);
+        }
+        default: {
+            double result = is_max ? math_max_double(x->data, x->length, &na) :
+                            math_min_double(x->data, x->length, &na);
+            result = na ? PL_DOUBLE_NA : result;
+            return primitive_new_from_array(PL_CLASS_DOUBLE, 1, &result);
+        }
+    }
+}
 
-    // Get the underlying type.
-    const int type = pl_class_get_ns().type(y->class);
+static pl_object math_min(pl_object x) {
+    return math_extreme(x, 0);
+}
+
+static pl_object math_max(pl_object x) {
+    return math_extreme(x, 1);
+}
+
+static pl_object math_cumsum(pl_object x) {
+    check_null_pointer(x);
+    const int type = pl_object_type(x);
+    check_numeric_type(x, type);
+
+    pl_object object = primitive_new(type, x->length == 0 ? 1 : x->length);
+    object->length = x->length;
 
+    // Once the running sum is NA, the rest of the results are NA.
     switch (type) {
-        case PL_CLASS_CHAR: {
-            char *const set_data_array = y->data;
-            char *const data_array = x->data;
-            pl_misc_for_i(x->length) {
-                int item_result = 0;
-                pl_misc_for_j(y->length) item_result = item_result ||
-                                                       (data_array[i] == set_data_array[j]);
-                object_data_array[i] = item_result;
-            }
-            break;
-        }
         case PL_CLASS_INT: {
-            int *const set_data_array = y->data;
-            int *const data_array = x->data;
+            const int *const data_array = x->data;
+            int *const dst_array = object->data;
+            int sum = 0;
             pl_misc_for_i(x->length) {
-                int item_result = 0;
-                pl_misc_for_j(y->length) item_result = item_result ||
-                                                       (data_array[i] == set_data_array[j]);
-                object_data_array[i] = item_result;
+                sum = math_int_result((long) sum + data_array[i], sum, data_array[i]);
+                dst_array[i] = sum;
             }
             break;
         }
         case PL_CLASS_LONG: {
-            long *const set_data_array = y->data;
-            long *const data_array = x->data;
+            const long *const data_array = x->data;
+            long *const dst_array = object->data;
+            long sum = 0;
             pl_misc_for_i(x->length) {
-                int item_result = 0;
-                pl_misc_for_j(y->length) item_result = item_result ||
-                                                       (data_array[i] == set_data_array[j]);
-                object_data_array[i] = item_result;
+                sum = math_long_add(sum, data_array[i]);
+                dst_array[i] = sum;
             }
             break;
         }
-        case PL_CLASS_DOUBLE: {
-            double *const set_data_array = y->data;
-            double *const data_array = x->data;
+        default: {
+            const double *const data_array = x->data;
+            double *const dst_array = object->data;
+            double sum = 0.0;
             pl_misc_for_i(x->length) {
-                int item_result = 0;
-                pl_misc_for_j(y->length) item_result = item_result ||
-                                                       (data_array[i] == set_data_array[j]) ||
-                                                       (pl_is_na(data_array[i]) && pl_is_na(set_data_array[i]));
-                object_data_array[i] = item_result;
+                sum += data_array[i];
+                dst_array[i] = sum;
             }
             break;
         }
-        case PL_CLASS_LIST: {
-            pl_object *const set_data_array = y->data;
-            pl_object *const data_array = x->data;
-            pl_misc_for_i(x->length) {
-                int item_result = 0;
-                pl_misc_for_j(y->length) item_result = item_result ||
-                                                       (data_array[i] == set_data_array[j]);
-                object_data_array[i] = item_result;
-            }
-            break;
+    }
+
+    return object;
+}
+
+/*-----------------------------------------------------------------------------
+ |  Group
+ ----------------------------------------------------------------------------*/
+
+static pl_object group(pl_object keys) {
+    check_null_pointer(keys);
+    pl_error_expect(keys->length <= INT_MAX,
+                    PL_ERROR_INVALID_LENGTH,
+                    "Object `keys` has length [%ld] which can't be indexed by [int]!",
+                    keys->length);
+
+    // Get the underlying type.
+    const int type = pl_object_type(keys);
+    check_hashable(keys, type);
+
+    pl_object ids = primitive_new(PL_CLASS_INT, keys->length == 0 ? 1 : keys->length);
+    pl_object first = primitive_new(PL_CLASS_INT, keys->length == 0 ? 1 : keys->length);
+    ids->length = keys->length;
+
+    first->length = group_kernels[type](keys->data, keys->length, ids->data, first->data);
+    if (first->length > 0 && first->length < first->capacity / 2)
+        primitive_shrink(first, first->length);
+
+    pl_object object = primitive_new(PL_CLASS_LIST, 2);
+    primitive_extend_object(object, ids);
+    primitive_extend_object(object, first);
+    return object;
+}
+
+// Check a grouping made by `group`. Group numbers are checked since they index the results,
+// and positions of the first items since they index the grouped items.
+static void check_grouping(pl_object grouping) {
+    check_null_pointer(grouping);
+    check_object_type(grouping, PL_CLASS_LIST);
+    check_object_length(grouping, 2);
+
+    pl_object *const group_items = grouping->data;
+    pl_object ids = group_items[0];
+    pl_object first = group_items[1];
+    check_null_pointer(ids);
+    check_null_pointer(first);
+    check_object_type(ids, PL_CLASS_INT);
+    check_object_type(first, PL_CLASS_INT);
+
+    const int *const id_array = ids->data;
+    pl_misc_for_i(ids->length) {
+        pl_error_expect(id_array[i] >= 0 && id_array[i] < first->length,
+                        PL_ERROR_INDEX_OUT_OF_BOUND,
+                        "Group [%d] out of bound [0, %ld)!",
+                        id_array[i],
+                        first->length);
+    }
+
+    const int *const first_array = first->data;
+    pl_misc_for_i(first->length) {
+        pl_error_expect(first_array[i] >= 0 && first_array[i] < ids->length,
+                        PL_ERROR_INDEX_OUT_OF_BOUND,
+                        "First item [%d] of group [%ld] out of bound [0, %ld)!",
+                        first_array[i],
+                        i,
+                        ids->length);
+    }
+}
+
+/*-----------------------------------------------------------------------------
+ |  Group aggregates
+ ----------------------------------------------------------------------------*/
+
+// Aggregate the items of each group in one pass. `init` is the initial value of the
+// accumulator of group `g`, and `combine` updates the accumulator `a` with an item `b`.
+// The first item of every group exists, so it can be the initial value. Sums start from zero
+// instead, so they don't use `first`.
+#define pl_object_group_kernel(name, type, result_type, init, combine)                                       \
+    static void name(const void *const x_data, const int *const ids, const int *const first,                \
+                     const long length, const long num_groups, void *const result_data) {                   \
+        const type *const x_array = x_data;                                                                 \
+        result_type *const result = result_data;                                                            \
+        (void) first;                                                                                       \
+        for (long g = 0; g < num_groups; g++)                                                               \
+            result[g] = (init);                                                                             \
+        for (long i = 0; i < length; i++) {                                                                 \
+            const result_type a = result[ids[i]];                                                           \
+            const type b = x_array[i];                                                                      \
+            result[ids[i]] = (combine);                                                                     \
+        }                                                                                                   \
+    }
+
+// Once an accumulator is NA, it stays NA.
+#define group_extreme(a, b, na, better) (pl_is_na(a) || pl_is_na(b) ? (na) : ((b) better (a) ? (b) : (a)))
+
+// Sums of ints can't overflow a long.
+pl_object_group_kernel(group_sum_int, int, long, 0, pl_is_na(a) || pl_is_na(b) ? PL_LONG_NA : a + b)
+pl_object_group_kernel(group_sum_long, long, long, 0, math_long_add(a, b))
+pl_object_group_kernel(group_sum_double, double, double, 0.0, a + b)
+pl_object_group_kernel(group_min_int, int, int, x_array[first[g]], group_extreme(a, b, PL_INT_NA, <))
+pl_object_group_kernel(group_min_long, long, long, x_array[first[g]], group_extreme(a, b, PL_LONG_NA, <))
+pl_object_group_kernel(group_min_double, double, double, x_array[first[g]], group_extreme(a, b, PL_DOUBLE_NA, <))
+pl_object_group_kernel(group_max_int, int, int, x_array[first[g]], group_extreme(a, b, PL_INT_NA, >))
+pl_object_group_kernel(group_max_long, long, long, x_array[first[g]], group_extreme(a, b, PL_LONG_NA, >))
+pl_object_group_kernel(group_max_double, double, double, x_array[first[g]], group_extreme(a, b, PL_DOUBLE_NA, >))
+
+// Aggregates of the numeric types.
+enum {
+    GROUP_SUM,
+    GROUP_MIN,
+    GROUP_MAX
+};
+
+static void (*const group_kernels_by_aggregate[3][PL_CLASS_DOUBLE + 1])(const void *, const int *, const int *,
+                                                                        long, long, void *) = {
+        [GROUP_SUM] = {[PL_CLASS_INT] = group_sum_int, [PL_CLASS_LONG] = group_sum_long, [PL_CLASS_DOUBLE] = group_sum_double},
+        [GROUP_MIN] = {[PL_CLASS_INT] = group_min_int, [PL_CLASS_LONG] = group_min_long, [PL_CLASS_DOUBLE] = group_min_double},
+        [GROUP_MAX] = {[PL_CLASS_INT] = group_max_int, [PL_CLASS_LONG] = group_max_long, [PL_CLASS_DOUBLE] = group_max_double}};
+
+static pl_object group_aggregate(pl_object x, pl_object grouping, const int aggregate) {
+    check_null_pointer(x);
+    const int type = pl_object_type(x);
+    check_numeric_type(x, type);
+    check_grouping(grouping);
+
+    pl_object *const group_items = grouping->data;
+    pl_object first = group_items[1];
+    pl_error_expect(group_items[0]->length == x->length,
+                    PL_ERROR_INVALID_LENGTH,
+                    "Object `grouping` groups [%ld] items instead of [%ld]!",
+                    group_items[0]->length,
+                    x->length);
+
+    // Sums of ints are longs.
+    const int result_type = aggregate == GROUP_SUM && type == PL_CLASS_INT ? PL_CLASS_LONG : type;
+    pl_object object = primitive_new(result_type, first->length == 0 ? 1 : first->length);
+    object->length = first->length;
+
+    group_kernels_by_aggregate[aggregate][type](x->data, group_items[0]->data, first->data,
+                                                x->length, first->length, object->data);
+    return object;
+}
+
+static pl_object group_sum(pl_object x, pl_object grouping) {
+    return group_aggregate(x, grouping, GROUP_SUM);
+}
+
+static pl_object group_min(pl_object x, pl_object grouping) {
+    return group_aggregate(x, grouping, GROUP_MIN);
+}
+
+static pl_object group_max(pl_object x, pl_object grouping) {
+    return group_aggregate(x, grouping, GROUP_MAX);
+}
+
+static pl_object group_count(pl_object grouping) {
+    check_grouping(grouping);
+    pl_object *const group_items = grouping->data;
+
+    const long num_groups = group_items[1]->length;
+    pl_object object = primitive_new(PL_CLASS_INT, num_groups == 0 ? 1 : num_groups);
+    object->length = num_groups;
+
+    const int *const ids = group_items[0]->data;
+    int *const counts = object->data;
+    memset(counts, 0, (size_t) num_groups * sizeof(int));
+    pl_misc_for_i(group_items[0]->length) counts[ids[i]]++;
+    return object;
+}
+
+/*-----------------------------------------------------------------------------
+ |  String
+ ----------------------------------------------------------------------------*/
+
+// Bytes taken by an item in a byte buffer, including the null terminator.
+#define string_item_bytes(item) (pl_is_na((item).length) || (item).length == 0 ? 0 : (item).length + 1)
+
+// New a string of `length` items, with a byte buffer of `capacity` bytes if `capacity` is positive.
+static pl_object string_new(const long length, const long capacity) {
+    pl_object object = primitive_new(PL_CLASS_STRING, length == 0 ? 1 : length);
+    object->length = length;
+    if (capacity > 0) {
+        pl_object bytes = primitive_new(PL_CLASS_CHAR, capacity);
+        pl_object_string_bytes(object->data) = bytes;
+        pl_gc_write_barrier(object, bytes);
+    }
+    return object;
+}
+
+static pl_object string_from_list(pl_object x) {
+    check_null_pointer(x);
+    check_object_type(x, PL_CLASS_LIST);
+
+    const pl_object *const data_array = x->data;
+    long capacity = 0;
+    pl_misc_for_i(x->length) {
+        if (data_array[i] != NULL) {
+            check_object_type(data_array[i], PL_CLASS_CHAR);
+            capacity += data_array[i]->length == 0 ? 0 : data_array[i]->length + 1;
         }
-        case PL_CLASS_EXTERNAL: {
-            void **const set_data_array = y->data;
-            void **const data_array = x->data;
-            pl_misc_for_i(x->length) {
-                int item_result = 0;
-                pl_misc_for_j(y->length) item_result = item_result ||
-                                                       (data_array[i] == set_data_array[j]);
-                object_data_array[i] = item_result;
-            }
-            break;
+    }
+
+    pl_object object = string_new(x->length, capacity);
+    pl_object_string_item *const items = pl_object_string_items(object->data);
+    pl_misc_for_i(x->length) {
+        if (data_array[i] == NULL)
+            items[i] = string_na_item;
+        else if (data_array[i]->length == 0)
+            items[i] = (pl_object_string_item) {.offset = 0, .length = 0};
+        else
+            items[i] = (pl_object_string_item) {.offset = string_append_bytes(object, data_array[i]->data, data_array[i]->length),
+                                                .length = data_array[i]->length};
+    }
+    return object;
+}
+
+static pl_object string_to_list(pl_object x) {
+    check_null_pointer(x);
+    check_object_type(x, PL_CLASS_STRING);
+
+    pl_object object = primitive_new(PL_CLASS_LIST, x->length == 0 ? 1 : x->length);
+    pl_misc_for_i(x->length) {
+        const long length = pl_object_string_items(x->data)[i].length;
+        if (pl_is_na(length)) {
+            primitive_extend_object(object, NULL);
+            continue;
         }
+        pl_object item = primitive_new(PL_CLASS_CHAR, length + 1);
+        memcpy(item->data, pl_object_string_get(x->data, i), (size_t) length + 1);
+        item->length = length;
+        primitive_extend_object(object, item);
     }
-
     return object;
 }
 
-/*-----------------------------------------------------------------------------
- |  Set decimals
- ----------------------------------------------------------------------------*/
+static pl_object string_compact(pl_object x) {
+    check_null_pointer(x);
+    check_object_type(x, PL_CLASS_STRING);
 
-static void print_set_decimals(pl_object x) {
+    const pl_object_string_item *const src_array = pl_object_string_items(x->data);
+    long capacity = 0;
+    pl_misc_for_i(x->length) capacity += string_item_bytes(src_array[i]);
+
+    pl_object object = string_new(x->length, capacity);
+    pl_object_string_item *const data_array = pl_object_string_items(object->data);
+    pl_misc_for_i(x->length) {
+        data_array[i] = src_array[i];
+        if (string_item_bytes(src_array[i]) > 0)
+            data_array[i].offset = string_append_bytes(object, pl_object_string_get(x->data, i), src_array[i].length);
+    }
+    return object;
+}
+
+// The bytes of every group are written once, at the first item of the group.
+static pl_object string_intern(pl_object x) {
     check_null_pointer(x);
-    check_object_type(x, PL_CLASS_INT);
-    check_object_length(x, 1);
+    check_object_type(x, PL_CLASS_STRING);
+    pl_error_expect(x->length <= INT_MAX,
+                    PL_ERROR_INVALID_LENGTH,
+                    "Object `x` has length [%ld] which can't be indexed by [int]!",
+                    x->length);
+
+    pl_object ids = primitive_new(PL_CLASS_INT, x->length == 0 ? 1 : x->length);
+    pl_object first = primitive_new(PL_CLASS_INT, x->length == 0 ? 1 : x->length);
+    const long num_groups = hash_string_group(x->data, x->length, ids->data, first->data);
+    const int *const id_array = ids->data;
+    const int *const first_array = first->data;
+
+    const pl_object_string_item *const src_array = pl_object_string_items(x->data);
+    long capacity = 0;
+    pl_misc_for_i(num_groups) capacity += string_item_bytes(src_array[first_array[i]]);
+
+    pl_object object = string_new(x->length, capacity);
+    pl_object offsets = primitive_new(PL_CLASS_LONG, num_groups == 0 ? 1 : num_groups);
+    long *const offset_array = offsets->data;
+    pl_misc_for_i(num_groups) {
+        const long item = first_array[i];
+        offset_array[i] = string_item_bytes(src_array[item]) == 0
+                                  ? 0
+                                  : string_append_bytes(object, pl_object_string_get(x->data, item), src_array[item].length);
+    }
 
-    const int num_decimals = ((int *) x->data)[0];
-    if (num_decimals >= 0) {
-        pl_object_print_num_decimals = num_decimals;
+    pl_object_string_item *const data_array = pl_object_string_items(object->data);
+    pl_misc_for_i(x->length) {
+        data_array[i] = src_array[i];
+        if (string_item_bytes(src_array[i]) > 0)
+            data_array[i].offset = offset_array[id_array[i]];
     }
+    return object;
 }
 
 /*-----------------------------------------------------------------------------
- |  Print
+ |  Lazy
  ----------------------------------------------------------------------------*/
 
-static void print(pl_object x) {
-    check_null_pointer(x);
+// A lazy object is a list of a spec and one or two operands. The spec is a long object
+// of [LAZY_MAGIC, operation, result type, result length].
+#define LAZY_MAGIC 0x6c617a79706c6f62L
+#define lazy_spec(x) ((const long *) ((pl_object *) (x)->data)[0]->data)
 
-    if (x->length == 0) {
-        puts("[]");
-        return;
-    }
+// Operations of lazy objects. Arithmetic operations are the math operators.
+enum {
+    LAZY_EQUAL = MATH_DIVIDE + 1,
+    LAZY_CONVERT
+};
 
-    const pl_class_ns class_ns = pl_class_get_ns();
-    const int type = class_ns.type(x->class);
+// Items evaluated at a time. A multiple of PL_OBJECT_BOOL_BLOCK, so Booleans start on a block.
+#define LAZY_BLOCK 1024
 
-    putchar('[');
+// Distinct operations of an expression, which also bounds its depth.
+#define LAZY_MAX_STEPS 64
 
-    switch (type) {
-        case PL_CLASS_CHAR: {
-            const char *data_array = x->data;
-            pl_misc_for_i(x->length - 1) {
-                if (pl_is_na(data_array[i]))
-                    printf("NA, ");
-                else
-                    printf("'%c', ", data_array[i]);
-            }
-            if (pl_is_na(data_array[x->length - 1]))
-                printf("NA");
-            else
-                printf("'%c'", data_array[x->length - 1]);
-            break;
-        }
-        case PL_CLASS_INT: {
-            const int *data_array = x->data;
-            pl_misc_for_i(x->length - 1) {
-                if (pl_is_na(data_array[i]))
-                    printf("NA, ");
-                else
-                    printf("%d, ", data_array[i]);
-            }
-            if (pl_is_na(data_array[x->length - 1]))
-                printf("NA");
-            else
-                printf("%d", data_array[x->length - 1]);
-            break;
-        }
-        case PL_CLASS_LONG: {
-            const long *data_array = x->data;
-            pl_misc_for_i(x->length - 1) {
-                if (pl_is_na(data_array[i]))
-                    printf("NA, ");
-                else
-                    printf("%ldL, ", data_array[i]);
-            }
-            if (pl_is_na(data_array[x->length - 1]))
-                printf("NA");
-            else
-                printf("%ldL", data_array[x->length - 1]);
-            break;
-        }
-        case PL_CLASS_DOUBLE: {
-            const double *data_array = x->data;
-            char format[100] = "";
-            char end_format[100] = "";
-            sprintf(format, "%%.%df, ", pl_object_print_num_decimals);
-            sprintf(end_format, "%%.%df", pl_object_print_num_decimals);
+static int lazy_is(pl_object x) {
+    check_null_pointer(x);
+    if (x->class != PL_CLASS_LIST || (x->length != 2 && x->length != 3))
+        return 0;
+    pl_object spec = ((pl_object *) x->data)[0];
+    return spec != NULL && spec->class == PL_CLASS_LONG && spec->length == 4 &&
+           ((long *) spec->data)[0] == LAZY_MAGIC;
+}
 
-            pl_misc_for_i(x->length - 1) {
-                if (pl_is_na(data_array[i]))
-                    printf("NA, ");
-                else
-                    printf(format, data_array[i]);
-            }
-            if (pl_is_na(data_array[x->length - 1]))
-                printf("NA");
-            else
-                printf(end_format, data_array[x->length - 1]);
-            break;
-        }
-        case PL_CLASS_LIST: {
-            const pl_object *data_array = x->data;
-            pl_misc_for_i(x->length - 1) {
-                if (pl_is_na(data_array[i]))
-                    printf("NA, ");
-                else
-                    printf("<%s>, ", PL_CLASS_NAME[data_array[i]->class]);
-            }
-            if (pl_is_na(data_array[x->length - 1]))
-                printf("NA");
-            else
-                printf("<%s>", PL_CLASS_NAME[data_array[x->length - 1]->class]);
-            break;
-        }
-        case PL_CLASS_EXTERNAL: {
-            const pl_object *data_array = x->data;
-            pl_misc_for_i(x->length - 1) {
-                if (pl_is_na(data_array[i]))
-                    printf("NA, ");
-                else
-                    printf("<EXTERNAL>, ");
-            }
-            if (pl_is_na(data_array[x->length - 1]))
-                printf("NA");
-            else
-                printf("<EXTERNAL>");
-            break;
-        }
+// Get the result type and length of an object or a lazy object.
+static int lazy_type(pl_object x, long *const length) {
+    if (lazy_is(x)) {
+        *length = lazy_spec(x)[3];
+        return (int) lazy_spec(x)[2];
     }
 
-    puts("]");
+    const int type = pl_object_type(x);
+    pl_error_expect(type != PL_CLASS_LIST && type != PL_CLASS_EXTERNAL && type != PL_CLASS_STRING,
+                    PL_ERROR_INVALID_CLASS,
+                    "Object `x` [%s] can't be evaluated lazily!",
+                    PL_CLASS_NAME[type]);
+    *length = x->length;
+    return type;
 }
 
-/*-----------------------------------------------------------------------------
- |  As char
- ----------------------------------------------------------------------------*/
+static pl_object lazy_new(const int operation, const int type, const long length, pl_object x, pl_object y) {
+    pl_object spec = primitive_new(PL_CLASS_LONG, 4);
+    long *const spec_array = spec->data;
+    spec_array[0] = LAZY_MAGIC;
+    spec_array[1] = operation;
+    spec_array[2] = type;
+    spec_array[3] = length;
+    spec->length = 4;
+
+    pl_object object = primitive_new(PL_CLASS_LIST, 3);
+    primitive_extend_object(object, spec);
+    primitive_extend_object(object, x);
+    if (y != NULL)
+        primitive_extend_object(object, y);
+    return object;
+}
 
-static pl_object as_char(pl_object x) {
+// Same checks as `convert_source_type`.
+static pl_object lazy_convert(pl_object x, const int target) {
     check_null_pointer(x);
+    long length;
+    const int type = lazy_type(x, &length);
+    pl_error_expect(type == target || convert_kernels[type][target] != NULL,
+                    PL_ERROR_INVALID_CLASS,
+                    "Can not convert a [%s] object to a [%s] object!",
+                    PL_CLASS_NAME[type],
+                    PL_CLASS_NAME[target]);
+    return type == target ? x : lazy_new(LAZY_CONVERT, target, length, x, NULL);
+}
 
-    const int type = pl_class_get_ns().type(x->class);
+static pl_object lazy_as_char(pl_object x) {
+    return lazy_convert(x, PL_CLASS_CHAR);
+}
 
-    pl_object object = primitive_new(PL_CLASS_CHAR, x->length);
-    object->length = x->length;
+static pl_object lazy_as_int(pl_object x) {
+    return lazy_convert(x, PL_CLASS_INT);
+}
 
-    switch (type) {
-        case PL_CLASS_CHAR: {
-            char *const data_array = x->data;
-            char *const dst_array = object->data;
-            pl_misc_for_i(x->length) dst_array[i] = data_array[i];
-            break;
-        }
-        case PL_CLASS_INT: {
-            int *const data_array = x->data;
-            char *const dst_array = object->data;
-            pl_misc_for_i(x->length) dst_array[i] = pl_is_na(data_array[i]) ||
-                                                    data_array[i] < CHAR_MIN ||
-                                                    data_array[i] > CHAR_MAX ?
-                                                    PL_CHAR_NA :
-                                                    (char) data_array[i];
-            break;
-        }
-        case PL_CLASS_LONG: {
-            long *const data_array = x->data;
-            char *const dst_array = object->data;
-            pl_misc_for_i(x->length) dst_array[i] = pl_is_na(data_array[i]) ||
-                                                    data_array[i] < CHAR_MIN ||
-                                                    data_array[i] > CHAR_MAX ?
-                                                    PL_CHAR_NA :
-                                                    (char) data_array[i];
-            break;
-        }
-        case PL_CLASS_DOUBLE: {
-            double *const data_array = x->data;
-            char *const dst_array = object->data;
-            pl_misc_for_i(x->length) dst_array[i] = pl_is_na(data_array[i]) ||
-                                                    data_array[i] < CHAR_MIN ||
-                                                    data_array[i] > CHAR_MAX ?
-                                                    PL_CHAR_NA :
-                                                    (char) data_array[i];
-            break;
-        }
-        default: {
-            pl_error_throw(PL_ERROR_INVALID_CLASS,
-                           "Can not convert a [%s] object to a [%s] object!",
-                           PL_CLASS_NAME[x->class],
-                           PL_CLASS_NAME[PL_CLASS_CHAR]);
-            break;
-        }
-    }
+static pl_object lazy_as_long(pl_object x) {
+    return lazy_convert(x, PL_CLASS_LONG);
+}
 
-    return object;
+static pl_object lazy_as_double(pl_object x) {
+    return lazy_convert(x, PL_CLASS_DOUBLE);
 }
 
-/*-----------------------------------------------------------------------------
- |  As int
- ----------------------------------------------------------------------------*/
+static pl_object lazy_as_bool(pl_object x) {
+    return lazy_convert(x, PL_CLASS_BOOL);
+}
 
-static pl_object as_int(pl_object x) {
+// Same checks as `equal_to`.
+static pl_object lazy_equal(pl_object x, pl_object y) {
     check_null_pointer(x);
+    check_null_pointer(y);
 
-    const pl_class_ns class_ns = pl_class_get_ns();
-    const int type = class_ns.type(x->class);
+    long x_length, y_length;
+    const int x_type = lazy_type(x, &x_length);
+    const int y_type = lazy_type(y, &y_length);
+    pl_error_expect(x_type == y_type,
+                    PL_ERROR_INVALID_CLASS,
+                    "Object `x` [%s] is not of the same type as object `y` [%s]!",
+                    PL_CLASS_NAME[x_type],
+                    PL_CLASS_NAME[y_type]);
+
+    const long length = x_length > y_length ? x_length : y_length;
+    check_incompatible_length(length, x_length < y_length ? x_length : y_length);
+    return lazy_new(LAZY_EQUAL, PL_CLASS_BOOL, length, x, y);
+}
 
-    pl_object object = primitive_new(PL_CLASS_INT, x->length);
-    object->length = x->length;
+// Same checks and promotions as `math_arithmetic`.
+static pl_object lazy_arithmetic(pl_object x, pl_object y, const int operator) {
+    check_null_pointer(x);
+    check_null_pointer(y);
 
-    switch (type) {
-        case PL_CLASS_CHAR: {
-            char *const data_array = x->data;
-            int *const dst_array = object->data;
-            pl_misc_for_i(x->length) dst_array[i] = pl_is_na(data_array[i]) ? PL_INT_NA : (int) data_array[i];
-            break;
-        }
-        case PL_CLASS_INT: {
-            int *const data_array = x->data;
-            int *const dst_array = object->data;
-            pl_misc_for_i(x->length) dst_array[i] = data_array[i];
-            break;
-        }
-        case PL_CLASS_LONG: {
-            long *const data_array = x->data;
-            int *const dst_array = object->data;
-            pl_misc_for_i(x->length) dst_array[i] = pl_is_na(data_array[i]) ||
-                                                    data_array[i] < INT_MIN ||
-                                                    data_array[i] > INT_MAX ?
-                                                    PL_INT_NA :
-                                                    (int) data_array[i];
-            break;
-        }
-        case PL_CLASS_DOUBLE: {
-            double *const data_array = x->data;
-            int *const dst_array = object->data;
-            pl_misc_for_i(x->length) dst_array[i] = pl_is_na(data_array[i]) ||
-                                                    data_array[i] < INT_MIN ||
-                                                    data_array[i] > INT_MAX ?
-                                                    PL_INT_NA :
-                                                    (int) data_array[i];
-            break;
-        }
-        default: {
-            pl_error_throw(PL_ERROR_INVALID_CLASS,
-                           "Can not convert a [%s] object to a [%s] object!",
-                           PL_CLASS_NAME[x->class],
-                           PL_CLASS_NAME[PL_CLASS_INT]);
-            break;
-        }
-    }
+    long x_length, y_length;
+    const int x_type = lazy_type(x, &x_length);
+    const int y_type = lazy_type(y, &y_length);
+    check_numeric_type(x, x_type);
+    check_numeric_type(y, y_type);
 
-    return object;
+    const int type = x_type == PL_CLASS_DOUBLE || y_type == PL_CLASS_DOUBLE ? PL_CLASS_DOUBLE :
+                     x_type == PL_CLASS_LONG || y_type == PL_CLASS_LONG ? PL_CLASS_LONG :
+                     PL_CLASS_INT;
+
+    const long length = x_length > y_length ? x_length : y_length;
+    check_incompatible_length(length, x_length < y_length ? x_length : y_length);
+
+    x = lazy_convert(x, type);
+    y = lazy_convert(y, type);
+    return lazy_new(operator, operator == MATH_DIVIDE ? PL_CLASS_DOUBLE : type, length, x, y);
 }
 
-/*-----------------------------------------------------------------------------
- |  As long
- ----------------------------------------------------------------------------*/
+static pl_object lazy_add(pl_object x, pl_object y) {
+    return lazy_arithmetic(x, y, MATH_ADD);
+}
 
-static pl_object as_long(pl_object x) {
-    check_null_pointer(x);
+static pl_object lazy_subtract(pl_object x, pl_object y) {
+    return lazy_arithmetic(x, y, MATH_SUBTRACT);
+}
+
+static pl_object lazy_multiply(pl_object x, pl_object y) {
+    return lazy_arithmetic(x, y, MATH_MULTIPLY);
+}
 
-    const pl_class_ns class_ns = pl_class_get_ns();
-    const int type = class_ns.type(x->class);
+static pl_object lazy_divide(pl_object x, pl_object y) {
+    return lazy_arithmetic(x, y, MATH_DIVIDE);
+}
 
-    pl_object object = primitive_new(PL_CLASS_LONG, x->length);
-    object->length = x->length;
+// An operation of an expression. An operand is either the data of an object, or the
+// block computed by an earlier step at `scratch` bytes into the scratch of a chunk.
+typedef struct lazy_step {
+    int operation;
+    int type;
+    long length;
+    int num_operands;
+    int operand_type[2];
+    long operand_length[2];
+    const void *operand_data[2];
+    size_t operand_scratch[2];
+    size_t scratch;
+} lazy_step;
+
+// Steps of an expression in post-order, so the root is the last step. Each chunk of
+// `parallel_for` evaluates its blocks of `block` items in its own `scratch_size` bytes of `scratch`.
+// With a mask, the root is compressed into `result` from the chunk offsets of the mask, over the
+// `num_chunks` chunks the mask was counted by. Without a mask, `num_chunks` is 0 and picked when run.
+typedef struct lazy_plan {
+    pl_object nodes[LAZY_MAX_STEPS];
+    lazy_step steps[LAZY_MAX_STEPS];
+    int num_steps;
+    long block;
+    size_t scratch_size;
+    char *scratch;
+    void *result;
+    const uint64_t *mask;
+    const long *offsets;
+    int num_chunks;
+} lazy_plan;
+
+// Items of the blocks of a lazy object. Short objects are evaluated in one block.
+static long lazy_block(pl_object x) {
+    const long length = bool_num_blocks(lazy_spec(x)[3]) * PL_OBJECT_BOOL_BLOCK;
+    return length < LAZY_BLOCK ? (length == 0 ? PL_OBJECT_BOOL_BLOCK : length) : LAZY_BLOCK;
+}
 
-    switch (type) {
-        case PL_CLASS_CHAR: {
-            char *const data_array = x->data;
-            long *const dst_array = object->data;
-            pl_misc_for_i(x->length) dst_array[i] = pl_is_na(data_array[i]) ? PL_LONG_NA : (long) data_array[i];
-            break;
-        }
-        case PL_CLASS_INT: {
-            int *const data_array = x->data;
-            long *const dst_array = object->data;
-            pl_misc_for_i(x->length) dst_array[i] = pl_is_na(data_array[i]) ? PL_LONG_NA : (long) data_array[i];
-            break;
+// Add the steps of a lazy object to a plan. Returns the index of its step.
+// Operations shared by several operands get one step.
+static int lazy_add_steps(lazy_plan *const plan, pl_object x, pl_object dst, const int depth) {
+    for (int i = 0; i < plan->num_steps; i++) {
+        if (plan->nodes[i] == x)
+            return i;
+    }
+    pl_error_expect(depth < LAZY_MAX_STEPS && plan->num_steps < LAZY_MAX_STEPS,
+                    PL_ERROR_INVALID_ARGUMENT,
+                    "Lazy object has more than [%d] operations!",
+                    LAZY_MAX_STEPS);
+
+    const long *const spec = lazy_spec(x);
+    lazy_step step = {.operation    = (int) spec[1],
+                      .type         = (int) spec[2],
+                      .length       = spec[3],
+                      .num_operands = (int) x->length - 1};
+    pl_misc_for_i(step.num_operands) {
+        pl_object operand = ((pl_object *) x->data)[i + 1];
+        if (lazy_is(operand)) {
+            const lazy_step *const operand_step = plan->steps + lazy_add_steps(plan, operand, dst, depth + 1);
+            step.operand_type[i] = operand_step->type;
+            step.operand_length[i] = operand_step->length;
+            step.operand_scratch[i] = operand_step->scratch;
+        } else {
+            pl_error_expect(operand != dst,
+                            PL_ERROR_INVALID_ARGUMENT,
+                            "The destination can't be an operand!");
+            step.operand_type[i] = pl_object_type(operand);
+            step.operand_length[i] = operand->length;
+            step.operand_data[i] = operand->data;
         }
-        case PL_CLASS_LONG: {
-            long *const data_array = x->data;
-            long *const dst_array = object->data;
-            pl_misc_for_i(x->length) dst_array[i] = data_array[i];
+    }
+
+    step.scratch = plan->scratch_size;
+    plan->scratch_size += pl_object_data_size(step.type, plan->block);
+    plan->nodes[plan->num_steps] = x;
+    plan->steps[plan->num_steps] = step;
+    return plan->num_steps++;
+}
+
+// An operand of a step for the block starting at `first`, where recycled operands stay at their item.
+static const void *lazy_operand(const lazy_step *const step, const int i, const char *const scratch, const long first) {
+    if (step->operand_data[i] == NULL)
+        return scratch + step->operand_scratch[i];
+    if (step->operand_length[i] == 1)
+        return step->operand_data[i];
+    return (const char *) step->operand_data[i] + pl_object_data_size(step->operand_type[i], first);
+}
+
+// Evaluate a step for `length` items into `result`, with the kernels of the eager functions.
+static void lazy_run_step(const lazy_step *const step, const char *const scratch, const long first, long length,
+                          void *const result) {
+    if (step->length == 1)
+        length = 1;
+
+    parallel_operands operands = {.x        = lazy_operand(step, 0, scratch, first),
+                                  .x_length = step->operand_length[0] == 1 ? 1 : length,
+                                  .result   = result};
+    if (step->num_operands == 2) {
+        operands.y = lazy_operand(step, 1, scratch, first);
+        operands.y_length = step->operand_length[1] == 1 ? 1 : length;
+    }
+
+    switch (step->operation) {
+        case LAZY_CONVERT:
+            convert_kernels[step->operand_type[0]][step->type](operands.x, result, length);
             break;
-        }
-        case PL_CLASS_DOUBLE: {
-            double *const data_array = x->data;
-            long *const dst_array = object->data;
-            pl_misc_for_i(x->length) dst_array[i] = pl_is_na(data_array[i]) ||
-                                                    data_array[i] < LONG_MIN ||
-                                                    data_array[i] > LONG_MAX ?
-                                                    PL_LONG_NA :
-                                                    (long) data_array[i];
+        case LAZY_EQUAL:
+            // Make sure x is longer
+            if (operands.x_length < operands.y_length) {
+                const void *const tmp = operands.x;
+                operands.x = operands.y;
+                operands.y = tmp;
+                operands.x_length = length;
+                operands.y_length = 1;
+            }
+            equal_chunks[step->operand_type[0]](&operands, 0, 0, bool_num_blocks(length));
             break;
-        }
-        default: {
-            pl_error_throw(PL_ERROR_INVALID_CLASS,
-                           "Can not convert a [%s] object to a [%s] object!",
-                           PL_CLASS_NAME[x->class],
-                           PL_CLASS_NAME[PL_CLASS_LONG]);
+        default:
+            math_chunks[step->operation][step->operand_type[0]](&operands, 0, 0, length);
             break;
+    }
+}
+
+// Evaluate the blocks of a chunk of Boolean blocks.
+static void lazy_chunk(void *const context, const int chunk, const long start, const long end) {
+    const lazy_plan *const plan = context;
+    const lazy_step *const root = plan->steps + plan->num_steps - 1;
+    char *const scratch = plan->scratch + (size_t) chunk * plan->scratch_size;
+    const long last = end * PL_OBJECT_BOOL_BLOCK < root->length ? end * PL_OBJECT_BOOL_BLOCK : root->length;
+    long count = plan->mask == NULL ? 0 : plan->offsets[chunk];
+
+    for (long first = start * PL_OBJECT_BOOL_BLOCK; first < last; first += plan->block) {
+        const long length = last - first < plan->block ? last - first : plan->block;
+        for (int i = 0; i < plan->num_steps - 1; i++)
+            lazy_run_step(plan->steps + i, scratch, first, length, scratch + plan->steps[i].scratch);
+
+        if (plan->mask == NULL) {
+            lazy_run_step(root, scratch, first, length, (char *) plan->result + pl_object_data_size(root->type, first));
+            continue;
         }
+
+        // Compress the block of the root by the block of the mask.
+        lazy_run_step(root, scratch, first, length, scratch + root->scratch);
+        const uint64_t *const mask = plan->mask + 2 * (first / PL_OBJECT_BOOL_BLOCK);
+        parallel_operands operands = {.x        = scratch + root->scratch,
+                                      .x_length = length,
+                                      .y        = mask,
+                                      .result   = plan->result,
+                                      .offsets  = &count};
+        const long num_blocks = bool_num_blocks(length);
+        if (root->type == PL_CLASS_BOOL)
+            mask_scatter_bool(&operands, 0, 0, num_blocks);
+        else
+            mask_scatter_chunks[root->type](&operands, 0, 0, num_blocks);
+        for (long block = 0; block < num_blocks; block++)
+            count += __builtin_popcountll(mask[2 * block] & bool_block_mask(length, block));
+    }
+}
+
+// Evaluate a plan into `result`. Booleans are compressed by one chunk, since neighbouring
+// items share a block.
+static void lazy_run(lazy_plan *const plan, void *const result) {
+    const pl_misc_ns misc_ns = pl_misc_get_ns();
+    const lazy_step *const root = plan->steps + plan->num_steps - 1;
+    const long num_blocks = bool_num_blocks(root->length);
+    const int sequential = plan->mask != NULL && root->type == PL_CLASS_BOOL;
+    const int num_chunks = num_blocks == 0 || sequential ? 1
+                           : plan->num_chunks != 0   ? plan->num_chunks
+                                                     : misc_ns.parallel_chunks(num_blocks);
+
+    // The scratch is an object, so it is released by the garbage collector.
+    pl_object scratch = primitive_new(PL_CLASS_CHAR, (long) (plan->scratch_size * (size_t) num_chunks));
+    plan->scratch = scratch->data;
+    plan->result = result;
+    if (sequential)
+        lazy_chunk(plan, 0, 0, num_blocks);
+    else
+        misc_ns.parallel_for_chunks(num_blocks, num_chunks, lazy_chunk, plan);
+}
+
+// The result is written into `dst`, or into a new object if `dst` is NULL.
+static pl_object lazy_force_to(pl_object dst, pl_object x) {
+    check_null_pointer(x);
+    if (!lazy_is(x)) {
+        if (dst == NULL)
+            return x;
+
+        pl_object object = prepare_destination(dst, x->class, x->length, x, NULL);
+        move_items(pl_object_type(x), object->data, 0, x->data, 0, x->length);
+        if (pl_object_type(x) == PL_CLASS_STRING)
+            share_bytes(object, x);
+        finish_destination(dst, object);
+        return object;
     }
 
+    lazy_plan plan = {.block = lazy_block(x)};
+    lazy_add_steps(&plan, x, dst, 0);
+    const lazy_step *const root = plan.steps + plan.num_steps - 1;
+    pl_object object = prepare_destination(dst, root->type, root->length, x, NULL);
+    lazy_run(&plan, object->data);
     return object;
 }
 
+static pl_object lazy_force(pl_object x) {
+    return lazy_force_to(NULL, x);
+}
+
+static void lazy_force_into(pl_object dst, pl_object x) {
+    check_null_pointer(dst);
+    lazy_force_to(dst, x);
+}
+
+static pl_object lazy_subset(pl_object x, pl_object mask) {
+    check_null_pointer(x);
+    check_null_pointer(mask);
+    long mask_length;
+    const int mask_type = lazy_type(mask, &mask_length);
+    pl_error_expect(mask_type == PL_CLASS_BOOL,
+                    PL_ERROR_INVALID_CLASS,
+                    "Object `mask` [%s] is not of type [%s]!",
+                    PL_CLASS_NAME[mask_type],
+                    PL_CLASS_NAME[PL_CLASS_BOOL]);
+    if (!lazy_is(x))
+        return subset_by_mask_to(NULL, x, lazy_force(mask));
+
+    lazy_plan plan = {.block = lazy_block(x)};
+    lazy_add_steps(&plan, x, NULL, 0);
+    const lazy_step *const root = plan.steps + plan.num_steps - 1;
+    pl_error_expect(mask_length == root->length,
+                    PL_ERROR_INVALID_LENGTH,
+                    "Object `mask` has length [%ld] instead of [%ld]!",
+                    mask_length,
+                    root->length);
+
+    // The chunks of the mask are the chunks of the evaluation.
+    pl_object forced = lazy_force(mask);
+    const long num_blocks = bool_num_blocks(mask_length);
+    const int num_chunks = num_blocks == 0 ? 1 : pl_misc_get_ns().parallel_chunks(num_blocks);
+    long offsets[PL_MISC_MAX_THREADS * 4 + 1] = {0};
+    const long count = mask_count(forced, forced, num_chunks, offsets);
+    pl_object object = prepare_destination(NULL, root->type, count, NULL, NULL);
+    plan.mask = forced->data;
+    plan.offsets = offsets;
+    plan.num_chunks = num_chunks;
+    lazy_run(&plan, object->data);
+    return object;
+}
 
 /*-----------------------------------------------------------------------------
- |  As double
+ |  Attribute
  ----------------------------------------------------------------------------*/
 
-static pl_object as_double(pl_object x) {
-    check_null_pointer(x);
+// The attribute field is a list of the attribute names, the attribute values
+// and, for objects with many attributes, a slot table indexing the names.
+#define ATTRIBUTE_NAMES_POSITION 0
+#define ATTRIBUTE_VALUES_POSITION 1
+#define ATTRIBUTE_SLOTS_POSITION 2
 
-    const pl_class_ns class_ns = pl_class_get_ns();
-    const int type = class_ns.type(x->class);
+// Objects with at most this many attributes are searched linearly.
+#define ATTRIBUTE_INLINE_CAPACITY 4
 
-    pl_object object = primitive_new(PL_CLASS_DOUBLE, x->length);
-    object->length = x->length;
+#define attribute_names_of(x) (((pl_object *) (x)->attribute->data)[ATTRIBUTE_NAMES_POSITION])
+#define attribute_values_of(x) (((pl_object *) (x)->attribute->data)[ATTRIBUTE_VALUES_POSITION])
+#define attribute_slots_of(x) (((pl_object *) (x)->attribute->data)[ATTRIBUTE_SLOTS_POSITION])
+#define attribute_is_hashed(x) ((x)->attribute->length > ATTRIBUTE_SLOTS_POSITION)
 
-    switch (type) {
-        case PL_CLASS_CHAR: {
-            char *const data_array = x->data;
-            double *const dst_array = object->data;
-            pl_misc_for_i(x->length) dst_array[i] = pl_is_na(data_array[i]) ? PL_DOUBLE_NA : (double) data_array[i];
-            break;
-        }
-        case PL_CLASS_INT: {
-            int *const data_array = x->data;
-            double *const dst_array = object->data;
-            pl_misc_for_i(x->length) dst_array[i] = pl_is_na(data_array[i]) ? PL_DOUBLE_NA : (double) data_array[i];
-            break;
-        }
-        case PL_CLASS_LONG: {
-            long *const data_array = x->data;
-            double *const dst_array = object->data;
-            pl_misc_for_i(x->length) dst_array[i] = pl_is_na(data_array[i]) ? PL_DOUBLE_NA : (double) data_array[i];
-            break;
-        }
-        case PL_CLASS_DOUBLE: {
-            double *const data_array = x->data;
-            double *const dst_array = object->data;
-            pl_misc_for_i(x->length) dst_array[i] = data_array[i];
-            break;
-        }
-        default: {
-            pl_error_throw(PL_ERROR_INVALID_CLASS,
-                           "Can not convert a [%s] object to a [%s] object!",
-                           PL_CLASS_NAME[x->class],
-                           PL_CLASS_NAME[PL_CLASS_DOUBLE]);
-            break;
-        }
+// Symbols are unique, so they are hashed by address.
+static unsigned long attribute_hash(const pl_object symbol) {
+    const unsigned long mixed = ((unsigned long) (uintptr_t) symbol >> 4) * 0xFF51AFD7ED558CCDUL;
+    return mixed ^ (mixed >> 29);
+}
+
+// Rebuild the slot table of the attribute names. Each slot holds an index of the names, or -1 if empty.
+// The table is dropped first, so if the rebuild fails, lookups fall back to the linear search.
+static void attribute_rehash(pl_object x) {
+    x->attribute->length = ATTRIBUTE_SLOTS_POSITION;
+
+    const pl_object attribute_names = attribute_names_of(x);
+    if (attribute_names->length <= ATTRIBUTE_INLINE_CAPACITY)
+        return;
+
+    // Keep the load factor at most one half after a rebuild.
+    int size = 16;
+    while (size < attribute_names->length * 2)
+        size *= 2;
+
+    pl_object slots = primitive_new(PL_CLASS_INT, size);
+    slots->length = size;
+    int *const slot_array = slots->data;
+    memset(slot_array, 0xFF, pl_object_data_size(PL_CLASS_INT, size));
+
+    const pl_object *const name_array = attribute_names->data;
+    const unsigned long mask = (unsigned long) size - 1;
+    pl_misc_for_i(attribute_names->length) {
+        unsigned long slot = attribute_hash(name_array[i]) & mask;
+        while (slot_array[slot] != -1)
+            slot = (slot + 1) & mask;
+        slot_array[slot] = (int) i;
     }
 
-    return object;
+    append(x->attribute, slots);
 }
 
-/*-----------------------------------------------------------------------------
- |  Attribute
- ----------------------------------------------------------------------------*/
+// Index a newly appended attribute name. The table is rebuilt beyond a load factor of 3/4.
+static void attribute_index_last(pl_object x) {
+    const pl_object attribute_names = attribute_names_of(x);
+    if (attribute_names->length <= ATTRIBUTE_INLINE_CAPACITY)
+        return;
+
+    if (!attribute_is_hashed(x) || attribute_names->length * 4 > attribute_slots_of(x)->length * 3) {
+        attribute_rehash(x);
+        return;
+    }
+
+    const pl_object slots = attribute_slots_of(x);
+    int *const slot_array = slots->data;
+    const unsigned long mask = (unsigned long) slots->length - 1;
+    const int index = (int) attribute_names->length - 1;
+    unsigned long slot = attribute_hash(((pl_object *) attribute_names->data)[index]) & mask;
+    while (slot_array[slot] != -1)
+        slot = (slot + 1) & mask;
+    slot_array[slot] = index;
+}
 
 // Returns the index of the matched attribute name. -1 for not found.
 static int primitive_index_attribute(pl_object x, pl_object name) {
@@ -1568,31 +4496,31 @@ static int primitive_index_attribute(pl_object x, pl_object name) {
     if (x->attribute == NULL)
         return -1;
 
-    char *const input_array = name->data;
-
-    // There are two objects stored in the attribute
-    // The first one is a list of attribute names
-    // The second one is a list of attribute values
-    pl_object name_array = ((pl_object *) x->attribute->data)[0]->data;
-    const int num_name = ((pl_object *) x->attribute->data)[0]->length;
+    // Attribute names are symbols, so a name that has never been interned can't be an attribute name.
+    const pl_object symbol = pl_symbol_get_ns().lookup_object(name);
+    if (symbol == NULL)
+        return -1;
 
-    pl_misc_for_i(num_name) {
-        // Check if the length of the attribute name
-        // matches with the length of the given name
-        if (name_array[i].length == name->length) {
-            char *const this_name = name_array[i].data;
-            int flag = 0;
+    const pl_object attribute_names = attribute_names_of(x);
+    pl_object *const name_array = attribute_names->data;
 
-            // Compare the matched length name character by character
-            pl_misc_for_j(name->length) {
-                flag = flag && this_name[j] == input_array[j];
-            }
-            if (flag == 1)
-                return i;
+    // Symbols are unique, so names are compared by address.
+    if (!attribute_is_hashed(x)) {
+        pl_misc_for_i(attribute_names->length) {
+            if (name_array[i] == symbol)
+                return (int) i;
         }
+        return -1;
     }
 
-    return -1;
+    const pl_object slots = attribute_slots_of(x);
+    const int *const slot_array = slots->data;
+    const unsigned long mask = (unsigned long) slots->length - 1;
+    for (unsigned long slot = attribute_hash(symbol) & mask;; slot = (slot + 1) & mask) {
+        const int index = slot_array[slot];
+        if (index == -1 || name_array[index] == symbol)
+            return index;
+    }
 }
 
 static pl_object has_attribute(pl_object x, pl_object name) {
@@ -1600,17 +4528,23 @@ static pl_object has_attribute(pl_object x, pl_object name) {
     return primitive_new_from_array(PL_CLASS_INT, 1, &result);
 }
 
+static void has_attribute_into(pl_object dst, pl_object x, pl_object name) {
+    check_null_pointer(dst);
+    const int result = primitive_index_attribute(x, name) != -1;
+    pl_object object = prepare_destination(dst, PL_CLASS_INT, 1, x, name);
+    ((int *) object->data)[0] = result;
+}
+
 static pl_object get_attribute(pl_object x, pl_object name) {
     const int index = primitive_index_attribute(x, name);
     if (index == -1) {
         char name_null[128] = "";
-        memcpy(name_null, name->data, 128);
+        memcpy(name_null, name->data, (size_t) (name->length < 127 ? name->length : 127));
         pl_error_throw(PL_ERROR_ATTRIBUTE_NOT_FOUND,
                        "Can not find attribute [%s]!",
                        name_null);
     }
-    pl_object attributes = ((pl_object *) x->attribute->data)[1];
-    return extract(attributes, primitive_new_from_array(PL_CLASS_INT, 1, &index));
+    return ((pl_object *) attribute_values_of(x)->data)[index];
 }
 
 static void set_attribute(pl_object x, pl_object name, pl_object item) {
@@ -1618,51 +4552,84 @@ static void set_attribute(pl_object x, pl_object name, pl_object item) {
 
     // If the attribute name is not found.
     if (index == -1) {
+        // Attribute names are stored as symbols.
+        name = pl_symbol_get_ns().intern_object(name);
+
         // If the attribute field is empty, init it.
         if (x->attribute == NULL) {
-            x->attribute = primitive_new(PL_CLASS_LIST, 2);
+            x->attribute = primitive_new(PL_CLASS_LIST, 3);
             pl_object attribute_names = primitive_new(PL_CLASS_LIST, 1);
             pl_object attributes = primitive_new(PL_CLASS_LIST, 1);
-            ((pl_object *) x->attribute->data)[0] = attribute_names;
-            ((pl_object *) x->attribute->data)[1] = attributes;
+            ((pl_object *) x->attribute->data)[ATTRIBUTE_NAMES_POSITION] = attribute_names;
+            ((pl_object *) x->attribute->data)[ATTRIBUTE_VALUES_POSITION] = attributes;
             x->attribute->length = 2;
+            pl_gc_write_barrier(x, x->attribute);
         }
 
-        pl_object attribute_names = ((pl_object *) x->attribute->data)[0];
-        pl_object attributes = ((pl_object *) x->attribute->data)[1];
-        pl_error_try {
-                    // Append the name to the attribute names
-                    append(attribute_names, name);
-
-                    // Append the item to the attributes
-                    append(attributes, item);
-                } pl_error_catch {
-            // If failed, removed the appended item.
-            if (attribute_names->length != attributes->length) {
-                const int smaller_length = attribute_names->length > attributes->length ?
-                                           attributes->length :
-                                           attribute_names->length;
-                attribute_names->length = smaller_length;
-                attributes->length = smaller_length;
-            }
-
-            pl_error_rethrow();
-        }
+        pl_object attribute_names = attribute_names_of(x);
+        pl_object attributes = attribute_values_of(x);
+
+        // Everything that may fail happens before the lists are modified,
+        // so the names and the values always have the same length.
+        check_null_pointer(item);
+        primitive_reserve(attribute_names, attribute_names->length + 1);
+        primitive_reserve(attributes, attributes->length + 1);
+        prepare_write(attribute_names);
+        prepare_write(attributes);
+        ((pl_object *) attribute_names->data)[attribute_names->length++] = name;
+        ((pl_object *) attributes->data)[attributes->length++] = item;
+        pl_gc_write_barrier(attribute_names, name);
+        pl_gc_write_barrier(attributes, item);
+
+        attribute_index_last(x);
     } else {
         // Replace the item with the provided item
-        pl_object attributes = ((pl_object *) x->attribute->data)[1];
-        ((pl_object *) attributes)[index] = item;
+        primitive_set_object(attribute_values_of(x), index, item);
     }
 }
 
 static void remove_attribute(pl_object x, pl_object name) {
     const int index = primitive_index_attribute(x, name);
     if (index != -1) {
-        pl_object attribute_names = ((pl_object *) x->attribute->data)[0];
-        pl_object attributes = ((pl_object *) x->attribute->data)[1];
-        primitive_remove(attribute_names, index, index);
-        primitive_remove(attributes, index, index);
+        primitive_remove(attribute_names_of(x), index, index);
+        primitive_remove(attribute_values_of(x), index, index);
+
+        // Removal shifts the indices, so the slot table is rebuilt.
+        if (attribute_is_hashed(x))
+            attribute_rehash(x);
+    }
+}
+
+// Names of an attribute copied from another heap are not symbols of this thread,
+// and the slot table hashes the addresses of the old symbols.
+static void rebuild_attribute(pl_object x) {
+    check_null_pointer(x);
+    if (x->attribute == NULL)
+        return;
+
+    check_object_type(x->attribute, PL_CLASS_LIST);
+    pl_error_expect(x->attribute->length >= ATTRIBUTE_SLOTS_POSITION,
+                    PL_ERROR_INVALID_ARGUMENT,
+                    "Malformed attribute of length [%ld]!",
+                    x->attribute->length);
+    const pl_object attribute_names = attribute_names_of(x);
+    const pl_object attributes = attribute_values_of(x);
+    check_null_pointer(attribute_names);
+    check_null_pointer(attributes);
+    check_object_type(attribute_names, PL_CLASS_LIST);
+    check_object_type(attributes, PL_CLASS_LIST);
+    check_object_length(attributes, attribute_names->length);
+
+    prepare_write(attribute_names);
+    const pl_symbol_ns symbol_ns = pl_symbol_get_ns();
+    pl_object *const name_array = attribute_names->data;
+    pl_misc_for_i(attribute_names->length) {
+        check_null_pointer(name_array[i]);
+        name_array[i] = symbol_ns.intern_object(name_array[i]);
     }
+    pl_gc_write_barrier(attribute_names, NULL);
+
+    attribute_rehash(x);
 }
 
 
@@ -1670,6 +4637,12 @@ static void remove_attribute(pl_object x, pl_object name) {
  |  Get object namespace
  ----------------------------------------------------------------------------*/
 
+static void test(void) {
+    printf("In file: %s\n", __FILE__);
+    pl_unittest_print_summary(test_sort());
+    pl_unittest_print_summary(test_subset());
+}
+
 pl_object_ns pl_object_get_ns(void) {
     static const pl_object_ns object_ns = {
             .primitive = {
@@ -1685,6 +4658,8 @@ pl_object_ns pl_object_get_ns(void) {
                     .set_double        = primitive_set_double,
                     .set_object        = primitive_set_object,
                     .set_external      = primitive_set_external,
+                    .set_bool          = primitive_set_bool,
+                    .set_string        = primitive_set_string,
                     .set_by_indices    = primitive_set_by_indices,
                     .set_range         = primitive_set_range,
                     .set_by_bool       = primitive_set_by_bool,
@@ -1694,17 +4669,24 @@ pl_object_ns pl_object_get_ns(void) {
                     .extract_double    = primitive_extract_double,
                     .extract_object    = primitive_extract_object,
                     .extract_external  = primitive_extract_external,
+                    .extract_bool      = primitive_extract_bool,
+                    .extract_string    = primitive_extract_string,
                     .extend_char       = primitive_extend_char,
                     .extend_int        = primitive_extend_int,
                     .extend_long       = primitive_extend_long,
                     .extend_double     = primitive_extend_double,
                     .extend_object     = primitive_extend_object,
                     .extend_external   = primitive_extend_external,
-                    .subset            = primitive_subset,
-                    .subset_exclude    = primitive_subset_exclude,
-                    .subset_by_bool    = primitive_subset_by_bool,
-                    .remove            = primitive_remove,
-                    .remove_by_indices = primitive_remove_by_indices},
+                    .extend_bool       = primitive_extend_bool,
+                    .extend_string     = primitive_extend_string,
+                    .subset              = primitive_subset,
+                    .subset_into         = primitive_subset_into,
+                    .subset_exclude      = primitive_subset_exclude,
+                    .subset_exclude_into = primitive_subset_exclude_into,
+                    .subset_by_bool      = primitive_subset_by_bool,
+                    .subset_by_bool_into = primitive_subset_by_bool_into,
+                    .remove              = primitive_remove,
+                    .remove_by_indices   = primitive_remove_by_indices},
             .new            = new,
             .reserve        = reserve,
             .set            = set,
@@ -1713,21 +4695,84 @@ pl_object_ns pl_object_get_ns(void) {
             .extract        = extract,
             .extend         = extend,
             .subset         = subset,
+            .subset_into    = subset_into,
             .subset_exclude = subset_exclude,
+            .subset_exclude_into = subset_exclude_into,
             .copy           = copy,
             .equal          = equal,
+            .equal_into     = equal_into,
             .in             = in,
+            .in_into        = in_into,
+            .match          = match,
+            .match_into     = match_into,
+            .unique         = unique,
+            .unique_into    = unique_into,
+            .sort           = sort,
+            .sort_into      = sort_into,
+            .order          = order,
+            .order_into     = order_into,
+            .group          = group,
+            .group_count    = group_count,
+            .group_sum      = group_sum,
+            .group_min      = group_min,
+            .group_max      = group_max,
             .print_set_decimals = print_set_decimals,
+            .print_set_max_items = print_set_max_items,
             .print          = print,
+            .print_to       = print_to,
+            .format         = format,
+            .format_into    = format_into,
             .as_char        = as_char,
             .as_int         = as_int,
             .as_long        = as_long,
             .as_double      = as_double,
+            .as_bool        = as_bool,
+            .as_char_into   = as_char_into,
+            .as_int_into    = as_int_into,
+            .as_long_into   = as_long_into,
+            .as_double_into = as_double_into,
+            .as_bool_into   = as_bool_into,
             .attribute = {
-                    .has    = has_attribute,
-                    .get    = get_attribute,
-                    .set    = set_attribute,
-                    .remove = remove_attribute}};
+                    .has      = has_attribute,
+                    .has_into = has_attribute_into,
+                    .get      = get_attribute,
+                    .set      = set_attribute,
+                    .remove   = remove_attribute,
+                    .rebuild  = rebuild_attribute},
+            .math = {
+                    .add      = math_add,
+                    .subtract = math_subtract,
+                    .multiply = math_multiply,
+                    .divide   = math_divide,
+                    .sum      = math_sum,
+                    .mean     = math_mean,
+                    .min      = math_min,
+                    .max      = math_max,
+                    .cumsum   = math_cumsum},
+            .string = {
+                    .from_list = string_from_list,
+                    .to_list   = string_to_list,
+                    .compact   = string_compact,
+                    .intern    = string_intern},
+            .lazy = {
+                    .is         = lazy_is,
+                    .as_char    = lazy_as_char,
+                    .as_int     = lazy_as_int,
+                    .as_long    = lazy_as_long,
+                    .as_double  = lazy_as_double,
+                    .as_bool    = lazy_as_bool,
+                    .equal      = lazy_equal,
+                    .add        = lazy_add,
+                    .subtract   = lazy_subtract,
+                    .multiply   = lazy_multiply,
+                    .divide     = lazy_divide,
+                    .force      = lazy_force,
+                    .force_into = lazy_force_into,
+                    .subset     = lazy_subset},
+#ifdef PL_TEST
+            .test = test,
+#endif//PL_TEST
+    };
 
     return object_ns;
 }
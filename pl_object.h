@@ -10,6 +10,8 @@
 #include "pl_class.h"
 #include "pl_error.h"
 #include "pl_misc.h"
+#include "stdint.h"
+#include "stdio.h"
 
 /*-----------------------------------------------------------------------------
  |  Object definition
@@ -20,28 +22,120 @@ typedef struct pl_object_struct pl_object_struct;
 
 /// An object.
 /// @param class (int). Class of the object.
-/// @param capacity (int). Capacity of the object.
-/// @param length (int). Length of the object.
-/// @param placeholder (int). A reserved space for future use.
+/// @param flags (int). Bit flags maintained by the garbage collector.
+/// @param capacity (long). Capacity of the object.
+/// @param length (long). Length of the object.
 /// @param attribute (pl_object). Additional attributes.
 /// @param data (void *). A data container.
+/// @param buffer (void *). The buffer holding the data if it is shared with other objects, otherwise NULL.
+/// Shared data must be detached before it is written directly.
+/// @param site (int). Allocation site of the object, only with PL_GC_PROFILE.
 typedef pl_object_struct *pl_object;
 struct pl_object_struct {
     const int class;
-    int capacity;
-    int length;
-    int placeholder;
+    int flags;
+    long capacity;
+    long length;
     pl_object attribute;
     void *data;
+    void *buffer;
+#ifdef PL_GC_PROFILE
+    int site;
+#endif
 };
 
+/*-----------------------------------------------------------------------------
+ |  Object flags
+ ----------------------------------------------------------------------------*/
+
+/// The object has been marked reachable in the current collection.
+#define PL_OBJECT_FLAG_MARK (1 << 0)
+
+/// The object is recorded by the garbage collector.
+#define PL_OBJECT_FLAG_TRACKED (1 << 1)
+
+/// The object has been promoted to the old generation.
+#define PL_OBJECT_FLAG_OLD (1 << 2)
+
+/// The object is in the remembered set of the garbage collector.
+#define PL_OBJECT_FLAG_REMEMBERED (1 << 3)
+
+/// Position of the number of collections survived in the nursery.
+#define PL_OBJECT_AGE_SHIFT 4
+
+/// Mask of the number of collections survived in the nursery.
+#define PL_OBJECT_AGE_MASK (0xF << PL_OBJECT_AGE_SHIFT)
+
+/// Maximum number of collections survived in the nursery.
+#define PL_OBJECT_MAX_AGE 15
+
+/// Position of the size class of the memory block holding the header.
+#define PL_OBJECT_BLOCK_SHIFT 8
+
+/// Mask of the size class of the memory block holding the header.
+#define PL_OBJECT_BLOCK_MASK (0xF << PL_OBJECT_BLOCK_SHIFT)
+
+/// The data is stored in the same memory block as the header.
+#define PL_OBJECT_FLAG_INLINE (1 << 12)
+
+/// The data is stored in a bump arena of an arena frame.
+#define PL_OBJECT_FLAG_ARENA_DATA (1 << 13)
+
+/// The object is the interned symbol of a name. Symbols are unique and are never collected.
+#define PL_OBJECT_FLAG_SYMBOL (1 << 14)
+
+/// Position of the depth of the arena frame owning the object. Zero for objects owned by the garbage collector.
+#define PL_OBJECT_ARENA_SHIFT 16
+
+/// Mask of the depth of the arena frame owning the object.
+#define PL_OBJECT_ARENA_MASK (0xFF << PL_OBJECT_ARENA_SHIFT)
+
+/// Number of collections survived in the nursery.
+#define pl_object_age(x) (((x)->flags & PL_OBJECT_AGE_MASK) >> PL_OBJECT_AGE_SHIFT)
+
+/// Depth of the arena frame owning the object.
+#define pl_object_arena_depth(x) (((x)->flags & PL_OBJECT_ARENA_MASK) >> PL_OBJECT_ARENA_SHIFT)
+
 
 /*-----------------------------------------------------------------------------
  |  Size of the object
  ----------------------------------------------------------------------------*/
 
+/// Number of items in a block of a PL_CLASS_BOOL object.
+/// @details The data of a PL_CLASS_BOOL object is a sequence of blocks. A block is a word of
+/// values followed by a word of NA flags, and bit `i % 64` of block `i / 64` holds item `i`.
+/// The value bit of an NA is zero. Growing the object only appends blocks.
+#define PL_OBJECT_BOOL_BLOCK 64
+
+/// Size of the data of a PL_CLASS_BOOL object.
+#define pl_object_bool_data_size(capacity) \
+    ((((size_t) (capacity)) + PL_OBJECT_BOOL_BLOCK - 1) / PL_OBJECT_BOOL_BLOCK * 2 * sizeof(uint64_t))
+
+/// An item of a PL_CLASS_STRING object.
+/// @details The data of a PL_CLASS_STRING object is the pointer to its byte buffer, a PL_CLASS_CHAR
+/// object or NULL, followed by its items. The bytes of an item are followed by a null terminator.
+/// Byte buffers are only appended to, so strings built from the items of another string share its
+/// buffer. Empty strings and NAs have no bytes.
+/// @param offset (long). Offset of the bytes in the byte buffer.
+/// @param length (long). Number of bytes. PL_LONG_NA for NA.
+typedef struct pl_object_string_item {
+    long offset;
+    long length;
+} pl_object_string_item;
+
+/// Size of the data of a PL_CLASS_STRING object.
+#define pl_object_string_data_size(capacity) \
+    (sizeof(pl_object) + ((size_t) (capacity)) * sizeof(pl_object_string_item))
+
 /// Size of the data.
-#define pl_object_data_size(class, capacity) (((size_t) (capacity)) * PL_CLASS_ELEMENT_SIZE[class])
+#define pl_object_data_size(class, capacity) ((class) == PL_CLASS_BOOL     ? pl_object_bool_data_size(capacity)   \
+                                              : (class) == PL_CLASS_STRING ? pl_object_string_data_size(capacity) \
+                                                                           : ((size_t) (capacity)) * PL_CLASS_ELEMENT_SIZE[class])
+
+/// Underlying type of an object.
+/// @details A lookup of PL_CLASS_TYPE without the range check of `pl_class_ns.type`, since
+/// the class of an object is checked when the object is created or imported.
+#define pl_object_type(x) (PL_CLASS_TYPE[(x)->class])
 
 /// Expected size of an object
 #define pl_object_expected_size(class, capacity) (sizeof(pl_object_struct) + pl_object_data_size(class, capacity))
@@ -53,7 +147,8 @@ struct pl_object_struct {
  |  Capacity and NA definition
  ----------------------------------------------------------------------------*/
 
-#define PL_OBJECT_MAX_CAPACITY (2 << (sizeof(int) * 7))
+/// Maximum capacity of an object. The data size of any class stays far below `SIZE_MAX`.
+#define PL_OBJECT_MAX_CAPACITY (1L << 48)
 
 #define PL_CHAR_NA 0
 #define PL_INT_NA INT_MAX
@@ -61,15 +156,88 @@ struct pl_object_struct {
 #define PL_DOUBLE_NA ((double) NAN)
 #define PL_LIST_NA NULL
 #define PL_EXTERNAL_NA NULL
+#define PL_BOOL_NA PL_INT_NA
+
+/// NA tests of each type. Use `pl_is_na`, which only calls the test of the type of its argument,
+/// so no comparison is made across types.
+static inline int pl_is_na_char(const char x) {
+    return x == PL_CHAR_NA;
+}
+
+static inline int pl_is_na_int(const int x) {
+    return x == PL_INT_NA;
+}
+
+static inline int pl_is_na_long(const long x) {
+    return x == PL_LONG_NA;
+}
+
+static inline int pl_is_na_double(const double x) {
+    return x != x;
+}
+
+static inline int pl_is_na_pointer(const void *const x) {
+    return x == 0;
+}
+
+#define pl_is_na(x) _Generic(x, char                          \
+                             : pl_is_na_char, int             \
+                             : pl_is_na_int, long             \
+                             : pl_is_na_long, double          \
+                             : pl_is_na_double, pl_object     \
+                             : pl_is_na_pointer, void *       \
+                             : pl_is_na_pointer, const void * \
+                             : pl_is_na_pointer)(x)
+
+/// Get a Boolean from the data of a PL_CLASS_BOOL object.
+/// @param data (const void *). The data.
+/// @param index (long). The index.
+/// @return 0, 1 or PL_BOOL_NA.
+static inline int pl_object_bool_get(const void *const data, const long index) {
+    const uint64_t *const block = (const uint64_t *) data + index / PL_OBJECT_BOOL_BLOCK * 2;
+    const int bit = (int) (index % PL_OBJECT_BOOL_BLOCK);
+    if ((block[1] >> bit) & 1)
+        return PL_BOOL_NA;
+    return (int) ((block[0] >> bit) & 1);
+}
+
+/// Set a Boolean in the data of a PL_CLASS_BOOL object.
+/// @param data (void *). The data.
+/// @param index (long). The index.
+/// @param value (int). PL_BOOL_NA, zero for FALSE, or any other value for TRUE.
+static inline void pl_object_bool_set(void *const data, const long index, const int value) {
+    uint64_t *const block = (uint64_t *) data + index / PL_OBJECT_BOOL_BLOCK * 2;
+    const uint64_t bit = (uint64_t) 1 << (index % PL_OBJECT_BOOL_BLOCK);
+    block[0] = pl_is_na(value) || value == 0 ? block[0] & ~bit : block[0] | bit;
+    block[1] = pl_is_na(value) ? block[1] | bit : block[1] & ~bit;
+}
+
+/// Byte buffer of the data of a PL_CLASS_STRING object.
+#define pl_object_string_bytes(data) (*(pl_object *) (data))
+
+/// Items of the data of a PL_CLASS_STRING object.
+#define pl_object_string_items(data) ((pl_object_string_item *) ((pl_object *) (data) + 1))
+
+/// Get a string from the data of a PL_CLASS_STRING object.
+/// @details The string lives in the byte buffer, so it is only valid until the buffer grows.
+/// @param data (const void *). The data.
+/// @param index (long). The index.
+/// @return A null-terminated string, or NULL for NA.
+static inline const char *pl_object_string_get(const void *const data, const long index) {
+    const pl_object_string_item item = pl_object_string_items(data)[index];
+    if (pl_is_na(item.length))
+        return NULL;
+    if (item.length == 0)
+        return "";
+    return (const char *) pl_object_string_bytes(data)->data + item.offset;
+}
+
+/*-----------------------------------------------------------------------------
+ |  Print
+ ----------------------------------------------------------------------------*/
 
-#define pl_is_na(x) _Generic(x, char                     \
-                             : (x) == PL_CHAR_NA, int    \
-                             : (x) == PL_INT_NA, long    \
-                             : (x) == PL_LONG_NA, double \
-                             : (x) != (x), pl_object     \
-                             : (x) == 0, void *          \
-                             : (x) == 0, const void *    \
-                             : (x) == 0)
+/// Number of decimals that prints doubles with the fewest digits that parse back to the same value.
+#define PL_OBJECT_PRINT_SHORTEST (-1)
 
 /*-----------------------------------------------------------------------------
  |  Shortcuts for object creation
@@ -136,32 +304,43 @@ struct pl_object_struct {
 /// New a char vector.
 /// @param ... Items need to be stored by the object.
 /// @return A new object.
-#define $c_char(...) pl.object.primitive.new_from_array(PL_CLASS_CHAR, pl_misc_count_arg(__VA_ARGS__), (char[pl_misc_count_arg(__VA_ARGS__)]){__VA_ARGS__})
+#define $c_char(...) pl_gc_profile(pl.object.primitive.new_from_array(PL_CLASS_CHAR, pl_misc_count_arg(__VA_ARGS__), (char[pl_misc_count_arg(__VA_ARGS__)]){__VA_ARGS__}))
 
 /// New a int vector.
 /// @param ... Items need to be stored by the object.
 /// @return A new object.
-#define $c_int(...) pl.object.primitive.new_from_array(PL_CLASS_INT, pl_misc_count_arg(__VA_ARGS__), (int[pl_misc_count_arg(__VA_ARGS__)]){__VA_ARGS__})
+#define $c_int(...) pl_gc_profile(pl.object.primitive.new_from_array(PL_CLASS_INT, pl_misc_count_arg(__VA_ARGS__), (int[pl_misc_count_arg(__VA_ARGS__)]){__VA_ARGS__}))
 
 /// New a long vector.
 /// @param ... Items need to be stored by the object.
 /// @return A new object.
-#define $c_long(...) pl.object.primitive.new_from_array(PL_CLASS_LONG, pl_misc_count_arg(__VA_ARGS__), (long[pl_misc_count_arg(__VA_ARGS__)]){__VA_ARGS__})
+#define $c_long(...) pl_gc_profile(pl.object.primitive.new_from_array(PL_CLASS_LONG, pl_misc_count_arg(__VA_ARGS__), (long[pl_misc_count_arg(__VA_ARGS__)]){__VA_ARGS__}))
 
 /// New a double vector.
 /// @param ... Items need to be stored by the object.
 /// @return A new object.
-#define $c_double(...) pl.object.primitive.new_from_array(PL_CLASS_DOUBLE, pl_misc_count_arg(__VA_ARGS__), (double[pl_misc_count_arg(__VA_ARGS__)]){__VA_ARGS__})
+#define $c_double(...) pl_gc_profile(pl.object.primitive.new_from_array(PL_CLASS_DOUBLE, pl_misc_count_arg(__VA_ARGS__), (double[pl_misc_count_arg(__VA_ARGS__)]){__VA_ARGS__}))
+
+/// New a Boolean vector.
+/// @param ... Items need to be stored by the object, as ints. PL_BOOL_NA for NA, zero for FALSE,
+/// and any other value for TRUE.
+/// @return A new object.
+#define $c_bool(...) pl_gc_profile(pl.object.primitive.new_from_variadic(PL_CLASS_BOOL, pl_misc_count_arg(__VA_ARGS__), __VA_ARGS__))
+
+/// New a string vector.
+/// @param ... Items need to be stored by the object, as null-terminated strings. NULL for NA.
+/// @return A new object.
+#define $c_string(...) pl_gc_profile(pl.object.primitive.new_from_array(PL_CLASS_STRING, pl_misc_count_arg(__VA_ARGS__), (const char *[pl_misc_count_arg(__VA_ARGS__)]){__VA_ARGS__}))
 
 /// New a external vector.
 /// @param ... Items need to be stored by the object.
 /// @return A new object.
-#define $c_external(...) pl.object.primitive.new_from_array(PL_CLASS_EXTERNAL, pl_misc_count_arg(__VA_ARGS__), (void *[pl_misc_count_arg(__VA_ARGS__)]){__VA_ARGS__})
+#define $c_external(...) pl_gc_profile(pl.object.primitive.new_from_array(PL_CLASS_EXTERNAL, pl_misc_count_arg(__VA_ARGS__), (void *[pl_misc_count_arg(__VA_ARGS__)]){__VA_ARGS__}))
 
 /// New a list.
 /// @param ... Items need to be stored by the object.
 /// @return A new object.
-#define $list(...) pl.object.primitive.new_from_array(PL_CLASS_LIST, pl_misc_count_arg(__VA_ARGS__), (pl_object[pl_misc_count_arg(__VA_ARGS__)]){__VA_ARGS__})
+#define $list(...) pl_gc_profile(pl.object.primitive.new_from_array(PL_CLASS_LIST, pl_misc_count_arg(__VA_ARGS__), (pl_object[pl_misc_count_arg(__VA_ARGS__)]){__VA_ARGS__}))
 
 #endif//PL_OBJECT_SHORTCUTS
 
@@ -180,33 +359,36 @@ typedef struct pl_object_ns {
 
         /// New an object.
         /// @param class (int). Class of the object.
-        /// @param capacity (int). Capacity of the object.
+        /// @param capacity (long). Capacity of the object.
         /// @return A new empty object.
-        pl_object (*const new)(int class, int capacity);
+        pl_object (*const new)(int class, long capacity);
 
         /// New an object using an array.
         /// @details If `length` is zero, an empty object will be returned. The `array`
-        /// will not be used.
+        /// will not be used. Arrays of PL_CLASS_BOOL objects are blocks as described by
+        /// `PL_OBJECT_BOOL_BLOCK`, and arrays of PL_CLASS_STRING objects are null-terminated
+        /// strings with NULL for NA, here and in all other primitive functions.
         /// @param class (int). Class of the object.
-        /// @param length (int). Length of the object.
+        /// @param length (long). Length of the object.
         /// @param array (const void *). The source array.
         /// @return A new object.
-        pl_object (*const new_from_array)(int class, int length, const void *array);
+        pl_object (*const new_from_array)(int class, long length, const void *array);
 
         /// New an object using variadic arguments.
-        /// @details If `length` is zero, an empty object will be returned.
+        /// @details If `length` is zero, an empty object will be returned. Booleans are
+        /// provided as ints, and strings as `const char *`.
         /// @param class (int). Class of the object.
-        /// @param length (int). Number of items will be provided.
+        /// @param length (long). Number of items will be provided.
         /// @param ... Items need to be stored by the object.
         /// @return A new object.
-        pl_object (*const new_from_variadic)(int class, int length, ...);
+        pl_object (*const new_from_variadic)(int class, long length, ...);
 
         /*-----------------------------------------------------------------------------
          |  Primitive to array
          ----------------------------------------------------------------------------*/
 
         /// Copy an object to an array.
-        /// @details This is a shallow copy.
+        /// @details This is a shallow copy. Strings are only valid until the byte buffer grows.
         /// @param x (pl_object). The object.
         /// @param array (void *). Destination array.
         void (*const to_array)(pl_object x, void *array);
@@ -219,8 +401,8 @@ typedef struct pl_object_ns {
         /// @details The function may reserve more memory than the requested
         /// amount for efficiency.
         /// @param x (pl_object). The object.
-        /// @param capacity (int). New capacity.
-        void (*const reserve)(pl_object x, int capacity);
+        /// @param capacity (long). New capacity.
+        void (*const reserve)(pl_object x, long capacity);
 
         /*-----------------------------------------------------------------------------
          |  Primitive shrink
@@ -229,70 +411,85 @@ typedef struct pl_object_ns {
         /// Shrink an object to a desired capacity.
         /// @details Data may be lost due to the shrink.
         /// @param x (pl_object). The object.
-        /// @param capacity (int). The desired capacity.
-        void (*const shrink)(pl_object x, int capacity);
+        /// @param capacity (long). The desired capacity.
+        void (*const shrink)(pl_object x, long capacity);
 
         /*-----------------------------------------------------------------------------
          |  Primitive set
          ----------------------------------------------------------------------------*/
 
         /// Set value for an object.
-        /// @details If `index` is NA, the value will not be set.
+        /// @details If `index` is NA (PL_LONG_NA), the value will not be set.
         /// @param x (pl_object). An object of type PL_CLASS_CHAR.
-        /// @param index (int). The index.
+        /// @param index (long). The index.
         /// @param item (char). The new value.
-        void (*const set_char)(pl_object x, int index, char item);
+        void (*const set_char)(pl_object x, long index, char item);
 
         /// Set value for an object.
-        /// @details If `index` is NA, the value will not be set.
+        /// @details If `index` is NA (PL_LONG_NA), the value will not be set.
         /// @param x (pl_object). An object of type PL_CLASS_INT.
-        /// @param index (int). The index.
+        /// @param index (long). The index.
         /// @param item (int). The new value.
-        void (*const set_int)(pl_object x, int index, int item);
+        void (*const set_int)(pl_object x, long index, int item);
 
         /// Set value for an object.
-        /// @details If `index` is NA, the value will not be set.
+        /// @details If `index` is NA (PL_LONG_NA), the value will not be set.
         /// @param x (pl_object). An object of type PL_CLASS_LONG.
-        /// @param index (int). The index.
+        /// @param index (long). The index.
         /// @param item (long). The new value.
-        void (*const set_long)(pl_object x, int index, long item);
+        void (*const set_long)(pl_object x, long index, long item);
 
         /// Set value for an object.
-        /// @details If `index` is NA, the value will not be set.
+        /// @details If `index` is NA (PL_LONG_NA), the value will not be set.
         /// @param x (pl_object). An object of type PL_CLASS_DOUBLE.
-        /// @param index (int). The index.
+        /// @param index (long). The index.
         /// @param item (double). The new value.
-        void (*const set_double)(pl_object x, int index, double item);
+        void (*const set_double)(pl_object x, long index, double item);
 
         /// Set value for an object.
-        /// @details If `index` is NA, the value will not be set.
+        /// @details If `index` is NA (PL_LONG_NA), the value will not be set.
         /// @param x (pl_object). An object of type PL_CLASS_LIST.
-        /// @param index (int). The index.
+        /// @param index (long). The index.
         /// @param item (pl_object). The new value.
-        void (*const set_object)(pl_object x, int index, pl_object item);
+        void (*const set_object)(pl_object x, long index, pl_object item);
 
         /// Set value for an object.
-        /// @details If `index` is NA, the value will not be set.
+        /// @details If `index` is NA (PL_LONG_NA), the value will not be set.
         /// @param x (pl_object). An object of type PL_CLASS_LIST.
-        /// @param index (int). The index.
+        /// @param index (long). The index.
         /// @param item (void *). The new value.
-        void (*const set_external)(pl_object x, int index, void *item);
+        void (*const set_external)(pl_object x, long index, void *item);
+
+        /// Set value for an object.
+        /// @details If `index` is NA (PL_LONG_NA), the value will not be set.
+        /// @param x (pl_object). An object of type PL_CLASS_BOOL.
+        /// @param index (long). The index.
+        /// @param item (int). The new value. PL_BOOL_NA, zero for FALSE, or any other value for TRUE.
+        void (*const set_bool)(pl_object x, long index, int item);
+
+        /// Set value for an object.
+        /// @details If `index` is NA (PL_LONG_NA), the value will not be set. The bytes of
+        /// the string are appended to the byte buffer.
+        /// @param x (pl_object). An object of type PL_CLASS_STRING.
+        /// @param index (long). The index.
+        /// @param item (const char *). The new value. A null-terminated string, or NULL for NA.
+        void (*const set_string)(pl_object x, long index, const char *item);
 
         /// Set values for an object by indices.
         /// @details If an index of `indices` is NA, the corresponding value will not be set.
         /// If `length` is zero, no items will be set and `array` will not be used.
         /// @param x (pl_object). The object.
-        /// @param length (int). Length of the array.
+        /// @param length (long). Length of the array.
         /// @param indices (const int *). The indices.
         /// @param array (const void *). The source array.
-        void (*const set_by_indices)(pl_object x, const int length, const int *indices, const void *array);
+        void (*const set_by_indices)(pl_object x, const long length, const int *indices, const void *array);
 
         /// Set a range of items for an object.
         /// @param x (pl_object). The object.
-        /// @param start (int). The first index.
-        /// @param end (int). The last index.
+        /// @param start (long). The first index.
+        /// @param end (long). The last index.
         /// @param array (const void *). The source array.
-        void (*const set_range)(pl_object x, const int start, const int end, const void *array);
+        void (*const set_range)(pl_object x, const long start, const long end, const void *array);
 
         /// Set values for an object by a Boolean array. The boolean array
         /// should not contain any NA values.
@@ -306,48 +503,63 @@ typedef struct pl_object_ns {
          ----------------------------------------------------------------------------*/
 
         /// Extract value of an object.
-        /// @details If `index` is NA, returns NA.
+        /// @details If `index` is NA (PL_LONG_NA), returns NA.
         /// @param x (pl_object). An object of type PL_CLASS_CHAR.
-        /// @param index (int). The index.
+        /// @param index (long). The index.
         /// @return A char.
-        char (*const extract_char)(pl_object x, int index);
+        char (*const extract_char)(pl_object x, long index);
 
         /// Extract value of an object.
-        /// @details If `index` is NA, returns NA.
+        /// @details If `index` is NA (PL_LONG_NA), returns NA.
         /// @param x (pl_object). An object of type PL_CLASS_INT.
-        /// @param index (int). The index.
+        /// @param index (long). The index.
         /// @return A int.
-        int (*const extract_int)(pl_object x, int index);
+        int (*const extract_int)(pl_object x, long index);
 
         /// Extract value of an object.
-        /// @details If `index` is NA, returns NA.
+        /// @details If `index` is NA (PL_LONG_NA), returns NA.
         /// @param x (pl_object). An object of type PL_CLASS_LONG.
-        /// @param index (int). The index.
+        /// @param index (long). The index.
         /// @return A long.
-        long (*const extract_long)(pl_object x, int index);
+        long (*const extract_long)(pl_object x, long index);
 
         /// Extract value of an object.
-        /// @details If `index` is NA, returns NA.
+        /// @details If `index` is NA (PL_LONG_NA), returns NA.
         /// @param x (pl_object). An object of type PL_CLASS_DOUBLE.
-        /// @param index (int). The index.
+        /// @param index (long). The index.
         /// @return A double.
-        double (*const extract_double)(pl_object x, int index);
+        double (*const extract_double)(pl_object x, long index);
 
         /// Extract value of an object.
-        /// @details If `index` is NA, returns NA.
+        /// @details If `index` is NA (PL_LONG_NA), returns NA.
         /// @details The attribute of the outer list will be dropped.
         /// @param x (pl_object). An object of type PL_CLASS_LIST.
-        /// @param index (int). The index.
+        /// @param index (long). The index.
         /// @return A pl_object.
-        pl_object (*const extract_object)(pl_object x, int index);
+        pl_object (*const extract_object)(pl_object x, long index);
 
         /// Extract value of an object.
-        /// @details If `index` is NA, returns NA.
+        /// @details If `index` is NA (PL_LONG_NA), returns NA.
         /// @details The attribute of the outer list will be dropped.
         /// @param x (pl_object). An object of type PL_CLASS_EXTERNAL.
-        /// @param index (int). The index.
+        /// @param index (long). The index.
         /// @return A pointer.
-        void *(*const extract_external)(pl_object x, int index);
+        void *(*const extract_external)(pl_object x, long index);
+
+        /// Extract value of an object.
+        /// @details If `index` is NA (PL_LONG_NA), returns NA.
+        /// @param x (pl_object). An object of type PL_CLASS_BOOL.
+        /// @param index (long). The index.
+        /// @return 0, 1 or PL_BOOL_NA.
+        int (*const extract_bool)(pl_object x, long index);
+
+        /// Extract value of an object.
+        /// @details If `index` is NA (PL_LONG_NA), returns NA. The string lives in the byte
+        /// buffer, so it is only valid until the buffer grows.
+        /// @param x (pl_object). An object of type PL_CLASS_STRING.
+        /// @param index (long). The index.
+        /// @return A null-terminated string, or NULL for NA.
+        const char *(*const extract_string)(pl_object x, long index);
 
         /*-----------------------------------------------------------------------------
          |  Primitive extend
@@ -383,6 +595,16 @@ typedef struct pl_object_ns {
         /// @param item (void *). The item.
         void (*const extend_external)(pl_object x, void *item);
 
+        /// Extend an object by a value.
+        /// @param x (pl_object). An object of type PL_CLASS_BOOL.
+        /// @param item (int). The item. PL_BOOL_NA, zero for FALSE, or any other value for TRUE.
+        void (*const extend_bool)(pl_object x, int item);
+
+        /// Extend an object by a value.
+        /// @param x (pl_object). An object of type PL_CLASS_STRING.
+        /// @param item (const char *). The item. A null-terminated string, or NULL for NA.
+        void (*const extend_string)(pl_object x, const char *item);
+
         /*-----------------------------------------------------------------------------
          |  Primitive subset
          ----------------------------------------------------------------------------*/
@@ -392,20 +614,36 @@ typedef struct pl_object_ns {
         /// the corresponding item will be NA. If `length` is zero, an empty
         /// object will be returned.
         /// @param x (pl_object). The object.
-        /// @param length (int). The length of the new object.
+        /// @param length (long). The length of the new object.
         /// @param indices (const int *). Indices.
         /// @return A new object.
-        pl_object (*const subset)(pl_object x, int length, const int *indices);
+        pl_object (*const subset)(pl_object x, long length, const int *indices);
+
+        /// Write a subset of the original object into another object.
+        /// @details The memory of `dst` is reused if its capacity is large enough.
+        /// @param dst (pl_object). An object of the same type as `x`. It can't be `x`.
+        /// @param x (pl_object). The object.
+        /// @param length (long). The length of the subset.
+        /// @param indices (const int *). Indices.
+        void (*const subset_into)(pl_object dst, pl_object x, long length, const int *indices);
 
         /// Construct a new object as a subset of the original object by excluding some indices.
         /// @details The attribute will be dropped. NAs in `indices` will be ignored.
         /// Duplicate indices will be ignored. If `length` is zero, a shallow
         /// copy of the object will be returned.
         /// @param x (pl_object). The object.
-        /// @param length (int). The length of indices.
+        /// @param length (long). The length of indices.
         /// @param indices (const int *). Indices that needs to be excluded.
         /// @return A new object.
-        pl_object (*const subset_exclude)(pl_object x, int length, const int *indices);
+        pl_object (*const subset_exclude)(pl_object x, long length, const int *indices);
+
+        /// Write a subset of the original object excluding some indices into another object.
+        /// @details The memory of `dst` is reused if its capacity is large enough.
+        /// @param dst (pl_object). An object of the same type as `x`. It can't be `x`.
+        /// @param x (pl_object). The object.
+        /// @param length (long). The length of indices.
+        /// @param indices (const int *). Indices that needs to be excluded.
+        void (*const subset_exclude_into)(pl_object dst, pl_object x, long length, const int *indices);
 
         /// Construct a new object as a subset of the original object by a Boolean array.
         /// @param x (pl_object). The object.
@@ -413,49 +651,58 @@ typedef struct pl_object_ns {
         /// @return A new object.
         pl_object (*const subset_by_bool)(pl_object x, const int *bool_array);
 
+        /// Write a subset of the original object selected by a Boolean array into another object.
+        /// @details The memory of `dst` is reused if its capacity is large enough.
+        /// @param dst (pl_object). An object of the same type as `x`. It can't be `x`.
+        /// @param x (pl_object). The object.
+        /// @param bool_array (const int *). An array of Booleans.
+        void (*const subset_by_bool_into)(pl_object dst, pl_object x, const int *bool_array);
+
         /*-----------------------------------------------------------------------------
          |  Primitive remove
          ----------------------------------------------------------------------------*/
 
         /// Remove items from the object.
         /// @param x (pl_object). The object.
-        /// @param start (int). The first index.
-        /// @param end (int). The last index.
-        void (*const remove)(pl_object x, int start, int end);
+        /// @param start (long). The first index.
+        /// @param end (long). The last index.
+        void (*const remove)(pl_object x, long start, long end);
 
         /// Remove items from the object by indices.
         /// @details NAs in `indices` will be ignored. Duplicate indices will
         /// be ignored.
         /// @param x (pl_object). The object.
-        /// @param length (int). Length of the array.
+        /// @param length (long). Length of the array.
         /// @param indices (const int *). The indices.
         /// @param array (const void *). The array.
-        void (*const remove_by_indices)(pl_object x, int length, const int *indices);
+        void (*const remove_by_indices)(pl_object x, long length, const int *indices);
 
     } primitive;
 
     /// New an object.
     /// @param class (pl_object). Class of the object.
-    /// @param capacity (pl_object). Capacity of the object.
+    /// @param capacity (pl_object). Capacity of the object. An int or long scalar.
     /// @return A new empty object.
     pl_object (*const new)(pl_object class, pl_object capacity);
 
     /// Reserve memory for an object.
     /// The function may reserve more memory than requested amount for efficiency.
     /// @param x (pl_object). The object.
-    /// @param capacity (pl_object). New capacity.
+    /// @param capacity (pl_object). New capacity. An int or long scalar.
     void (*const reserve)(pl_object x, pl_object capacity);
 
     /// Set one or more values of an object.
+    /// @details A PL_CLASS_BOOL mask of the same length as x selects the items to set. It can't
+    /// contain NA, and the items are either one per selected item or a single recycled item.
     /// @param x (pl_object). The object.
-    /// @param indices (pl_object). Indices.
+    /// @param indices (pl_object). Indices of type PL_CLASS_INT or PL_CLASS_LONG, or a PL_CLASS_BOOL mask.
     /// @param items (pl_object). Items.
     void (*const set)(pl_object x, pl_object indices, pl_object items);
 
     /// Set values for a range of items of an object.
     /// @param x (pl_object). The object.
-    /// @param start (pl_object). The start index.
-    /// @param end (pl_object). The end index.
+    /// @param start (pl_object). The start index. An int or long scalar.
+    /// @param end (pl_object). The end index. An int or long scalar.
     /// @param items (pl_object). Items.
     void (*const set_range)(pl_object x, pl_object start, pl_object end, pl_object items);
 
@@ -466,7 +713,7 @@ typedef struct pl_object_ns {
 
     /// Extract a value of an object.
     /// @param x (pl_object). The object.
-    /// @param index (pl_object). The index.
+    /// @param index (pl_object). The index. An int or long scalar.
     /// @return If x is of type PL_CLASS_LIST,
     /// this function will return the value directly.
     /// Otherwise, the function will act the same as `subset`
@@ -479,12 +726,20 @@ typedef struct pl_object_ns {
     void (*const extend)(pl_object x, pl_object y);
 
     /// Construct a new object as a subset of the original object.
-    /// @details The attribute will be dropped.
+    /// @details The attribute will be dropped. A PL_CLASS_BOOL mask of the same length as x
+    /// selects the items to keep. It can't contain NA.
     /// @param x (pl_object). The object.
-    /// @param indices (pl_object). Indices.
+    /// @param indices (pl_object). Indices of type PL_CLASS_INT or PL_CLASS_LONG, or a PL_CLASS_BOOL mask.
     /// @return A new object.
     pl_object (*const subset)(pl_object x, pl_object indices);
 
+    /// Write a subset of the original object into another object.
+    /// @details The memory of `dst` is reused if its capacity is large enough.
+    /// @param dst (pl_object). An object of the same type as `x`. It can't be an operand.
+    /// @param x (pl_object). The object.
+    /// @param indices (pl_object). Indices of type PL_CLASS_INT or PL_CLASS_LONG, or a PL_CLASS_BOOL mask.
+    void (*const subset_into)(pl_object dst, pl_object x, pl_object indices);
+
     /// Construct a new object as a subset of the original object by excluding some indices.
     /// @details The attribute will be dropped. NAs in `indices` will be ignored.
     /// Duplicate indices will be ignored.
@@ -493,6 +748,13 @@ typedef struct pl_object_ns {
     /// @return A new object.
     pl_object (*const subset_exclude)(pl_object x, pl_object indices);
 
+    /// Write a subset of the original object excluding some indices into another object.
+    /// @details The memory of `dst` is reused if its capacity is large enough.
+    /// @param dst (pl_object). An object of the same type as `x`. It can't be an operand.
+    /// @param x (pl_object). The object.
+    /// @param indices (pl_object). Indices.
+    void (*const subset_exclude_into)(pl_object dst, pl_object x, pl_object indices);
+
     /// Construct a shallow copy of an object.
     /// @details The attribute will be dropped.
     /// @param x (pl_object). The object.
@@ -500,26 +762,162 @@ typedef struct pl_object_ns {
     pl_object (*const copy)(pl_object x);
 
     /// Check if items in two objects are equal.
+    /// @details An object of length one is recycled. Any NA operand gives NA.
     /// @param x (pl_object). The object.
     /// @param y (pl_object). Another object.
-    /// @return A new object.
+    /// @return A new PL_CLASS_BOOL object.
     pl_object (*const equal)(pl_object x, pl_object y);
 
+    /// Check if items in two objects are equal and write the result into another object.
+    /// @details The memory of `dst` is reused if its capacity is large enough.
+    /// @param dst (pl_object). A PL_CLASS_BOOL object. It can't be an operand.
+    /// @param x (pl_object). The object.
+    /// @param y (pl_object). Another object.
+    void (*const equal_into)(pl_object dst, pl_object x, pl_object y);
+
     /// Check if each element of x is in y.
     /// @param x (pl_object). The object.
     /// @param y (pl_object). Another object.
-    /// @return A new object of type PL_CLASS_INT of
+    /// @return A new object of type PL_CLASS_BOOL of
     /// the same length as x.
     pl_object (*const in)(pl_object x, pl_object y);
 
+    /// Check if each element of x is in y and write the result into another object.
+    /// @details The memory of `dst` is reused if its capacity is large enough.
+    /// @param dst (pl_object). A PL_CLASS_BOOL object. It can't be an operand.
+    /// @param x (pl_object). The object.
+    /// @param y (pl_object). Another object.
+    void (*const in_into)(pl_object dst, pl_object x, pl_object y);
+
+    /// Find the position of each element of x in a table.
+    /// @details Hash based. All NAs are equal, and so are 0.0 and -0.0. Lists and externals are
+    /// compared by address.
+    /// @param x (pl_object). The object.
+    /// @param table (pl_object). An object of the same type, of length at most INT_MAX.
+    /// @return A new object of type PL_CLASS_INT of the same length as x, holding the position of
+    /// the first equal item in the table, or NA if there is none.
+    pl_object (*const match)(pl_object x, pl_object table);
+
+    /// Find the position of each element of x in a table and write the result into another object.
+    /// @details The memory of `dst` is reused if its capacity is large enough.
+    /// @param dst (pl_object). A PL_CLASS_INT object. It can't be an operand.
+    /// @param x (pl_object). The object.
+    /// @param table (pl_object). An object of the same type.
+    void (*const match_into)(pl_object dst, pl_object x, pl_object table);
+
+    /// Get the distinct items of an object.
+    /// @details Items are kept in order of first appearance, with the same equality as `match`.
+    /// The attribute will be dropped.
+    /// @param x (pl_object). The object.
+    /// @return A new object of the same class as x.
+    pl_object (*const unique)(pl_object x);
+
+    /// Get the distinct items of an object and write them into another object.
+    /// @details The memory of `dst` is reused if its capacity is large enough.
+    /// @param dst (pl_object). An object of the same type as x. It can't be x.
+    /// @param x (pl_object). The object.
+    void (*const unique_into)(pl_object dst, pl_object x);
+
+    /// Sort the items of an object in increasing order.
+    /// @details Radix sort for PL_CLASS_CHAR, PL_CLASS_INT, PL_CLASS_LONG and PL_CLASS_DOUBLE.
+    /// Chars are ordered as unsigned bytes, and -0.0 comes before 0.0. The attribute will be dropped.
+    /// @param x (pl_object). The object.
+    /// @param na_last (pl_object). An int object. 1 to place NAs last, 0 to place them first,
+    /// NA to drop them.
+    /// @return A new object of the same class as x.
+    pl_object (*const sort)(pl_object x, pl_object na_last);
+
+    /// Sort the items of an object and write them into another object.
+    /// @details The memory of `dst` is reused if its capacity is large enough.
+    /// @param dst (pl_object). An object of the same type as x. It can't be x.
+    /// @param x (pl_object). The object.
+    /// @param na_last (pl_object). An int object. See `sort`.
+    void (*const sort_into)(pl_object dst, pl_object x, pl_object na_last);
+
+    /// Get the positions that sort an object.
+    /// @details The order is stable, so equal items keep their relative positions. The result can be
+    /// passed to `subset`. Items are compared as by `sort`.
+    /// @param x (pl_object). The object, of length at most INT_MAX.
+    /// @param na_last (pl_object). An int object. See `sort`.
+    /// @return A new object of type PL_CLASS_INT.
+    pl_object (*const order)(pl_object x, pl_object na_last);
+
+    /// Get the positions that sort an object and write them into another object.
+    /// @details The memory of `dst` is reused if its capacity is large enough.
+    /// @param dst (pl_object). A PL_CLASS_INT object. It can't be x.
+    /// @param x (pl_object). The object.
+    /// @param na_last (pl_object). An int object. See `sort`.
+    void (*const order_into)(pl_object dst, pl_object x, pl_object na_last);
+
+    /// Group the items of an object by their values.
+    /// @details Hash based, with the same equality as `match`. Groups are numbered from 0 in
+    /// order of first appearance, and NAs form a group of their own.
+    /// @param keys (pl_object). The object, of length at most INT_MAX.
+    /// @return A new list of two PL_CLASS_INT objects. The first holds the group of each item of
+    /// `keys`, and the second holds the position of the first item of each group, so its length
+    /// is the number of groups and `subset` with it gives the key of each group.
+    pl_object (*const group)(pl_object keys);
+
+    /// Count the items of each group.
+    /// @param grouping (pl_object). A grouping made by `group`.
+    /// @return A new PL_CLASS_INT object with one item per group.
+    pl_object (*const group_count)(pl_object grouping);
+
+    /// Sum the items of each group.
+    /// @details One pass over x. A group with an NA or an overflowing sum gives NA.
+    /// @param x (pl_object). A PL_CLASS_INT, PL_CLASS_LONG or PL_CLASS_DOUBLE object.
+    /// @param grouping (pl_object). A grouping made by `group` from keys of the same length as x.
+    /// @return A new object with one item per group, of type PL_CLASS_LONG for ints and longs,
+    /// or PL_CLASS_DOUBLE for doubles.
+    pl_object (*const group_sum)(pl_object x, pl_object grouping);
+
+    /// Minimum of the items of each group.
+    /// @details One pass over x. A group with an NA gives NA.
+    /// @param x (pl_object). A PL_CLASS_INT, PL_CLASS_LONG or PL_CLASS_DOUBLE object.
+    /// @param grouping (pl_object). A grouping made by `group` from keys of the same length as x.
+    /// @return A new object of the same type with one item per group.
+    pl_object (*const group_min)(pl_object x, pl_object grouping);
+
+    /// Maximum of the items of each group.
+    /// @details One pass over x. A group with an NA gives NA.
+    /// @param x (pl_object). A PL_CLASS_INT, PL_CLASS_LONG or PL_CLASS_DOUBLE object.
+    /// @param grouping (pl_object). A grouping made by `group` from keys of the same length as x.
+    /// @return A new object of the same type with one item per group.
+    pl_object (*const group_max)(pl_object x, pl_object grouping);
+
     /// Set number of decimals.
+    /// @details With PL_OBJECT_PRINT_SHORTEST, doubles are printed with
+    /// the fewest digits that parse back to the same value.
     /// @param x (pl_object). An int object.
     void (*const print_set_decimals)(pl_object x);
 
+    /// Set the maximum number of items to print.
+    /// @details Longer objects are printed as their head and tail. Zero for no limit.
+    /// @param x (pl_object). An int object.
+    void (*const print_set_max_items)(pl_object x);
+
     /// Print an object.
     /// @param x (pl_object). The object.
     void (*const print)(pl_object x);
 
+    /// Print an object to a stream.
+    /// @details The text is buffered and written at once.
+    /// @param stream (FILE *). The stream.
+    /// @param x (pl_object). The object.
+    void (*const print_to)(FILE *stream, pl_object x);
+
+    /// Format an object as it is printed, without the newline.
+    /// @details The text is followed by a null terminator, which is not counted in the length.
+    /// @param x (pl_object). The object.
+    /// @return A new PL_CLASS_CHAR object.
+    pl_object (*const format)(pl_object x);
+
+    /// Format an object into another object.
+    /// @details The memory of `dst` is reused if its capacity is large enough.
+    /// @param dst (pl_object). A PL_CLASS_CHAR object. It can't be an operand.
+    /// @param x (pl_object). The object.
+    void (*const format_into)(pl_object dst, pl_object x);
+
     /// Convert to a PL_CLASS_CHAR object.
     /// @details The attribute will be dropped.
     /// @param x (pl_object). The object.
@@ -544,6 +942,44 @@ typedef struct pl_object_ns {
     /// @return A new PL_CLASS_DOUBLE object.
     pl_object (*const as_double)(pl_object x);
 
+    /// Convert to a PL_CLASS_BOOL object.
+    /// @details Non-zero items are TRUE. Only PL_CLASS_INT, PL_CLASS_LONG and PL_CLASS_DOUBLE
+    /// objects can be converted, and Booleans only convert to these types, as 0, 1 or NA.
+    /// The attribute will be dropped.
+    /// @param x (pl_object). The object.
+    /// @return A new PL_CLASS_BOOL object.
+    pl_object (*const as_bool)(pl_object x);
+
+    /// Convert to a PL_CLASS_CHAR object in place of another object.
+    /// @details The memory of `dst` is reused if its capacity is large enough.
+    /// @param dst (pl_object). A PL_CLASS_CHAR object to write into. It may be `x` itself.
+    /// @param x (pl_object). The object.
+    void (*const as_char_into)(pl_object dst, pl_object x);
+
+    /// Convert to a PL_CLASS_INT object in place of another object.
+    /// @details The memory of `dst` is reused if its capacity is large enough.
+    /// @param dst (pl_object). A PL_CLASS_INT object to write into. It may be `x` itself.
+    /// @param x (pl_object). The object.
+    void (*const as_int_into)(pl_object dst, pl_object x);
+
+    /// Convert to a PL_CLASS_LONG object in place of another object.
+    /// @details The memory of `dst` is reused if its capacity is large enough.
+    /// @param dst (pl_object). A PL_CLASS_LONG object to write into. It may be `x` itself.
+    /// @param x (pl_object). The object.
+    void (*const as_long_into)(pl_object dst, pl_object x);
+
+    /// Convert to a PL_CLASS_DOUBLE object in place of another object.
+    /// @details The memory of `dst` is reused if its capacity is large enough.
+    /// @param dst (pl_object). A PL_CLASS_DOUBLE object to write into. It may be `x` itself.
+    /// @param x (pl_object). The object.
+    void (*const as_double_into)(pl_object dst, pl_object x);
+
+    /// Convert to a PL_CLASS_BOOL object in place of another object.
+    /// @details The memory of `dst` is reused if its capacity is large enough.
+    /// @param dst (pl_object). A PL_CLASS_BOOL object to write into. It may be `x` itself.
+    /// @param x (pl_object). The object.
+    void (*const as_bool_into)(pl_object dst, pl_object x);
+
     struct pl_object_attribute_ns {
         /// Check if an attribute name exists.
         /// @param x (pl_object). The object.
@@ -551,7 +987,16 @@ typedef struct pl_object_ns {
         /// @param A length one PL_CLASS_INT object.
         pl_object (*const has)(pl_object x, pl_object name);
 
+        /// Check if an attribute name exists and write the result into another object.
+        /// @details Unlike `has`, this function does not allocate if `dst` is large enough.
+        /// @param dst (pl_object). A PL_CLASS_INT object. It can't be an operand.
+        /// @param x (pl_object). The object.
+        /// @param name (pl_object). The attribute name.
+        void (*const has_into)(pl_object dst, pl_object x, pl_object name);
+
         /// Get an attribute with its name.
+        /// @details Objects with more than four attributes look names up in a hash table.
+        /// The lookup does not allocate.
         /// @param x (pl_object). The object.
         /// @param name (pl_object). The attribute name.
         /// @param The attribute.
@@ -567,8 +1012,197 @@ typedef struct pl_object_ns {
         /// @param x (pl_object). The object.
         /// @param name (pl_object). The attribute name.
         void (*const remove)(pl_object x, pl_object name);
+
+        /// Rebuild the attribute of an object copied from another heap.
+        /// @details The names are interned as symbols of the current thread and
+        /// the hash table is rebuilt. Called by `import_graph` for every object.
+        /// @param x (pl_object). The object.
+        void (*const rebuild)(pl_object x);
     } attribute;
 
+    /// Arithmetic and reductions over PL_CLASS_INT, PL_CLASS_LONG and PL_CLASS_DOUBLE objects.
+    /// @details Operands of different types are promoted to the wider type (INT < LONG < DOUBLE).
+    /// An operand of length one is recycled. Any NA operand gives an NA result, and so does
+    /// an integer overflow. The attribute will be dropped.
+    struct pl_object_math_ns {
+        /// Element-wise addition.
+        /// @param x (pl_object). The object.
+        /// @param y (pl_object). Another object of the same length or of length one.
+        /// @return A new object.
+        pl_object (*const add)(pl_object x, pl_object y);
+
+        /// Element-wise subtraction.
+        /// @param x (pl_object). The object.
+        /// @param y (pl_object). Another object of the same length or of length one.
+        /// @return A new object.
+        pl_object (*const subtract)(pl_object x, pl_object y);
+
+        /// Element-wise multiplication.
+        /// @param x (pl_object). The object.
+        /// @param y (pl_object). Another object of the same length or of length one.
+        /// @return A new object.
+        pl_object (*const multiply)(pl_object x, pl_object y);
+
+        /// Element-wise division.
+        /// @param x (pl_object). The object.
+        /// @param y (pl_object). Another object of the same length or of length one.
+        /// @return A new PL_CLASS_DOUBLE object.
+        pl_object (*const divide)(pl_object x, pl_object y);
+
+        /// Sum of the items.
+        /// @details Doubles are summed pairwise.
+        /// @param x (pl_object). The object.
+        /// @return A length one PL_CLASS_LONG object, or a PL_CLASS_DOUBLE object for doubles.
+        pl_object (*const sum)(pl_object x);
+
+        /// Mean of the items.
+        /// @param x (pl_object). The object.
+        /// @return A length one PL_CLASS_DOUBLE object. NA for an empty object.
+        pl_object (*const mean)(pl_object x);
+
+        /// Minimum of the items.
+        /// @details Fails with error code PL_ERROR_INVALID_LENGTH for an empty object.
+        /// @param x (pl_object). The object.
+        /// @return A length one object of the same type.
+        pl_object (*const min)(pl_object x);
+
+        /// Maximum of the items.
+        /// @details Fails with error code PL_ERROR_INVALID_LENGTH for an empty object.
+        /// @param x (pl_object). The object.
+        /// @return A length one object of the same type.
+        pl_object (*const max)(pl_object x);
+
+        /// Cumulative sum of the items.
+        /// @param x (pl_object). The object.
+        /// @return A new object of the same type and length.
+        pl_object (*const cumsum)(pl_object x);
+    } math;
+
+    /// Byte buffers of PL_CLASS_STRING objects.
+    /// @details A string built from the items of another string shares its byte buffer, and
+    /// a replaced item leaves its bytes behind. `compact` and `intern` give a string its own buffer.
+    struct pl_object_string_ns {
+        /// Construct a string from a list of PL_CLASS_CHAR objects.
+        /// @details Each item holds the bytes of a char object. NULL items give NAs.
+        /// @param x (pl_object). A PL_CLASS_LIST object.
+        /// @return A new PL_CLASS_STRING object.
+        pl_object (*const from_list)(pl_object x);
+
+        /// Construct a list of PL_CLASS_CHAR objects from a string.
+        /// @details Each char object is followed by a null terminator, which is not counted
+        /// in its length. NAs give NULL items.
+        /// @param x (pl_object). A PL_CLASS_STRING object.
+        /// @return A new PL_CLASS_LIST object.
+        pl_object (*const to_list)(pl_object x);
+
+        /// Copy a string into a byte buffer holding only its items.
+        /// @param x (pl_object). A PL_CLASS_STRING object.
+        /// @return A new PL_CLASS_STRING object.
+        pl_object (*const compact)(pl_object x);
+
+        /// Copy a string into a byte buffer holding every distinct item once.
+        /// @details Equal items of the result share their bytes, so they are compared
+        /// without reading them. Items appended later are not deduplicated.
+        /// @param x (pl_object). A PL_CLASS_STRING object.
+        /// @return A new PL_CLASS_STRING object.
+        pl_object (*const intern)(pl_object x);
+    } string;
+
+    /// Lazy element-wise operations over PL_CLASS_CHAR, PL_CLASS_INT, PL_CLASS_LONG, PL_CLASS_DOUBLE
+    /// and PL_CLASS_BOOL objects.
+    /// @details A lazy object is a PL_CLASS_LIST object holding an operation and its operands, which are
+    /// objects or other lazy objects. Nothing is computed until a lazy object is forced. The whole
+    /// expression is then evaluated by blocks of items that stay in the cache, so no intermediate object
+    /// is allocated. Results are the same as those of the eager functions, NAs included. Type and length
+    /// errors are raised when an operation is built. The operands must not be modified before forcing.
+    struct pl_object_lazy_ns {
+        /// Check if an object is lazy.
+        /// @param x (pl_object). The object.
+        /// @return 1 if the object is lazy, 0 otherwise.
+        int (*const is)(pl_object x);
+
+        /// Lazy conversion to PL_CLASS_CHAR.
+        /// @param x (pl_object). The object or lazy object.
+        /// @return A lazy object, or x if it is already of the type.
+        pl_object (*const as_char)(pl_object x);
+
+        /// Lazy conversion to PL_CLASS_INT.
+        /// @param x (pl_object). The object or lazy object.
+        /// @return A lazy object, or x if it is already of the type.
+        pl_object (*const as_int)(pl_object x);
+
+        /// Lazy conversion to PL_CLASS_LONG.
+        /// @param x (pl_object). The object or lazy object.
+        /// @return A lazy object, or x if it is already of the type.
+        pl_object (*const as_long)(pl_object x);
+
+        /// Lazy conversion to PL_CLASS_DOUBLE.
+        /// @param x (pl_object). The object or lazy object.
+        /// @return A lazy object, or x if it is already of the type.
+        pl_object (*const as_double)(pl_object x);
+
+        /// Lazy conversion to PL_CLASS_BOOL.
+        /// @param x (pl_object). The object or lazy object.
+        /// @return A lazy object, or x if it is already of the type.
+        pl_object (*const as_bool)(pl_object x);
+
+        /// Lazy element-wise equality.
+        /// @param x (pl_object). The object or lazy object.
+        /// @param y (pl_object). Another object or lazy object of the same type.
+        /// @return A lazy PL_CLASS_BOOL object.
+        pl_object (*const equal)(pl_object x, pl_object y);
+
+        /// Lazy element-wise addition.
+        /// @param x (pl_object). The object or lazy object.
+        /// @param y (pl_object). Another object or lazy object of the same length or of length one.
+        /// @return A lazy object.
+        pl_object (*const add)(pl_object x, pl_object y);
+
+        /// Lazy element-wise subtraction.
+        /// @param x (pl_object). The object or lazy object.
+        /// @param y (pl_object). Another object or lazy object of the same length or of length one.
+        /// @return A lazy object.
+        pl_object (*const subtract)(pl_object x, pl_object y);
+
+        /// Lazy element-wise multiplication.
+        /// @param x (pl_object). The object or lazy object.
+        /// @param y (pl_object). Another object or lazy object of the same length or of length one.
+        /// @return A lazy object.
+        pl_object (*const multiply)(pl_object x, pl_object y);
+
+        /// Lazy element-wise division.
+        /// @param x (pl_object). The object or lazy object.
+        /// @param y (pl_object). Another object or lazy object of the same length or of length one.
+        /// @return A lazy PL_CLASS_DOUBLE object.
+        pl_object (*const divide)(pl_object x, pl_object y);
+
+        /// Evaluate a lazy object.
+        /// @details Operations shared by several operands are evaluated once per block.
+        /// @param x (pl_object). The lazy object.
+        /// @return A new object, or x if it is not lazy.
+        pl_object (*const force)(pl_object x);
+
+        /// Evaluate a lazy object into another object.
+        /// @details The memory of `dst` is reused if its capacity is large enough.
+        /// @param dst (pl_object). An object of the type of the result. It can't be an operand.
+        /// @param x (pl_object). The object or lazy object.
+        void (*const force_into)(pl_object dst, pl_object x);
+
+        /// Subset an object by a mask, evaluating both in one pass.
+        /// @details The mask is forced first, then the items of a lazy x are only
+        /// written for the TRUEs of the mask. The mask can't contain NA.
+        /// @param x (pl_object). The object or lazy object.
+        /// @param mask (pl_object). A PL_CLASS_BOOL object or lazy object of the same length.
+        /// @return A new object.
+        pl_object (*const subset)(pl_object x, pl_object mask);
+    } lazy;
+
+#ifdef PL_TEST
+
+    void (*const test)(void);
+
+#endif//PL_TEST
+
 } pl_object_ns;
 
 /// Get object namespace.
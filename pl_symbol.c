@@ -0,0 +1,315 @@
+//
+// Created by Patrick Li on 14/10/2026.
+//
+
+#include "pl_symbol.h"
+#include "pl_class.h"
+#include "pl_error.h"
+#include "pl_gc.h"
+#include "stdio.h"
+#include "string.h"
+
+#ifdef PL_TEST
+
+#include "pl_unittest.h"
+
+#endif//PL_TEST
+
+// Global variables for storing symbols.
+// Symbols are stored in a list, and indexed by an open-addressing hash table of positions
+// in the list. All arrays are objects held by `global_symbol_table`, which is directly
+// reachable, so symbols are never collected.
+static _Thread_local pl_object global_symbol_table  = NULL;
+static _Thread_local pl_object global_symbol_list   = NULL;
+static _Thread_local pl_object global_symbol_hashes = NULL;
+static _Thread_local pl_object global_symbol_slots  = NULL;
+
+// Position of the slot array in the symbol table.
+#define SYMBOL_SLOTS_POSITION 2
+
+// Initial number of slots. Always a power of two.
+#define SYMBOL_INIT_SLOTS 64
+
+/*-----------------------------------------------------------------------------
+ |  Checks
+ ----------------------------------------------------------------------------*/
+
+#define check_null_pointer(x) pl_error_expect((x) != NULL,                      \
+                                              PL_ERROR_UNEXPECTED_NULL_POINTER, \
+                                              "Can't access NULL pointer `" #x "` !")
+
+#define check_char(x) pl_error_expect((x)->class == PL_CLASS_CHAR,                  \
+                                      PL_ERROR_INVALID_CLASS,                       \
+                                      "Unexpected class [%s], expecting [CHAR]!",   \
+                                      PL_CLASS_NAME[(x)->class])
+
+/*-----------------------------------------------------------------------------
+ |  Init
+ ----------------------------------------------------------------------------*/
+
+// New an int array filled with -1.
+static pl_object new_slots(const int length)
+{
+    pl_object x = pl_object_get_ns().primitive.new(PL_CLASS_INT, length);
+    x->length   = length;
+    pl_misc_for_i(length)((int *) x->data)[i] = -1;
+    return x;
+}
+
+// Init the symbol table.
+static void init(void)
+{
+    const pl_gc_ns gc_ns = pl_gc_get_ns();
+
+    // If the garbage collector is killed, it needs to be restarted.
+    if (global_symbol_table != NULL && gc_ns.check_status())
+        return;
+
+    const pl_object_ns object_ns = pl_object_get_ns();
+
+    pl_error_try
+    {
+        global_symbol_table  = object_ns.primitive.new(PL_CLASS_LIST, 3);
+        global_symbol_list   = object_ns.primitive.new(PL_CLASS_LIST, 1);
+        global_symbol_hashes = object_ns.primitive.new(PL_CLASS_LONG, 1);
+        global_symbol_slots  = new_slots(SYMBOL_INIT_SLOTS);
+
+        object_ns.append(global_symbol_table, global_symbol_list);
+        object_ns.append(global_symbol_table, global_symbol_hashes);
+        object_ns.append(global_symbol_table, global_symbol_slots);
+
+        gc_ns.directly_reachable(global_symbol_table);
+    }
+    pl_error_catch
+    {
+        // If fails, reset all pointers.
+        global_symbol_table  = NULL;
+        global_symbol_list   = NULL;
+        global_symbol_hashes = NULL;
+        global_symbol_slots  = NULL;
+        pl_error_rethrow();
+    }
+}
+
+/*-----------------------------------------------------------------------------
+ |  Hash
+ ----------------------------------------------------------------------------*/
+
+// FNV-1a hash of a name.
+static long hash_name(const char *const name, const long length)
+{
+    unsigned long hash = 14695981039346656037UL;
+    pl_misc_for_i(length)
+    {
+        hash ^= (unsigned char) name[i];
+        hash *= 1099511628211UL;
+    }
+    return (long) hash;
+}
+
+// Find the slot of a name. Returns the slot holding the name, or the empty slot where it should be inserted.
+static int find_slot(const char *const name, const long length, const long hash)
+{
+    const int *const slots              = global_symbol_slots->data;
+    const long *const hashes            = global_symbol_hashes->data;
+    const pl_object *const symbol_array = global_symbol_list->data;
+    const int mask                      = (int) global_symbol_slots->length - 1;
+
+    // Linear probing stops at the first empty slot.
+    int i = (int) ((unsigned long) hash & (unsigned long) mask);
+    while (slots[i] != -1)
+    {
+        pl_object symbol = symbol_array[slots[i]];
+        if (hashes[slots[i]] == hash && symbol->length == length && memcmp(symbol->data, name, (size_t) length) == 0)
+            return i;
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+// Double the number of slots and reinsert all the symbols.
+static void rehash(void)
+{
+    pl_object slots = new_slots((int) global_symbol_slots->length * 2);
+
+    const long *const hashes = global_symbol_hashes->data;
+    int *const slot_array    = slots->data;
+    const int mask           = (int) slots->length - 1;
+    pl_misc_for_i(global_symbol_list->length)
+    {
+        int j = (int) ((unsigned long) hashes[i] & (unsigned long) mask);
+        while (slot_array[j] != -1)
+            j = (j + 1) & mask;
+        slot_array[j] = (int) i;
+    }
+
+    pl_object_get_ns().primitive.set_object(global_symbol_table, SYMBOL_SLOTS_POSITION, slots);
+    global_symbol_slots = slots;
+}
+
+/*-----------------------------------------------------------------------------
+ |  Lookup
+ ----------------------------------------------------------------------------*/
+
+static pl_object lookup_name(const char *const name, const long length)
+{
+    init();
+    const int slot = find_slot(name, length, hash_name(name, length));
+    const int position = ((int *) global_symbol_slots->data)[slot];
+    return position == -1 ? NULL : ((pl_object *) global_symbol_list->data)[position];
+}
+
+static pl_object lookup(const char *const name)
+{
+    check_null_pointer(name);
+    return lookup_name(name, (long) strlen(name));
+}
+
+static pl_object lookup_object(pl_object x)
+{
+    check_null_pointer(x);
+    if (x->flags & PL_OBJECT_FLAG_SYMBOL)
+        return x;
+    check_char(x);
+    return lookup_name(x->data, x->length);
+}
+
+/*-----------------------------------------------------------------------------
+ |  Intern
+ ----------------------------------------------------------------------------*/
+
+static pl_object intern_name(const char *const name, const long length)
+{
+    init();
+    const long hash = hash_name(name, length);
+    int slot        = find_slot(name, length, hash);
+
+    const int position = ((int *) global_symbol_slots->data)[slot];
+    if (position != -1)
+        return ((pl_object *) global_symbol_list->data)[position];
+
+    // Keep the load factor below 3/4.
+    if ((long) (global_symbol_list->length + 1) * 4 > (long) global_symbol_slots->length * 3)
+    {
+        rehash();
+        slot = find_slot(name, length, hash);
+    }
+
+    const pl_object_ns object_ns = pl_object_get_ns();
+    pl_object symbol             = object_ns.primitive.new_from_array(PL_CLASS_CHAR, length, name);
+    symbol->flags |= PL_OBJECT_FLAG_SYMBOL;
+
+    // Everything that may fail happens before the tables are modified.
+    object_ns.primitive.reserve(global_symbol_list, global_symbol_list->length + 1);
+    object_ns.primitive.reserve(global_symbol_hashes, global_symbol_hashes->length + 1);
+    object_ns.primitive.extend_long(global_symbol_hashes, hash);
+    object_ns.append(global_symbol_list, symbol);
+
+    ((int *) global_symbol_slots->data)[slot] = (int) global_symbol_list->length - 1;
+    return symbol;
+}
+
+static pl_object intern(const char *const name)
+{
+    check_null_pointer(name);
+    return intern_name(name, (long) strlen(name));
+}
+
+static pl_object intern_object(pl_object x)
+{
+    check_null_pointer(x);
+    if (x->flags & PL_OBJECT_FLAG_SYMBOL)
+        return x;
+    check_char(x);
+    return intern_name(x->data, x->length);
+}
+
+/*-----------------------------------------------------------------------------
+ |  Is symbol
+ ----------------------------------------------------------------------------*/
+
+static int is_symbol(pl_object x)
+{
+    check_null_pointer(x);
+    return (x->flags & PL_OBJECT_FLAG_SYMBOL) != 0;
+}
+
+/*-----------------------------------------------------------------------------
+ |  Tests
+ ----------------------------------------------------------------------------*/
+
+static pl_unittest_summary test_intern(void)
+{
+    pl_unittest_summary summary = pl_unittest_new_summary();
+
+    // Enough names to rehash, including names that are prefixes of each other.
+    char name[16];
+    pl_object symbols[200];
+    const long interned = global_symbol_list == NULL ? 0 : global_symbol_list->length;
+    pl_misc_for_i(200)
+    {
+        snprintf(name, sizeof(name), "s%d", (int) i);
+        symbols[i] = intern(name);
+    }
+    pl_unittest_expect_true(summary, global_symbol_list->length == interned + 200);
+    pl_unittest_expect_true(summary, global_symbol_slots->length > SYMBOL_INIT_SLOTS);
+    pl_unittest_expect_true(summary, global_symbol_list->length * 4 <= global_symbol_slots->length * 3);
+
+    // Interning again returns the same symbols, and so does looking them up.
+    volatile int all_same = 1;
+    pl_misc_for_i(200)
+    {
+        snprintf(name, sizeof(name), "s%d", (int) i);
+        all_same = all_same && intern(name) == symbols[i] && lookup(name) == symbols[i];
+    }
+    pl_unittest_expect_true(summary, all_same && global_symbol_list->length == interned + 200);
+    pl_unittest_expect_true(summary, symbols[1] != symbols[10] && symbols[1]->length == 2);
+    pl_unittest_expect_true(summary, lookup("s200") == NULL && lookup("s") == NULL);
+
+    // Names stored in objects are interned by content.
+    pl_object x = pl_object_get_ns().primitive.new_from_array(PL_CLASS_CHAR, 3, "s42");
+    pl_unittest_expect_true(summary, intern_object(x) == symbols[42] && lookup_object(x) == symbols[42]);
+    pl_unittest_expect_true(summary, !is_symbol(x) && is_symbol(symbols[42]) && intern_object(symbols[42]) == symbols[42]);
+
+    volatile int caught = PL_ERROR_NONE;
+    pl_error_try
+    {
+        intern_object(pl_object_get_ns().primitive.new(PL_CLASS_INT, 1));
+    }
+    pl_error_catch
+    {
+        caught = pl_error_get_current();
+    }
+    pl_unittest_expect_true(summary, caught == PL_ERROR_INVALID_CLASS);
+
+    return summary;
+}
+
+static void test(void)
+{
+    printf("In file: %s\n", __FILE__);
+    pl_unittest_print_summary(test_intern());
+}
+
+/*-----------------------------------------------------------------------------
+ |  Get symbol namespace
+ ----------------------------------------------------------------------------*/
+
+pl_symbol_ns pl_symbol_get_ns(void)
+{
+#ifdef PL_TEST
+    static const pl_symbol_ns symbol_ns = {.intern        = intern,
+                                           .intern_object = intern_object,
+                                           .lookup        = lookup,
+                                           .lookup_object = lookup_object,
+                                           .is_symbol     = is_symbol,
+                                           .test          = test};
+#else
+    static const pl_symbol_ns symbol_ns = {.intern        = intern,
+                                           .intern_object = intern_object,
+                                           .lookup        = lookup,
+                                           .lookup_object = lookup_object,
+                                           .is_symbol     = is_symbol};
+#endif//PL_TEST
+    return symbol_ns;
+}
@@ -0,0 +1,58 @@
+//
+// Created by Patrick Li on 14/10/2026.
+//
+
+#ifndef PL_PL_SYMBOL_H
+#define PL_PL_SYMBOL_H
+
+#include "pl_object.h"
+
+/*-----------------------------------------------------------------------------
+ |  Symbol namespace
+ ----------------------------------------------------------------------------*/
+
+/// Namespace of symbol.
+/// @details A symbol is the canonical PL_CLASS_CHAR object of a name. Interning
+/// the same name always returns the same object, so symbols can be compared by
+/// address. Symbols are never collected. Like the heap, the symbol table is
+/// thread-local.
+typedef struct pl_symbol_ns
+{
+    /// Intern a name.
+    /// @param name (const char *). A null-terminated name.
+    /// @return The symbol.
+    pl_object (*const intern)(const char *name);
+
+    /// Intern a name stored in a PL_CLASS_CHAR object.
+    /// @param x (pl_object). The name. Symbols are returned as is.
+    /// @return The symbol.
+    pl_object (*const intern_object)(pl_object x);
+
+    /// Find the symbol of a name without interning it.
+    /// @param name (const char *). A null-terminated name.
+    /// @return The symbol, or NULL if the name has not been interned.
+    pl_object (*const lookup)(const char *name);
+
+    /// Find the symbol of a name stored in a PL_CLASS_CHAR object without interning it.
+    /// @param x (pl_object). The name.
+    /// @return The symbol, or NULL if the name has not been interned.
+    pl_object (*const lookup_object)(pl_object x);
+
+    /// Check if an object is a symbol.
+    /// @param x (pl_object). The object.
+    /// @return 0 or 1.
+    int (*const is_symbol)(pl_object x);
+
+#ifdef PL_TEST
+
+    void (*const test)(void);
+
+#endif//PL_TEST
+
+} pl_symbol_ns;
+
+/// Get symbol namespace.
+/// @return Namespace of symbol.
+pl_symbol_ns pl_symbol_get_ns(void);
+
+#endif//PL_PL_SYMBOL_H
@@ -117,7 +117,7 @@ static inline void pl_unittest_print_summary(pl_unittest_summary summary)
         pl_misc_for_i(summary.total - 1)
         {
             if (summary.success_bool[i] != 1)
-                printf("%d, ", i);
+                printf("%ld, ", i);
         }
         if (summary.total > 0)
             if (summary.success_bool[summary.total - 1] != 1)
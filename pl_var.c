@@ -6,13 +6,44 @@
 #include "pl_class.h"
 #include "pl_error.h"
 #include "pl_gc.h"
+#include "pl_symbol.h"
+#include "stdint.h"
+#include "stdio.h"
 #include "string.h"
 
+#ifdef PL_TEST
+
+#include "pl_unittest.h"
+
+#endif//PL_TEST
+
 // Global variables for storing user variables.
-static pl_object global_var_table   = NULL;
-static pl_object global_var_frames  = NULL;
-static pl_object global_var_strings = NULL;
-static pl_object global_var_objects = NULL;
+// Variables are stored in slots of parallel arrays, and names are stored as symbols. Slots
+// are indexed by a chained hash table keyed on (frame, symbol), and slots of the same frame
+// are linked in a doubly linked chain. All arrays are objects held by `global_var_table`,
+// so the garbage collector keeps the contents alive.
+static _Thread_local pl_object global_var_table       = NULL;
+static _Thread_local pl_object global_var_frames      = NULL;
+static _Thread_local pl_object global_var_symbols     = NULL;
+static _Thread_local pl_object global_var_objects     = NULL;
+static _Thread_local pl_object global_var_bucket_next = NULL;
+static _Thread_local pl_object global_var_frame_prev  = NULL;
+static _Thread_local pl_object global_var_frame_next  = NULL;
+static _Thread_local pl_object global_var_buckets     = NULL;
+static _Thread_local pl_object global_var_frame_heads = NULL;
+
+// Number of variables, and the first free slot. Free slots are chained by `global_var_bucket_next`.
+static _Thread_local int global_var_count     = 0;
+static _Thread_local int global_var_free_slot = -1;
+
+// Position of the bucket array in the variable table.
+#define VAR_BUCKETS_POSITION 6
+
+// Initial number of buckets. Always a power of two.
+#define VAR_INIT_BUCKETS 16
+
+// Access an int array by position.
+#define var_int_array(x) ((int *) (x)->data)
 
 /*-----------------------------------------------------------------------------
  |  Checks
@@ -22,10 +53,24 @@ static pl_object global_var_objects = NULL;
                                               PL_ERROR_UNEXPECTED_NULL_POINTER, \
                                               "Can't access NULL pointer `" #x "` !")
 
+#define check_frame(frame) pl_error_expect((frame) >= 0,              \
+                                           PL_ERROR_INVALID_FRAME,    \
+                                           "Frame [%d] is negative!", \
+                                           frame)
+
 /*-----------------------------------------------------------------------------
  |  Init
  ----------------------------------------------------------------------------*/
 
+// New an int array filled with -1.
+static pl_object new_index_array(const int length)
+{
+    pl_object x = pl_object_get_ns().primitive.new(PL_CLASS_INT, length);
+    x->length   = length;
+    pl_misc_for_i(length) var_int_array(x)[i] = -1;
+    return x;
+}
+
 // Init the variable table.
 static void init(void)
 {
@@ -41,68 +86,126 @@ static void init(void)
     // variable table to be directly reachable.
     pl_error_try
     {
-        global_var_table   = object_ns.primitive.new(PL_CLASS_LIST, 3);
-        global_var_frames  = object_ns.primitive.new(PL_CLASS_INT, 1);
-        global_var_strings = object_ns.primitive.new(PL_CLASS_LIST, 1);
-        global_var_objects = object_ns.primitive.new(PL_CLASS_LIST, 1);
+        global_var_table       = object_ns.primitive.new(PL_CLASS_LIST, 10);
+        global_var_frames      = object_ns.primitive.new(PL_CLASS_INT, 1);
+        global_var_symbols     = object_ns.primitive.new(PL_CLASS_LIST, 1);
+        global_var_objects     = object_ns.primitive.new(PL_CLASS_LIST, 1);
+        global_var_bucket_next = object_ns.primitive.new(PL_CLASS_INT, 1);
+        global_var_frame_prev  = object_ns.primitive.new(PL_CLASS_INT, 1);
+        global_var_frame_next  = object_ns.primitive.new(PL_CLASS_INT, 1);
+        global_var_buckets     = new_index_array(VAR_INIT_BUCKETS);
+        global_var_frame_heads = object_ns.primitive.new(PL_CLASS_INT, 1);
 
         object_ns.append(global_var_table, global_var_frames);
-        object_ns.append(global_var_table, global_var_strings);
+        object_ns.append(global_var_table, global_var_symbols);
         object_ns.append(global_var_table, global_var_objects);
+        object_ns.append(global_var_table, global_var_bucket_next);
+        object_ns.append(global_var_table, global_var_frame_prev);
+        object_ns.append(global_var_table, global_var_frame_next);
+        object_ns.append(global_var_table, global_var_buckets);
+        object_ns.append(global_var_table, global_var_frame_heads);
 
         gc_ns.directly_reachable(global_var_table);
     }
     pl_error_catch
     {
         // If fails, reset all pointers.
-        global_var_table   = NULL;
-        global_var_frames  = NULL;
-        global_var_strings = NULL;
-        global_var_objects = NULL;
+        global_var_table       = NULL;
+        global_var_frames      = NULL;
+        global_var_symbols     = NULL;
+        global_var_objects     = NULL;
+        global_var_bucket_next = NULL;
+        global_var_frame_prev  = NULL;
+        global_var_frame_next  = NULL;
+        global_var_buckets     = NULL;
+        global_var_frame_heads = NULL;
         pl_error_rethrow();
     }
+
+    global_var_count     = 0;
+    global_var_free_slot = -1;
+}
+
+/*-----------------------------------------------------------------------------
+ |  Hash
+ ----------------------------------------------------------------------------*/
+
+// Bucket of a (frame, symbol) pair. Symbols are unique, so their addresses are hashed.
+static int bucket_of(const pl_object symbol, const int frame)
+{
+    unsigned long mixed = ((unsigned long) (uintptr_t) symbol >> 4) * 0xFF51AFD7ED558CCDUL;
+    mixed ^= (unsigned long) frame * 0x9E3779B97F4A7C15UL;
+    mixed ^= mixed >> 29;
+    return (int) (mixed & (unsigned long) (global_var_buckets->length - 1));
+}
+
+// Double the number of buckets and relink all the variables.
+static void rehash(void)
+{
+    pl_object buckets                   = new_index_array((int) global_var_buckets->length * 2);
+    const pl_object *const symbol_array = global_var_symbols->data;
+    const int *const frame_array        = var_int_array(global_var_frames);
+    int *const bucket_next              = var_int_array(global_var_bucket_next);
+
+    // Replace the bucket array first, so that `bucket_of` uses the new size.
+    pl_object_get_ns().primitive.set_object(global_var_table, VAR_BUCKETS_POSITION, buckets);
+    global_var_buckets = buckets;
+
+    int *const bucket_array = var_int_array(buckets);
+    pl_misc_for_i(global_var_symbols->length)
+    {
+        if (symbol_array[i] == NULL)
+            continue;
+        const int bucket     = bucket_of(symbol_array[i], frame_array[i]);
+        bucket_next[i]       = bucket_array[bucket];
+        bucket_array[bucket] = (int) i;
+    }
 }
 
 /*-----------------------------------------------------------------------------
  |  Find
  ----------------------------------------------------------------------------*/
 
-// Returns the position or -1 for not found.
-static int find(const char *const name, const int frame)
+// Check the name and the frame, and init the variable table.
+static void check_name(const char *const name, const int frame)
 {
     check_null_pointer(name);
-    pl_error_expect(frame >= 0,
-                    PL_ERROR_INVALID_FRAME,
-                    "Frame [%d] is negative!",
-                    frame);
-
-    const int name_length = (int) strlen(name);
-    pl_error_expect(name_length > 0,
+    check_frame(frame);
+    pl_error_expect(name[0] != '\0',
                     PL_ERROR_INVALID_VARIABLE_NAME,
                     "Variable name [%s] is invalid!",
                     name);
     init();
+}
+
+// Returns the position of a symbol or -1 for not found.
+static int find_symbol(const pl_object symbol, const int frame)
+{
+    const pl_object *const symbol_array = global_var_symbols->data;
+    const int *const frame_array        = var_int_array(global_var_frames);
+    const int *const bucket_next        = var_int_array(global_var_bucket_next);
 
-    pl_object *const string_array = global_var_strings->data;
-    int *const frame_array        = global_var_frames->data;
-    pl_misc_for_i(global_var_strings->length)
+    for (int i = var_int_array(global_var_buckets)[bucket_of(symbol, frame)]; i != -1; i = bucket_next[i])
     {
-        pl_object this_string = string_array[i];
-        int this_frame        = frame_array[i];
-
-        if (name_length == this_string->length && this_frame == frame)
-        {
-            int match                                = 1;
-            char *const data_array                   = this_string->data;
-            pl_misc_for_j(this_string->length) match = match && (data_array[j] == name[j]);
-            if (match)
-                return i;
-        }
+        if (symbol_array[i] == symbol && frame_array[i] == frame)
+            return i;
     }
 
     return -1;
 }
 
+// Returns the position or -1 for not found.
+static int find(const char *const name, const int frame)
+{
+    check_name(name, frame);
+
+    // A name that has never been interned can't be a variable.
+    const pl_object symbol = pl_symbol_get_ns().lookup(name);
+    if (symbol == NULL)
+        return -1;
+    return find_symbol(symbol, frame);
+}
+
 /*-----------------------------------------------------------------------------
  |  Get
  ----------------------------------------------------------------------------*/
@@ -123,43 +226,82 @@ static pl_object get(const char *const name, const int frame)
  |  Set
  ----------------------------------------------------------------------------*/
 
+// Grow an array to a given length. New items are left uninitialized.
+static void grow_array(pl_object x, const int length)
+{
+    pl_object_get_ns().primitive.reserve(x, length);
+    x->length = length;
+}
+
 static pl_object set(const char *const name, pl_object content, const int frame)
 {
-    int position = find(name, frame);
+    check_name(name, frame);
     check_null_pointer(content);
 
-    const pl_object_ns object_ns = pl_object_get_ns();
+    const pl_object symbol = pl_symbol_get_ns().intern(name);
+    int position           = find_symbol(symbol, frame);
 
     if (position >= 0)
     {
         ((pl_object *) global_var_objects->data)[position] = content;
+        pl_gc_write_barrier(global_var_objects, content);
+        return content;
     }
-    else
+
+    // Everything that may fail happens before the tables are modified.
+    if (global_var_free_slot == -1)
     {
-        const int var_frames_length  = global_var_frames->length;
-        const int var_strings_length = global_var_strings->length;
-        const int var_objects_length = global_var_objects->length;
-
-        pl_error_try
-        {
-            object_ns.primitive.extend_int(global_var_frames, frame);
-
-            const int name_length = (int) strlen(name);
-            pl_object this_name   = object_ns.primitive.new_from_array(PL_CLASS_CHAR, name_length, name);
-            object_ns.append(global_var_strings, this_name);
-
-            object_ns.append(global_var_objects, content);
-        }
-        pl_error_catch
-        {
-            // Recover the tables if fails.
-            global_var_frames->length  = var_frames_length;
-            global_var_strings->length = var_strings_length;
-            global_var_objects->length = var_objects_length;
-            pl_error_rethrow();
-        }
+        const int length = (int) global_var_symbols->length + 1;
+        grow_array(global_var_frames, length);
+        grow_array(global_var_bucket_next, length);
+        grow_array(global_var_frame_prev, length);
+        grow_array(global_var_frame_next, length);
+        grow_array(global_var_objects, length);
+        grow_array(global_var_symbols, length);
+        ((pl_object *) global_var_symbols->data)[length - 1] = NULL;
+        var_int_array(global_var_bucket_next)[length - 1]    = global_var_free_slot;
+        global_var_free_slot                                 = length - 1;
     }
 
+    if (frame >= global_var_frame_heads->length)
+    {
+        const int old_length = (int) global_var_frame_heads->length;
+        grow_array(global_var_frame_heads, frame + 1);
+        for (int i = old_length; i <= frame; i++)
+            var_int_array(global_var_frame_heads)[i] = -1;
+    }
+
+    if ((long) (global_var_count + 1) * 4 > (long) global_var_buckets->length * 3)
+        rehash();
+
+    // Take a free slot.
+    position             = global_var_free_slot;
+    global_var_free_slot = var_int_array(global_var_bucket_next)[position];
+    global_var_count++;
+
+    ((pl_object *) global_var_symbols->data)[position] = symbol;
+    pl_gc_write_barrier(global_var_symbols, symbol);
+    ((pl_object *) global_var_objects->data)[position] = content;
+    pl_gc_write_barrier(global_var_objects, content);
+    var_int_array(global_var_frames)[position] = frame;
+
+    // Link the slot to its bucket.
+    int *const bucket_array = var_int_array(global_var_buckets);
+    int *const bucket_next  = var_int_array(global_var_bucket_next);
+    const int bucket        = bucket_of(symbol, frame);
+    bucket_next[position]   = bucket_array[bucket];
+    bucket_array[bucket]    = position;
+
+    // Link the slot to the head of its frame.
+    int *const heads      = var_int_array(global_var_frame_heads);
+    int *const frame_prev = var_int_array(global_var_frame_prev);
+    int *const frame_next = var_int_array(global_var_frame_next);
+    frame_prev[position]  = -1;
+    frame_next[position]  = heads[frame];
+    if (heads[frame] != -1)
+        frame_prev[heads[frame]] = position;
+    heads[frame] = position;
+
     return content;
 }
 
@@ -173,33 +315,31 @@ static void delete_pos(const int position)
     if (position == -1)
         return;
 
-    // If it is the last item.
-    if (position == global_var_strings->length - 1)
-    {
-        global_var_frames->length--;
-        global_var_strings->length--;
-        global_var_objects->length--;
-        return;
-    }
+    int *const bucket_next = var_int_array(global_var_bucket_next);
+    int *const frame_prev  = var_int_array(global_var_frame_prev);
+    int *const frame_next  = var_int_array(global_var_frame_next);
+    const int frame        = var_int_array(global_var_frames)[position];
+
+    // Unlink the slot from its bucket.
+    int *link = &var_int_array(global_var_buckets)[bucket_of(((pl_object *) global_var_symbols->data)[position], frame)];
+    while (*link != position)
+        link = &bucket_next[*link];
+    *link = bucket_next[position];
 
-    // Otherwise, move the memory.
-    int *const frame_data_array = global_var_frames->data;
-    memmove(frame_data_array + position,
-            frame_data_array + position + 1,
-            (size_t) (global_var_frames->length - position - 1) * PL_CLASS_ELEMENT_SIZE[PL_CLASS_INT]);
-    global_var_frames->length--;
-
-    pl_object *const string_data_array = global_var_strings->data;
-    memmove(string_data_array + position,
-            string_data_array + position + 1,
-            (size_t) (global_var_strings->length - position - 1) * PL_CLASS_ELEMENT_SIZE[PL_CLASS_LIST]);
-    global_var_strings->length--;
-
-    pl_object *const object_data_array = global_var_objects->data;
-    memmove(object_data_array + position,
-            object_data_array + position + 1,
-            (size_t) (global_var_objects->length - position - 1) * PL_CLASS_ELEMENT_SIZE[PL_CLASS_LIST]);
-    global_var_objects->length--;
+    // Unlink the slot from its frame.
+    if (frame_prev[position] == -1)
+        var_int_array(global_var_frame_heads)[frame] = frame_next[position];
+    else
+        frame_next[frame_prev[position]] = frame_next[position];
+    if (frame_next[position] != -1)
+        frame_prev[frame_next[position]] = frame_prev[position];
+
+    // Release the slot.
+    ((pl_object *) global_var_symbols->data)[position] = NULL;
+    ((pl_object *) global_var_objects->data)[position] = NULL;
+    bucket_next[position]                              = global_var_free_slot;
+    global_var_free_slot                               = position;
+    global_var_count--;
 }
 
 static void delete(const char *name, const int frame)
@@ -214,21 +354,14 @@ static void delete(const char *name, const int frame)
 
 static void delete_frame(const int frame)
 {
-    pl_error_expect(frame >= 0,
-                    PL_ERROR_INVALID_FRAME,
-                    "Frame [%d] is negative!",
-                    frame);
+    check_frame(frame);
+    init();
 
-    int i                       = 0;
-    int *const frame_data_array = global_var_frames->data;
-    while (i < global_var_frames->length)
-    {
-        int position = frame_data_array[i];
-        if (position == frame)
-            delete_pos(position);
-        else
-            i++;
-    }
+    if (frame >= global_var_frame_heads->length)
+        return;
+
+    while (var_int_array(global_var_frame_heads)[frame] != -1)
+        delete_pos(var_int_array(global_var_frame_heads)[frame]);
 }
 
 /*-----------------------------------------------------------------------------
@@ -237,21 +370,14 @@ static void delete_frame(const int frame)
 
 static void delete_frames_greater(const int frame)
 {
-    pl_error_expect(frame >= 0,
-                    PL_ERROR_INVALID_FRAME,
-                    "Frame [%d] is negative!",
-                    frame);
+    check_frame(frame);
+    init();
 
-    int i                       = 0;
-    int *const frame_data_array = global_var_frames->data;
-    while (i < global_var_frames->length)
-    {
-        int position = frame_data_array[i];
-        if (position > frame)
-            delete_pos(position);
-        else
-            i++;
-    }
+    for (int i = (int) global_var_frame_heads->length - 1; i > frame; i--)
+        delete_frame(i);
+
+    if (global_var_frame_heads->length > frame + 1)
+        global_var_frame_heads->length = frame + 1;
 }
 
 /*-----------------------------------------------------------------------------
@@ -261,14 +387,81 @@ static void delete_frames_greater(const int frame)
 static int max_frame_number(void)
 {
     init();
-    int max_frame               = -1;
-    int *const frame_data_array = global_var_frames->data;
-    pl_misc_for_i(global_var_frames->length)
+    for (int i = (int) global_var_frame_heads->length - 1; i >= 0; i--)
+    {
+        if (var_int_array(global_var_frame_heads)[i] != -1)
+            return i;
+    }
+    return -1;
+}
+
+/*-----------------------------------------------------------------------------
+ |  Tests
+ ----------------------------------------------------------------------------*/
+
+static pl_unittest_summary test_table(void)
+{
+    pl_unittest_summary summary = pl_unittest_new_summary();
+
+    // Enough variables to rehash, with the same names in different frames.
+    char name[16];
+    pl_object contents[200];
+    pl_misc_for_i(200)
+    {
+        snprintf(name, sizeof(name), "v%d", (int) i / 4);
+        contents[i] = pl_object_get_ns().primitive.new(PL_CLASS_INT, 1);
+        set(name, contents[i], (int) i % 4);
+    }
+    const long buckets = global_var_buckets->length;
+    pl_unittest_expect_true(summary, global_var_count == 200);
+    pl_unittest_expect_true(summary, buckets > VAR_INIT_BUCKETS && (buckets & (buckets - 1)) == 0);
+    pl_unittest_expect_true(summary, (long) global_var_count * 4 <= buckets * 3);
+    volatile int all_found = 1;
+    pl_misc_for_i(200)
     {
-        if (frame_data_array[i] > max_frame)
-            max_frame = frame_data_array[i];
+        snprintf(name, sizeof(name), "v%d", (int) i / 4);
+        all_found = all_found && get(name, (int) i % 4) == contents[i];
     }
-    return max_frame;
+    pl_unittest_expect_true(summary, all_found);
+
+    // Setting an existing variable reuses its slot, and deleted slots are reused.
+    set("v0", contents[1], 0);
+    pl_unittest_expect_true(summary, global_var_count == 200 && get("v0", 0) == contents[1]);
+    delete("v1", 0);
+    pl_unittest_expect_true(summary, global_var_count == 199 && find("v1", 0) == -1 && get("v1", 1) == contents[5]);
+    const long slots = global_var_symbols->length;
+    set("v1", contents[4], 0);
+    pl_unittest_expect_true(summary, global_var_symbols->length == slots && get("v1", 0) == contents[4]);
+
+    // Frames are deleted through their chains.
+    pl_unittest_expect_true(summary, max_frame_number() == 3);
+    delete_frame(2);
+    pl_unittest_expect_true(summary, global_var_count == 150 && find("v7", 2) == -1 && get("v7", 3) == contents[31]);
+    delete_frames_greater(0);
+    pl_unittest_expect_true(summary, global_var_count == 50 && max_frame_number() == 0);
+
+    volatile int caught = PL_ERROR_NONE;
+    pl_error_try
+    {
+        get("v1", 1);
+    }
+    pl_error_catch
+    {
+        caught = pl_error_get_current();
+    }
+    pl_unittest_expect_true(summary, caught == PL_ERROR_VARIABLE_NOT_FOUND);
+    pl_unittest_expect_true(summary, find("never_interned", 0) == -1);
+
+    delete_frame(0);
+    pl_unittest_expect_true(summary, global_var_count == 0 && max_frame_number() == -1);
+
+    return summary;
+}
+
+static void test(void)
+{
+    printf("In file: %s\n", __FILE__);
+    pl_unittest_print_summary(test_table());
 }
 
 /*-----------------------------------------------------------------------------
@@ -277,11 +470,21 @@ static int max_frame_number(void)
 
 pl_var_ns pl_var_get_ns(void)
 {
+#ifdef PL_TEST
+    static const pl_var_ns var_ns = {.get                   = get,
+                                     .set                   = set,
+                                     .delete                = delete,
+                                     .delete_frame          = delete_frame,
+                                     .delete_frames_greater = delete_frames_greater,
+                                     .max_frame_number      = max_frame_number,
+                                     .test                  = test};
+#else
     static const pl_var_ns var_ns = {.get                    = get,
                                      .set                    = set,
                                      .delete                 = delete,
                                      .delete_frame           = delete_frame,
                                      .delete_frames_greater = delete_frames_greater,
                                      .max_frame_number       = max_frame_number};
+#endif//PL_TEST
     return var_ns;
 }
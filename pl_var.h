@@ -45,6 +45,13 @@ typedef struct pl_var_ns
     /// Get the greatest frame number.
     /// @return The frame number.
     int (*const max_frame_number)(void);
+
+#ifdef PL_TEST
+
+    void (*const test)(void);
+
+#endif//PL_TEST
+
 } pl_var_ns;
 
 /// Get variable namespace.